@@ -0,0 +1,644 @@
+#ifndef VAOT_C
+#define VAOT_C
+
+/*
+ * ahead of time compilation of executables to C:
+ * the program is written out as a single C translation unit where every instruction is a labeled statement.
+ * the instructions are split in chunks of AOT_CHUNK_SIZE, one function each, since compilers take superlinear time
+ * on huge functions. jumps with literal offsets inside a chunk become gotos, jumps through registers, RET and
+ * anything else that sets RIP go back to a switch over the instruction positions of the chunk. jumps out of a chunk
+ * return to vpu_run, which calls the chunk of the new IP. the registers stay in the register space, just like in the
+ * interpreter, so the generated code keeps the exact same semantics (sub registers, GRP, GSP...).
+ * the generated file includes system.c and core.c, build it with the Virtual sources in the include path:
+ *      cc -O2 -I <Virtual>/src program.c -o program -lm -pthread
+ * perform_inst stays the reference: instructions naming RIP, EXEC, DISREG and unknown instructions call it directly,
+ * the vector instructions call perform_vector_inst (see vector.c) and the bulk memory instructions their kernels (see bulk.c).
+ */
+
+#include "core.h"
+#include "virtual_files.h"
+#include <stdio.h>
+#include <inttypes.h>
+
+
+// the instructions per generated function
+#ifndef AOT_CHUNK_SIZE
+#define AOT_CHUNK_SIZE 256
+#endif
+
+// the instructions of the function being written, [begin, end)
+typedef struct AotChunk{
+    uint64_t begin;
+    uint64_t end;
+} AotChunk;
+
+// writes the jump to instruction target, a goto if it is in chunk or a return to vpu_run otherwise
+static void aot_goto(FILE* output, uint64_t target, AotChunk chunk){
+    if(target >= chunk.begin && target < chunk.end) fprintf(output, "goto I%"PRIu64";", target);
+    else fprintf(output, "{ IP = %"PRIu64"u; return 0; }", target);
+}
+
+// writes the C statements of the instruction at program[ip], part of chunk
+static void aot_emit_inst(FILE* output, const Inst* program, uint64_t ip, uint64_t program_size, AotChunk chunk){
+
+    const Inst inst = program[ip];
+    const unsigned int r1 = (uint8_t) (inst >> 8);
+    const unsigned int r2 = (uint8_t) (inst >> 16);
+    const unsigned int r3 = (uint8_t) (inst >> 24);
+    const unsigned int l1 = (uint16_t) (inst >> 8);
+    const unsigned int l2 = (uint16_t) (inst >> 16);
+    const int hint_reg    = GET_OP_HINT(inst) == HINT_REG;
+
+    #define EMIT(...)                   fprintf(output, "    " __VA_ARGS__)
+    #define OPERATION(OP, TYPE)         EMIT("REG(%u).as_" TYPE " = REG(%u).as_" TYPE " " OP " REG(%u).as_" TYPE ";\n", r1, r2, r3)
+    #define COMPARE(OP, TYPE)           EMIT("REG(%u).as_uint8 = REG(%u).as_" TYPE " " OP " REG(%u).as_" TYPE ";\n", r1, r2, r3)
+    #define UNARY(TYPE, EXPRESSION)     EMIT("REG(%u).as_" TYPE " = " EXPRESSION ";\n", r1, r2)
+
+    // instructions that can see or change RIP through their operands are left to perform_inst
+    const int operands = get_inst_register_operands(inst);
+    const unsigned int registers[3] = {r1, r2, r3};
+    int touches_r0 = 0;
+    for(int i = 0; i < operands; i+=1){
+        if(registers[i] > RIP - 8 && registers[i] < RIP + 8){
+            EMIT("IP = %"PRIu64"u;\n", ip);
+            EMIT("IP += perform_inst(vpu, 0x%08"PRIx32"u);\n", inst);
+            EMIT("REG(R0).as_uint64 = 0;\n");
+            EMIT("goto dispatch;\n");
+            return;
+        }
+        if(registers[i] < 8) touches_r0 = 1;
+    }
+
+    switch (inst & 0XFF)
+    {
+    case INST_NOP:
+        break;
+    case INST_HALT:
+        if(hint_reg) EMIT("vpu->status = (int) REG(%u).as_int8;\n", r1);
+        else         EMIT("vpu->status = %u;\n", l1);
+        EMIT("IP = 0XFFFFFFFFFFFFFFFF;\n");
+        EMIT("return 1;\n");
+        return;
+    case INST_MOV8:   UNARY("uint8",  "REG(%u).as_uint8");  break;
+    case INST_MOV16:  UNARY("uint16", "REG(%u).as_uint16"); break;
+    case INST_MOV32:  UNARY("uint32", "REG(%u).as_uint32"); break;
+    case INST_MOV:    EMIT("REG(%u) = REG(%u);\n", r1, r2); break;
+    case INST_MOVC:   EMIT("if(REG(%u).as_uint64) REG(%u) = REG(%u);\n", r1, r2, r3); break;
+    case INST_MOVV:   EMIT("REG(%u).as_uint64 = %uu;\n", r1, l2); break;
+    case INST_MOVN:   EMIT("REG(%u).as_uint64 = ~(uint64_t) %uu;\n", r1, l2); break;
+    case INST_MOVV16: EMIT("REG(%u).as_uint16 = %uu;\n", r1, l2); break;
+    case INST_MOVVW:
+    case INST_MOVVL:{
+        const uint64_t next = ip + 1 + get_inst_payload_size(inst & 0XFF);
+        if(next > program_size){
+            EMIT("IP = %"PRIu64"u;\n", ip);
+            EMIT("IP += perform_inst(vpu, 0x%08"PRIx32"u);\n", inst);
+            EMIT("goto dispatch;\n");
+            return;
+        }
+        EMIT("REG(%u).as_uint64 = %"PRIu64"u;\n", r1, get_wide_literal(program + ip));
+        if(touches_r0) EMIT("REG(R0).as_uint64 = 0;\n");
+        // the containers are never run
+        EMIT("");
+        aot_goto(output, next, chunk);
+        fprintf(output, "\n");
+    }   return;
+    case INST_PUSH:
+        if(hint_reg) EMIT("vpu->stack[SP++] = REG(%u).as_uint64;\n", r1);
+        else         EMIT("vpu->stack[SP++] = %uu;\n", l1);
+        break;
+    case INST_POP:       EMIT("REG(%u).as_uint64 = vpu->stack[--SP];\n", r1); break;
+    case INST_STACK_GET: EMIT("REG(%u).as_uint64 = vpu->stack[SP - %uu];\n", r1, l2); break;
+    case INST_STACK_PUT: EMIT("vpu->stack[SP - %uu] = REG(%u).as_uint64;\n", l2, r1); break;
+    case INST_GSP:
+        EMIT("REG(%u).as_ptr = (uint8_t*)((uint64_t*) vpu->stack + REG(%u).as_uint64) + REG(%u).as_uint64;\n", r1, r2, r3);
+        break;
+    case INST_STATIC:
+        if(hint_reg) EMIT("vpu->stack[SP++] = (uint64_t)(uintptr_t)(vpu->static_memory + REG(%u).as_uint64);\n", r1);
+        else         EMIT("vpu->stack[SP++] = (uint64_t)(uintptr_t)(vpu->static_memory + %uu);\n", l1);
+        break;
+    case INST_READ8:
+        EMIT("REG(%u).as_uint8 = *(uint8_t*)((uintptr_t)(REG(%u).as_ptr) + REG(%u).as_int64);\n", r1, r2, r3);
+        break;
+    case INST_READ16:
+        EMIT("REG(%u).as_uint16 = *(uint16_t*)((uintptr_t)(REG(%u).as_ptr) + REG(%u).as_int64);\n", r1, r2, r3);
+        break;
+    case INST_READ32:
+        EMIT("REG(%u).as_uint32 = *(uint32_t*)((uintptr_t)(REG(%u).as_ptr) + REG(%u).as_int64);\n", r1, r2, r3);
+        break;
+    case INST_READ:
+        EMIT("REG(%u).as_uint64 = *(uint64_t*)((uintptr_t)(REG(%u).as_ptr) + REG(%u).as_int64);\n", r1, r2, r3);
+        break;
+    case INST_MREADS:
+        EMIT("REG(%u).as_ptr = memcpy(REG(%u).as_ptr, REG(%u).as_ptr, (size_t) REG(%u).as_uint64);\n", r1, r1, r2, r3);
+        break;
+    case INST_WRITE8:
+        EMIT("*(uint8_t*)((uintptr_t)(REG(%u).as_ptr) + REG(%u).as_int64) = REG(%u).as_uint8;\n", r1, r3, r2);
+        break;
+    case INST_WRITE16:
+        EMIT("*(uint16_t*)((uintptr_t)(REG(%u).as_ptr) + REG(%u).as_int64) = REG(%u).as_uint16;\n", r1, r3, r2);
+        break;
+    case INST_WRITE32:
+        EMIT("*(uint32_t*)((uintptr_t)(REG(%u).as_ptr) + REG(%u).as_int64) = REG(%u).as_uint32;\n", r1, r3, r2);
+        break;
+    case INST_WRITE:
+        EMIT("*(uint64_t*)((uintptr_t)(REG(%u).as_ptr) + REG(%u).as_int64) = REG(%u).as_uint64;\n", r1, r3, r2);
+        break;
+    case INST_MWRITES:
+        EMIT("REG(%u).as_ptr = memset(REG(%u).as_ptr, (int) REG(%u).as_int8, (size_t) REG(%u).as_uint64);\n", r1, r1, r2, r3);
+        break;
+    case INST_MMOVS:
+        EMIT("REG(%u).as_ptr = memmove(REG(%u).as_ptr, REG(%u).as_ptr, (size_t) REG(%u).as_uint64);\n", r1, r1, r2, r3);
+        break;
+    case INST_MEMCMP:
+        EMIT("REG(%u).as_uint8 = (uint8_t) memcmp(REG(%u).as_ptr, REG(%u).as_ptr, (size_t) REG(%u).as_uint64);\n", r1, r1, r2, r3);
+        break;
+    case INST_MSTRLEN:
+        EMIT("REG(%u).as_uint64 = (uint64_t) strlen((const char*) REG(%u).as_ptr);\n", r1, r2);
+        break;
+    case INST_MCHR:
+        EMIT("REG(%u).as_ptr = memchr(REG(%u).as_ptr, (int) REG(%u).as_uint8, (size_t) REG(%u).as_uint64);\n", r1, r1, r2, r3);
+        break;
+    case INST_MFILL32:
+        EMIT("bulk_fill32(REG(%u).as_ptr, REG(%u).as_uint32, REG(%u).as_uint64);\n", r1, r2, r3);
+        break;
+    case INST_MFILL64:
+        EMIT("bulk_fill64(REG(%u).as_ptr, REG(%u).as_uint64, REG(%u).as_uint64);\n", r1, r2, r3);
+        break;
+    case INST_MCRC32:
+        EMIT("REG(%u).as_uint64 = bulk_crc32c(REG(%u).as_uint32, REG(%u).as_ptr, REG(%u).as_uint64);\n", r1, r1, r2, r3);
+        break;
+    case INST_MHASH:
+        EMIT("REG(%u).as_uint64 = bulk_hash(REG(%u).as_uint64, REG(%u).as_ptr, REG(%u).as_uint64);\n", r1, r1, r2, r3);
+        break;
+    case INST_MPOPCNT:
+        EMIT("REG(%u).as_uint64 = bulk_popcount(REG(%u).as_ptr, REG(%u).as_uint64);\n", r1, r2, r3);
+        break;
+    case INST_ALOAD8:
+        EMIT("REG(%u).as_uint8 = atomic_load_explicit(VPU_ATOMIC(8, (uintptr_t)(REG(%u).as_ptr) + REG(%u).as_int64), memory_order_acquire);\n", r1, r2, r3);
+        break;
+    case INST_ALOAD16:
+        EMIT("REG(%u).as_uint16 = atomic_load_explicit(VPU_ATOMIC(16, (uintptr_t)(REG(%u).as_ptr) + REG(%u).as_int64), memory_order_acquire);\n", r1, r2, r3);
+        break;
+    case INST_ALOAD32:
+        EMIT("REG(%u).as_uint32 = atomic_load_explicit(VPU_ATOMIC(32, (uintptr_t)(REG(%u).as_ptr) + REG(%u).as_int64), memory_order_acquire);\n", r1, r2, r3);
+        break;
+    case INST_ALOAD:
+        EMIT("REG(%u).as_uint64 = atomic_load_explicit(VPU_ATOMIC(64, (uintptr_t)(REG(%u).as_ptr) + REG(%u).as_int64), memory_order_acquire);\n", r1, r2, r3);
+        break;
+    case INST_ASTORE8:
+        EMIT("atomic_store_explicit(VPU_ATOMIC(8, (uintptr_t)(REG(%u).as_ptr) + REG(%u).as_int64), REG(%u).as_uint8, memory_order_release);\n", r1, r3, r2);
+        break;
+    case INST_ASTORE16:
+        EMIT("atomic_store_explicit(VPU_ATOMIC(16, (uintptr_t)(REG(%u).as_ptr) + REG(%u).as_int64), REG(%u).as_uint16, memory_order_release);\n", r1, r3, r2);
+        break;
+    case INST_ASTORE32:
+        EMIT("atomic_store_explicit(VPU_ATOMIC(32, (uintptr_t)(REG(%u).as_ptr) + REG(%u).as_int64), REG(%u).as_uint32, memory_order_release);\n", r1, r3, r2);
+        break;
+    case INST_ASTORE:
+        EMIT("atomic_store_explicit(VPU_ATOMIC(64, (uintptr_t)(REG(%u).as_ptr) + REG(%u).as_int64), REG(%u).as_uint64, memory_order_release);\n", r1, r3, r2);
+        break;
+    case INST_ACAS8:
+        EMIT("atomic_compare_exchange_strong(VPU_ATOMIC(8, REG(%u).as_ptr), &REG(%u).as_uint8, REG(%u).as_uint8);\n", r2, r1, r3);
+        break;
+    case INST_ACAS16:
+        EMIT("atomic_compare_exchange_strong(VPU_ATOMIC(16, REG(%u).as_ptr), &REG(%u).as_uint16, REG(%u).as_uint16);\n", r2, r1, r3);
+        break;
+    case INST_ACAS32:
+        EMIT("atomic_compare_exchange_strong(VPU_ATOMIC(32, REG(%u).as_ptr), &REG(%u).as_uint32, REG(%u).as_uint32);\n", r2, r1, r3);
+        break;
+    case INST_ACAS:
+        EMIT("atomic_compare_exchange_strong(VPU_ATOMIC(64, REG(%u).as_ptr), &REG(%u).as_uint64, REG(%u).as_uint64);\n", r2, r1, r3);
+        break;
+    case INST_AADD8:
+        EMIT("REG(%u).as_uint8 = atomic_fetch_add(VPU_ATOMIC(8, REG(%u).as_ptr), REG(%u).as_uint8);\n", r1, r2, r3);
+        break;
+    case INST_AADD16:
+        EMIT("REG(%u).as_uint16 = atomic_fetch_add(VPU_ATOMIC(16, REG(%u).as_ptr), REG(%u).as_uint16);\n", r1, r2, r3);
+        break;
+    case INST_AADD32:
+        EMIT("REG(%u).as_uint32 = atomic_fetch_add(VPU_ATOMIC(32, REG(%u).as_ptr), REG(%u).as_uint32);\n", r1, r2, r3);
+        break;
+    case INST_AADD:
+        EMIT("REG(%u).as_uint64 = atomic_fetch_add(VPU_ATOMIC(64, REG(%u).as_ptr), REG(%u).as_uint64);\n", r1, r2, r3);
+        break;
+    case INST_AOR8:
+        EMIT("REG(%u).as_uint8 = atomic_fetch_or(VPU_ATOMIC(8, REG(%u).as_ptr), REG(%u).as_uint8);\n", r1, r2, r3);
+        break;
+    case INST_AOR16:
+        EMIT("REG(%u).as_uint16 = atomic_fetch_or(VPU_ATOMIC(16, REG(%u).as_ptr), REG(%u).as_uint16);\n", r1, r2, r3);
+        break;
+    case INST_AOR32:
+        EMIT("REG(%u).as_uint32 = atomic_fetch_or(VPU_ATOMIC(32, REG(%u).as_ptr), REG(%u).as_uint32);\n", r1, r2, r3);
+        break;
+    case INST_AOR:
+        EMIT("REG(%u).as_uint64 = atomic_fetch_or(VPU_ATOMIC(64, REG(%u).as_ptr), REG(%u).as_uint64);\n", r1, r2, r3);
+        break;
+    case INST_AXCHG8:
+        EMIT("REG(%u).as_uint8 = atomic_exchange(VPU_ATOMIC(8, REG(%u).as_ptr), REG(%u).as_uint8);\n", r1, r2, r3);
+        break;
+    case INST_AXCHG16:
+        EMIT("REG(%u).as_uint16 = atomic_exchange(VPU_ATOMIC(16, REG(%u).as_ptr), REG(%u).as_uint16);\n", r1, r2, r3);
+        break;
+    case INST_AXCHG32:
+        EMIT("REG(%u).as_uint32 = atomic_exchange(VPU_ATOMIC(32, REG(%u).as_ptr), REG(%u).as_uint32);\n", r1, r2, r3);
+        break;
+    case INST_AXCHG:
+        EMIT("REG(%u).as_uint64 = atomic_exchange(VPU_ATOMIC(64, REG(%u).as_ptr), REG(%u).as_uint64);\n", r1, r2, r3);
+        break;
+    case INST_FENCE:
+        EMIT("atomic_thread_fence(memory_order_seq_cst);\n");
+        break;
+    case INST_NOT:  UNARY("uint64", "!REG(%u).as_uint64"); break;
+    case INST_NEG:  EMIT("REG(%u).as_uint64 = ~REG(%u).as_uint64 | REG(%u).as_uint64;\n", r1, r2, r3); break;
+    case INST_AND:  OPERATION("&", "uint64"); break;
+    case INST_NAND: EMIT("REG(%u).as_uint64 = ~(REG(%u).as_uint64 & REG(%u).as_uint64);\n", r1, r2, r3); break;
+    case INST_OR:   OPERATION("|", "uint64"); break;
+    case INST_XOR:  OPERATION("^", "uint64"); break;
+    case INST_BSHIFT:
+        EMIT(
+            "REG(%u).as_uint64 = REG(%u).as_int8 < 0? REG(%u).as_uint64 >> -(REG(%u).as_int8) : REG(%u).as_uint64 << REG(%u).as_uint8;\n",
+            r1, r3, r2, r3, r2, r3
+        );
+        break;
+    case INST_JMP:
+        if(hint_reg){
+            EMIT("IP = %"PRIu64"u + REG(%u).as_uint64;\n", ip, r1);
+            EMIT("goto dispatch;\n");
+        }
+        else{
+            EMIT("");
+            aot_goto(output, ip + (int16_t) l1, chunk);
+            fprintf(output, "\n");
+        }
+        return;
+    case INST_JMPF:
+    case INST_JMPFN:
+        EMIT("if(%sREG(%u).as_uint8) ", ((inst & 0xFF) == INST_JMPF)? "" : "!", r1);
+        aot_goto(output, ip + (int16_t) l2, chunk);
+        fprintf(output, "\n");
+        break;
+    case INST_CALL:
+        EMIT("vpu->stack[SP++] = %"PRIu64"u;\n", ip + 1);
+        if(hint_reg){
+            EMIT("IP = %"PRIu64"u + REG(%u).as_uint64;\n", ip, r1);
+            EMIT("goto dispatch;\n");
+        }
+        else{
+            EMIT("");
+            aot_goto(output, ip + (int16_t) l1, chunk);
+            fprintf(output, "\n");
+        }
+        return;
+    case INST_JMPW:
+    case INST_JMPFW:
+    case INST_JMPFNW:
+    case INST_CALLW:{
+        const uint64_t next = ip + 2;
+        if(next > program_size){
+            EMIT("IP = %"PRIu64"u;\n", ip);
+            EMIT("IP += perform_inst(vpu, 0x%08"PRIx32"u);\n", inst);
+            EMIT("goto dispatch;\n");
+            return;
+        }
+        const uint64_t target = ip + get_wide_literal(program + ip);
+        if((inst & 0xFF) == INST_CALLW) EMIT("vpu->stack[SP++] = %"PRIu64"u;\n", next);
+        if((inst & 0xFF) == INST_JMPFW || (inst & 0xFF) == INST_JMPFNW){
+            EMIT("if(%sREG(%u).as_uint8) ", ((inst & 0xFF) == INST_JMPFW)? "" : "!", r1);
+            aot_goto(output, target, chunk);
+            fprintf(output, "\n");
+        }
+        // the container is never run
+        EMIT("");
+        aot_goto(output, ((inst & 0xFF) == INST_JMPFW || (inst & 0xFF) == INST_JMPFNW)? next : target, chunk);
+        fprintf(output, "\n");
+    }   return;
+    case INST_RET:
+        EMIT("IP = vpu->stack[--SP];\n");
+        EMIT("goto dispatch;\n");
+        return;
+
+    case INST_ADD8:  OPERATION("+", "uint8");   break;
+    case INST_SUB8:  OPERATION("-", "uint8");   break;
+    case INST_MUL8:  OPERATION("*", "uint8");   break;
+    case INST_ADD16: OPERATION("+", "uint16");  break;
+    case INST_SUB16: OPERATION("-", "uint16");  break;
+    case INST_MUL16: OPERATION("*", "uint16");  break;
+    case INST_ADD32: OPERATION("+", "uint32");  break;
+    case INST_SUB32: OPERATION("-", "uint32");  break;
+    case INST_MUL32: OPERATION("*", "uint32");  break;
+    case INST_ADD:   OPERATION("+", "uint64");  break;
+    case INST_SUB:   OPERATION("-", "uint64");  break;
+    case INST_MUL:   OPERATION("*", "uint64");  break;
+    case INST_DIVI:  OPERATION("/", "int64");   break;
+    case INST_DIVU:  OPERATION("/", "uint64");  break;
+    case INST_ADDF:  OPERATION("+", "float64"); break;
+    case INST_SUBF:  OPERATION("-", "float64"); break;
+    case INST_MULF:  OPERATION("*", "float64"); break;
+    case INST_DIVF:  OPERATION("/", "float64"); break;
+    case INST_INC:   EMIT("REG(%u).as_uint64 += %uu;\n", r1, l2);         break;
+    case INST_DEC:   EMIT("REG(%u).as_int64 -= %u;\n", r1, l2);           break;
+    case INST_INCF:  EMIT("REG(%u).as_float64 += (double) %u;\n", r1, l2); break;
+    case INST_DECF:  EMIT("REG(%u).as_float64 -= (double) %u;\n", r1, l2); break;
+    case INST_ABS:
+        EMIT("{ const int64_t v = REG(%u).as_int64 - REG(%u).as_int64; REG(%u).as_uint64 = (v < 0)? -v : v; }\n", r2, r3, r1);
+        break;
+    case INST_ABSF:
+        EMIT("{ const double v = REG(%u).as_float64 - REG(%u).as_float64; REG(%u).as_float64 = (v < 0)? -v : v; }\n", r2, r3, r1);
+        break;
+
+    case INST_NEQ:  COMPARE("!=", "uint64");  break;
+    case INST_EQ:   COMPARE("==", "uint64");  break;
+    case INST_EQF:  COMPARE("==", "float64"); break;
+    case INST_BIGI: COMPARE(">",  "int64");   break;
+    case INST_BIGU: COMPARE(">",  "uint64");  break;
+    case INST_BIGF: COMPARE(">",  "float64"); break;
+    case INST_SMLI: COMPARE("<",  "int64");   break;
+    case INST_SMLU: COMPARE("<",  "uint64");  break;
+    case INST_SMLF: COMPARE("<",  "float64"); break;
+
+    case INST_CASTIU: UNARY("int64",   "(int64_t) REG(%u).as_uint64");  break;
+    case INST_CASTIF: UNARY("int64",   "(int64_t) REG(%u).as_float64"); break;
+    case INST_CASTUI: UNARY("uint64",  "(uint64_t) REG(%u).as_int64");  break;
+    case INST_CASTUF: UNARY("uint64",  "(uint64_t) REG(%u).as_float64"); break;
+    case INST_CASTFI: UNARY("float64", "(double) REG(%u).as_int64");    break;
+    case INST_CASTFU: UNARY("float64", "(double) REG(%u).as_uint64");   break;
+    case INST_CF3264: UNARY("float32", "(float) REG(%u).as_float64");   break;
+    case INST_CF6432: UNARY("float64", "(double) REG(%u).as_float32");  break;
+    case INST_FLOAT:
+        EMIT("REG(%u).as_float64 = (double) REG(%u).as_int64 / (double) REG(%u).as_uint64;\n", r1, r2, r3);
+        break;
+    case INST_FMAF:
+        EMIT("REG(%u).as_float64 = fma(REG(%u).as_float64, REG(%u).as_float64, REG(%u).as_float64);\n", r1, r2, r3, r1);
+        break;
+    case INST_SQRTF:  UNARY("float64", "sqrt(REG(%u).as_float64)");      break;
+    case INST_MINF:
+        EMIT("REG(%u).as_float64 = (REG(%u).as_float64 < REG(%u).as_float64)? REG(%u).as_float64 : REG(%u).as_float64;\n", r1, r2, r3, r2, r3);
+        break;
+    case INST_MAXF:
+        EMIT("REG(%u).as_float64 = (REG(%u).as_float64 > REG(%u).as_float64)? REG(%u).as_float64 : REG(%u).as_float64;\n", r1, r2, r3, r2, r3);
+        break;
+    case INST_FLOORF: UNARY("float64", "floor(REG(%u).as_float64)");     break;
+    case INST_CEILF:  UNARY("float64", "ceil(REG(%u).as_float64)");      break;
+    case INST_ROUNDF: UNARY("float64", "nearbyint(REG(%u).as_float64)"); break;
+    case INST_ADDF32: OPERATION("+", "float32"); break;
+    case INST_SUBF32: OPERATION("-", "float32"); break;
+    case INST_MULF32: OPERATION("*", "float32"); break;
+    case INST_DIVF32: OPERATION("/", "float32"); break;
+    case INST_FMAF32:
+        EMIT("REG(%u).as_float32 = fmaf(REG(%u).as_float32, REG(%u).as_float32, REG(%u).as_float32);\n", r1, r2, r3, r1);
+        break;
+    case INST_SQRTF32: UNARY("float32", "sqrtf(REG(%u).as_float32)"); break;
+
+    case INST_DUMPCHAR:
+        EMIT("if(REG(%u).as_int8 == 0) putchar((int) REG(%u).as_int32);\n", r2, r1);
+        EMIT("else fputc((int) REG(%u).as_int32, stderr);\n", r1);
+        EMIT("if(REG(%u).as_uint8) fflush(stdout);\n", r3);
+        break;
+    case INST_GETCHAR:
+        EMIT("REG(%u).as_int32 = fgetc(stdin);\n", r1);
+        EMIT("if(REG(%u).as_uint8) fclose(stdin);\n", r2);
+        break;
+    case INST_SYS:
+        EMIT("IP = %"PRIu64"u;\n", ip);
+        if(hint_reg) EMIT("if(vpu_syscall(vpu, REG(%u).as_uint64)) return 1;\n", r1);
+        else         EMIT("if(vpu_syscall(vpu, %uu)) return 1;\n", l1);
+        break;
+    case INST_GRP:
+        EMIT("REG(%u).as_ptr = ((uint8_t*) &REG(%u)) + REG(%u).as_int64;\n", r1, r2, r3);
+        break;
+    case INST_GIP:
+        EMIT("REG(%u).as_ptr = ((uint8_t*) (vpu->program + REG(%u).as_uint64)) + REG(%u).as_uint64;\n", r1, r2, r3);
+        break;
+
+    // DISREG always continues to the next instruction
+    case INST_DISREG:
+        EMIT("perform_inst(vpu, 0x%08"PRIx32"u);\n", inst);
+        break;
+
+    // EXEC and unknown instructions, the vector instructions always continue to the next one
+    default:
+        if(is_vector_inst(inst & 0XFF)){
+            EMIT("perform_vector_inst(registers, 0x%08"PRIx32"u);\n", inst);
+            break;
+        }
+        EMIT("IP = %"PRIu64"u;\n", ip);
+        EMIT("IP += perform_inst(vpu, 0x%08"PRIx32"u);\n", inst);
+        EMIT("REG(R0).as_uint64 = 0;\n");
+        EMIT("goto dispatch;\n");
+        return;
+    }
+
+    // R0 always reads as 0
+    if(touches_r0) EMIT("REG(R0).as_uint64 = 0;\n");
+
+    #undef EMIT
+    #undef OPERATION
+    #undef COMPARE
+    #undef UNARY
+}
+
+// writes program as a standalone C translation unit to output
+// \param source where the program came from, only used in the header comment
+int compile_to_c(
+    FILE* output, const Inst* program, uint64_t program_size, uint64_t entry_point,
+    const uint8_t* static_memory, uint64_t static_memory_size, const char* source
+){
+
+    fprintf(output,
+        "// generated by vpu -compile-c from '%s'\n"
+        "// build with the Virtual sources in the include path: cc -O2 -I <Virtual>/src <this file> -lm -pthread\n"
+        "#include \"system.c\"\n"
+        "#include \"core.c\"\n"
+        "\n"
+        "#define VPU_PROGRAM_SIZE %"PRIu64"u\n"
+        "#define VPU_ENTRY_POINT  %"PRIu64"u\n"
+        "\n",
+        source, program_size, entry_point
+    );
+
+    // the program is still needed by GIP and EXEC
+    fprintf(output, "static Inst vpu_program[] = {");
+    for(uint64_t i = 0; i < program_size; i+=1){
+        fprintf(output, "%s0x%08"PRIx32"u,", (i % 8)? " " : "\n    ", program[i]);
+    }
+    fprintf(output, "%s\n};\n\n", program_size? "" : "\n    0");
+
+    if(static_memory){
+        fprintf(output, "static uint8_t vpu_static_memory[] = {");
+        for(uint64_t i = 0; i < static_memory_size; i+=1){
+            fprintf(output, "%s0x%02"PRIx8",", (i % 16)? " " : "\n    ", static_memory[i]);
+        }
+        fprintf(output, "%s\n};\n\n", static_memory_size? "" : "\n    0");
+    }
+
+    fprintf(output,
+        "static inline int vpu_syscall(VPU* vpu, uint64_t id){\n"
+        "    if(virtual_syscall(vpu, id)){\n"
+        "        fprintf(stderr, \"Syscall Failed At IP %%\"PRIu64\"\\n\", GET_REG(vpu->register_space, RIP)->as_uint64);\n"
+        "        vpu->status = 1;\n"
+        "        return 1;\n"
+        "    }\n"
+        "    return 0;\n"
+        "}\n"
+        "\n"
+        "#define REG(OFFSET) (*(Register*)(registers + (OFFSET)))\n"
+        "#define SP REG(RSP).as_uint64\n"
+        "#define IP REG(RIP).as_uint64\n"
+        "\n"
+    );
+
+    const uint64_t chunk_count = (program_size + AOT_CHUNK_SIZE - 1) / AOT_CHUNK_SIZE;
+
+    char _buff[24];
+    char* buff[] = {&_buff[0], &_buff[8], &_buff[16]};
+    for(uint64_t c = 0; c < chunk_count; c+=1){
+        const AotChunk chunk = {c * AOT_CHUNK_SIZE, (c + 1 < chunk_count)? (c + 1) * AOT_CHUNK_SIZE : program_size};
+
+        fprintf(output,
+            "// returns 1 when the program ends or 0 when IP left the chunk\n"
+            "static int vpu_chunk%"PRIu64"(VPU* vpu){\n"
+            "\n"
+            "    uint8_t* const registers = vpu->register_space;\n"
+            "\n"
+            "dispatch:\n"
+            "    switch (IP)\n"
+            "    {\n",
+            c
+        );
+        for(uint64_t i = chunk.begin; i < chunk.end; i+=1){
+            fprintf(output, "    case %"PRIu64"u: goto I%"PRIu64";\n", i, i);
+        }
+        fprintf(output,
+            "    default: return 0;\n"
+            "    }\n"
+            "\n"
+        );
+
+        for(uint64_t i = chunk.begin; i < chunk.end; i+=1){
+            fprintf(output, "I%"PRIu64": //", i);
+            if((program[i] & 0xFF) < INST_TOTAL_COUNT || (program[i] & 0xFF) == INST_CONTAINER)
+                print_program_inst(output, program, program_size, i, buff);
+            else fprintf(output, "\tunknown instruction\n");
+            aot_emit_inst(output, program, i, program_size, chunk);
+        }
+
+        fprintf(output,
+            "    IP = %"PRIu64"u;\n"
+            "    return 0;\n"
+            "}\n"
+            "\n",
+            chunk.end
+        );
+    }
+
+    fprintf(output, "static int (*const vpu_chunks[])(VPU*) = {");
+    for(uint64_t c = 0; c < chunk_count; c+=1){
+        fprintf(output, "%svpu_chunk%"PRIu64",", (c % 8)? " " : "\n    ", c);
+    }
+    fprintf(output, "%s\n};\n\n", chunk_count? "" : "\n    NULL");
+
+    fprintf(output,
+        "static int vpu_run(VPU* vpu){\n"
+        "    uint8_t* const registers = vpu->register_space;\n"
+        "    while(IP < VPU_PROGRAM_SIZE && !vpu_chunks[IP / %uu](vpu));\n"
+        "    return vpu->status;\n"
+        "}\n"
+        "\n"
+        "#undef REG\n"
+        "#undef SP\n"
+        "#undef IP\n"
+        "\n"
+        "int main(int argc, char** argv){\n"
+        "\n"
+        "    VpuStack stack;\n"
+        "    if(create_vpu_stack(&stack, 0)) return 1;\n"
+        "    Register registers[VPU_REGISTER_SPACE_SIZE / sizeof(Register)];\n"
+        "    memset(registers, 0, sizeof(registers));\n"
+        "\n"
+        "    VPU vpu;\n"
+        "    memset(&vpu, 0, sizeof(vpu));\n"
+        "    vpu.program        = vpu_program;\n"
+        "    vpu.program_size   = VPU_PROGRAM_SIZE;\n"
+        "    vpu.static_memory  = %s;\n"
+        "    vpu.stack          = stack.base;\n"
+        "    vpu.register_space = (uint8_t*) &registers[0];\n"
+        "\n"
+        "    // sets argc and argv of the program to RA.as_int64 and RB.as_ptr, respectively\n"
+        "    registers[RA >> 3].as_int64  = argc;\n"
+        "    registers[RB >> 3].as_ptr    = (uint8_t*) argv;\n"
+        "    registers[RIP >> 3].as_uint64 = VPU_ENTRY_POINT;\n"
+        "\n"
+        "#if VPU_STACK_GUARD\n"
+        "    // the generated code does not keep IP up to date, so stack faults are reported without it\n"
+        "    arm_vpu_stack_guard(&vpu, &stack);\n"
+        "    if(sigsetjmp(vpu_stack_fault.jump, 1)){\n"
+        "        fflush(stdout);\n"
+        "        fprintf(stderr, \"[ERROR] Stack %%s (Stack Size Is %%\"PRIu64\" Bytes)\\n\",\n"
+        "            (vpu_stack_fault.kind == VPU_STACK_UNDERFLOW)? \"Underflow\" : \"Overflow\", stack.size);\n"
+        "        return 1;\n"
+        "    }\n"
+        "#endif\n"
+        "\n"
+        "    return vpu_run(&vpu);\n"
+        "}\n",
+        (unsigned int) AOT_CHUNK_SIZE, static_memory? "&(vpu_static_memory[0])" : "NULL"
+    );
+
+    return ferror(output);
+}
+
+// reads the executable in input_file and writes it as C to output_file (stdout if NULL)
+int compile_file_to_c(const char* input_file, const char* output_file){
+
+    VirtualFile vfile;
+    const char* required_fields[] = {
+        VIRTUAL_FILE_PROGRAM_FIELD_NAME,
+        NULL
+    };
+    const char* optional_fields[] = {
+        VIRTUAL_FILE_STATIC_FIELD_NAME,
+        NULL
+    };
+    if(vfopen(&vfile, input_file, required_fields, optional_fields)){
+        fprintf(stderr, "[ERROR] failed trying to open virtual file '%s'\n", input_file);
+        return 1;
+    }
+
+    const void* const program_field = get_virtual_file_field(vfile, VIRTUAL_FILE_PROGRAM_FIELD_NAME);
+
+    uint64_t entry_point;
+    uint64_t program_size;
+    const Inst* program = get_program_from_vfield(program_field, &program_size, &entry_point);
+    if(program == NULL){
+        fprintf(stderr, "[ERROR] virtual file in '%s' has corrupt program\n", input_file);
+        vfclose(vfile);
+        return 1;
+    }
+
+    const uint8_t* static_memory = (const uint8_t*) get_virtual_file_field(vfile, VIRTUAL_FILE_STATIC_FIELD_NAME);
+    uint64_t static_memory_size = 0;
+    if(static_memory){
+        static_memory_size = *(uint64_t*) static_memory;
+        static_memory_size -= sizeof(static_memory_size) + sizeof(VIRTUAL_FILE_STATIC_FIELD_NAME);
+        static_memory += sizeof(static_memory_size) + sizeof(VIRTUAL_FILE_STATIC_FIELD_NAME);
+    }
+
+    FILE* output = output_file? fopen(output_file, "w") : stdout;
+    if(!output){
+        fprintf(stderr, "[ERROR] could not open output file '%s'\n", output_file);
+        vfclose(vfile);
+        return 1;
+    }
+
+    const int status = compile_to_c(output, program, program_size, entry_point, static_memory, static_memory_size, input_file);
+    if(status){
+        fprintf(stderr, "[ERROR] could not write C translation of '%s'\n", input_file);
+    }
+
+    vfclose(vfile);
+    if(output != stdout) fclose(output);
+    return status;
+}
+
+#endif // END OF FILE VAOT_C =================================================
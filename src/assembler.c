@@ -67,24 +67,102 @@ int write_exe(const Mc_stream_t* program, const char* path, uint64_t entry_point
     return errstatus;
 }
 
-#ifdef _WIN32
-// assembles program in input_path to output_path
-int assemble(char* input_path, char* output_path, int export_labels){
+typedef struct AssembleOptions{
+    // whether the executable keeps the labels still defined by the end of the code
+    int         export_labels;
+    // compress the static memory and program (see vfsave)
+    int         compress;
+    // directory of the include cache (see include_cache.h), NULL to parse every include
+    const char* include_cache;
+    // assemble to a relocatable object (see object.h) instead of an executable
+    int         object;
+} AssembleOptions;
+
+// saves program, its instructions followed by the entry point, static_memory and, if export_labels, labels as an executable
+// \returns 0 on success or 1 otherwise
+int save_executable(const char* path, const Mc_stream_t* program, const Mc_stream_t* static_memory, const Mc_stream_t* labels,
+    int export_labels, int compress){
 
-    // changing file separator to default '/'
-    for(size_t i = 0; input_path[i]; i+=1){
-        if(input_path[i] == '\\') input_path[i] = '/';
+    VirtualFile vfile = create_virtual_file(
+        NULL,
+        is_little_endian()? VIRTUAL_FILE_INTERNAL_FLAG_IS_LITTLE_ENDIAN : 0,
+        VIRTUAL_FILE_TYPE_EXE, 0, 0, NULL, NULL
+    );
+
+    if(static_memory->size){
+        add_virtual_file_field(&vfile, VIRTUAL_FILE_STATIC_FIELD_NAME, static_memory->size, static_memory->data);
     }
-    for(size_t i = 0; output_path[i]; i+=1){
-        if(output_path[i] == '\\') output_path[i] = '/';
+    if(labels->size && export_labels){
+        add_virtual_file_field(&vfile, VIRTUAL_FILE_LABELS_FIELD_NAME, labels->size, labels->data);
     }
+    add_virtual_file_field(&vfile, VIRTUAL_FILE_PROGRAM_FIELD_NAME, program->size, program->data);
 
-#else
+    const char* compressed_fields[] = {VIRTUAL_FILE_STATIC_FIELD_NAME, VIRTUAL_FILE_PROGRAM_FIELD_NAME, NULL};
 
-// assembles program in input_path to output_path
-int assemble(const char* input_path, const char* output_path, int export_labels){
+    int status = 0;
+    if(vfsave(vfile, path, compress? compressed_fields : NULL)){
+        fprintf(stderr, "[ERROR] failed to save virtual file to '%s'\n", path);
+        status = 1;
+    }
+    vfclose(vfile);
+    return status;
+}
 
-#endif
+// saves the instructions in program, static_memory, labels and relocations as an object (see object.h)
+// \param entry_point the entry point set by %start or UINT64_MAX if the object has none
+// \returns 0 on success or 1 otherwise
+int save_object(const char* path, const Mc_stream_t* program, const Mc_stream_t* static_memory, const Mc_stream_t* labels,
+    const Mc_stream_t* relocations, uint64_t entry_point, int compress){
+
+    VirtualFile vfile = create_virtual_file(
+        NULL,
+        is_little_endian()? VIRTUAL_FILE_INTERNAL_FLAG_IS_LITTLE_ENDIAN : 0,
+        VIRTUAL_FILE_TYPE_OBJECT, 0, 0, NULL, NULL
+    );
+
+    add_virtual_file_field(&vfile, OBJECT_CODE_FIELD_NAME, program->size, program->data);
+    add_virtual_file_field(&vfile, VIRTUAL_FILE_STATIC_FIELD_NAME, static_memory->size, static_memory->data);
+    add_virtual_file_field(&vfile, VIRTUAL_FILE_LABELS_FIELD_NAME, labels->size, labels->data);
+    add_virtual_file_field(&vfile, OBJECT_RELOCATIONS_FIELD_NAME, relocations->size, relocations->data);
+    if(entry_point != UINT64_MAX){
+        add_virtual_file_field(&vfile, OBJECT_START_FIELD_NAME, sizeof(entry_point), &entry_point);
+    }
+
+    const char* compressed_fields[] = {VIRTUAL_FILE_STATIC_FIELD_NAME, OBJECT_CODE_FIELD_NAME, NULL};
+
+    int status = 0;
+    if(vfsave(vfile, path, compress? compressed_fields : NULL)){
+        fprintf(stderr, "[ERROR] failed to save virtual file to '%s'\n", path);
+        status = 1;
+    }
+    vfclose(vfile);
+    return status;
+}
+
+// what assembling one input leaves behind, see assemble_unit
+typedef struct AssembledUnit{
+    Mc_stream_t program;
+    Mc_stream_t static_memory;
+    Mc_stream_t labels;
+    Mc_stream_t relocations;
+    // UINT64_MAX for objects without %start
+    uint64_t    entry_point;
+} AssembledUnit;
+
+void destroy_assembled_unit(AssembledUnit* unit){
+    if(unit->program.data)          mc_destroy_stream(unit->program);
+    if(unit->static_memory.data)    mc_destroy_stream(unit->static_memory);
+    if(unit->labels.data)           mc_destroy_stream(unit->labels);
+    if(unit->relocations.data)      mc_destroy_stream(unit->relocations);
+    memset(unit, 0, sizeof(*unit));
+}
+
+// parses the program in input_path into unit, nothing is written to disk
+// the label index of unit->labels is released before returning so unit can be used by any thread
+// \returns 0 on success or 1 otherwise, unit has to be destroyed with destroy_assembled_unit either way
+int assemble_unit(const char* input_path, const AssembleOptions* options, AssembledUnit* unit){
+
+    memset(unit, 0, sizeof(*unit));
 
     Mc_stream_t files = mc_create_stream(1000, 0);
 
@@ -94,12 +172,15 @@ int assemble(const char* input_path, const char* output_path, int export_labels)
         return 1;
     }
 
-    Mc_stream_t program = mc_create_stream(1024 * sizeof(Inst), 8);
+    unit->program = mc_create_stream(1024 * sizeof(Inst), 8);
 
-    Mc_stream_t static_memory = mc_create_stream(0, 0);
+    unit->static_memory = mc_create_stream(0, 0);
 
-    Mc_stream_t labels = mc_create_stream(0, 0);
+    unit->labels = mc_create_stream(0, 0);
     Mc_stream_t local_labels = mc_create_stream(0, 0);
+    LocalScope local_scope = (LocalScope){.refs = mc_create_stream(0, 0), .begin = 0, .relocations = 0};
+
+    unit->relocations = mc_create_stream(0, 0);
 
     Tokenizer tokenizer = (Tokenizer){
         .data = (char*)((uint8_t*)(files.data) + sizeof(uint32_t) + *(uint32_t*)(files.data) + 1),
@@ -109,54 +190,85 @@ int assemble(const char* input_path, const char* output_path, int export_labels)
     Parser parser;
     parser.file_path = (char*)((uint8_t*)(files.data) + sizeof(uint32_t));
     parser.file_path_size = *(uint32_t*)(files.data);
-    parser.labels = &labels;
+    parser.labels = &unit->labels;
     parser.local_labels = &local_labels;
-    parser.static_memory = &static_memory;
-    parser.program = &program;
+    parser.local_scope = &local_scope;
+    parser.static_memory = &unit->static_memory;
+    parser.program = &unit->program;
     parser.tokenizer = &tokenizer;
-    parser.entry_point = 0;
-    parser.flags = export_labels? EXEFLAG_LABELS_INCLUDED : EXEFLAG_NONE;
+    // objects only have an entry point if they have %start
+    parser.entry_point = options->object? UINT64_MAX : 0;
+    parser.flags = options->export_labels? EXEFLAG_LABELS_INCLUDED : EXEFLAG_NONE;
     parser.macro_if_depth = 0;
-    
-    int status = parse_file(&parser, &files);
+    parser.include_cache = options->include_cache;
+    parser.include_record = NULL;
+    parser.relocations = options->object? &unit->relocations : NULL;
 
-    if(status) goto defer;
+    if(options->include_cache) create_include_cache(options->include_cache);
+    
+    const int status = parse_file(&parser, &files);
 
-    if(program.size % sizeof(Inst))
+    if(!status && unit->program.size % sizeof(Inst))
         VIRTUAL_DEBUG_WARN(
             "program stream does not have compatible size with Inst array, "
             "expected multiple of %i, got %"PRIu64" instead\n",
-            (int) sizeof(Inst), program.size
+            (int) sizeof(Inst), unit->program.size
         );
 
-    mc_stream(&program, &parser.entry_point, sizeof(parser.entry_point));
+    unit->entry_point = parser.entry_point;
 
-    VirtualFile vfile = create_virtual_file(
-        NULL,
-        is_little_endian()? VIRTUAL_FILE_INTERNAL_FLAG_IS_LITTLE_ENDIAN : 0,
-        VIRTUAL_FILE_TYPE_EXE, 0, 0, NULL, NULL
-    );
+    release_label_index(&unit->labels);
+    release_label_index(&local_labels);
+
+    if(local_labels.data)   mc_destroy_stream(local_labels);
+    if(local_scope.refs.data) mc_destroy_stream(local_scope.refs);
+    if(files.data)          mc_destroy_stream(files);
 
-    if(static_memory.size){
-        add_virtual_file_field(&vfile, VIRTUAL_FILE_STATIC_FIELD_NAME, static_memory.size, static_memory.data);
+    return status;
+}
+
+#ifdef _WIN32
+// assembles program in input_path to output_path
+int assemble(char* input_path, char* output_path, const AssembleOptions* options){
+
+    // changing file separator to default '/'
+    for(size_t i = 0; input_path[i]; i+=1){
+        if(input_path[i] == '\\') input_path[i] = '/';
     }
-    if(labels.size && export_labels){
-        add_virtual_file_field(&vfile, VIRTUAL_FILE_LABELS_FIELD_NAME, labels.size, labels.data);
+    for(size_t i = 0; output_path && output_path[i]; i+=1){
+        if(output_path[i] == '\\') output_path[i] = '/';
     }
-    add_virtual_file_field(&vfile, VIRTUAL_FILE_PROGRAM_FIELD_NAME, program.size, program.data);
 
-    if(vfsave(vfile, output_path? output_path : "output.out")){
-        fprintf(stderr, "[ERROR] failed to save virtual file to '%s'\n", output_path? output_path : "output.out");
-        status = 1;
+#else
+
+// assembles program in input_path to output_path
+int assemble(const char* input_path, const char* output_path, const AssembleOptions* options){
+
+#endif
+
+    AssembledUnit unit;
+
+    int status = assemble_unit(input_path, options, &unit);
+
+    if(status) goto defer;
+
+    if(options->object){
+        status = save_object(
+            output_path? output_path : "output.out", &unit.program, &unit.static_memory, &unit.labels, &unit.relocations,
+            unit.entry_point, options->compress
+        );
+        goto defer;
     }
 
+    mc_stream(&unit.program, &unit.entry_point, sizeof(unit.entry_point));
+
+    status = save_executable(
+        output_path? output_path : "output.out", &unit.program, &unit.static_memory, &unit.labels, options->export_labels, options->compress
+    );
+
     defer:
 
-    if(program.data)        mc_destroy_stream(program);
-    if(static_memory.data)  mc_destroy_stream(static_memory);
-    if(labels.data)         mc_destroy_stream(labels);
-    if(local_labels.data)   mc_destroy_stream(local_labels);
-    if(files.data)          mc_destroy_stream(files);
+    destroy_assembled_unit(&unit);
 
     return status;
 }
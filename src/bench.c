@@ -0,0 +1,711 @@
+// vpu_bench: assembles a set of micro and macro benchmarks and times every engine on them,
+// results are written as json so they can be compared across commits
+#include "system.c"
+#include "assembler.c"
+#include "core.c"
+#include <time.h>
+
+#if !defined(_WIN32) && (defined(__unix__) || defined(__APPLE__))
+    #include <unistd.h>
+    // the output of the examples is checked by pointing stdout to a temporary file
+    #define BENCH_CAPTURE_STDOUT 1
+#else
+    #define BENCH_CAPTURE_STDOUT 0
+#endif
+
+// where the micro benchmarks (bench/*.txt) and the examples are, cmake points these to the source tree
+#ifndef VPU_BENCH_DIR
+#define VPU_BENCH_DIR "bench"
+#endif
+#ifndef VPU_EXAMPLES_DIR
+#define VPU_EXAMPLES_DIR "examples"
+#endif
+
+typedef struct Benchmark{
+    const char* name;
+    // "micro" for the bench/ programs that stress a single kind of instruction, "macro" for the examples,
+    // "bulk" for the bench/ programs built around a bulk memory instruction (see bulk.c) and their VPU loops
+    const char* kind;
+    // 0 for VPU_BENCH_DIR, 1 for VPU_EXAMPLES_DIR
+    int         in_examples;
+    const char* file;
+    // the benchmark doing the same work as this one another way, listed before it, the speedup over it is reported
+    const char* baseline;
+    // how many calls to the routine it times the program makes, the time of a call is reported if it is not 0
+    uint64_t    calls;
+    // what a correct run leaves behind, an engine that gets it wrong is reported instead of timed:
+    // the value of RH when a bench/ program halts (they leave their result there), the mc_fnv1a32 of what an example prints
+    uint64_t    checksum;
+} Benchmark;
+
+static const Benchmark benchmarks[] = {
+    {.name = "dispatch",       .kind = "micro",                   .file = "hot_loop.txt",                                                     .checksum = 0x00002D7987F0D4C0},
+    {.name = "alu",            .kind = "micro",                   .file = "alu.txt",                                                          .checksum = 0x7FFCA8CD0AD1CBF0},
+    {.name = "float",          .kind = "micro",                   .file = "float.txt",                                                        .checksum = 0x413E848000000000},
+    {.name = "memory",         .kind = "micro",                   .file = "memory.txt",                                                       .checksum = 0xF427E},
+    {.name = "stack",          .kind = "micro",                   .file = "stack.txt",                                                        .checksum = 0x1E847F},
+    {.name = "call",           .kind = "micro",                   .file = "call.txt",                                                         .checksum = 0xF4240},
+    {.name = "branch",         .kind = "micro",                   .file = "branch.txt",                                                       .checksum = 0xF4240},
+    {.name = "strlen_loop",    .kind = "bulk",                    .file = "strlen_loop.txt",                                                  .checksum = 0xFFFF},
+    {.name = "strlen",         .kind = "bulk",                    .file = "strlen.txt",         .baseline = "strlen_loop",                    .checksum = 0xFFFF},
+    {.name = "memchr_loop",    .kind = "bulk",                    .file = "memchr_loop.txt",                                                  .checksum = 0xFFFF},
+    {.name = "memchr",         .kind = "bulk",                    .file = "memchr.txt",         .baseline = "memchr_loop",                    .checksum = 0xFFFF},
+    {.name = "fill_loop",      .kind = "bulk",                    .file = "fill_loop.txt",                                                    .checksum = 0xDC},
+    {.name = "fill",           .kind = "bulk",                    .file = "fill.txt",           .baseline = "fill_loop",                      .checksum = 0xDC},
+    {.name = "crc32_loop",     .kind = "bulk",                    .file = "crc32_loop.txt",                                                   .checksum = 0xA5DC8B85},
+    {.name = "crc32",          .kind = "bulk",                    .file = "crc32.txt",          .baseline = "crc32_loop",                     .checksum = 0xA5DC8B85},
+    {.name = "hash_loop",      .kind = "bulk",                    .file = "hash_loop.txt",                                                    .checksum = 0x6F390122057EE74F},
+    {.name = "hash",           .kind = "bulk",                    .file = "hash.txt",           .baseline = "hash_loop",                      .checksum = 0x6F390122057EE74F},
+    {.name = "popcount_loop",  .kind = "bulk",                    .file = "popcount_loop.txt",                                                .checksum = 0x400000},
+    {.name = "popcount",       .kind = "bulk",                    .file = "popcount.txt",       .baseline = "popcount_loop",                  .checksum = 0x400000},
+    {.name = "sqrt_soft",      .kind = "micro",                   .file = "sqrt_soft.txt",                                   .calls = 200000, .checksum = 0x20},
+    {.name = "sqrt",           .kind = "micro",                   .file = "sqrt.txt",           .baseline = "sqrt_soft",     .calls = 200000, .checksum = 0x20},
+    {.name = "counter_mutex",  .kind = "micro",                   .file = "counter_mutex.txt",                               .calls = 200000, .checksum = 0x30D40},
+    {.name = "counter_atomic", .kind = "micro",                   .file = "counter_atomic.txt", .baseline = "counter_mutex", .calls = 200000, .checksum = 0x30D40},
+    {.name = "primes",         .kind = "macro", .in_examples = 1, .file = "primes.txt",                                                       .checksum = 0x7A9BCE4A},
+    {.name = "eulers_number",  .kind = "macro", .in_examples = 1, .file = "eulers_number.txt",                                                .checksum = 0x08891C59},
+    {.name = "rule110",        .kind = "macro", .in_examples = 1, .file = "rule110.txt",                                                      .checksum = 0x23A037E9},
+    {.name = "Q_rsqrt",        .kind = "macro", .in_examples = 1, .file = "Q_rsqrt.txt",                                                      .checksum = 0x1371735C},
+};
+
+#define BENCHMARK_COUNT (sizeof(benchmarks) / sizeof(benchmarks[0]))
+
+// the shortest a timed sample can be, see main
+#define BENCH_MIN_SAMPLE_SECONDS 0.02
+
+// the static memory size of the executable the load benchmark loads
+#define BENCH_LOAD_STATIC_SIZE (32 * 1024 * 1024)
+
+typedef struct BenchResult{
+    double  seconds;
+    int     status;
+} BenchResult;
+
+static uint64_t bench_stack[1000];
+static Register bench_registers[VPU_REGISTER_SPACE_SIZE / sizeof(Register)];
+
+// puts vpu back in the state execute leaves it in right before running the program
+static inline void reset_vpu(VPU* vpu, char** argv){
+    memset(bench_stack, 0, sizeof(bench_stack));
+    memset(bench_registers, 0, sizeof(bench_registers));
+    bench_registers[RA >> 3].as_int64 = 1;
+    bench_registers[RB >> 3].as_ptr   = (uint8_t*) argv;
+    vpu->stack = &bench_stack[0];
+    vpu->register_space = (uint8_t*) &bench_registers[0];
+    vpu->system = NULL;
+    vpu->status = 0;
+}
+
+// runs the program once with the reference loop to know how many instructions it executes
+static uint64_t count_instructions(VPU* vpu, uint64_t program_size, uint64_t entry_point){
+    Register* const registers = (Register*) vpu->register_space;
+    uint64_t count = 0;
+    for(
+        registers[RIP >> 3].as_uint64 = entry_point;
+        registers[RIP >> 3].as_uint64 < program_size;
+        registers[RIP >> 3].as_int64 += perform_inst(vpu, vpu->program[registers[RIP >> 3].as_uint64])
+    ) count += 1;
+    return count;
+}
+
+// points stdout to a temporary file until end_stdout_capture
+// \returns the file or NULL if it could not
+static FILE* begin_stdout_capture(int* saved_stdout){
+#if BENCH_CAPTURE_STDOUT
+    FILE* const capture = tmpfile();
+    if(!capture) return NULL;
+    fflush(stdout);
+    *saved_stdout = dup(STDOUT_FILENO);
+    if(*saved_stdout < 0 || dup2(fileno(capture), STDOUT_FILENO) < 0){
+        if(*saved_stdout >= 0) close(*saved_stdout);
+        fclose(capture);
+        return NULL;
+    }
+    return capture;
+#else
+    (void) saved_stdout;
+    return NULL;
+#endif
+}
+
+// points stdout back to where it was before begin_stdout_capture
+// \returns the mc_fnv1a32 of what was written to it in the meantime
+static uint32_t end_stdout_capture(FILE* capture, int saved_stdout){
+    uint32_t hash = MC_FNV1A32_OFFSET_BASIS;
+#if BENCH_CAPTURE_STDOUT
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+    rewind(capture);
+    uint8_t buffer[4096];
+    size_t size;
+    while((size = fread(buffer, 1, sizeof(buffer), capture)) > 0) hash = mc_fnv1a32(hash, buffer, size);
+    fclose(capture);
+#else
+    (void) capture;
+    (void) saved_stdout;
+#endif
+    return hash;
+}
+
+// runs the program once with the engine in options, or with the reference loop if options is NULL (setting instructions),
+// and compares what it leaves behind with the benchmark's checksum
+// \returns 1 if the run failed or the checksums differ
+static int check_benchmark(
+    VPU* vpu, char** argv, const Benchmark* benchmark, uint64_t program_size, uint64_t entry_point,
+    const ExecuteOptions* options, uint64_t* instructions
+){
+    int saved_stdout = -1;
+    FILE* const capture = benchmark->in_examples? begin_stdout_capture(&saved_stdout) : NULL;
+    reset_vpu(vpu, argv);
+    int err = 0;
+    if(options) err = run_program(vpu, program_size, entry_point, options, argv[0]);
+    else *instructions = count_instructions(vpu, program_size, entry_point);
+    const uint64_t checksum = capture? end_stdout_capture(capture, saved_stdout) : ((Register*) vpu->register_space)[RH >> 3].as_uint64;
+    if(err) return 1;
+    // without a way to capture stdout the examples can not be checked
+    if(benchmark->in_examples && !capture) return 0;
+    if(checksum != benchmark->checksum){
+        fprintf(stderr,
+            "[ERROR] Benchmark '%s' Ended With Checksum 0x%"PRIx64" On Engine '%s', Expected 0x%"PRIx64"\n",
+            benchmark->name, checksum, options? get_engine_str(options->engine) : "reference", benchmark->checksum
+        );
+        return 1;
+    }
+    return 0;
+}
+
+static double wall_clock(void){
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (double) now.tv_sec + (double) now.tv_nsec * 1e-9;
+}
+
+// asks the kernel to forget the cached pages of path so the next load reads it from the disk
+// \returns 1 if it could
+static int drop_from_page_cache(const char* path){
+#if VIRTUAL_FILE_MMAP && defined(POSIX_FADV_DONTNEED)
+    const int fd = open(path, O_RDONLY);
+    if(fd < 0) return 0;
+    // dirty pages are not dropped
+    fdatasync(fd);
+    const int dropped = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(fd);
+    return dropped;
+#else
+    (void) path;
+    return 0;
+#endif
+}
+
+typedef int (*BenchLoader)(VirtualFile* vfile, const char* path, const char** required_fields, const char** optional_fields);
+
+// loads the executable at path and reads all of its static memory, as running a program that uses it would
+// \returns the time it took or a negative number if it failed
+static double time_load(BenchLoader loader, const char* path, uint64_t* sum){
+    VirtualFile vfile;
+    const char* required_fields[] = {VIRTUAL_FILE_PROGRAM_FIELD_NAME, VIRTUAL_FILE_STATIC_FIELD_NAME, NULL};
+    const char* optional_fields[] = {NULL};
+    const double begin = wall_clock();
+    if(loader(&vfile, path, required_fields, optional_fields)) return -1.0;
+    const uint8_t* const field = (const uint8_t*) get_virtual_file_field(vfile, VIRTUAL_FILE_STATIC_FIELD_NAME);
+    const uint64_t field_size = *(const uint64_t*) field;
+    for(uint64_t i = sizeof(uint64_t) + sizeof(VIRTUAL_FILE_STATIC_FIELD_NAME); i < field_size; i += 512) *sum += field[i];
+    vfclose(vfile);
+    return wall_clock() - begin;
+}
+
+// times loading an executable with a large static memory stored as is and compressed,
+// the static memory looks like a framebuffer's initial data followed by a table of noise
+static int bench_load(FILE* output, int runs){
+
+    uint8_t* const static_memory = (uint8_t*) malloc(BENCH_LOAD_STATIC_SIZE);
+    if(!static_memory){
+        fprintf(stderr, "[ERROR] Could Not Allocate The Load Benchmark's Static Memory\n");
+        return 1;
+    }
+    const uint64_t noise_begin = BENCH_LOAD_STATIC_SIZE - BENCH_LOAD_STATIC_SIZE / 8;
+    uint32_t state = 0x12345678;
+    for(uint64_t i = 0; i < BENCH_LOAD_STATIC_SIZE / sizeof(uint32_t); i+=1){
+        const uint64_t x = i % 1024, y = i / 1024;
+        uint32_t pixel = 0xFF000000u | (uint32_t) ((y % 256) << 16) | (uint32_t) ((x / 4) << 8) | (uint32_t) ((x ^ y) & 0xC0);
+        if(i * sizeof(uint32_t) >= noise_begin){
+            state ^= state << 13; state ^= state >> 17; state ^= state << 5;
+            pixel = state;
+        }
+        memcpy(static_memory + i * sizeof(uint32_t), &pixel, sizeof(pixel));
+    }
+    // an empty program, only its entry point
+    const uint64_t program[1] = {0};
+
+    const char* const paths[] = {"vpu_bench_load.out", "vpu_bench_load_lz.out"};
+    const char* compressed_fields[] = {VIRTUAL_FILE_STATIC_FIELD_NAME, VIRTUAL_FILE_PROGRAM_FIELD_NAME, NULL};
+
+    int err = 0;
+    for(int compressed = 0; compressed < 2 && !err; compressed+=1){
+        VirtualFile vfile = create_virtual_file(
+            NULL, is_little_endian()? VIRTUAL_FILE_INTERNAL_FLAG_IS_LITTLE_ENDIAN : 0, VIRTUAL_FILE_TYPE_EXE, 0, 0, NULL, NULL
+        );
+        add_virtual_file_field(&vfile, VIRTUAL_FILE_STATIC_FIELD_NAME, BENCH_LOAD_STATIC_SIZE, static_memory);
+        add_virtual_file_field(&vfile, VIRTUAL_FILE_PROGRAM_FIELD_NAME, sizeof(program), (void*) program);
+        err = vfsave(vfile, paths[compressed], compressed? compressed_fields : NULL);
+        vfclose(vfile);
+    }
+    free(static_memory);
+
+    if(err){
+        fprintf(stderr, "[ERROR] Could Not Write The Load Benchmark's Executables\n");
+        remove(paths[0]);
+        remove(paths[1]);
+        return 1;
+    }
+
+    static const struct{
+        const char* name;
+        BenchLoader loader;
+    } loaders[] = {{"vfmap", vfmap}, {"vfopen", vfopen}};
+
+    int cold = 1;
+    uint64_t sum = 0;
+
+    fprintf(output, ",\n    \"load\": {\n        \"static_bytes\": %"PRIu64",\n        \"files\": [", (uint64_t) BENCH_LOAD_STATIC_SIZE);
+
+    for(int compressed = 0; compressed < 2 && !err; compressed+=1){
+        FILE* const f = fopen(paths[compressed], "rb");
+        long file_size = -1;
+        if(f){
+            fseek(f, 0, SEEK_END);
+            file_size = ftell(f);
+            fclose(f);
+        }
+        fprintf(output,
+            "%s\n            {\n                \"name\": \"%s\",\n                \"bytes\": %li,\n                \"results\": [",
+            compressed? "," : "", compressed? "lz" : "raw", file_size
+        );
+        for(size_t l = 0; l < sizeof(loaders) / sizeof(loaders[0]) && !err; l+=1){
+            double best = -1.0;
+            for(int r = 0; r < runs; r+=1){
+                cold &= drop_from_page_cache(paths[compressed]);
+                const double seconds = time_load(loaders[l].loader, paths[compressed], &sum);
+                if(seconds < 0.0){
+                    err = 1;
+                    break;
+                }
+                if(best < 0.0 || seconds < best) best = seconds;
+            }
+            if(err) break;
+            fprintf(output, "%s\n                    {\"loader\": \"%s\", \"seconds\": %.6f}", l? "," : "", loaders[l].name, best);
+            fprintf(stderr, "[BENCH] load %-4s %-7s %10li bytes %10.3f ms\n", compressed? "lz" : "raw", loaders[l].name, file_size, best * 1e3);
+        }
+        fprintf(output, "\n                ]\n            }");
+    }
+
+    // the sum is only there so reading the static memory is not optimized away
+    fprintf(output, "\n        ],\n        \"cold_cache\": %s,\n        \"checksum\": %"PRIu64"\n    }", cold? "true" : "false", sum);
+
+    if(!cold) fprintf(stderr, "[WARNING] Could Not Drop The Load Benchmark's Files From The Page Cache, Load Times Are Warm\n");
+
+    remove(paths[0]);
+    remove(paths[1]);
+    return err;
+}
+
+// the labels in the assembler benchmark's source, half of them %label and half %enum entries
+#define BENCH_ASSEMBLER_LABELS 100000
+
+// times assembling a generated source with BENCH_ASSEMBLER_LABELS labels, each referenced once
+static int bench_assembler(FILE* output, int runs){
+    const char* const source = "vpu_bench_labels.txt";
+    const char* const executable = "vpu_bench_labels.out";
+
+    FILE* f = fopen(source, "w");
+    if(!f){
+        fprintf(stderr, "[ERROR] Could Not Write The Assembler Benchmark's Source '%s'\n", source);
+        return 1;
+    }
+    const int half = BENCH_ASSEMBLER_LABELS / 2;
+    for(int i = 0; i < half; i+=1) fprintf(f, "%%label LABEL_%i %i\n", i, i % 1000);
+    fprintf(f, "%%enum\n");
+    for(int i = 0; i < half; i+=1) fprintf(f, "    ENUM_%i\n", i);
+    fprintf(f, "%%endenum\n");
+    for(int i = 0; i < half; i+=1) fprintf(f, "    MOVV RA $LABEL_%i\n    MOVV RB $ENUM_%i\n", i, i % 1000);
+    const long source_size = ftell(f);
+    fclose(f);
+
+    int err = 0;
+    double best = -1.0;
+    for(int r = 0; r < runs; r+=1){
+        const double begin = wall_clock();
+        if(assemble(source, executable, &(AssembleOptions){.export_labels = 1})){
+            fprintf(stderr, "[ERROR] Could Not Assemble The Assembler Benchmark's Source\n");
+            err = 1;
+            break;
+        }
+        const double seconds = wall_clock() - begin;
+        if(best < 0.0 || seconds < best) best = seconds;
+    }
+    remove(source);
+    remove(executable);
+    if(err) return 1;
+
+    fprintf(output,
+        ",\n    \"assembler\": {\"labels\": %i, \"source_bytes\": %li, \"seconds\": %.6f, \"labels_per_second\": %.0f}",
+        BENCH_ASSEMBLER_LABELS, source_size, best, (double) BENCH_ASSEMBLER_LABELS / best
+    );
+    fprintf(stderr, "[BENCH] assembler %i labels %10.3f ms\n", BENCH_ASSEMBLER_LABELS, best * 1e3);
+    return 0;
+}
+
+// the size of the lexer benchmark's source
+#define BENCH_LEXER_SOURCE_SIZE (16 * 1024 * 1024)
+
+// writes a source of about size bytes that looks like what people write, labels, instructions, literals, strings and comments
+static char* generate_lexer_source(uint64_t size, uint64_t* written){
+    static const char* const lines[] = {
+        "label_%"PRIu64":\n",
+        "    MOVV RA %"PRIu64"\n",
+        "    ADD RB RA RC ; running sum\n",
+        "    MOV8 RD1 RSP\n",
+        "    STATIC \"line %"PRIu64" says \\\"hi\\\"\\n\"\n",
+        "    JMPF RA @label_%"PRIu64"\n",
+        "%%label CONSTANT_%"PRIu64" 0x%"PRIx64"\n",
+        "    STACK_GET RE 3\n",
+        "    CASTFI RF RG\n",
+        "    CALL $label_%"PRIu64"\n",
+        "    MOVV RH 'x'\n",
+        "; a comment on its own line\n",
+    };
+    const uint64_t line_count = sizeof(lines) / sizeof(lines[0]);
+    char* const source = (char*) malloc((size_t) size + 128);
+    if(!source) return NULL;
+    uint64_t pos = 0;
+    for(uint64_t i = 0; pos < size; i+=1){
+        const int n = snprintf(source + pos, 128, lines[i % line_count], i / line_count, i / line_count);
+        if(n < 0) break;
+        pos += (uint64_t) n;
+    }
+    source[pos] = '\0';
+    *written = pos;
+    return source;
+}
+
+// times get_next_token on a generated source, alone and with every raw token looked up as a mnemonic and as a register
+static int bench_lexer(FILE* output, int runs){
+    uint64_t size = 0;
+    char* const source = generate_lexer_source(BENCH_LEXER_SOURCE_SIZE, &size);
+    char* const copy = (char*) malloc((size_t) size + 1);
+    if(!source || !copy){
+        fprintf(stderr, "[ERROR] Could Not Allocate The Lexer Benchmark's Source\n");
+        free(source);
+        free(copy);
+        return 1;
+    }
+
+    double best[2] = {-1.0, -1.0};
+    uint64_t tokens = 0;
+    uint64_t keywords = 0;
+    for(int pass = 0; pass < 2; pass+=1){
+        for(int r = 0; r < runs; r+=1){
+            // strings are unescaped in place, so every run gets a fresh copy
+            memcpy(copy, source, (size_t) size + 1);
+            Tokenizer tokenizer = (Tokenizer){.data = copy, .line = 0, .column = 0, .pos = 0};
+            tokens = 0;
+            keywords = 0;
+            const double begin = wall_clock();
+            for(Token token = get_next_token(&tokenizer); token.type != TKN_NONE; token = get_next_token(&tokenizer)){
+                tokens += 1;
+                if(pass && token.type == TKN_RAW){
+                    keywords += (get_inst_profile(token).opcode != INST_ERROR) || (get_reg(token) >= 0);
+                }
+            }
+            const double seconds = wall_clock() - begin;
+            if(best[pass] < 0.0 || seconds < best[pass]) best[pass] = seconds;
+        }
+    }
+    free(source);
+    free(copy);
+
+    const double mb = (double) size / (1024.0 * 1024.0);
+    fprintf(output,
+        ",\n    \"lexer\": {\"source_bytes\": %"PRIu64", \"tokens\": %"PRIu64", \"keywords\": %"PRIu64", "
+        "\"tokenize_seconds\": %.6f, \"tokenize_mb_per_second\": %.2f, \"lookup_seconds\": %.6f, \"lookup_mb_per_second\": %.2f}",
+        size, tokens, keywords, best[0], mb / best[0], best[1], mb / best[1]
+    );
+    fprintf(stderr, "[BENCH] lexer tokenize %10.2f MB/s, with keyword lookups %10.2f MB/s\n", mb / best[0], mb / best[1]);
+    return 0;
+}
+
+static void help(const char* main_executable){
+    printf(
+        "Usage: %s [options] [benchmark names]\n"
+        "Functionality: times every engine on the micro benchmarks in bench/ and on some of the examples,\n"
+        "reports ns/instruction and MIPS as json. With no benchmark names every benchmark runs.\n"
+        "Every engine first runs each program once and its result is checked, an engine that gets it wrong is not timed.\n"
+        "Each bulk memory instruction benchmark (strlen, memchr, fill, crc32, hash, popcount) has a <name>_loop twin doing\n"
+        "the same work with a VPU loop, the bulk one reports how many times faster than its twin it is when both run.\n"
+        "The 'sqrt' benchmark reports the latency of a call to vmath.in's sqrt, 'sqrt_soft' the one of its software version.\n"
+        "The 'counter_atomic' benchmark reports the time of an AADD to a counter shared by 4 threads, 'counter_mutex' the one of\n"
+        "an increment under a mutex.\n"
+        "The 'load' benchmark times loading a large executable stored as is and compressed, on a cold page cache.\n"
+        "The 'assembler' benchmark times assembling a generated source with 100000 labels.\n"
+        "The 'lexer' benchmark reports how many MB/s of a generated 16MB source the lexer tokenizes.\n"
+        "Options:\n"
+        "   --help:             displays this help message\n"
+        "   -o <output>:        write the json results to <output> (default vpu_bench.json, '-' for stdout)\n"
+        "   -runs <n>:          time each engine <n> times and keep the fastest run (default 3)\n"
+        "   -engine <name>:     only time engine <name> ('switch', 'threaded' or 'jit'), can be repeated\n"
+        "   -bench-dir <dir>:   where the micro benchmarks are (default " VPU_BENCH_DIR ")\n"
+        "   -examples-dir <dir>: where the examples are (default " VPU_EXAMPLES_DIR ")\n",
+        main_executable
+    );
+}
+
+int main(int argc, char** argv){
+
+    // the macro benchmarks print to stdout, so the results go to a file by default
+    const char* output_path  = "vpu_bench.json";
+    const char* bench_dir    = VPU_BENCH_DIR;
+    const char* examples_dir = VPU_EXAMPLES_DIR;
+    int runs = 3;
+    int engines[VPU_ENGINE_COUNT] = {0};
+    int engine_filter = 0;
+    int selected[BENCHMARK_COUNT] = {0};
+    int benchmark_filter = 0;
+    int load_selected = 0;
+    int assembler_selected = 0;
+    int lexer_selected = 0;
+
+    for(int i = 1; i < argc; i++){
+        if(mc_compare_str(argv[i], "--help", 0)){
+            help(argv[0]);
+            return 0;
+        }
+        if(mc_compare_str(argv[i], "-o", 0) || mc_compare_str(argv[i], "-runs", 0) || mc_compare_str(argv[i], "-engine", 0) ||
+           mc_compare_str(argv[i], "-bench-dir", 0) || mc_compare_str(argv[i], "-examples-dir", 0)){
+            if(i + 1 >= argc){
+                fprintf(stderr, "[ERROR] Missing Argument After '%s'\n", argv[i]);
+                return 1;
+            }
+            const char* const option = argv[i++];
+            if(mc_compare_str(option, "-o", 0))                  output_path  = argv[i];
+            else if(mc_compare_str(option, "-bench-dir", 0))     bench_dir    = argv[i];
+            else if(mc_compare_str(option, "-examples-dir", 0))  examples_dir = argv[i];
+            else if(mc_compare_str(option, "-runs", 0)){
+                runs = atoi(argv[i]);
+                if(runs < 1){
+                    fprintf(stderr, "[ERROR] Invalid Number Of Runs '%s'\n", argv[i]);
+                    return 1;
+                }
+            }
+            else{
+                int found = 0;
+                for(int e = 0; e < VPU_ENGINE_COUNT; e+=1){
+                    if(mc_compare_str(argv[i], get_engine_str((VpuEngine) e), 0)){
+                        engines[e] = 1;
+                        found = 1;
+                    }
+                }
+                if(!found){
+                    fprintf(stderr, "[ERROR] Unknown Engine '%s', Expected 'switch', 'threaded' Or 'jit'\n", argv[i]);
+                    return 1;
+                }
+                engine_filter = 1;
+            }
+            continue;
+        }
+        int found = 0;
+        if(mc_compare_str(argv[i], "load", 0)){
+            load_selected = 1;
+            found = 1;
+        }
+        if(mc_compare_str(argv[i], "assembler", 0)){
+            assembler_selected = 1;
+            found = 1;
+        }
+        if(mc_compare_str(argv[i], "lexer", 0)){
+            lexer_selected = 1;
+            found = 1;
+        }
+        for(size_t b = 0; b < BENCHMARK_COUNT; b+=1){
+            if(mc_compare_str(argv[i], benchmarks[b].name, 0)){
+                selected[b] = 1;
+                found = 1;
+            }
+        }
+        if(!found){
+            fprintf(stderr, "[ERROR] Unknown Benchmark '%s'\n", argv[i]);
+            return 1;
+        }
+        benchmark_filter = 1;
+    }
+
+    for(int e = 0; e < VPU_ENGINE_COUNT; e+=1){
+        if(!engine_filter) engines[e] = 1;
+    }
+#if !VPU_JIT_SUPPORTED
+    // execute would fall back to the threaded engine and report it as the jit
+    engines[VPU_ENGINE_JIT] = 0;
+#endif
+
+    FILE* output = mc_compare_str(output_path, "-", 0)? stdout : fopen(output_path, "w");
+    if(!output){
+        fprintf(stderr, "[ERROR] Could Not Open '%s'\n", output_path);
+        return 1;
+    }
+
+    fprintf(output, "{\n    \"version\": \"%s\",\n    \"runs\": %i,\n    \"benchmarks\": [", VERSION, runs);
+
+    int err = 0;
+    int first_benchmark = 1;
+
+    // the fastest time of every benchmark on every engine, for the speedups over the baselines
+    double best_seconds[BENCHMARK_COUNT][VPU_ENGINE_COUNT];
+    for(size_t b = 0; b < BENCHMARK_COUNT; b+=1){
+        for(int e = 0; e < VPU_ENGINE_COUNT; e+=1) best_seconds[b][e] = -1.0;
+    }
+
+    for(size_t b = 0; b < BENCHMARK_COUNT; b+=1){
+        if(benchmark_filter && !selected[b]) continue;
+
+        const Benchmark* const benchmark = &benchmarks[b];
+
+        char source[1024];
+        char executable[1024];
+        snprintf(source, sizeof(source), "%s/%s", benchmark->in_examples? examples_dir : bench_dir, benchmark->file);
+        snprintf(executable, sizeof(executable), "vpu_bench_%s.out", benchmark->name);
+
+        if(assemble(source, executable, &(AssembleOptions){.export_labels = 0})){
+            fprintf(stderr, "[ERROR] Could Not Assemble Benchmark '%s' From '%s'\n", benchmark->name, source);
+            err = 1;
+            continue;
+        }
+
+        VirtualFile vfile;
+        const char* required_fields[] = {VIRTUAL_FILE_PROGRAM_FIELD_NAME, NULL};
+        const char* optional_fields[] = {VIRTUAL_FILE_STATIC_FIELD_NAME, NULL};
+        if(vfmap(&vfile, executable, required_fields, optional_fields)){
+            fprintf(stderr, "[ERROR] Failed Trying To Open Virtual File '%s'\n", executable);
+            remove(executable);
+            err = 1;
+            continue;
+        }
+
+        VPU vpu;
+        uint64_t entry_point;
+        uint64_t program_size;
+        vpu.program = get_program_from_vfield(get_virtual_file_field(vfile, VIRTUAL_FILE_PROGRAM_FIELD_NAME), &program_size, &entry_point);
+        vpu.program_size = program_size;
+        vpu.static_memory = (uint8_t*) get_virtual_file_field(vfile, VIRTUAL_FILE_STATIC_FIELD_NAME);
+        if(vpu.static_memory){
+            vpu.static_memory = (uint8_t*) (((uintptr_t) vpu.static_memory) + sizeof(uint64_t) + sizeof(VIRTUAL_FILE_STATIC_FIELD_NAME));
+        }
+
+        char* vpu_argv[] = {source, NULL};
+
+        uint64_t instructions = 0;
+        if(check_benchmark(&vpu, vpu_argv, benchmark, program_size, entry_point, NULL, &instructions)){
+            vfclose(vfile);
+            remove(executable);
+            err = 1;
+            continue;
+        }
+
+        BenchResult results[VPU_ENGINE_COUNT];
+
+        for(int e = 0; e < VPU_ENGINE_COUNT; e+=1){
+            if(!engines[e]) continue;
+            const ExecuteOptions options = {.engine = (VpuEngine) e, .stats = 0};
+            results[e] = (BenchResult){.seconds = -1.0, .status = 0};
+            // an engine that gets the program wrong is not timed, so it can not report a fast result
+            if(check_benchmark(&vpu, vpu_argv, benchmark, program_size, entry_point, &options, NULL)){
+                err = 1;
+                continue;
+            }
+            for(int r = 0; r < runs && !err; r+=1){
+                // the examples finish way faster than clock's resolution, so short programs are repeated
+                // until the sample is long enough and the time of a single execution is averaged out of it
+                uint64_t repetitions = 0;
+                double elapsed = 0.0;
+                const clock_t begin = clock();
+                do{
+                    reset_vpu(&vpu, vpu_argv);
+                    if(run_program(&vpu, program_size, entry_point, &options, source)){
+                        err = 1;
+                        break;
+                    }
+                    repetitions += 1;
+                    elapsed = (double) (clock() - begin) / (double) CLOCKS_PER_SEC;
+                } while(elapsed < BENCH_MIN_SAMPLE_SECONDS);
+                if(err) break;
+                elapsed /= (double) repetitions;
+                results[e].status = vpu.status;
+                if(results[e].seconds < 0.0 || elapsed < results[e].seconds) results[e].seconds = elapsed;
+            }
+        }
+
+        vfclose(vfile);
+        remove(executable);
+
+        fflush(stdout);
+
+        size_t baseline = BENCHMARK_COUNT;
+        for(size_t other = 0; benchmark->baseline && other < b; other+=1){
+            if(mc_compare_str(benchmarks[other].name, benchmark->baseline, 0)) baseline = other;
+        }
+
+        fprintf(output,
+            "%s\n        {\n            \"name\": \"%s\",\n            \"kind\": \"%s\",\n",
+            first_benchmark? "" : ",", benchmark->name, benchmark->kind
+        );
+        if(benchmark->baseline) fprintf(output, "            \"baseline\": \"%s\",\n", benchmark->baseline);
+        fprintf(output, "            \"instructions\": %"PRIu64",\n            \"results\": [", instructions);
+        first_benchmark = 0;
+
+        int first_result = 1;
+        for(int e = 0; e < VPU_ENGINE_COUNT; e+=1){
+            if(!engines[e] || results[e].seconds < 0.0) continue;
+            best_seconds[b][e] = results[e].seconds;
+            const double seconds = (results[e].seconds > 0.0)? results[e].seconds : 1e-9;
+            const double ns_per_inst = (instructions)? seconds * 1e9 / (double) instructions : 0.0;
+            const double mips = (double) instructions / seconds / 1e6;
+            fprintf(output,
+                "%s\n                {\"engine\": \"%s\", \"seconds\": %.6f, \"ns_per_inst\": %.3f, \"mips\": %.2f, \"status\": %i",
+                first_result? "" : ",", get_engine_str((VpuEngine) e), results[e].seconds, ns_per_inst, mips, results[e].status
+            );
+            fprintf(stderr, "[BENCH] %-14s %-9s %10.3f ns/inst %10.2f MIPS", benchmark->name, get_engine_str((VpuEngine) e), ns_per_inst, mips);
+            if(benchmark->calls){
+                const double ns_per_call = seconds * 1e9 / (double) benchmark->calls;
+                fprintf(output, ", \"ns_per_call\": %.3f", ns_per_call);
+                fprintf(stderr, " %10.3f ns/call", ns_per_call);
+            }
+            // the baseline may not have run (filtered out or failed)
+            if(baseline < BENCHMARK_COUNT && best_seconds[baseline][e] >= 0.0){
+                const double speedup = best_seconds[baseline][e] / seconds;
+                fprintf(output, ", \"speedup\": %.2f", speedup);
+                fprintf(stderr, " %10.1fx faster than %s", speedup, benchmark->baseline);
+            }
+            fprintf(output, "}");
+            fprintf(stderr, "\n");
+            first_result = 0;
+        }
+        fprintf(output, "\n            ]\n        }");
+    }
+
+    fprintf(output, "\n    ]");
+
+    if(!benchmark_filter || load_selected){
+        err |= bench_load(output, runs);
+    }
+    if(!benchmark_filter || assembler_selected){
+        err |= bench_assembler(output, runs);
+    }
+    if(!benchmark_filter || lexer_selected){
+        err |= bench_lexer(output, runs);
+    }
+
+    fprintf(output, "\n}\n");
+
+    if(output != stdout) fclose(output);
+
+    return err;
+}
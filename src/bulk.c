@@ -0,0 +1,235 @@
+#ifndef VBULK_C
+#define VBULK_C
+
+/*
+ * bulk memory instructions:
+ * the host kernels behind MSTRLEN, MCHR, MFILL32, MFILL64, MCRC32, MHASH and MPOPCNT, each does over a whole range
+ * what would otherwise be a loop of VPU instructions per byte or per element.
+ * MSTRLEN and MCHR are strlen and memchr, the C libraries already vectorize them.
+ * the fills and MPOPCNT go 16 bytes at a time with SSE2 (see VPU_SSE2 in vector.c), MPOPCNT with the SSSE3 nibble
+ * table when the compiler targets it. MCRC32 is CRC-32C (Castagnoli, the polynomial of SSE4.2's crc32 instruction),
+ * it uses that instruction when the processor has it, even if the compiler does not target it, and a table otherwise.
+ * MHASH is XXH64, its 4 independent lanes already keep a processor busy without SIMD.
+ * with VPU_NO_SIMD defined, or off x86, every kernel is plain C, the results are the same either way.
+ */
+
+#include "core.h"
+#include "vector.c"
+#include <string.h>
+
+#if !defined(VPU_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+    // the crc32 instruction is picked at run time, see bulk_crc32c
+    #define VPU_CRC32C_DISPATCH 1
+    #include <nmmintrin.h>
+#else
+    #define VPU_CRC32C_DISPATCH 0
+#endif
+
+// sets count uint32_t at destination to value
+static void bulk_fill32(void* destination, uint32_t value, uint64_t count){
+    uint8_t* d = (uint8_t*) destination;
+#if VPU_SSE2
+    const __m128i x = _mm_set1_epi32((int) value);
+    for(; count >= 8; count -= 8, d += 32){
+        VSTOREI(d, x);
+        VSTOREI(d + 16, x);
+    }
+#endif
+    for(; count; count -= 1, d += sizeof(value)) memcpy(d, &value, sizeof(value));
+}
+
+// sets count uint64_t at destination to value
+static void bulk_fill64(void* destination, uint64_t value, uint64_t count){
+    uint8_t* d = (uint8_t*) destination;
+#if VPU_SSE2
+    const __m128i x = _mm_set1_epi64x((long long) value);
+    for(; count >= 4; count -= 4, d += 32){
+        VSTOREI(d, x);
+        VSTOREI(d + 16, x);
+    }
+#endif
+    for(; count; count -= 1, d += sizeof(value)) memcpy(d, &value, sizeof(value));
+}
+
+static const uint32_t bulk_crc32c_table[256] = {
+    0x00000000, 0xF26B8303, 0xE13B70F7, 0x1350F3F4, 0xC79A971F, 0x35F1141C, 0x26A1E7E8, 0xD4CA64EB,
+    0x8AD958CF, 0x78B2DBCC, 0x6BE22838, 0x9989AB3B, 0x4D43CFD0, 0xBF284CD3, 0xAC78BF27, 0x5E133C24,
+    0x105EC76F, 0xE235446C, 0xF165B798, 0x030E349B, 0xD7C45070, 0x25AFD373, 0x36FF2087, 0xC494A384,
+    0x9A879FA0, 0x68EC1CA3, 0x7BBCEF57, 0x89D76C54, 0x5D1D08BF, 0xAF768BBC, 0xBC267848, 0x4E4DFB4B,
+    0x20BD8EDE, 0xD2D60DDD, 0xC186FE29, 0x33ED7D2A, 0xE72719C1, 0x154C9AC2, 0x061C6936, 0xF477EA35,
+    0xAA64D611, 0x580F5512, 0x4B5FA6E6, 0xB93425E5, 0x6DFE410E, 0x9F95C20D, 0x8CC531F9, 0x7EAEB2FA,
+    0x30E349B1, 0xC288CAB2, 0xD1D83946, 0x23B3BA45, 0xF779DEAE, 0x05125DAD, 0x1642AE59, 0xE4292D5A,
+    0xBA3A117E, 0x4851927D, 0x5B016189, 0xA96AE28A, 0x7DA08661, 0x8FCB0562, 0x9C9BF696, 0x6EF07595,
+    0x417B1DBC, 0xB3109EBF, 0xA0406D4B, 0x522BEE48, 0x86E18AA3, 0x748A09A0, 0x67DAFA54, 0x95B17957,
+    0xCBA24573, 0x39C9C670, 0x2A993584, 0xD8F2B687, 0x0C38D26C, 0xFE53516F, 0xED03A29B, 0x1F682198,
+    0x5125DAD3, 0xA34E59D0, 0xB01EAA24, 0x42752927, 0x96BF4DCC, 0x64D4CECF, 0x77843D3B, 0x85EFBE38,
+    0xDBFC821C, 0x2997011F, 0x3AC7F2EB, 0xC8AC71E8, 0x1C661503, 0xEE0D9600, 0xFD5D65F4, 0x0F36E6F7,
+    0x61C69362, 0x93AD1061, 0x80FDE395, 0x72966096, 0xA65C047D, 0x5437877E, 0x4767748A, 0xB50CF789,
+    0xEB1FCBAD, 0x197448AE, 0x0A24BB5A, 0xF84F3859, 0x2C855CB2, 0xDEEEDFB1, 0xCDBE2C45, 0x3FD5AF46,
+    0x7198540D, 0x83F3D70E, 0x90A324FA, 0x62C8A7F9, 0xB602C312, 0x44694011, 0x5739B3E5, 0xA55230E6,
+    0xFB410CC2, 0x092A8FC1, 0x1A7A7C35, 0xE811FF36, 0x3CDB9BDD, 0xCEB018DE, 0xDDE0EB2A, 0x2F8B6829,
+    0x82F63B78, 0x709DB87B, 0x63CD4B8F, 0x91A6C88C, 0x456CAC67, 0xB7072F64, 0xA457DC90, 0x563C5F93,
+    0x082F63B7, 0xFA44E0B4, 0xE9141340, 0x1B7F9043, 0xCFB5F4A8, 0x3DDE77AB, 0x2E8E845F, 0xDCE5075C,
+    0x92A8FC17, 0x60C37F14, 0x73938CE0, 0x81F80FE3, 0x55326B08, 0xA759E80B, 0xB4091BFF, 0x466298FC,
+    0x1871A4D8, 0xEA1A27DB, 0xF94AD42F, 0x0B21572C, 0xDFEB33C7, 0x2D80B0C4, 0x3ED04330, 0xCCBBC033,
+    0xA24BB5A6, 0x502036A5, 0x4370C551, 0xB11B4652, 0x65D122B9, 0x97BAA1BA, 0x84EA524E, 0x7681D14D,
+    0x2892ED69, 0xDAF96E6A, 0xC9A99D9E, 0x3BC21E9D, 0xEF087A76, 0x1D63F975, 0x0E330A81, 0xFC588982,
+    0xB21572C9, 0x407EF1CA, 0x532E023E, 0xA145813D, 0x758FE5D6, 0x87E466D5, 0x94B49521, 0x66DF1622,
+    0x38CC2A06, 0xCAA7A905, 0xD9F75AF1, 0x2B9CD9F2, 0xFF56BD19, 0x0D3D3E1A, 0x1E6DCDEE, 0xEC064EED,
+    0xC38D26C4, 0x31E6A5C7, 0x22B65633, 0xD0DDD530, 0x0417B1DB, 0xF67C32D8, 0xE52CC12C, 0x1747422F,
+    0x49547E0B, 0xBB3FFD08, 0xA86F0EFC, 0x5A048DFF, 0x8ECEE914, 0x7CA56A17, 0x6FF599E3, 0x9D9E1AE0,
+    0xD3D3E1AB, 0x21B862A8, 0x32E8915C, 0xC083125F, 0x144976B4, 0xE622F5B7, 0xF5720643, 0x07198540,
+    0x590AB964, 0xAB613A67, 0xB831C993, 0x4A5A4A90, 0x9E902E7B, 0x6CFBAD78, 0x7FAB5E8C, 0x8DC0DD8F,
+    0xE330A81A, 0x115B2B19, 0x020BD8ED, 0xF0605BEE, 0x24AA3F05, 0xD6C1BC06, 0xC5914FF2, 0x37FACCF1,
+    0x69E9F0D5, 0x9B8273D6, 0x88D28022, 0x7AB90321, 0xAE7367CA, 0x5C18E4C9, 0x4F48173D, 0xBD23943E,
+    0xF36E6F75, 0x0105EC76, 0x12551F82, 0xE03E9C81, 0x34F4F86A, 0xC69F7B69, 0xD5CF889D, 0x27A40B9E,
+    0x79B737BA, 0x8BDCB4B9, 0x988C474D, 0x6AE7C44E, 0xBE2DA0A5, 0x4C4623A6, 0x5F16D052, 0xAD7D5351,
+};
+
+static uint32_t crc32c_portable(uint32_t crc, const uint8_t* data, uint64_t size){
+    for(uint64_t i = 0; i < size; i+=1) crc = bulk_crc32c_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+#if VPU_CRC32C_DISPATCH
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_sse42(uint32_t crc, const uint8_t* data, uint64_t size){
+    uint64_t c = crc;
+    for(; size >= 8; size -= 8, data += 8){
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        c = _mm_crc32_u64(c, word);
+    }
+    crc = (uint32_t) c;
+    for(; size; size -= 1, data += 1) crc = _mm_crc32_u8(crc, *data);
+    return crc;
+}
+#endif
+
+// the CRC-32C of size bytes at data continuing from crc, the CRC-32C of the empty range, so
+// bulk_crc32c(bulk_crc32c(0, a, n), b, m) is the CRC-32C of the n bytes at a followed by the m bytes at b
+static uint32_t bulk_crc32c(uint32_t crc, const void* data, uint64_t size){
+    crc = ~crc;
+#if VPU_CRC32C_DISPATCH
+    #ifndef __SSE4_2__
+    if(__builtin_cpu_supports("sse4.2"))
+    #endif
+        return ~crc32c_sse42(crc, (const uint8_t*) data, size);
+#endif
+    return ~crc32c_portable(crc, (const uint8_t*) data, size);
+}
+
+#define XXH64_PRIME1 0x9E3779B185EBCA87ull
+#define XXH64_PRIME2 0xC2B2AE3D27D4EB4Full
+#define XXH64_PRIME3 0x165667B19E3779F9ull
+#define XXH64_PRIME4 0x85EBCA77C2B2AE63ull
+#define XXH64_PRIME5 0x27D4EB2F165667C5ull
+
+static inline uint64_t xxh64_rotl(uint64_t x, int r){
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t xxh64_read64(const uint8_t* p){
+    uint64_t x;
+    memcpy(&x, p, sizeof(x));
+    return is_little_endian()? x : mc_swap64(x);
+}
+
+static inline uint32_t xxh64_read32(const uint8_t* p){
+    uint32_t x;
+    memcpy(&x, p, sizeof(x));
+    return is_little_endian()? x : mc_swap32(x);
+}
+
+static inline uint64_t xxh64_round(uint64_t acc, uint64_t input){
+    acc += input * XXH64_PRIME2;
+    return xxh64_rotl(acc, 31) * XXH64_PRIME1;
+}
+
+static inline uint64_t xxh64_merge(uint64_t acc, uint64_t lane){
+    acc ^= xxh64_round(0, lane);
+    return acc * XXH64_PRIME1 + XXH64_PRIME4;
+}
+
+// the XXH64 of size bytes at data with seed
+static uint64_t bulk_hash(uint64_t seed, const void* data, uint64_t size){
+    const uint8_t* p = (const uint8_t*) data;
+    const uint8_t* const end = p + size;
+    uint64_t h;
+    if(size >= 32){
+        uint64_t v1 = seed + XXH64_PRIME1 + XXH64_PRIME2, v2 = seed + XXH64_PRIME2, v3 = seed, v4 = seed - XXH64_PRIME1;
+        for(; end - p >= 32; p += 32){
+            v1 = xxh64_round(v1, xxh64_read64(p));
+            v2 = xxh64_round(v2, xxh64_read64(p + 8));
+            v3 = xxh64_round(v3, xxh64_read64(p + 16));
+            v4 = xxh64_round(v4, xxh64_read64(p + 24));
+        }
+        h = xxh64_rotl(v1, 1) + xxh64_rotl(v2, 7) + xxh64_rotl(v3, 12) + xxh64_rotl(v4, 18);
+        h = xxh64_merge(h, v1);
+        h = xxh64_merge(h, v2);
+        h = xxh64_merge(h, v3);
+        h = xxh64_merge(h, v4);
+    }
+    else h = seed + XXH64_PRIME5;
+    h += size;
+    for(; end - p >= 8; p += 8) h = xxh64_rotl(h ^ xxh64_round(0, xxh64_read64(p)), 27) * XXH64_PRIME1 + XXH64_PRIME4;
+    if(end - p >= 4){
+        h = xxh64_rotl(h ^ (xxh64_read32(p) * XXH64_PRIME1), 23) * XXH64_PRIME2 + XXH64_PRIME3;
+        p += 4;
+    }
+    for(; p < end; p += 1) h = xxh64_rotl(h ^ (*p * XXH64_PRIME5), 11) * XXH64_PRIME1;
+    h ^= h >> 33;
+    h *= XXH64_PRIME2;
+    h ^= h >> 29;
+    h *= XXH64_PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+#undef XXH64_PRIME1
+#undef XXH64_PRIME2
+#undef XXH64_PRIME3
+#undef XXH64_PRIME4
+#undef XXH64_PRIME5
+
+static inline uint64_t popcount64(uint64_t x){
+    x = x - ((x >> 1) & 0x5555555555555555ull);
+    x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    return (x * 0x0101010101010101ull) >> 56;
+}
+
+// the number of set bits in size bytes at data
+static uint64_t bulk_popcount(const void* data, uint64_t size){
+    const uint8_t* p = (const uint8_t*) data;
+    uint64_t count = 0;
+#if VPU_SSE2
+    // the bits of every byte are counted in the byte, _mm_sad_epu8 adds the 16 byte counts into the 2 halves
+    __m128i total = _mm_setzero_si128();
+    for(; size >= 16; size -= 16, p += 16){
+        __m128i x = VLOADI(p);
+    #ifdef __SSSE3__
+        const __m128i table = _mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m128i low = _mm_set1_epi8(0x0F);
+        x = _mm_add_epi8(_mm_shuffle_epi8(table, _mm_and_si128(x, low)), _mm_shuffle_epi8(table, _mm_and_si128(_mm_srli_epi16(x, 4), low)));
+    #else
+        x = _mm_sub_epi8(x, _mm_and_si128(_mm_srli_epi16(x, 1), _mm_set1_epi8(0x55)));
+        x = _mm_add_epi8(_mm_and_si128(x, _mm_set1_epi8(0x33)), _mm_and_si128(_mm_srli_epi16(x, 2), _mm_set1_epi8(0x33)));
+        x = _mm_and_si128(_mm_add_epi8(x, _mm_srli_epi16(x, 4)), _mm_set1_epi8(0x0F));
+    #endif
+        total = _mm_add_epi64(total, _mm_sad_epu8(x, _mm_setzero_si128()));
+    }
+    uint64_t halves[2];
+    VSTOREI(halves, total);
+    count = halves[0] + halves[1];
+#endif
+    for(; size >= 8; size -= 8, p += 8){
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        count += popcount64(word);
+    }
+    for(; size; size -= 1, p += 1) count += popcount64(*p);
+    return count;
+}
+
+#endif // =====================  END OF FILE VBULK_C ===========================
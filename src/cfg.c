@@ -0,0 +1,374 @@
+#ifndef VCFG_C
+#define VCFG_C
+
+/*
+ * control flow graph of a program:
+ * splits the program in basic blocks (straight runs of instructions with a single entry and a single exit) and
+ * records how each block ends, its successors inside the program and every call target.
+ * block leaders are the entry point, the first instruction, targets of jumps/branches/calls with literal offsets
+ * and every instruction right after a block exit.
+ * control that depends on register values (JMP/CALL through registers, RET, EXEC, unknown instructions and
+ * any instruction naming RIP) can't be followed statically, those blocks are flagged as indirect and a jump
+ * through a register may land on any instruction, not only on a leader.
+ */
+
+#include "core.h"
+#include "virtual.h"
+#include "virtual_files.h"
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+
+// how a basic block ends
+typedef enum CfgExit{
+    // the next instruction is a leader
+    CFG_EXIT_FALLTHROUGH = 0,
+    // JMP with a literal offset
+    CFG_EXIT_JUMP,
+    // JMPF/JMPFN, either the target or the next instruction
+    CFG_EXIT_BRANCH,
+    // CALL with a literal offset, continues at the next instruction once the call returns
+    CFG_EXIT_CALL,
+    // JMP through a register, EXEC or an instruction that writes to RIP
+    CFG_EXIT_INDIRECT_JUMP,
+    // CALL through a register
+    CFG_EXIT_INDIRECT_CALL,
+    CFG_EXIT_RETURN,
+    CFG_EXIT_HALT,
+    // the block runs off the end of the program
+    CFG_EXIT_END,
+
+    // for counting purposes
+    CFG_EXIT_COUNT
+} CfgExit;
+
+typedef enum CfgBlockFlags{
+    CFG_BLOCK_ENTRY         = 1 << 0,
+    CFG_BLOCK_JUMP_TARGET   = 1 << 1,
+    CFG_BLOCK_CALL_TARGET   = 1 << 2,
+    // the instruction before the block is a call, RET comes back here
+    CFG_BLOCK_RETURN_SITE   = 1 << 3,
+    // the block ends with control that can't be followed statically
+    CFG_BLOCK_INDIRECT      = 1 << 4
+} CfgBlockFlags;
+
+// successor positions equal or above the program size leave the program
+#define CFG_NO_SUCCESSOR 0XFFFFFFFFFFFFFFFF
+
+typedef struct CfgBlock{
+    // instructions [begin, end)
+    uint64_t    begin;
+    uint64_t    end;
+    // instruction positions of the successors inside the function (a call's successor is its return site),
+    // unused slots are CFG_NO_SUCCESSOR
+    uint64_t    successors[2];
+    // the target of a call with a literal offset, CFG_NO_SUCCESSOR otherwise
+    uint64_t    call_target;
+    CfgExit     exit;
+    uint32_t    flags;
+} CfgBlock;
+
+typedef struct Cfg{
+    CfgBlock*   blocks;
+    uint64_t    block_count;
+    // the block of each instruction
+    uint64_t*   block_of;
+    // distinct call targets, in program order
+    uint64_t*   call_targets;
+    uint64_t    call_target_count;
+    uint64_t    indirect_count;
+    uint64_t    program_size;
+    uint64_t    entry_point;
+} Cfg;
+
+// \returns the exit kind if inst ends a basic block or CFG_EXIT_FALLTHROUGH if it doesn't
+CfgExit get_inst_cfg_exit(Inst inst){
+
+    const int operands = get_inst_register_operands(inst);
+    for(int i = 0; i < operands; i+=1){
+        const uint8_t reg = (uint8_t) (inst >> (8 * (i + 1)));
+        if(reg > RIP - 8 && reg < RIP + 8) return CFG_EXIT_INDIRECT_JUMP;
+    }
+
+    switch (inst & 0XFF)
+    {
+    case INST_HALT:
+        return CFG_EXIT_HALT;
+    case INST_JMP:
+        return (GET_OP_HINT(inst) == HINT_REG)? CFG_EXIT_INDIRECT_JUMP : CFG_EXIT_JUMP;
+    case INST_JMPW:
+        return CFG_EXIT_JUMP;
+    case INST_JMPF:
+    case INST_JMPFN:
+    case INST_JMPFW:
+    case INST_JMPFNW:
+        return CFG_EXIT_BRANCH;
+    case INST_CALL:
+        return (GET_OP_HINT(inst) == HINT_REG)? CFG_EXIT_INDIRECT_CALL : CFG_EXIT_CALL;
+    case INST_CALLW:
+        return CFG_EXIT_CALL;
+    case INST_RET:
+        return CFG_EXIT_RETURN;
+    case INST_EXEC:
+        return CFG_EXIT_INDIRECT_JUMP;
+    // the containers of a wide instruction are part of it
+    case INST_CONTAINER:
+        return CFG_EXIT_FALLTHROUGH;
+    default:
+        if((inst & 0XFF) >= INST_TOTAL_COUNT) return CFG_EXIT_INDIRECT_JUMP;
+        return CFG_EXIT_FALLTHROUGH;
+    }
+}
+
+// the target of the jump, branch or call with a literal offset at program[ip]
+static inline uint64_t get_inst_cfg_target(const Inst* program, uint64_t program_size, uint64_t ip){
+    const Inst inst = program[ip];
+    if(get_inst_payload_size(inst & 0XFF))
+        return (ip + 1 < program_size)? ip + get_wide_literal(program + ip) : program_size;
+    switch (inst & 0XFF)
+    {
+    case INST_JMPF:
+    case INST_JMPFN:
+        return ip + (int16_t) (uint16_t) (inst >> 16);
+    default:
+        return ip + (int16_t) (uint16_t) (inst >> 8);
+    }
+}
+
+const char* get_cfg_exit_str(CfgExit exit){
+    switch (exit)
+    {
+    case CFG_EXIT_FALLTHROUGH:      return "fallthrough";
+    case CFG_EXIT_JUMP:             return "jump";
+    case CFG_EXIT_BRANCH:           return "branch";
+    case CFG_EXIT_CALL:             return "call";
+    case CFG_EXIT_INDIRECT_JUMP:    return "indirect jump";
+    case CFG_EXIT_INDIRECT_CALL:    return "indirect call";
+    case CFG_EXIT_RETURN:           return "return";
+    case CFG_EXIT_HALT:             return "halt";
+    case CFG_EXIT_END:              return "end";
+    default:                        return "?";
+    }
+}
+
+void free_cfg(Cfg* cfg){
+    virtual_free(cfg->blocks);
+    virtual_free(cfg->block_of);
+    virtual_free(cfg->call_targets);
+    memset(cfg, 0, sizeof(*cfg));
+}
+
+// builds the control flow graph of program
+// \returns 0 on success or non zero if out of memory
+int build_cfg(Cfg* cfg, const Inst* program, uint64_t program_size, uint64_t entry_point){
+
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->program_size = program_size;
+    cfg->entry_point  = entry_point;
+
+    int err = 0;
+
+    // leader flags of each instruction, the low bits are CfgBlockFlags
+    #define CFG_LEADER (1 << 7)
+    uint8_t* const leaders = (uint8_t*) virtual_alloc(program_size + 1);
+    cfg->block_of = (uint64_t*) virtual_alloc(sizeof(uint64_t) * (program_size + 1));
+    if(!leaders || !cfg->block_of)
+        DEFER_ERROR("Could Not Allocate Memory For The Control Flow Graph Of %"PRIu64" Instructions\n", program_size);
+    memset(leaders, 0, program_size + 1);
+
+    if(program_size) leaders[0] |= CFG_LEADER;
+    if(entry_point < program_size) leaders[entry_point] |= CFG_LEADER | CFG_BLOCK_ENTRY;
+
+    // first pass: mark the leaders
+    for(uint64_t i = 0; i < program_size; i+=1){
+        const CfgExit exit = get_inst_cfg_exit(program[i]);
+        if(exit == CFG_EXIT_FALLTHROUGH) continue;
+        // the block of a wide branch ends with its container
+        uint64_t next = i + 1 + get_inst_payload_size(program[i] & 0XFF);
+        if(next > program_size) next = program_size;
+        leaders[next] |= CFG_LEADER;
+        if(exit == CFG_EXIT_CALL || exit == CFG_EXIT_INDIRECT_CALL) leaders[next] |= CFG_BLOCK_RETURN_SITE;
+        if(exit == CFG_EXIT_JUMP || exit == CFG_EXIT_BRANCH || exit == CFG_EXIT_CALL){
+            const uint64_t target = get_inst_cfg_target(program, program_size, i);
+            if(target >= program_size) continue;
+            leaders[target] |= CFG_LEADER | ((exit == CFG_EXIT_CALL)? CFG_BLOCK_CALL_TARGET : CFG_BLOCK_JUMP_TARGET);
+        }
+    }
+
+    // the containers of wide branches stay in the block of their branch even if something jumps into them
+    for(uint64_t i = 0; i < program_size; i+=1){
+        if(get_inst_cfg_exit(program[i]) == CFG_EXIT_FALLTHROUGH) continue;
+        for(int c = 1; c <= get_inst_payload_size(program[i] & 0XFF) && i + c < program_size; c+=1){
+            leaders[i + c] = 0;
+        }
+    }
+
+    for(uint64_t i = 0; i < program_size; i+=1){
+        cfg->block_count += (leaders[i] & CFG_LEADER)? 1 : 0;
+        cfg->call_target_count += (leaders[i] & CFG_BLOCK_CALL_TARGET)? 1 : 0;
+    }
+
+    cfg->blocks       = (CfgBlock*) virtual_alloc(sizeof(CfgBlock) * (cfg->block_count + 1));
+    cfg->call_targets = (uint64_t*) virtual_alloc(sizeof(uint64_t) * (cfg->call_target_count + 1));
+    if(!cfg->blocks || !cfg->call_targets)
+        DEFER_ERROR("Could Not Allocate Memory For %"PRIu64" Basic Blocks\n", cfg->block_count);
+
+    // second pass: build the blocks
+    uint64_t block = 0;
+    uint64_t call_target = 0;
+    for(uint64_t begin = 0; begin < program_size; block+=1){
+        CfgBlock* const b = &cfg->blocks[block];
+        b->begin        = begin;
+        b->flags        = leaders[begin] & ~CFG_LEADER;
+        b->successors[0]= CFG_NO_SUCCESSOR;
+        b->successors[1]= CFG_NO_SUCCESSOR;
+        b->call_target  = CFG_NO_SUCCESSOR;
+        if(b->flags & CFG_BLOCK_CALL_TARGET) cfg->call_targets[call_target++] = begin;
+
+        uint64_t i = begin;
+        CfgExit exit = CFG_EXIT_FALLTHROUGH;
+        for(; i < program_size; i+=1){
+            cfg->block_of[i] = block;
+            exit = get_inst_cfg_exit(program[i]);
+            if(exit != CFG_EXIT_FALLTHROUGH || (leaders[i + 1] & CFG_LEADER)) break;
+        }
+        const uint64_t last = (i < program_size)? i : program_size - 1;
+        b->end = (i < program_size)? i + 1 : program_size;
+        if(exit != CFG_EXIT_FALLTHROUGH){
+            for(int c = get_inst_payload_size(program[last] & 0XFF); c > 0 && b->end < program_size; c-=1){
+                cfg->block_of[b->end++] = block;
+            }
+        }
+        if(exit == CFG_EXIT_FALLTHROUGH && b->end >= program_size) exit = CFG_EXIT_END;
+        b->exit = exit;
+
+        switch (exit)
+        {
+        case CFG_EXIT_FALLTHROUGH:
+            b->successors[0] = b->end;
+            break;
+        case CFG_EXIT_JUMP:
+            b->successors[0] = get_inst_cfg_target(program, program_size, last);
+            break;
+        case CFG_EXIT_BRANCH:
+            b->successors[0] = get_inst_cfg_target(program, program_size, last);
+            b->successors[1] = b->end;
+            break;
+        case CFG_EXIT_CALL:
+            b->call_target   = get_inst_cfg_target(program, program_size, last);
+            b->successors[0] = b->end;
+            break;
+        case CFG_EXIT_INDIRECT_CALL:
+            b->successors[0] = b->end;
+            b->flags |= CFG_BLOCK_INDIRECT;
+            cfg->indirect_count += 1;
+            break;
+        case CFG_EXIT_INDIRECT_JUMP:
+            b->flags |= CFG_BLOCK_INDIRECT;
+            cfg->indirect_count += 1;
+            break;
+        default:
+            break;
+        }
+        // leaving the program through a successor
+        for(int s = 0; s < 2; s+=1){
+            if(b->successors[s] != CFG_NO_SUCCESSOR && b->successors[s] >= program_size) b->successors[s] = program_size;
+        }
+
+        begin = b->end;
+    }
+    cfg->block_of[program_size] = cfg->block_count;
+
+defer:
+    #undef CFG_LEADER
+    virtual_free(leaders);
+    if(err) free_cfg(cfg);
+    return err;
+}
+
+// writes every block of cfg to output
+void dump_cfg(FILE* output, const Cfg* cfg){
+
+    fprintf(output,
+        "%"PRIu64" instructions, %"PRIu64" basic blocks, %"PRIu64" call targets, %"PRIu64" indirect exits, entry point %"PRIu64"\n",
+        cfg->program_size, cfg->block_count, cfg->call_target_count, cfg->indirect_count, cfg->entry_point
+    );
+
+    for(uint64_t i = 0; i < cfg->block_count; i+=1){
+        const CfgBlock* const b = &cfg->blocks[i];
+        fprintf(output, "block %"PRIu64": [%"PRIu64", %"PRIu64")", i, b->begin, b->end);
+        if(b->flags & CFG_BLOCK_ENTRY)       fprintf(output, " entry");
+        if(b->flags & CFG_BLOCK_CALL_TARGET) fprintf(output, " call-target");
+        if(b->flags & CFG_BLOCK_JUMP_TARGET) fprintf(output, " jump-target");
+        if(b->flags & CFG_BLOCK_RETURN_SITE) fprintf(output, " return-site");
+        fprintf(output, "\n\texit: %s", get_cfg_exit_str(b->exit));
+        if(b->call_target != CFG_NO_SUCCESSOR){
+            if(b->call_target < cfg->program_size) fprintf(output, ", calls block %"PRIu64, cfg->block_of[b->call_target]);
+            else fprintf(output, ", calls outside of the program");
+        }
+        for(int s = 0; s < 2; s+=1){
+            if(b->successors[s] == CFG_NO_SUCCESSOR) continue;
+            if(b->successors[s] < cfg->program_size) fprintf(output, ", -> block %"PRIu64, cfg->block_of[b->successors[s]]);
+            else fprintf(output, ", -> leaves the program");
+        }
+        fprintf(output, "\n");
+    }
+}
+
+// builds the control flow graph of the executable in input_file and dumps it to output_file (stdout if NULL),
+// together with how long it took to build
+int dump_cfg_file(const char* input_file, const char* output_file){
+
+    VirtualFile vfile;
+    const char* required_fields[] = {
+        VIRTUAL_FILE_PROGRAM_FIELD_NAME,
+        NULL
+    };
+    const char* optional_fields[] = {
+        NULL
+    };
+    if(vfopen(&vfile, input_file, required_fields, optional_fields)){
+        fprintf(stderr, "[ERROR] failed trying to open virtual file '%s'\n", input_file);
+        return 1;
+    }
+
+    uint64_t entry_point;
+    uint64_t program_size;
+    const Inst* program = get_program_from_vfield(get_virtual_file_field(vfile, VIRTUAL_FILE_PROGRAM_FIELD_NAME), &program_size, &entry_point);
+    if(program == NULL){
+        fprintf(stderr, "[ERROR] virtual file in '%s' has corrupt program\n", input_file);
+        vfclose(vfile);
+        return 1;
+    }
+
+    Cfg cfg;
+    const clock_t begin = clock();
+    if(build_cfg(&cfg, program, program_size, entry_point)){
+        vfclose(vfile);
+        return 1;
+    }
+    const double elapsed = (double) (clock() - begin) / (double) CLOCKS_PER_SEC;
+
+    FILE* output = output_file? fopen(output_file, "w") : stdout;
+    if(!output){
+        fprintf(stderr, "[ERROR] could not open output file '%s'\n", output_file);
+        free_cfg(&cfg);
+        vfclose(vfile);
+        return 1;
+    }
+
+    fprintf(output, "control flow graph of '%s'\n", input_file);
+    dump_cfg(output, &cfg);
+    fprintf(output,
+        "built in %.3f ms (%.1f ns per instruction)\n",
+        elapsed * 1e3, program_size? elapsed * 1e9 / (double) program_size : 0.0
+    );
+
+    if(output != stdout) fclose(output);
+    free_cfg(&cfg);
+    vfclose(vfile);
+    return 0;
+}
+
+#endif // END OF FILE VCFG_C =================================================
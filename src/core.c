@@ -7,7 +7,16 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <inttypes.h>
+#include <math.h>
+#include <stdatomic.h>
 #include "virtual_files.h"
+#include "vector.c"
+#include "bulk.c"
+#include "cfg.c"
+#include "profiler.c"
+#include "stack.c"
+#include "threaded.c"
+#include "jit.c"
 
 
 // returns the number of instruction to sum to RIP
@@ -127,6 +136,103 @@ int64_t perform_inst(VPU* vpu, Inst inst){
     case INST_MEMCMP:
         R1.as_uint8 = (uint8_t) memcmp(R1.as_ptr, R2.as_ptr, (size_t) R3.as_uint64);
         return 1;
+    case INST_MSTRLEN:
+        R1.as_uint64 = (uint64_t) strlen((const char*) R2.as_ptr);
+        return 1;
+    case INST_MCHR:
+        R1.as_ptr = memchr(R1.as_ptr, (int) R2.as_uint8, (size_t) R3.as_uint64);
+        return 1;
+    case INST_MFILL32:
+        bulk_fill32(R1.as_ptr, R2.as_uint32, R3.as_uint64);
+        return 1;
+    case INST_MFILL64:
+        bulk_fill64(R1.as_ptr, R2.as_uint64, R3.as_uint64);
+        return 1;
+    case INST_MCRC32:
+        R1.as_uint64 = bulk_crc32c(R1.as_uint32, R2.as_ptr, R3.as_uint64);
+        return 1;
+    case INST_MHASH:
+        R1.as_uint64 = bulk_hash(R1.as_uint64, R2.as_ptr, R3.as_uint64);
+        return 1;
+    case INST_MPOPCNT:
+        R1.as_uint64 = bulk_popcount(R2.as_ptr, R3.as_uint64);
+        return 1;
+    case INST_ALOAD8:
+        R1.as_uint8 = atomic_load_explicit(VPU_ATOMIC(8, (uintptr_t)(R2.as_ptr) + R3.as_int64), memory_order_acquire);
+        return 1;
+    case INST_ALOAD16:
+        R1.as_uint16 = atomic_load_explicit(VPU_ATOMIC(16, (uintptr_t)(R2.as_ptr) + R3.as_int64), memory_order_acquire);
+        return 1;
+    case INST_ALOAD32:
+        R1.as_uint32 = atomic_load_explicit(VPU_ATOMIC(32, (uintptr_t)(R2.as_ptr) + R3.as_int64), memory_order_acquire);
+        return 1;
+    case INST_ALOAD:
+        R1.as_uint64 = atomic_load_explicit(VPU_ATOMIC(64, (uintptr_t)(R2.as_ptr) + R3.as_int64), memory_order_acquire);
+        return 1;
+    case INST_ASTORE8:
+        atomic_store_explicit(VPU_ATOMIC(8, (uintptr_t)(R1.as_ptr) + R3.as_int64), R2.as_uint8, memory_order_release);
+        return 1;
+    case INST_ASTORE16:
+        atomic_store_explicit(VPU_ATOMIC(16, (uintptr_t)(R1.as_ptr) + R3.as_int64), R2.as_uint16, memory_order_release);
+        return 1;
+    case INST_ASTORE32:
+        atomic_store_explicit(VPU_ATOMIC(32, (uintptr_t)(R1.as_ptr) + R3.as_int64), R2.as_uint32, memory_order_release);
+        return 1;
+    case INST_ASTORE:
+        atomic_store_explicit(VPU_ATOMIC(64, (uintptr_t)(R1.as_ptr) + R3.as_int64), R2.as_uint64, memory_order_release);
+        return 1;
+    // the read-modify-write atomics need R3 for their operand, so unlike ALOAD and ASTORE they take no offset
+    case INST_ACAS8:
+        atomic_compare_exchange_strong(VPU_ATOMIC(8, R2.as_ptr), &R1.as_uint8, R3.as_uint8);
+        return 1;
+    case INST_ACAS16:
+        atomic_compare_exchange_strong(VPU_ATOMIC(16, R2.as_ptr), &R1.as_uint16, R3.as_uint16);
+        return 1;
+    case INST_ACAS32:
+        atomic_compare_exchange_strong(VPU_ATOMIC(32, R2.as_ptr), &R1.as_uint32, R3.as_uint32);
+        return 1;
+    case INST_ACAS:
+        atomic_compare_exchange_strong(VPU_ATOMIC(64, R2.as_ptr), &R1.as_uint64, R3.as_uint64);
+        return 1;
+    case INST_AADD8:
+        R1.as_uint8 = atomic_fetch_add(VPU_ATOMIC(8, R2.as_ptr), R3.as_uint8);
+        return 1;
+    case INST_AADD16:
+        R1.as_uint16 = atomic_fetch_add(VPU_ATOMIC(16, R2.as_ptr), R3.as_uint16);
+        return 1;
+    case INST_AADD32:
+        R1.as_uint32 = atomic_fetch_add(VPU_ATOMIC(32, R2.as_ptr), R3.as_uint32);
+        return 1;
+    case INST_AADD:
+        R1.as_uint64 = atomic_fetch_add(VPU_ATOMIC(64, R2.as_ptr), R3.as_uint64);
+        return 1;
+    case INST_AOR8:
+        R1.as_uint8 = atomic_fetch_or(VPU_ATOMIC(8, R2.as_ptr), R3.as_uint8);
+        return 1;
+    case INST_AOR16:
+        R1.as_uint16 = atomic_fetch_or(VPU_ATOMIC(16, R2.as_ptr), R3.as_uint16);
+        return 1;
+    case INST_AOR32:
+        R1.as_uint32 = atomic_fetch_or(VPU_ATOMIC(32, R2.as_ptr), R3.as_uint32);
+        return 1;
+    case INST_AOR:
+        R1.as_uint64 = atomic_fetch_or(VPU_ATOMIC(64, R2.as_ptr), R3.as_uint64);
+        return 1;
+    case INST_AXCHG8:
+        R1.as_uint8 = atomic_exchange(VPU_ATOMIC(8, R2.as_ptr), R3.as_uint8);
+        return 1;
+    case INST_AXCHG16:
+        R1.as_uint16 = atomic_exchange(VPU_ATOMIC(16, R2.as_ptr), R3.as_uint16);
+        return 1;
+    case INST_AXCHG32:
+        R1.as_uint32 = atomic_exchange(VPU_ATOMIC(32, R2.as_ptr), R3.as_uint32);
+        return 1;
+    case INST_AXCHG:
+        R1.as_uint64 = atomic_exchange(VPU_ATOMIC(64, R2.as_ptr), R3.as_uint64);
+        return 1;
+    case INST_FENCE:
+        atomic_thread_fence(memory_order_seq_cst);
+        return 1;
     case INST_NOT:
         R1.as_uint64 = !R2.as_uint64;
         return 1;
@@ -302,6 +408,45 @@ int64_t perform_inst(VPU* vpu, Inst inst){
     case INST_CF6432:
         R1.as_float64 = (double)R2.as_float32;
         return 1;
+    case INST_FMAF:
+        R1.as_float64 = fma(R2.as_float64, R3.as_float64, R1.as_float64);
+        return 1;
+    case INST_SQRTF:
+        R1.as_float64 = sqrt(R2.as_float64);
+        return 1;
+    case INST_MINF:
+        R1.as_float64 = (R2.as_float64 < R3.as_float64)? R2.as_float64 : R3.as_float64;
+        return 1;
+    case INST_MAXF:
+        R1.as_float64 = (R2.as_float64 > R3.as_float64)? R2.as_float64 : R3.as_float64;
+        return 1;
+    case INST_FLOORF:
+        R1.as_float64 = floor(R2.as_float64);
+        return 1;
+    case INST_CEILF:
+        R1.as_float64 = ceil(R2.as_float64);
+        return 1;
+    case INST_ROUNDF:
+        R1.as_float64 = nearbyint(R2.as_float64);
+        return 1;
+    case INST_ADDF32:
+        OPERATION(+, float32);
+        return 1;
+    case INST_SUBF32:
+        OPERATION(-, float32);
+        return 1;
+    case INST_MULF32:
+        OPERATION(*, float32);
+        return 1;
+    case INST_DIVF32:
+        OPERATION(/, float32);
+        return 1;
+    case INST_FMAF32:
+        R1.as_float32 = fmaf(R2.as_float32, R3.as_float32, R1.as_float32);
+        return 1;
+    case INST_SQRTF32:
+        R1.as_float32 = sqrtf(R2.as_float32);
+        return 1;
     case INST_FLOAT:
         R1.as_float64 = (double) R2.as_int64 / (double) R3.as_uint64;
         return 1;
@@ -321,6 +466,12 @@ int64_t perform_inst(VPU* vpu, Inst inst){
         if(R2.as_uint8) fclose(stdin);
         return 1;
     case INST_EXEC:
+        // the containers of a wide instruction can't come with it in a register
+        if(get_inst_payload_size(R3.as_uint32 & 0xFF)){
+            fprintf(stderr, "[ERROR] Can Not EXEC The Wide Instruction '%"PRIu32"' At Instuction Position %"PRIu64"\n", R3.as_uint32, IP);
+            vpu->status = 1;
+            return 0xFFFFFFFFFFFFFFFF - IP;
+        }
         return perform_inst(vpu, R3.as_uint32);
     case INST_SYS:
         if(virtual_syscall(vpu, (GET_OP_HINT(inst) == HINT_REG)? R1.as_uint64 : L1)){
@@ -345,9 +496,29 @@ int64_t perform_inst(VPU* vpu, Inst inst){
     case INST_GIP:
         R1.as_ptr = ((uint8_t*) (vpu->program + R2.as_uint64)) + R3.as_uint64;
         return 1;
+    case INST_MOVVW:
+        R1.as_uint64 = get_wide_literal(vpu->program + IP);
+        return 2;
+    case INST_MOVVL:
+        R1.as_uint64 = get_wide_literal(vpu->program + IP);
+        return 3;
+    case INST_JMPW:
+        return (int64_t) get_wide_literal(vpu->program + IP);
+    case INST_JMPFW:
+        return (R1.as_uint8)? (int64_t) get_wide_literal(vpu->program + IP) : 2;
+    case INST_JMPFNW:
+        return (!(R1.as_uint8))? (int64_t) get_wide_literal(vpu->program + IP) : 2;
+    case INST_CALLW:
+        vpu->stack[SP++] = IP + 2;
+        return (int64_t) get_wide_literal(vpu->program + IP);
     
     
     default:
+        // the vector instructions are in vector.c
+        if(is_vector_inst(inst & 0XFF)){
+            perform_vector_inst(vpu->register_space, inst);
+            return 1;
+        }
         fprintf(stderr, "[ERROR] Unknwon Instruction '%u' At Instuction Position %"PRIu64"\n", (unsigned int)inst, IP);
 	    vpu->status = 1;
         return 0xFFFFFFFFFFFFFFFF - IP;
@@ -365,8 +536,77 @@ int64_t perform_inst(VPU* vpu, Inst inst){
 
 }
 
-// executes raw program and passes argc and argv to the executing program
-int execute(const char* input_file, int argc, char** argv){
+// runs the program loaded in vpu from entry_point with the engine in options until it halts,
+// vpu must be ready to execute (registers, stack and static memory set), name is only used for diagnostics
+// \returns 0 on success or 1 if the program could not be prepared for the engine (vpu->status holds the program's status)
+int run_program(VPU* vpu, uint64_t program_size, uint64_t entry_point, const ExecuteOptions* options, const char* name){
+
+    #define RIP_REGISTER (((Register*) vpu->register_space)[RIP >> 3])
+
+    VpuEngine engine = options->engine;
+
+    if(engine == VPU_ENGINE_JIT){
+        JitProgram jitted;
+        if(jit_compile(&jitted, vpu, program_size)){
+            fprintf(stderr, "[WARNING] Could Not Compile '%s', Falling Back To The Threaded Engine\n", name);
+            engine = VPU_ENGINE_THREADED;
+        }
+        else{
+            RIP_REGISTER.as_uint64 = entry_point;
+            // RIP is not kept up to date by the jitted code, a stack fault in it is mapped back through its pc
+            watch_native_code(jit_native_ip, &jitted);
+            jit_run(vpu, &jitted);
+            watch_native_code(NULL, NULL);
+            if(options->stats){
+                fprintf(stderr,
+                    "[STATS] engine: jit\n"
+                    "[STATS] native code: %zu bytes for %"PRIu64" instructions\n"
+                    "[STATS] instructions left to perform_inst: %"PRIu64"\n",
+                    jitted.code_size, jitted.size, jitted.fallbacks
+                );
+            }
+            jit_free(&jitted);
+            return 0;
+        }
+    }
+
+    if(engine == VPU_ENGINE_THREADED){
+        DecodedProgram decoded;
+        if(decode_program(&decoded, vpu->program, program_size, vpu->register_space)){
+            return 1;
+        }
+        fuse_program(&decoded);
+        RIP_REGISTER.as_uint64 = entry_point;
+        run_threaded(vpu, &decoded);
+        if(options->stats){
+            fprintf(stderr,
+                "[STATS] engine: threaded\n"
+                "[STATS] superinstructions: %"PRIu64" out of %"PRIu64" instructions\n"
+                "[STATS] dispatches saved by superinstructions: %"PRIu64"\n",
+                decoded.fused_sites, decoded.size, decoded.dispatches_saved
+            );
+        }
+        free_decoded_program(&decoded);
+        return 0;
+    }
+
+    for(
+        RIP_REGISTER.as_uint64 = entry_point;
+        RIP_REGISTER.as_uint64 < program_size;
+        RIP_REGISTER.as_int64 += perform_inst(vpu, vpu->program[RIP_REGISTER.as_uint64])
+    );
+
+    if(options->stats){
+        fprintf(stderr, "[STATS] engine: switch (no superinstructions)\n");
+    }
+
+    #undef RIP_REGISTER
+
+    return 0;
+}
+
+// executes raw program as described by options and passes argc and argv to the executing program
+int execute(const char* input_file, int argc, char** argv, const ExecuteOptions* options){
 
     if(!input_file){
         fprintf(stderr, "[ERROR] Expected Input Program Path\n");
@@ -380,9 +620,10 @@ int execute(const char* input_file, int argc, char** argv){
     };
     const char* optional_fields[] = {
         VIRTUAL_FILE_STATIC_FIELD_NAME,
+        VIRTUAL_FILE_LABELS_FIELD_NAME,
         NULL
     };
-    if(vfopen(&vfile, input_file, required_fields, optional_fields)){
+    if(vfmap(&vfile, input_file, required_fields, optional_fields)){
         fprintf(stderr, "[ERROR] failed trying to open virtual file '%s'\n", input_file);
         return 1;
     }
@@ -394,15 +635,20 @@ int execute(const char* input_file, int argc, char** argv){
     uint64_t entry_point;
     uint64_t program_size;
     vpu.program = get_program_from_vfield(program_field, &program_size, &entry_point);
+    vpu.program_size = program_size;
     if(program_field == NULL){
         fprintf(stderr, "[ERROR] virtual file in '%s' has corrupt program\n", input_file);
         vfclose(vfile);
         return 1;
     }
 
-    static uint64_t stack[1000];
-    Register registers[REGISTER_SPACE_SIZE / sizeof(Register)];
-    memset(stack, 0, sizeof(stack));
+    VpuStack stack;
+    if(create_vpu_stack(&stack, options->stack_size)){
+        vfclose(vfile);
+        return 1;
+    }
+
+    Register registers[VPU_REGISTER_SPACE_SIZE / sizeof(Register)];
     memset(registers, 0, sizeof(registers));
 
     vpu.static_memory = (uint8_t*) get_virtual_file_field(vfile, VIRTUAL_FILE_STATIC_FIELD_NAME);
@@ -410,7 +656,7 @@ int execute(const char* input_file, int argc, char** argv){
         vpu.static_memory = (uint8_t*) (((uintptr_t) vpu.static_memory) + sizeof(uint64_t) + sizeof(VIRTUAL_FILE_STATIC_FIELD_NAME));
     }
     
-    vpu.stack = &(stack[0]);
+    vpu.stack = stack.base;
 
     // sets argc and argv of the program to RA.as_int64 and RB.as_ptr, respectively
     registers[RA >> 3].as_int64 = argc;
@@ -418,19 +664,61 @@ int execute(const char* input_file, int argc, char** argv){
 
     vpu.register_space = (uint8_t*) &registers[0];
 
+    vpu.system = NULL;
     vpu.status = 0;
 
-    for(
-        registers[RIP >> 3].as_uint64 = entry_point;
-        registers[RIP >> 3].as_uint64 < program_size;
-        registers[RIP >> 3].as_int64 += perform_inst(&vpu, vpu.program[registers[RIP >> 3].as_uint64])
-    ) {
-	    //vpu.registers[R0].as_uint64 = 0;
+#if VPU_STACK_GUARD
+    // overflowing or underflowing the stack faults in its guard regions and lands back here, see stack.c
+    arm_vpu_stack_guard(&vpu, &stack);
+    if(sigsetjmp(vpu_stack_fault.jump, 1)){
+        fflush(stdout);
+        fprintf(stderr, "[ERROR] Stack %s At IP %"PRIu64" (Stack Size Is %"PRIu64" Bytes)\n",
+            (vpu_stack_fault.kind == VPU_STACK_UNDERFLOW)? "Underflow" : "Overflow", (uint64_t) vpu_stack_fault.ip, stack.size);
+        disarm_vpu_stack_guard();
+        destroy_vpu_stack(&stack);
+        vfclose(vfile);
+        return 1;
+    }
+#endif
+
+    int err = 0;
+
+    if(options->profile){
+        // profiling runs on its own loop around perform_inst, see profiler.c
+        const uint8_t* labels = (const uint8_t*) get_virtual_file_field(vfile, VIRTUAL_FILE_LABELS_FIELD_NAME);
+        uint64_t labels_size = 0;
+        if(labels){
+            labels_size = *(uint64_t*) labels - sizeof(uint64_t) - sizeof(VIRTUAL_FILE_LABELS_FIELD_NAME);
+            labels += sizeof(uint64_t) + sizeof(VIRTUAL_FILE_LABELS_FIELD_NAME);
+        }
+        else{
+            fprintf(stderr, "[WARNING] '%s' Has No Labels, The Profile Will Only Have Instructions And Opcodes\n", input_file);
+        }
+        Profile profile;
+        err = init_profile(&profile, program_size, entry_point, labels, labels_size);
+        if(!err){
+            run_profiled(&vpu, &profile, entry_point);
+            fflush(stdout);
+            report_profile(stderr, &profile, vpu.program, 20);
+            err = options->profile_stacks? write_profile_stacks(options->profile_stacks, &profile) : 0;
+            free_profile(&profile);
+        }
+    }
+    else{
+        err = run_program(&vpu, program_size, entry_point, options, input_file);
     }
 
+#if VPU_STACK_GUARD
+    disarm_vpu_stack_guard();
+#endif
+#ifndef CUSTOM_SYSTEM
+    // a program that did not close its system could leave threads running on the program unmapped below
+    if(vpu.system) virtual_syscall(&vpu, VSYS_CLOSE);
+#endif
+    destroy_vpu_stack(&stack);
     vfclose(vfile);
 
-    return vpu.status;
+    return err? err : vpu.status;
 }
 
 #endif // END OF FILE VCORE_C =================================================
\ No newline at end of file
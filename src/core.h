@@ -9,6 +9,7 @@
  * Rn stands for the nth argument which is a register in this case
  * Ln stands for the nth argument which is a literal in this case
  * E stands for the only argument which can be either a literal or a register
+ * Vn stands for the nth argument which is a vector register (V0 to V15) in this case
  * the .as_<type> suffix indicates that the value is to be read as the <type>, which also means that if the argument is a register it only needs sizeof(<type>) bytes.
  * the .<size> suffix indicates that only the first <size> less significant bits will be taken into account
  * if no suffix is provided the default is .64 for registers and .16 for literals (as literals have to be up to 16 bit, saved for the LOAD1 and LOAD2 arguments)
@@ -215,9 +216,223 @@ typedef enum OpCode{
 	INST_GRP,
 	// R1.as_ptr = PROGRAM_BEGIN_POINTER + E
 	INST_GIP,
+    // R1.as_int64 = L2.as_int32, the literal is wide: its high 16 bits are in the INST_CONTAINER that follows
+    INST_MOVVW,
+    // R1.as_uint64 = L2.as_uint64, the literal is wide: its high 48 bits are in the 2 INST_CONTAINERs that follow
+    INST_MOVVL,
+    // RIP += L2.as_int32, JMP with a wide literal: its high 16 bits are in the INST_CONTAINER that follows
+    INST_JMPW,
+    // if(R1.8 != 0x00) RIP += L2.as_int32
+    // else             RIP += 2
+    INST_JMPFW,
+    // if(R1.8 == 0x00) RIP += L2.as_int32
+    // else             RIP += 2
+    INST_JMPFNW,
+    // STACK[RSP++] = RIP.as_uint64 + 2
+    // RIP += L2.as_int32
+    INST_CALLW,
+    // the vector instructions, V1, V2 and V3 are vector registers (V0 to V15, see VRegister) and i is a lane,
+    // integer lanes wrap around like ADD8 to MUL32 and compare as unsigned integers
+    // V1.as_uint8[i] = V2.as_uint8[i] + V3.as_uint8[i], for the 16 lanes
+    INST_VADD8,
+    // V1.as_uint8[i] = V2.as_uint8[i] - V3.as_uint8[i], for the 16 lanes
+    INST_VSUB8,
+    // V1.as_uint8[i] = V2.as_uint8[i] * V3.as_uint8[i], for the 16 lanes
+    INST_VMUL8,
+    // V1.as_uint8[i] = (V2.as_uint8[i] < V3.as_uint8[i])? V2.as_uint8[i] : V3.as_uint8[i], for the 16 lanes
+    INST_VMIN8,
+    // V1.as_uint8[i] = (V2.as_uint8[i] > V3.as_uint8[i])? V2.as_uint8[i] : V3.as_uint8[i], for the 16 lanes
+    INST_VMAX8,
+    // V1.as_uint8[i] = (V2.as_uint8[i] == V3.as_uint8[i])? all ones : 0, for the 16 lanes
+    INST_VEQ8,
+    // V1.as_uint8[i] = (V2.as_uint8[i] > V3.as_uint8[i])? all ones : 0, for the 16 lanes
+    INST_VBIG8,
+    // V1.as_uint16[i] = V2.as_uint16[i] + V3.as_uint16[i], for the 8 lanes
+    INST_VADD16,
+    // V1.as_uint16[i] = V2.as_uint16[i] - V3.as_uint16[i], for the 8 lanes
+    INST_VSUB16,
+    // V1.as_uint16[i] = V2.as_uint16[i] * V3.as_uint16[i], for the 8 lanes
+    INST_VMUL16,
+    // V1.as_uint16[i] = (V2.as_uint16[i] < V3.as_uint16[i])? V2.as_uint16[i] : V3.as_uint16[i], for the 8 lanes
+    INST_VMIN16,
+    // V1.as_uint16[i] = (V2.as_uint16[i] > V3.as_uint16[i])? V2.as_uint16[i] : V3.as_uint16[i], for the 8 lanes
+    INST_VMAX16,
+    // V1.as_uint16[i] = (V2.as_uint16[i] == V3.as_uint16[i])? all ones : 0, for the 8 lanes
+    INST_VEQ16,
+    // V1.as_uint16[i] = (V2.as_uint16[i] > V3.as_uint16[i])? all ones : 0, for the 8 lanes
+    INST_VBIG16,
+    // V1.as_uint32[i] = V2.as_uint32[i] + V3.as_uint32[i], for the 4 lanes
+    INST_VADD32,
+    // V1.as_uint32[i] = V2.as_uint32[i] - V3.as_uint32[i], for the 4 lanes
+    INST_VSUB32,
+    // V1.as_uint32[i] = V2.as_uint32[i] * V3.as_uint32[i], for the 4 lanes
+    INST_VMUL32,
+    // V1.as_uint32[i] = (V2.as_uint32[i] < V3.as_uint32[i])? V2.as_uint32[i] : V3.as_uint32[i], for the 4 lanes
+    INST_VMIN32,
+    // V1.as_uint32[i] = (V2.as_uint32[i] > V3.as_uint32[i])? V2.as_uint32[i] : V3.as_uint32[i], for the 4 lanes
+    INST_VMAX32,
+    // V1.as_uint32[i] = (V2.as_uint32[i] == V3.as_uint32[i])? all ones : 0, for the 4 lanes
+    INST_VEQ32,
+    // V1.as_uint32[i] = (V2.as_uint32[i] > V3.as_uint32[i])? all ones : 0, for the 4 lanes
+    INST_VBIG32,
+    // V1.as_float32[i] = V2.as_float32[i] + V3.as_float32[i], for the 4 lanes
+    INST_VADDF32,
+    // V1.as_float32[i] = V2.as_float32[i] - V3.as_float32[i], for the 4 lanes
+    INST_VSUBF32,
+    // V1.as_float32[i] = V2.as_float32[i] * V3.as_float32[i], for the 4 lanes
+    INST_VMULF32,
+    // V1.as_float32[i] = (V2.as_float32[i] < V3.as_float32[i])? V2.as_float32[i] : V3.as_float32[i], for the 4 lanes
+    INST_VMINF32,
+    // V1.as_float32[i] = (V2.as_float32[i] > V3.as_float32[i])? V2.as_float32[i] : V3.as_float32[i], for the 4 lanes
+    INST_VMAXF32,
+    // V1.as_uint32[i] = (V2.as_float32[i] == V3.as_float32[i])? all ones : 0, for the 4 lanes
+    INST_VEQF32,
+    // V1.as_uint32[i] = (V2.as_float32[i] > V3.as_float32[i])? all ones : 0, for the 4 lanes
+    INST_VBIGF32,
+    // V1.as_float64[i] = V2.as_float64[i] + V3.as_float64[i], for the 2 lanes
+    INST_VADDF64,
+    // V1.as_float64[i] = V2.as_float64[i] - V3.as_float64[i], for the 2 lanes
+    INST_VSUBF64,
+    // V1.as_float64[i] = V2.as_float64[i] * V3.as_float64[i], for the 2 lanes
+    INST_VMULF64,
+    // V1.as_float64[i] = (V2.as_float64[i] < V3.as_float64[i])? V2.as_float64[i] : V3.as_float64[i], for the 2 lanes
+    INST_VMINF64,
+    // V1.as_float64[i] = (V2.as_float64[i] > V3.as_float64[i])? V2.as_float64[i] : V3.as_float64[i], for the 2 lanes
+    INST_VMAXF64,
+    // V1.as_uint64[i] = (V2.as_float64[i] == V3.as_float64[i])? all ones : 0, for the 2 lanes
+    INST_VEQF64,
+    // V1.as_uint64[i] = (V2.as_float64[i] > V3.as_float64[i])? all ones : 0, for the 2 lanes
+    INST_VBIGF64,
+    // V1 = V2 & V3
+    INST_VAND,
+    // V1 = V2 | V3
+    INST_VOR,
+    // V1 = V2 ^ V3
+    INST_VXOR,
+    // V1.as_uint8[i] = (V3.as_uint8[i] & 0x80)? 0 : V2.as_uint8[V3.as_uint8[i] & 0x0F], for the 16 lanes
+    INST_VSHUF,
+    // V1 = *(128 bits*)(R2.as_ptr + R3.as_int64)
+    INST_VLOAD,
+    // *(128 bits*)(R1.as_ptr + R3.as_int64) = V2
+    INST_VSTORE,
+    // V1.as_uint8[i] = R2.8, for the 16 lanes
+    INST_VSPLAT8,
+    // V1.as_uint16[i] = R2.16, for the 8 lanes
+    INST_VSPLAT16,
+    // V1.as_uint32[i] = R2.32, for the 4 lanes
+    INST_VSPLAT32,
+    // V1.as_uint64[i] = R2.64, for the 2 lanes
+    INST_VSPLAT64,
+    // R1.8 = V2.as_uint8[R3.as_uint64 % 16]
+    INST_VGET8,
+    // R1.16 = V2.as_uint16[R3.as_uint64 % 8]
+    INST_VGET16,
+    // R1.32 = V2.as_uint32[R3.as_uint64 % 4]
+    INST_VGET32,
+    // R1.64 = V2.as_uint64[R3.as_uint64 % 2]
+    INST_VGET64,
+    // V1.as_uint8[R3.as_uint64 % 16] = R2.8
+    INST_VSET8,
+    // V1.as_uint16[R3.as_uint64 % 8] = R2.16
+    INST_VSET16,
+    // V1.as_uint32[R3.as_uint64 % 4] = R2.32
+    INST_VSET32,
+    // V1.as_uint64[R3.as_uint64 % 2] = R2.64
+    INST_VSET64,
+    // R1 = strlen(R2.as_ptr)
+    INST_MSTRLEN,
+    // R1.as_ptr = memchr(R1.as_ptr, R2.8, R3.as_uint64) basically, 0 if none of the R3.as_uint64 bytes is R2.8
+    INST_MCHR,
+    // sets R3.as_uint64 uint32_t at R1.as_ptr to R2.32
+    INST_MFILL32,
+    // sets R3.as_uint64 uint64_t at R1.as_ptr to R2
+    INST_MFILL64,
+    // R1 = the CRC-32C of R3.as_uint64 bytes at R2.as_ptr continuing from R1.32 (0 for a new checksum)
+    INST_MCRC32,
+    // R1 = the XXH64 of R3.as_uint64 bytes at R2.as_ptr with R1 as the seed
+    INST_MHASH,
+    // R1 = the number of set bits in R3.as_uint64 bytes at R2.as_ptr
+    INST_MPOPCNT,
+    // R1.as_float64 = R2.as_float64 * R3.as_float64 + R1.as_float64, rounded once (fma)
+    INST_FMAF,
+    // R1.as_float64 = sqrt(R2.as_float64)
+    INST_SQRTF,
+    // R1.as_float64 = (R2.as_float64 < R3.as_float64)? R2.as_float64 : R3.as_float64
+    INST_MINF,
+    // R1.as_float64 = (R2.as_float64 > R3.as_float64)? R2.as_float64 : R3.as_float64
+    INST_MAXF,
+    // R1.as_float64 = floor(R2.as_float64)
+    INST_FLOORF,
+    // R1.as_float64 = ceil(R2.as_float64)
+    INST_CEILF,
+    // R1.as_float64 = R2.as_float64 rounded to the nearest integer, halves to the even one
+    INST_ROUNDF,
+    // R1.as_float32 = R2.as_float32 + R3.as_float32
+    INST_ADDF32,
+    // R1.as_float32 = R2.as_float32 - R3.as_float32
+    INST_SUBF32,
+    // R1.as_float32 = R2.as_float32 * R3.as_float32
+    INST_MULF32,
+    // R1.as_float32 = R2.as_float32 / R3.as_float32
+    INST_DIVF32,
+    // R1.as_float32 = R2.as_float32 * R3.as_float32 + R1.as_float32, rounded once (fmaf)
+    INST_FMAF32,
+    // R1.as_float32 = sqrt(R2.as_float32)
+    INST_SQRTF32,
+    // R1.8 = *(uint8_t*)(R2.as_ptr + R3.as_int64), an atomic acquire load
+    INST_ALOAD8,
+    // R1.16 = *(uint16_t*)(R2.as_ptr + R3.as_int64), an atomic acquire load
+    INST_ALOAD16,
+    // R1.32 = *(uint32_t*)(R2.as_ptr + R3.as_int64), an atomic acquire load
+    INST_ALOAD32,
+    // R1.64 = *(uint64_t*)(R2.as_ptr + R3.as_int64), an atomic acquire load
+    INST_ALOAD,
+    // *(uint8_t*)(R1.as_ptr + R3.as_int64) = R2.8, an atomic release store
+    INST_ASTORE8,
+    // *(uint16_t*)(R1.as_ptr + R3.as_int64) = R2.16, an atomic release store
+    INST_ASTORE16,
+    // *(uint32_t*)(R1.as_ptr + R3.as_int64) = R2.32, an atomic release store
+    INST_ASTORE32,
+    // *(uint64_t*)(R1.as_ptr + R3.as_int64) = R2.64, an atomic release store
+    INST_ASTORE,
+    // atomically: old = *(uint8_t*)R2.as_ptr, if(old == R1.8) *(uint8_t*)R2.as_ptr = R3.8, R1.8 = old
+    INST_ACAS8,
+    // atomically: old = *(uint16_t*)R2.as_ptr, if(old == R1.16) *(uint16_t*)R2.as_ptr = R3.16, R1.16 = old
+    INST_ACAS16,
+    // atomically: old = *(uint32_t*)R2.as_ptr, if(old == R1.32) *(uint32_t*)R2.as_ptr = R3.32, R1.32 = old
+    INST_ACAS32,
+    // atomically: old = *(uint64_t*)R2.as_ptr, if(old == R1.64) *(uint64_t*)R2.as_ptr = R3.64, R1.64 = old
+    INST_ACAS,
+    // atomically: R1.8 = *(uint8_t*)R2.as_ptr, *(uint8_t*)R2.as_ptr += R3.8
+    INST_AADD8,
+    // atomically: R1.16 = *(uint16_t*)R2.as_ptr, *(uint16_t*)R2.as_ptr += R3.16
+    INST_AADD16,
+    // atomically: R1.32 = *(uint32_t*)R2.as_ptr, *(uint32_t*)R2.as_ptr += R3.32
+    INST_AADD32,
+    // atomically: R1.64 = *(uint64_t*)R2.as_ptr, *(uint64_t*)R2.as_ptr += R3.64
+    INST_AADD,
+    // atomically: R1.8 = *(uint8_t*)R2.as_ptr, *(uint8_t*)R2.as_ptr |= R3.8
+    INST_AOR8,
+    // atomically: R1.16 = *(uint16_t*)R2.as_ptr, *(uint16_t*)R2.as_ptr |= R3.16
+    INST_AOR16,
+    // atomically: R1.32 = *(uint32_t*)R2.as_ptr, *(uint32_t*)R2.as_ptr |= R3.32
+    INST_AOR32,
+    // atomically: R1.64 = *(uint64_t*)R2.as_ptr, *(uint64_t*)R2.as_ptr |= R3.64
+    INST_AOR,
+    // atomically: R1.8 = *(uint8_t*)R2.as_ptr, *(uint8_t*)R2.as_ptr = R3.8
+    INST_AXCHG8,
+    // atomically: R1.16 = *(uint16_t*)R2.as_ptr, *(uint16_t*)R2.as_ptr = R3.16
+    INST_AXCHG16,
+    // atomically: R1.32 = *(uint32_t*)R2.as_ptr, *(uint32_t*)R2.as_ptr = R3.32
+    INST_AXCHG32,
+    // atomically: R1.64 = *(uint64_t*)R2.as_ptr, *(uint64_t*)R2.as_ptr = R3.64
+    INST_AXCHG,
+    // a full memory fence, no memory access moves across it
+    INST_FENCE,
     // for counting putposes
     INST_TOTAL_COUNT,
-    // a dummy instruction that serves to hold immediate values, no use yet...
+    // a dummy instruction that serves to hold immediate values, the payload of wide instructions,
+    // its 24 high bits are part of the literal of the wide instruction before it and it can't be executed
     INST_CONTAINER = 254,
     // this instruction is used for parsing purposes to signal an error while parsing a file, IT SHOULD NEVER APPEAR IN YOUR PROGRAM
     INST_ERROR = 255
@@ -235,9 +450,13 @@ enum Expects{
     // LITERAL OR REGISTER
     EXPECT_OP_EITHER,
     EXPECT_OPTIONAL,
+    // LITERAL OF A WIDE INSTRUCTION, UP TO 64 BITS
+    EXPECT_OP_WIDE_LIT,
+    // VECTOR REGISTER, V0 TO V15
+    EXPECT_OP_VREG,
 };
 
-// R: REGISTER, L: LITERAL, E: EITHER LITERAL OR REGISTER ID
+// R: REGISTER, L: LITERAL, W: WIDE LITERAL, E: EITHER LITERAL OR REGISTER ID, V: VECTOR REGISTER
 typedef enum OpProfile{
 
     OP_PROFILE_NONE = EXPECT_ANY,
@@ -245,15 +464,27 @@ typedef enum OpProfile{
     OP_PROFILE_R = EXPECT_OP_REG,
     // instruction takes one literal
     OP_PROFILE_L = EXPECT_OP_LIT,
+    // instruction takes one wide literal
+    OP_PROFILE_W = EXPECT_OP_WIDE_LIT,
     // instruction takes either a literal or a register
     OP_PROFILE_E = EXPECT_OP_EITHER,
     // instruction takes two registers
     OP_PROFILE_RR = (EXPECT_OP_REG << 8) | EXPECT_OP_REG,
     // instruction takes one register and a literal
     OP_PROFILE_RL = (EXPECT_OP_LIT << 8) | EXPECT_OP_REG,
+    // instruction takes one register and a wide literal
+    OP_PROFILE_RW = (EXPECT_OP_WIDE_LIT << 8) | EXPECT_OP_REG,
     // instruction takes three registers
     OP_PROFILE_RRR = (EXPECT_OP_REG << 16) | (EXPECT_OP_REG << 8) | EXPECT_OP_REG,
-    OP_PROFILE_RROR = ((EXPECT_OPTIONAL << 20) | (EXPECT_OP_REG << 16)) | (EXPECT_OP_REG << 8) | EXPECT_OP_REG
+    OP_PROFILE_RROR = ((EXPECT_OPTIONAL << 20) | (EXPECT_OP_REG << 16)) | (EXPECT_OP_REG << 8) | EXPECT_OP_REG,
+    // instruction takes a vector register and a register
+    OP_PROFILE_VR = (EXPECT_OP_REG << 8) | EXPECT_OP_VREG,
+    // instruction takes three vector registers
+    OP_PROFILE_VVV = (EXPECT_OP_VREG << 16) | (EXPECT_OP_VREG << 8) | EXPECT_OP_VREG,
+    // instruction takes a vector register and two registers
+    OP_PROFILE_VRR = (EXPECT_OP_REG << 16) | (EXPECT_OP_REG << 8) | EXPECT_OP_VREG,
+    // instruction takes a register, a vector register and a register
+    OP_PROFILE_RVR = (EXPECT_OP_REG << 16) | (EXPECT_OP_VREG << 8) | EXPECT_OP_REG
 
 } OpProfile;
 
@@ -352,6 +583,24 @@ typedef union Register{
     void* 	 as_ptr;
 } Register;
 
+// the vector registers, V0 to V15, are 128 bits each and come right after the registers in the register space,
+// a vector register operand is the number of the register, its high 4 bits are ignored
+#define VECTOR_REGISTER_COUNT 16
+
+typedef union VRegister{
+
+    uint8_t  as_uint8[16];
+    uint16_t as_uint16[8];
+    uint32_t as_uint32[4];
+    uint64_t as_uint64[2];
+
+    float    as_float32[4];
+    double   as_float64[2];
+} VRegister;
+
+// the bytes of the register space, the registers and the vector registers after them
+#define VPU_REGISTER_SPACE_SIZE (REGISTER_SPACE_SIZE + VECTOR_REGISTER_COUNT * sizeof(VRegister))
+
 // Virtual Processing Unit
 typedef struct VPU
 {
@@ -368,16 +617,346 @@ typedef struct VPU
 
     Inst*       program;
 
+    // in instructions, running past it ends the program
+    uint64_t    program_size;
+
     uint64_t*   stack;
     
 } VPU;
 
 #define GET_REG(register_space, POS) ((Register*)((uintptr_t)(register_space) + POS))
 
+#define GET_VREG(register_space, POS) ((VRegister*)((uintptr_t)(register_space) + REGISTER_SPACE_SIZE + ((POS) & (VECTOR_REGISTER_COUNT - 1)) * sizeof(VRegister)))
+
 #define GET_OP_HINT(INST) (INST >> 31)
 
+// the memory operand of the atomic instructions (ALOAD, ASTORE, ACAS...) as a C11 atomic, it has to be aligned to its size
+#define VPU_ATOMIC(BITS, ADDRESS) ((_Atomic uint##BITS##_t*)(uintptr_t)(ADDRESS))
+
+// the assembly name of every opcode, indexed by opcode
+static inline const char* get_inst_name(int opcode){
+    static const char* const names[INST_TOTAL_COUNT] = {
+        [INST_NOP]       = "NOP",
+        [INST_HALT]      = "HALT",
+        [INST_MOV8]      = "MOV8",
+        [INST_MOV16]     = "MOV16",
+        [INST_MOV32]     = "MOV32",
+        [INST_MOV]       = "MOV",
+        [INST_MOVC]      = "MOVC",
+        [INST_MOVV]      = "MOVV",
+        [INST_MOVN]      = "MOVN",
+        [INST_MOVV16]    = "MOVV16",
+        [INST_PUSH]      = "PUSH",
+        [INST_POP]       = "POP",
+        [INST_STACK_GET] = "STACK_GET",
+        [INST_STACK_PUT] = "STACK_PUT",
+        [INST_GSP]       = "GSP",
+        [INST_STATIC]    = "STATIC",
+        [INST_READ8]     = "READ8",
+        [INST_READ16]    = "READ16",
+        [INST_READ32]    = "READ32",
+        [INST_READ]      = "READ",
+        [INST_MREADS]    = "MREADS",
+        [INST_WRITE8]    = "WRITE8",
+        [INST_WRITE16]   = "WRITE16",
+        [INST_WRITE32]   = "WRITE32",
+        [INST_WRITE]     = "WRITE",
+        [INST_MWRITES]   = "MWRITES",
+        [INST_MMOVS]     = "MMOVS",
+        [INST_MEMCMP]    = "MEMCMP",
+        [INST_NOT]       = "NOT",
+        [INST_NEG]       = "NEG",
+        [INST_AND]       = "AND",
+        [INST_NAND]      = "NAND",
+        [INST_OR]        = "OR",
+        [INST_XOR]       = "XOR",
+        [INST_BSHIFT]    = "BSHIFT",
+        [INST_JMP]       = "JMP",
+        [INST_JMPF]      = "JMPF",
+        [INST_JMPFN]     = "JMPFN",
+        [INST_CALL]      = "CALL",
+        [INST_RET]       = "RET",
+        [INST_ADD8]      = "ADD8",
+        [INST_SUB8]      = "SUB8",
+        [INST_MUL8]      = "MUL8",
+        [INST_ADD16]     = "ADD16",
+        [INST_SUB16]     = "SUB16",
+        [INST_MUL16]     = "MUL16",
+        [INST_ADD32]     = "ADD32",
+        [INST_SUB32]     = "SUB32",
+        [INST_MUL32]     = "MUL32",
+        [INST_ADD]       = "ADD",
+        [INST_SUB]       = "SUB",
+        [INST_MUL]       = "MUL",
+        [INST_DIVI]      = "DIVI",
+        [INST_DIVU]      = "DIVU",
+        [INST_ADDF]      = "ADDF",
+        [INST_SUBF]      = "SUBF",
+        [INST_MULF]      = "MULF",
+        [INST_DIVF]      = "DIVF",
+        [INST_INC]       = "INC",
+        [INST_DEC]       = "DEC",
+        [INST_INCF]      = "INCF",
+        [INST_DECF]      = "DECF",
+        [INST_ABS]       = "ABS",
+        [INST_ABSF]      = "ABSF",
+        [INST_NEQ]       = "NEQ",
+        [INST_EQ]        = "EQ",
+        [INST_EQF]       = "EQF",
+        [INST_BIGI]      = "BIGI",
+        [INST_BIGU]      = "BIGU",
+        [INST_BIGF]      = "BIGF",
+        [INST_SMLI]      = "SMLI",
+        [INST_SMLU]      = "SMLU",
+        [INST_SMLF]      = "SMLF",
+        [INST_CASTIU]    = "CASTIU",
+        [INST_CASTIF]    = "CASTIF",
+        [INST_CASTUI]    = "CASTUI",
+        [INST_CASTUF]    = "CASTUF",
+        [INST_CASTFI]    = "CASTFI",
+        [INST_CASTFU]    = "CASTFU",
+        [INST_CF3264]    = "CF3264",
+        [INST_CF6432]    = "CF6432",
+        [INST_FLOAT]     = "FLOAT",
+        [INST_DUMPCHAR]  = "DUMPCHAR",
+        [INST_GETCHAR]   = "GETCHAR",
+        [INST_EXEC]      = "EXEC",
+        [INST_SYS]       = "SYS",
+        [INST_DISREG]    = "DISREG",
+        [INST_GRP]       = "GRP",
+        [INST_GIP]       = "GIP",
+        [INST_MOVVW]     = "MOVVW",
+        [INST_MOVVL]     = "MOVVL",
+        [INST_JMPW]      = "JMPW",
+        [INST_JMPFW]     = "JMPFW",
+        [INST_JMPFNW]    = "JMPFNW",
+        [INST_CALLW]     = "CALLW",
+        [INST_VADD8]     = "VADD8",
+        [INST_VSUB8]     = "VSUB8",
+        [INST_VMUL8]     = "VMUL8",
+        [INST_VMIN8]     = "VMIN8",
+        [INST_VMAX8]     = "VMAX8",
+        [INST_VEQ8]      = "VEQ8",
+        [INST_VBIG8]     = "VBIG8",
+        [INST_VADD16]    = "VADD16",
+        [INST_VSUB16]    = "VSUB16",
+        [INST_VMUL16]    = "VMUL16",
+        [INST_VMIN16]    = "VMIN16",
+        [INST_VMAX16]    = "VMAX16",
+        [INST_VEQ16]     = "VEQ16",
+        [INST_VBIG16]    = "VBIG16",
+        [INST_VADD32]    = "VADD32",
+        [INST_VSUB32]    = "VSUB32",
+        [INST_VMUL32]    = "VMUL32",
+        [INST_VMIN32]    = "VMIN32",
+        [INST_VMAX32]    = "VMAX32",
+        [INST_VEQ32]     = "VEQ32",
+        [INST_VBIG32]    = "VBIG32",
+        [INST_VADDF32]   = "VADDF32",
+        [INST_VSUBF32]   = "VSUBF32",
+        [INST_VMULF32]   = "VMULF32",
+        [INST_VMINF32]   = "VMINF32",
+        [INST_VMAXF32]   = "VMAXF32",
+        [INST_VEQF32]    = "VEQF32",
+        [INST_VBIGF32]   = "VBIGF32",
+        [INST_VADDF64]   = "VADDF64",
+        [INST_VSUBF64]   = "VSUBF64",
+        [INST_VMULF64]   = "VMULF64",
+        [INST_VMINF64]   = "VMINF64",
+        [INST_VMAXF64]   = "VMAXF64",
+        [INST_VEQF64]    = "VEQF64",
+        [INST_VBIGF64]   = "VBIGF64",
+        [INST_VAND]      = "VAND",
+        [INST_VOR]       = "VOR",
+        [INST_VXOR]      = "VXOR",
+        [INST_VSHUF]     = "VSHUF",
+        [INST_VLOAD]     = "VLOAD",
+        [INST_VSTORE]    = "VSTORE",
+        [INST_VSPLAT8]   = "VSPLAT8",
+        [INST_VSPLAT16]  = "VSPLAT16",
+        [INST_VSPLAT32]  = "VSPLAT32",
+        [INST_VSPLAT64]  = "VSPLAT64",
+        [INST_VGET8]     = "VGET8",
+        [INST_VGET16]    = "VGET16",
+        [INST_VGET32]    = "VGET32",
+        [INST_VGET64]    = "VGET64",
+        [INST_VSET8]     = "VSET8",
+        [INST_VSET16]    = "VSET16",
+        [INST_VSET32]    = "VSET32",
+        [INST_VSET64]    = "VSET64",
+        [INST_MSTRLEN]   = "MSTRLEN",
+        [INST_MCHR]      = "MCHR",
+        [INST_MFILL32]   = "MFILL32",
+        [INST_MFILL64]   = "MFILL64",
+        [INST_MCRC32]    = "MCRC32",
+        [INST_MHASH]     = "MHASH",
+        [INST_MPOPCNT]   = "MPOPCNT",
+        [INST_FMAF]      = "FMAF",
+        [INST_SQRTF]     = "SQRTF",
+        [INST_MINF]      = "MINF",
+        [INST_MAXF]      = "MAXF",
+        [INST_FLOORF]    = "FLOORF",
+        [INST_CEILF]     = "CEILF",
+        [INST_ROUNDF]    = "ROUNDF",
+        [INST_ADDF32]    = "ADDF32",
+        [INST_SUBF32]    = "SUBF32",
+        [INST_MULF32]    = "MULF32",
+        [INST_DIVF32]    = "DIVF32",
+        [INST_FMAF32]    = "FMAF32",
+        [INST_SQRTF32]   = "SQRTF32",
+        [INST_ALOAD8]    = "ALOAD8",
+        [INST_ALOAD16]   = "ALOAD16",
+        [INST_ALOAD32]   = "ALOAD32",
+        [INST_ALOAD]     = "ALOAD",
+        [INST_ASTORE8]   = "ASTORE8",
+        [INST_ASTORE16]  = "ASTORE16",
+        [INST_ASTORE32]  = "ASTORE32",
+        [INST_ASTORE]    = "ASTORE",
+        [INST_ACAS8]     = "ACAS8",
+        [INST_ACAS16]    = "ACAS16",
+        [INST_ACAS32]    = "ACAS32",
+        [INST_ACAS]      = "ACAS",
+        [INST_AADD8]     = "AADD8",
+        [INST_AADD16]    = "AADD16",
+        [INST_AADD32]    = "AADD32",
+        [INST_AADD]      = "AADD",
+        [INST_AOR8]      = "AOR8",
+        [INST_AOR16]     = "AOR16",
+        [INST_AOR32]     = "AOR32",
+        [INST_AOR]       = "AOR",
+        [INST_AXCHG8]    = "AXCHG8",
+        [INST_AXCHG16]   = "AXCHG16",
+        [INST_AXCHG32]   = "AXCHG32",
+        [INST_AXCHG]     = "AXCHG",
+        [INST_FENCE]     = "FENCE",
+    };
+    if(opcode < 0 || opcode >= INST_TOTAL_COUNT) return "?";
+    return names[opcode];
+}
+
+// the different ways a loaded program can be executed
+typedef enum VpuEngine{
+    // perform_inst is called once per instruction, this is the reference implementation
+    VPU_ENGINE_SWITCH = 0,
+    // decode and dispatch in a single function with threaded jumps between handlers, see threaded.c
+    VPU_ENGINE_THREADED,
+    // translates the whole program to x86-64 machine code before running it, see jit.c
+    VPU_ENGINE_JIT,
+
+    // for counting purposes
+    VPU_ENGINE_COUNT
+} VpuEngine;
+
+static inline const char* get_engine_str(VpuEngine engine){
+    switch (engine)
+    {
+    case VPU_ENGINE_SWITCH:     return "switch";
+    case VPU_ENGINE_THREADED:   return "threaded";
+    case VPU_ENGINE_JIT:        return "jit";
+    default:                    return "unknown";
+    }
+}
+
+// the engine used when none is requested, can be changed at build time
+#ifndef VPU_DEFAULT_ENGINE
+#define VPU_DEFAULT_ENGINE VPU_ENGINE_THREADED
+#endif
+
+// how execute should run a program
+typedef struct ExecuteOptions{
+    VpuEngine   engine;
+    // print execution statistics to stderr once the program finishes
+    int         stats;
+    // run on the profiler instead of engine and print the hot spots to stderr, see profiler.c
+    int         profile;
+    // if not NULL the profiler also writes the call stacks it saw to this path, in the collapsed format of flamegraph tools
+    const char* profile_stacks;
+    // the size of the VPU stack in bytes, 0 for the default, see stack.c
+    uint64_t    stack_size;
+} ExecuteOptions;
+
 int64_t perform_inst(VPU* vpu, Inst inst);
 
+// how many of the operands of inst are registers (counting from the first one),
+// instructions taking either a register or a literal depend on the hint
+int get_inst_register_operands(Inst inst){
+    switch (inst & 0xFF)
+    {
+    case INST_NOP: case INST_RET: case INST_FENCE:
+        return 0;
+    case INST_HALT: case INST_PUSH: case INST_STATIC: case INST_JMP: case INST_CALL: case INST_SYS:
+        return (GET_OP_HINT(inst) == HINT_REG)? 1 : 0;
+    case INST_JMPW: case INST_CALLW:
+        return 0;
+    case INST_MOVV: case INST_MOVN: case INST_MOVV16: case INST_STACK_GET: case INST_STACK_PUT:
+    case INST_JMPF: case INST_JMPFN: case INST_INC: case INST_DEC: case INST_INCF: case INST_DECF:
+    case INST_MOVVW: case INST_MOVVL: case INST_JMPFW: case INST_JMPFNW:
+        return 1;
+    case INST_CONTAINER:
+        return 0;
+    default:
+        return 3;
+    }
+}
+
+// wide instructions are followed by INST_CONTAINER words holding the rest of their literal, the low 16 bits
+// of the literal are in the instruction itself (L2) and each container holds 24 more bits above its opcode
+// \returns how many containers follow an instruction with opcode
+static inline int get_inst_payload_size(int opcode){
+    switch (opcode)
+    {
+    case INST_MOVVW: case INST_JMPW: case INST_JMPFW: case INST_JMPFNW: case INST_CALLW:
+        return 1;
+    case INST_MOVVL:
+        return 2;
+    default:
+        return 0;
+    }
+}
+
+// \returns whether opcode is one of the vector instructions (VADD8 to VSET64)
+static inline int is_vector_inst(int opcode){
+    return opcode >= INST_VADD8 && opcode <= INST_VSET64;
+}
+
+// \returns the wide form of a jump, branch or call with a literal offset (its offset is 32 bits instead of 16),
+// INST_ERROR if opcode has none
+static inline int get_far_branch(int opcode){
+    switch (opcode)
+    {
+    case INST_JMP:   return INST_JMPW;
+    case INST_JMPF:  return INST_JMPFW;
+    case INST_JMPFN: return INST_JMPFNW;
+    case INST_CALL:  return INST_CALLW;
+    default:         return INST_ERROR;
+    }
+}
+
+// \returns the literal of the wide instruction at inst as it is loaded, its containers have to follow it
+static inline uint64_t get_wide_literal(const Inst* inst){
+    const uint64_t low = (uint16_t) (inst[0] >> 16);
+    if(get_inst_payload_size(inst[0] & 0xFF) == 1)
+        return (uint64_t)(int64_t)(int32_t)(uint32_t) (low | ((uint64_t)(uint16_t) (inst[1] >> 8) << 16));
+    return low | ((uint64_t) (inst[1] >> 8) << 16) | ((uint64_t) (inst[2] >> 8) << 40);
+}
+
+// \returns whether value can be the literal of a wide instruction with opcode
+static inline int fits_wide_literal(int opcode, uint64_t value){
+    return get_inst_payload_size(opcode) != 1 || (uint64_t)(int64_t)(int32_t) value == value;
+}
+
+// writes value as the literal of the wide instruction at inst and fills its containers,
+// value has to fit (see fits_wide_literal)
+static inline void set_wide_literal(Inst* inst, uint64_t value){
+    inst[0] = (inst[0] & 0xFFFF) | ((Inst)(uint16_t) value << 16);
+    if(get_inst_payload_size(inst[0] & 0xFF) == 1){
+        inst[1] = INST_CONTAINER | ((Inst)(uint16_t) (value >> 16) << 8);
+        return;
+    }
+    inst[1] = INST_CONTAINER | ((Inst) (value >> 16) << 8);
+    inst[2] = INST_CONTAINER | ((Inst) (value >> 40) << 8);
+}
+
 char get_digit_char(int i){
     switch (i)
     {
@@ -441,6 +1020,21 @@ char* get_reg_str(int reg, char* output){
     }
 }
 
+// writes the name of the vector register vreg (V0 to V15) to output, which needs 4 bytes
+char* get_vreg_str(int vreg, char* output){
+    vreg &= VECTOR_REGISTER_COUNT - 1;
+    output[0] = 'V';
+    if(vreg < 10){
+        output[1] = '0' + vreg;
+        output[2] = '\0';
+        return output;
+    }
+    output[1] = '1';
+    output[2] = '0' + (vreg - 10);
+    output[3] = '\0';
+    return output;
+}
+
 
 int print_inst_description(FILE* output, int inst){
     switch (inst)
@@ -812,6 +1406,431 @@ int print_inst_description(FILE* output, int inst){
 		fprintf(output, "GIP:\n");
 		fprintf(output, "\tR1.as_ptr = PROGRAM_BEGIN_POINTER + R2.as_uint64 * sizeof(Inst) + R3.as_uint64\n");
 		return 0;
+	case INST_MOVVW:
+		fprintf(output, "MOVVW:\n");
+		fprintf(output, "\tR1.as_int64 = L2.as_int32\n");
+		fprintf(output, "\tthe literal is wide, its high 16 bits are in the container that follows the instruction\n");
+		return 0;
+	case INST_MOVVL:
+		fprintf(output, "MOVVL:\n");
+		fprintf(output, "\tR1.as_uint64 = L2.as_uint64\n");
+		fprintf(output, "\tthe literal is wide, its high 48 bits are in the 2 containers that follow the instruction\n");
+		return 0;
+	case INST_JMPW:
+		fprintf(output, "JMPW:\n");
+		fprintf(output, "\tRIP += L2.as_int32\n");
+		fprintf(output, "\tthe literal is wide, its high 16 bits are in the container that follows the instruction\n");
+		return 0;
+	case INST_JMPFW:
+		fprintf(output, "JMPFW:\n");
+		fprintf(output, "\tif(R1.as_uint8 != 0x00) RIP += L2.as_int32\n");
+		fprintf(output, "\telse                    RIP += 2\n");
+		fprintf(output, "\tthe literal is wide, its high 16 bits are in the container that follows the instruction\n");
+		return 0;
+	case INST_JMPFNW:
+		fprintf(output, "JMPFNW:\n");
+		fprintf(output, "\tif(R1.as_uint8 == 0x00) RIP += L2.as_int32\n");
+		fprintf(output, "\telse                    RIP += 2\n");
+		fprintf(output, "\tthe literal is wide, its high 16 bits are in the container that follows the instruction\n");
+		return 0;
+	case INST_CALLW:
+		fprintf(output, "CALLW:\n");
+		fprintf(output, "\tSTACK[RSP++] = RIP.as_uint64 + 2\n");
+		fprintf(output, "\tRIP += L2.as_int32\n");
+		fprintf(output, "\tthe literal is wide, its high 16 bits are in the container that follows the instruction\n");
+		return 0;
+	case INST_VADD8:
+		fprintf(output, "VADD8:\n");
+		fprintf(output, "\tV1.as_uint8[i] = V2.as_uint8[i] + V3.as_uint8[i], for the 16 lanes\n");
+		return 0;
+	case INST_VSUB8:
+		fprintf(output, "VSUB8:\n");
+		fprintf(output, "\tV1.as_uint8[i] = V2.as_uint8[i] - V3.as_uint8[i], for the 16 lanes\n");
+		return 0;
+	case INST_VMUL8:
+		fprintf(output, "VMUL8:\n");
+		fprintf(output, "\tV1.as_uint8[i] = V2.as_uint8[i] * V3.as_uint8[i], for the 16 lanes\n");
+		return 0;
+	case INST_VMIN8:
+		fprintf(output, "VMIN8:\n");
+		fprintf(output, "\tV1.as_uint8[i] = (V2.as_uint8[i] < V3.as_uint8[i])? V2.as_uint8[i] : V3.as_uint8[i], for the 16 lanes\n");
+		return 0;
+	case INST_VMAX8:
+		fprintf(output, "VMAX8:\n");
+		fprintf(output, "\tV1.as_uint8[i] = (V2.as_uint8[i] > V3.as_uint8[i])? V2.as_uint8[i] : V3.as_uint8[i], for the 16 lanes\n");
+		return 0;
+	case INST_VEQ8:
+		fprintf(output, "VEQ8:\n");
+		fprintf(output, "\tV1.as_uint8[i] = (V2.as_uint8[i] == V3.as_uint8[i])? all ones : 0, for the 16 lanes\n");
+		return 0;
+	case INST_VBIG8:
+		fprintf(output, "VBIG8:\n");
+		fprintf(output, "\tV1.as_uint8[i] = (V2.as_uint8[i] > V3.as_uint8[i])? all ones : 0, for the 16 lanes\n");
+		return 0;
+	case INST_VADD16:
+		fprintf(output, "VADD16:\n");
+		fprintf(output, "\tV1.as_uint16[i] = V2.as_uint16[i] + V3.as_uint16[i], for the 8 lanes\n");
+		return 0;
+	case INST_VSUB16:
+		fprintf(output, "VSUB16:\n");
+		fprintf(output, "\tV1.as_uint16[i] = V2.as_uint16[i] - V3.as_uint16[i], for the 8 lanes\n");
+		return 0;
+	case INST_VMUL16:
+		fprintf(output, "VMUL16:\n");
+		fprintf(output, "\tV1.as_uint16[i] = V2.as_uint16[i] * V3.as_uint16[i], for the 8 lanes\n");
+		return 0;
+	case INST_VMIN16:
+		fprintf(output, "VMIN16:\n");
+		fprintf(output, "\tV1.as_uint16[i] = (V2.as_uint16[i] < V3.as_uint16[i])? V2.as_uint16[i] : V3.as_uint16[i], for the 8 lanes\n");
+		return 0;
+	case INST_VMAX16:
+		fprintf(output, "VMAX16:\n");
+		fprintf(output, "\tV1.as_uint16[i] = (V2.as_uint16[i] > V3.as_uint16[i])? V2.as_uint16[i] : V3.as_uint16[i], for the 8 lanes\n");
+		return 0;
+	case INST_VEQ16:
+		fprintf(output, "VEQ16:\n");
+		fprintf(output, "\tV1.as_uint16[i] = (V2.as_uint16[i] == V3.as_uint16[i])? all ones : 0, for the 8 lanes\n");
+		return 0;
+	case INST_VBIG16:
+		fprintf(output, "VBIG16:\n");
+		fprintf(output, "\tV1.as_uint16[i] = (V2.as_uint16[i] > V3.as_uint16[i])? all ones : 0, for the 8 lanes\n");
+		return 0;
+	case INST_VADD32:
+		fprintf(output, "VADD32:\n");
+		fprintf(output, "\tV1.as_uint32[i] = V2.as_uint32[i] + V3.as_uint32[i], for the 4 lanes\n");
+		return 0;
+	case INST_VSUB32:
+		fprintf(output, "VSUB32:\n");
+		fprintf(output, "\tV1.as_uint32[i] = V2.as_uint32[i] - V3.as_uint32[i], for the 4 lanes\n");
+		return 0;
+	case INST_VMUL32:
+		fprintf(output, "VMUL32:\n");
+		fprintf(output, "\tV1.as_uint32[i] = V2.as_uint32[i] * V3.as_uint32[i], for the 4 lanes\n");
+		return 0;
+	case INST_VMIN32:
+		fprintf(output, "VMIN32:\n");
+		fprintf(output, "\tV1.as_uint32[i] = (V2.as_uint32[i] < V3.as_uint32[i])? V2.as_uint32[i] : V3.as_uint32[i], for the 4 lanes\n");
+		return 0;
+	case INST_VMAX32:
+		fprintf(output, "VMAX32:\n");
+		fprintf(output, "\tV1.as_uint32[i] = (V2.as_uint32[i] > V3.as_uint32[i])? V2.as_uint32[i] : V3.as_uint32[i], for the 4 lanes\n");
+		return 0;
+	case INST_VEQ32:
+		fprintf(output, "VEQ32:\n");
+		fprintf(output, "\tV1.as_uint32[i] = (V2.as_uint32[i] == V3.as_uint32[i])? all ones : 0, for the 4 lanes\n");
+		return 0;
+	case INST_VBIG32:
+		fprintf(output, "VBIG32:\n");
+		fprintf(output, "\tV1.as_uint32[i] = (V2.as_uint32[i] > V3.as_uint32[i])? all ones : 0, for the 4 lanes\n");
+		return 0;
+	case INST_VADDF32:
+		fprintf(output, "VADDF32:\n");
+		fprintf(output, "\tV1.as_float32[i] = V2.as_float32[i] + V3.as_float32[i], for the 4 lanes\n");
+		return 0;
+	case INST_VSUBF32:
+		fprintf(output, "VSUBF32:\n");
+		fprintf(output, "\tV1.as_float32[i] = V2.as_float32[i] - V3.as_float32[i], for the 4 lanes\n");
+		return 0;
+	case INST_VMULF32:
+		fprintf(output, "VMULF32:\n");
+		fprintf(output, "\tV1.as_float32[i] = V2.as_float32[i] * V3.as_float32[i], for the 4 lanes\n");
+		return 0;
+	case INST_VMINF32:
+		fprintf(output, "VMINF32:\n");
+		fprintf(output, "\tV1.as_float32[i] = (V2.as_float32[i] < V3.as_float32[i])? V2.as_float32[i] : V3.as_float32[i], for the 4 lanes\n");
+		return 0;
+	case INST_VMAXF32:
+		fprintf(output, "VMAXF32:\n");
+		fprintf(output, "\tV1.as_float32[i] = (V2.as_float32[i] > V3.as_float32[i])? V2.as_float32[i] : V3.as_float32[i], for the 4 lanes\n");
+		return 0;
+	case INST_VEQF32:
+		fprintf(output, "VEQF32:\n");
+		fprintf(output, "\tV1.as_uint32[i] = (V2.as_float32[i] == V3.as_float32[i])? all ones : 0, for the 4 lanes\n");
+		return 0;
+	case INST_VBIGF32:
+		fprintf(output, "VBIGF32:\n");
+		fprintf(output, "\tV1.as_uint32[i] = (V2.as_float32[i] > V3.as_float32[i])? all ones : 0, for the 4 lanes\n");
+		return 0;
+	case INST_VADDF64:
+		fprintf(output, "VADDF64:\n");
+		fprintf(output, "\tV1.as_float64[i] = V2.as_float64[i] + V3.as_float64[i], for the 2 lanes\n");
+		return 0;
+	case INST_VSUBF64:
+		fprintf(output, "VSUBF64:\n");
+		fprintf(output, "\tV1.as_float64[i] = V2.as_float64[i] - V3.as_float64[i], for the 2 lanes\n");
+		return 0;
+	case INST_VMULF64:
+		fprintf(output, "VMULF64:\n");
+		fprintf(output, "\tV1.as_float64[i] = V2.as_float64[i] * V3.as_float64[i], for the 2 lanes\n");
+		return 0;
+	case INST_VMINF64:
+		fprintf(output, "VMINF64:\n");
+		fprintf(output, "\tV1.as_float64[i] = (V2.as_float64[i] < V3.as_float64[i])? V2.as_float64[i] : V3.as_float64[i], for the 2 lanes\n");
+		return 0;
+	case INST_VMAXF64:
+		fprintf(output, "VMAXF64:\n");
+		fprintf(output, "\tV1.as_float64[i] = (V2.as_float64[i] > V3.as_float64[i])? V2.as_float64[i] : V3.as_float64[i], for the 2 lanes\n");
+		return 0;
+	case INST_VEQF64:
+		fprintf(output, "VEQF64:\n");
+		fprintf(output, "\tV1.as_uint64[i] = (V2.as_float64[i] == V3.as_float64[i])? all ones : 0, for the 2 lanes\n");
+		return 0;
+	case INST_VBIGF64:
+		fprintf(output, "VBIGF64:\n");
+		fprintf(output, "\tV1.as_uint64[i] = (V2.as_float64[i] > V3.as_float64[i])? all ones : 0, for the 2 lanes\n");
+		return 0;
+	case INST_VAND:
+		fprintf(output, "VAND:\n");
+		fprintf(output, "\tV1 = V2 & V3\n");
+		return 0;
+	case INST_VOR:
+		fprintf(output, "VOR:\n");
+		fprintf(output, "\tV1 = V2 | V3\n");
+		return 0;
+	case INST_VXOR:
+		fprintf(output, "VXOR:\n");
+		fprintf(output, "\tV1 = V2 ^ V3\n");
+		return 0;
+	case INST_VSHUF:
+		fprintf(output, "VSHUF:\n");
+		fprintf(output, "\tV1.as_uint8[i] = (V3.as_uint8[i] & 0x80)? 0 : V2.as_uint8[V3.as_uint8[i] & 0x0F], for the 16 lanes\n");
+		return 0;
+	case INST_VLOAD:
+		fprintf(output, "VLOAD:\n");
+		fprintf(output, "\tV1 = *(128 bits*)(R2.as_ptr + R3.as_int64)\n");
+		return 0;
+	case INST_VSTORE:
+		fprintf(output, "VSTORE:\n");
+		fprintf(output, "\t*(128 bits*)(R1.as_ptr + R3.as_int64) = V2\n");
+		return 0;
+	case INST_VSPLAT8:
+		fprintf(output, "VSPLAT8:\n");
+		fprintf(output, "\tV1.as_uint8[i] = R2.8, for the 16 lanes\n");
+		return 0;
+	case INST_VSPLAT16:
+		fprintf(output, "VSPLAT16:\n");
+		fprintf(output, "\tV1.as_uint16[i] = R2.16, for the 8 lanes\n");
+		return 0;
+	case INST_VSPLAT32:
+		fprintf(output, "VSPLAT32:\n");
+		fprintf(output, "\tV1.as_uint32[i] = R2.32, for the 4 lanes\n");
+		return 0;
+	case INST_VSPLAT64:
+		fprintf(output, "VSPLAT64:\n");
+		fprintf(output, "\tV1.as_uint64[i] = R2.64, for the 2 lanes\n");
+		return 0;
+	case INST_VGET8:
+		fprintf(output, "VGET8:\n");
+		fprintf(output, "\tR1.8 = V2.as_uint8[R3.as_uint64 %% 16]\n");
+		return 0;
+	case INST_VGET16:
+		fprintf(output, "VGET16:\n");
+		fprintf(output, "\tR1.16 = V2.as_uint16[R3.as_uint64 %% 8]\n");
+		return 0;
+	case INST_VGET32:
+		fprintf(output, "VGET32:\n");
+		fprintf(output, "\tR1.32 = V2.as_uint32[R3.as_uint64 %% 4]\n");
+		return 0;
+	case INST_VGET64:
+		fprintf(output, "VGET64:\n");
+		fprintf(output, "\tR1.64 = V2.as_uint64[R3.as_uint64 %% 2]\n");
+		return 0;
+	case INST_VSET8:
+		fprintf(output, "VSET8:\n");
+		fprintf(output, "\tV1.as_uint8[R3.as_uint64 %% 16] = R2.8\n");
+		return 0;
+	case INST_VSET16:
+		fprintf(output, "VSET16:\n");
+		fprintf(output, "\tV1.as_uint16[R3.as_uint64 %% 8] = R2.16\n");
+		return 0;
+	case INST_VSET32:
+		fprintf(output, "VSET32:\n");
+		fprintf(output, "\tV1.as_uint32[R3.as_uint64 %% 4] = R2.32\n");
+		return 0;
+	case INST_VSET64:
+		fprintf(output, "VSET64:\n");
+		fprintf(output, "\tV1.as_uint64[R3.as_uint64 %% 2] = R2.64\n");
+		return 0;
+	case INST_MSTRLEN:
+		fprintf(output, "MSTRLEN:\n");
+		fprintf(output, "\tR1 = strlen(R2.as_ptr)\n");
+		return 0;
+	case INST_MCHR:
+		fprintf(output, "MCHR:\n");
+		fprintf(output, "\tR1.as_ptr = memchr(R1.as_ptr, R2.8, R3.as_uint64) basically, 0 if none of the R3.as_uint64 bytes is R2.8\n");
+		return 0;
+	case INST_MFILL32:
+		fprintf(output, "MFILL32:\n");
+		fprintf(output, "\tsets R3.as_uint64 uint32_t at R1.as_ptr to R2.32\n");
+		return 0;
+	case INST_MFILL64:
+		fprintf(output, "MFILL64:\n");
+		fprintf(output, "\tsets R3.as_uint64 uint64_t at R1.as_ptr to R2\n");
+		return 0;
+	case INST_MCRC32:
+		fprintf(output, "MCRC32:\n");
+		fprintf(output, "\tR1 = the CRC-32C of R3.as_uint64 bytes at R2.as_ptr continuing from R1.32 (0 for a new checksum)\n");
+		return 0;
+	case INST_MHASH:
+		fprintf(output, "MHASH:\n");
+		fprintf(output, "\tR1 = the XXH64 of R3.as_uint64 bytes at R2.as_ptr with R1 as the seed\n");
+		return 0;
+	case INST_MPOPCNT:
+		fprintf(output, "MPOPCNT:\n");
+		fprintf(output, "\tR1 = the number of set bits in R3.as_uint64 bytes at R2.as_ptr\n");
+		return 0;
+	case INST_FMAF:
+		fprintf(output, "FMAF:\n");
+		fprintf(output, "\tR1.as_float64 = R2.as_float64 * R3.as_float64 + R1.as_float64, rounded once (fma)\n");
+		return 0;
+	case INST_SQRTF:
+		fprintf(output, "SQRTF:\n");
+		fprintf(output, "\tR1.as_float64 = sqrt(R2.as_float64)\n");
+		return 0;
+	case INST_MINF:
+		fprintf(output, "MINF:\n");
+		fprintf(output, "\tR1.as_float64 = (R2.as_float64 < R3.as_float64)? R2.as_float64 : R3.as_float64\n");
+		return 0;
+	case INST_MAXF:
+		fprintf(output, "MAXF:\n");
+		fprintf(output, "\tR1.as_float64 = (R2.as_float64 > R3.as_float64)? R2.as_float64 : R3.as_float64\n");
+		return 0;
+	case INST_FLOORF:
+		fprintf(output, "FLOORF:\n");
+		fprintf(output, "\tR1.as_float64 = floor(R2.as_float64)\n");
+		return 0;
+	case INST_CEILF:
+		fprintf(output, "CEILF:\n");
+		fprintf(output, "\tR1.as_float64 = ceil(R2.as_float64)\n");
+		return 0;
+	case INST_ROUNDF:
+		fprintf(output, "ROUNDF:\n");
+		fprintf(output, "\tR1.as_float64 = R2.as_float64 rounded to the nearest integer, halves to the even one\n");
+		return 0;
+	case INST_ADDF32:
+		fprintf(output, "ADDF32:\n");
+		fprintf(output, "\tR1.as_float32 = R2.as_float32 + R3.as_float32\n");
+		return 0;
+	case INST_SUBF32:
+		fprintf(output, "SUBF32:\n");
+		fprintf(output, "\tR1.as_float32 = R2.as_float32 - R3.as_float32\n");
+		return 0;
+	case INST_MULF32:
+		fprintf(output, "MULF32:\n");
+		fprintf(output, "\tR1.as_float32 = R2.as_float32 * R3.as_float32\n");
+		return 0;
+	case INST_DIVF32:
+		fprintf(output, "DIVF32:\n");
+		fprintf(output, "\tR1.as_float32 = R2.as_float32 / R3.as_float32\n");
+		return 0;
+	case INST_FMAF32:
+		fprintf(output, "FMAF32:\n");
+		fprintf(output, "\tR1.as_float32 = R2.as_float32 * R3.as_float32 + R1.as_float32, rounded once (fmaf)\n");
+		return 0;
+	case INST_SQRTF32:
+		fprintf(output, "SQRTF32:\n");
+		fprintf(output, "\tR1.as_float32 = sqrt(R2.as_float32)\n");
+		return 0;
+	case INST_ALOAD8:
+		fprintf(output, "ALOAD8:\n");
+		fprintf(output, "\tR1.8 = *(uint8_t*)(R2.as_ptr + R3.as_int64), an atomic acquire load\n");
+		return 0;
+	case INST_ALOAD16:
+		fprintf(output, "ALOAD16:\n");
+		fprintf(output, "\tR1.16 = *(uint16_t*)(R2.as_ptr + R3.as_int64), an atomic acquire load\n");
+		return 0;
+	case INST_ALOAD32:
+		fprintf(output, "ALOAD32:\n");
+		fprintf(output, "\tR1.32 = *(uint32_t*)(R2.as_ptr + R3.as_int64), an atomic acquire load\n");
+		return 0;
+	case INST_ALOAD:
+		fprintf(output, "ALOAD:\n");
+		fprintf(output, "\tR1.64 = *(uint64_t*)(R2.as_ptr + R3.as_int64), an atomic acquire load\n");
+		return 0;
+	case INST_ASTORE8:
+		fprintf(output, "ASTORE8:\n");
+		fprintf(output, "\t*(uint8_t*)(R1.as_ptr + R3.as_int64) = R2.8, an atomic release store\n");
+		return 0;
+	case INST_ASTORE16:
+		fprintf(output, "ASTORE16:\n");
+		fprintf(output, "\t*(uint16_t*)(R1.as_ptr + R3.as_int64) = R2.16, an atomic release store\n");
+		return 0;
+	case INST_ASTORE32:
+		fprintf(output, "ASTORE32:\n");
+		fprintf(output, "\t*(uint32_t*)(R1.as_ptr + R3.as_int64) = R2.32, an atomic release store\n");
+		return 0;
+	case INST_ASTORE:
+		fprintf(output, "ASTORE:\n");
+		fprintf(output, "\t*(uint64_t*)(R1.as_ptr + R3.as_int64) = R2.64, an atomic release store\n");
+		return 0;
+	case INST_ACAS8:
+		fprintf(output, "ACAS8:\n");
+		fprintf(output, "\tatomically: old = *(uint8_t*)R2.as_ptr, if(old == R1.8) *(uint8_t*)R2.as_ptr = R3.8, R1.8 = old\n");
+		return 0;
+	case INST_ACAS16:
+		fprintf(output, "ACAS16:\n");
+		fprintf(output, "\tatomically: old = *(uint16_t*)R2.as_ptr, if(old == R1.16) *(uint16_t*)R2.as_ptr = R3.16, R1.16 = old\n");
+		return 0;
+	case INST_ACAS32:
+		fprintf(output, "ACAS32:\n");
+		fprintf(output, "\tatomically: old = *(uint32_t*)R2.as_ptr, if(old == R1.32) *(uint32_t*)R2.as_ptr = R3.32, R1.32 = old\n");
+		return 0;
+	case INST_ACAS:
+		fprintf(output, "ACAS:\n");
+		fprintf(output, "\tatomically: old = *(uint64_t*)R2.as_ptr, if(old == R1.64) *(uint64_t*)R2.as_ptr = R3.64, R1.64 = old\n");
+		return 0;
+	case INST_AADD8:
+		fprintf(output, "AADD8:\n");
+		fprintf(output, "\tatomically: R1.8 = *(uint8_t*)R2.as_ptr, *(uint8_t*)R2.as_ptr += R3.8\n");
+		return 0;
+	case INST_AADD16:
+		fprintf(output, "AADD16:\n");
+		fprintf(output, "\tatomically: R1.16 = *(uint16_t*)R2.as_ptr, *(uint16_t*)R2.as_ptr += R3.16\n");
+		return 0;
+	case INST_AADD32:
+		fprintf(output, "AADD32:\n");
+		fprintf(output, "\tatomically: R1.32 = *(uint32_t*)R2.as_ptr, *(uint32_t*)R2.as_ptr += R3.32\n");
+		return 0;
+	case INST_AADD:
+		fprintf(output, "AADD:\n");
+		fprintf(output, "\tatomically: R1.64 = *(uint64_t*)R2.as_ptr, *(uint64_t*)R2.as_ptr += R3.64\n");
+		return 0;
+	case INST_AOR8:
+		fprintf(output, "AOR8:\n");
+		fprintf(output, "\tatomically: R1.8 = *(uint8_t*)R2.as_ptr, *(uint8_t*)R2.as_ptr |= R3.8\n");
+		return 0;
+	case INST_AOR16:
+		fprintf(output, "AOR16:\n");
+		fprintf(output, "\tatomically: R1.16 = *(uint16_t*)R2.as_ptr, *(uint16_t*)R2.as_ptr |= R3.16\n");
+		return 0;
+	case INST_AOR32:
+		fprintf(output, "AOR32:\n");
+		fprintf(output, "\tatomically: R1.32 = *(uint32_t*)R2.as_ptr, *(uint32_t*)R2.as_ptr |= R3.32\n");
+		return 0;
+	case INST_AOR:
+		fprintf(output, "AOR:\n");
+		fprintf(output, "\tatomically: R1.64 = *(uint64_t*)R2.as_ptr, *(uint64_t*)R2.as_ptr |= R3.64\n");
+		return 0;
+	case INST_AXCHG8:
+		fprintf(output, "AXCHG8:\n");
+		fprintf(output, "\tatomically: R1.8 = *(uint8_t*)R2.as_ptr, *(uint8_t*)R2.as_ptr = R3.8\n");
+		return 0;
+	case INST_AXCHG16:
+		fprintf(output, "AXCHG16:\n");
+		fprintf(output, "\tatomically: R1.16 = *(uint16_t*)R2.as_ptr, *(uint16_t*)R2.as_ptr = R3.16\n");
+		return 0;
+	case INST_AXCHG32:
+		fprintf(output, "AXCHG32:\n");
+		fprintf(output, "\tatomically: R1.32 = *(uint32_t*)R2.as_ptr, *(uint32_t*)R2.as_ptr = R3.32\n");
+		return 0;
+	case INST_AXCHG:
+		fprintf(output, "AXCHG:\n");
+		fprintf(output, "\tatomically: R1.64 = *(uint64_t*)R2.as_ptr, *(uint64_t*)R2.as_ptr = R3.64\n");
+		return 0;
+	case INST_FENCE:
+		fprintf(output, "FENCE:\n");
+		fprintf(output, "\ta full memory fence, no memory access moves across it\n");
+		return 0;
     default:
         fprintf(output, "NO INSTRUCTION FOR %i\n", inst);
         return 1;
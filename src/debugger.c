@@ -310,7 +310,8 @@ int debugger_help(Debugger* debugger, int dupc){
         fprintf(
             debugger->output,
             "disreg <optional: registers>...:\n"
-            "    displays provided registers, or all vpu registers if none are provided\n"
+            "    displays provided registers, or all vpu registers if none are provided,\n"
+            "    vector registers (V0 to V15) are displayed byte by byte (lane 0 first) and as uint32, float32 and float64 lanes\n"
         );
         return 0;
     case DUPC_DISPLAY_INST:
@@ -419,7 +420,7 @@ int debug_display_inst(Debugger* debugger, uint64_t center, uint64_t width){
         if(i >= finish) break;
         if(debugger->signals[i] & DEBUG_SIGNAL_BREAK_MASK) fprintf(debugger->output, "!");
         else fprintf(debugger->output, "%*"PRIu64"- ", digit_len_max, i);
-        print_inst(debugger->output, debugger->program[i], buff);
+        print_program_inst(debugger->output, debugger->program, debugger->program_size, i, buff);
     }
     for(uint64_t lip = i + 1; found_label_ip && i == label_ip && i < finish; lip+=1){
         fprintf(debugger->output, "%.*s:\n", label_ip_strlen, label_ip_str);
@@ -433,7 +434,8 @@ int debug_display_inst(Debugger* debugger, uint64_t center, uint64_t width){
             fputc('\n', debugger->output);
         } else{
             if(debugger->signals[i] & DEBUG_SIGNAL_BREAK_MASK) fprintf(debugger->output, "!");
-            print_inst(debugger->output, debugger->program[i++], buff);
+            print_program_inst(debugger->output, debugger->program, debugger->program_size, i, buff);
+            i += 1;
         }
     }
     for(; i < finish; i+=1){
@@ -446,11 +448,26 @@ int debug_display_inst(Debugger* debugger, uint64_t center, uint64_t width){
         if(i >= finish) break;
         if(debugger->signals[i] & DEBUG_SIGNAL_BREAK_MASK) fprintf(debugger->output, "!");
         else fprintf(debugger->output, "%*"PRIu64"- ", digit_len_max, i);
-        print_inst(debugger->output, debugger->program[i], buff);
+        print_program_inst(debugger->output, debugger->program, debugger->program_size, i, buff);
     }
     return 0;
 }
 
+// displays the vector register vreg byte by byte (lane 0 first) and as uint32, float32 and float64 lanes
+static void debug_print_vreg(FILE* output, const uint8_t* register_space, int vreg){
+    VRegister v;
+    memcpy(&v, GET_VREG(register_space, vreg), sizeof(v));
+    char buff[4];
+    fprintf(output, "%s = (", get_vreg_str(vreg, buff));
+    for(int i = 0; i < 16; i+=1) fprintf(output, "%02"PRIx8, v.as_uint8[i]);
+    fprintf(
+        output, "; u32: %"PRIu32" %"PRIu32" %"PRIu32" %"PRIu32"; f32: %f %f %f %f; f64: %f %f)\n",
+        v.as_uint32[0], v.as_uint32[1], v.as_uint32[2], v.as_uint32[3],
+        v.as_float32[0], v.as_float32[1], v.as_float32[2], v.as_float32[3],
+        v.as_float64[0], v.as_float64[1]
+    );
+}
+
 int perform_user_prompt(Debugger* debugger, int code, int argc, char** argv){
 
     #define EXPECT_ARGC(expected_argc)\
@@ -558,7 +575,7 @@ int perform_user_prompt(Debugger* debugger, int code, int argc, char** argv){
     }
         break;
     case DUPC_RESTART:{
-        memset(debugger->vpu->register_space, 0, REGISTER_SPACE_SIZE);
+        memset(debugger->vpu->register_space, 0, VPU_REGISTER_SPACE_SIZE);
         GET_REG(debugger->vpu->register_space, RA)->as_int64    = debugger->argc;
         GET_REG(debugger->vpu->register_space, RB)->as_ptr      = (uint8_t*) debugger->argv;
         GET_REG(debugger->vpu->register_space, RIP)->as_uint64  = debugger->parser.entry_point;
@@ -663,15 +680,36 @@ int perform_user_prompt(Debugger* debugger, int code, int argc, char** argv){
             return 1;
         }
 
+        Inst wide_inst[3];
         const Inst inst = parse_inst(
             &debugger->parser, inst_profile,
-            (StringView){.str = inst_tkn.value.as_str, .size = inst_tkn.size}
+            (StringView){.str = inst_tkn.value.as_str, .size = inst_tkn.size}, wide_inst + 1
         );
         switch (inst & 0xFF)
         {
         case INST_ERROR:
             fprintf(debugger->output, "failed to parse '%s'\n", argv[1]);
             return 1;
+        case INST_MOVVW:
+        case INST_MOVVL:
+            // perform_inst would read the containers from the program, so the literal is loaded here
+            wide_inst[0] = inst;
+            GET_REG(debugger->vpu->register_space, (uint8_t) (inst >> 8))->as_uint64 = get_wide_literal(wide_inst);
+            GET_REG(debugger->vpu->register_space, R0)->as_uint64 = 0;
+            return 0;
+        case INST_JMPW:
+        case INST_JMPFW:
+        case INST_JMPFNW:
+        case INST_CALLW:{
+            // the same goes for the offset of the wide branches, they behave as if they were at RIP
+            wide_inst[0] = inst;
+            Register* const rip = GET_REG(debugger->vpu->register_space, RIP);
+            const int taken = ((inst & 0xFF) == INST_JMPW) || ((inst & 0xFF) == INST_CALLW) ||
+                ((GET_REG(debugger->vpu->register_space, (uint8_t) (inst >> 8))->as_uint8 != 0) == ((inst & 0xFF) == INST_JMPFW));
+            if((inst & 0xFF) == INST_CALLW)
+                debugger->vpu->stack[GET_REG(debugger->vpu->register_space, RSP)->as_uint64++] = rip->as_uint64 + 2;
+            rip->as_int64 += taken? (int64_t) get_wide_literal(wide_inst) : 2;
+        }   return 0;
         case INST_JMP:
         case INST_JMPF:
         case INST_JMPFN:
@@ -917,9 +955,16 @@ int perform_user_prompt(Debugger* debugger, int code, int argc, char** argv){
                     r.as_uint64, r.as_uint64, r.as_int64, r.as_float64
                 );
             }
+            for(int i = 0; i < VECTOR_REGISTER_COUNT; i+=1)
+                debug_print_vreg(debugger->output, debugger->vpu->register_space, i);
             break;
         }
         for(int i = 1; i < argc; i+=1){
+            const int vreg = get_vreg(get_token_from_cstr(argv[i]));
+            if(vreg >= 0){
+                debug_print_vreg(debugger->output, debugger->vpu->register_space, vreg);
+                continue;
+            }
             const int reg = get_reg(get_token_from_cstr(argv[i]));
             if(reg < 0){
                 fprintf(debugger->err, "[ERROR] No register '%s'\n", argv[i]);
@@ -1167,7 +1212,7 @@ int debug(const char* input_file, int argc, char** argv){
         VIRTUAL_FILE_STATIC_FIELD_NAME,
         NULL
     };
-    if(vfopen(&vfile, input_file, required_fields, optional_fields)){
+    if(vfmap(&vfile, input_file, required_fields, optional_fields)){
         fprintf(stderr, "[ERROR] debugger failed trying to open virtual file '%s'\n", input_file);
         return 1;
     }
@@ -1204,20 +1249,27 @@ int debug(const char* input_file, int argc, char** argv){
     VIRTUAL_DEBUG_LOG("setting up virtual processing unit\n");
     VPU vpu;
     vpu.program = (Inst*) program;
+    vpu.program_size = program_size;
     vpu.static_memory = static_memory;
 
-    Register registers[REGISTER_SPACE_SIZE / sizeof(Register)];
-    for(int i = 0; i < REGISTER_SPACE_SIZE / sizeof(Register); i+=1){
+    Register registers[VPU_REGISTER_SPACE_SIZE / sizeof(Register)];
+    for(int i = 0; i < VPU_REGISTER_SPACE_SIZE / sizeof(Register); i+=1){
         registers[i].as_uint64 = 0;
     }
     registers[RIP >> 3].as_uint64 = entry_point;
     vpu.register_space = (uint8_t*) registers;
 
-    vpu.stack = (uint64_t*) malloc(1024);
+    VpuStack stack;
+    if(create_vpu_stack(&stack, 0)){
+        vfclose(vfile);
+        return 1;
+    }
+    vpu.stack = stack.base;
 
     registers[RA >> 3].as_int64 = argc;
     registers[RB >> 3].as_ptr   = (uint8_t*) argv;
 
+    vpu.system = NULL;
     vpu.status = 0;
 
     VIRTUAL_DEBUG_LOG("setting up mini parser...\n");
@@ -1235,12 +1287,16 @@ int debug(const char* input_file, int argc, char** argv){
     parser.file_path_size = sizeof("stdin") - sizeof("");
     parser.labels = &labels;
     parser.local_labels = NULL;
+    parser.local_scope = NULL;
     parser.static_memory = NULL;
     parser.program = &dstream;
     parser.tokenizer = &tokenizer;
     parser.entry_point = entry_point;
     parser.flags = EXEFLAG_NONE;
     parser.macro_if_depth = 0;
+    parser.include_cache = NULL;
+    parser.include_record = NULL;
+    parser.relocations = NULL;
 
     VIRTUAL_DEBUG_LOG("setting up debugger...\n");
 
@@ -1319,7 +1375,8 @@ int debug(const char* input_file, int argc, char** argv){
 
 
     VIRTUAL_DEBUG_LOG("finnished debugging, cleaning up...\n");
-    free(vpu.stack);
+    release_label_index(&labels);
+    destroy_vpu_stack(&stack);
     mc_destroy_stream(dstream);
     free(debugger.signals);
     vfclose(vfile);
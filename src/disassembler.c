@@ -11,6 +11,30 @@
 #include "virtual.h"
 
 
+// prints the vector instruction inst, see is_vector_inst
+// \param buff should be an array of 3 buffers of size 8 bytes each
+static void print_vector_inst(FILE* output, Inst inst, char** buff){
+    const int op1 = (uint8_t) (inst >> 8), op2 = (uint8_t) (inst >> 16), op3 = (uint8_t) (inst >> 24);
+    const char* const name = get_inst_name(inst & 0XFF);
+    switch (inst & 0XFF)
+    {
+    case INST_VLOAD:
+    case INST_VSET8: case INST_VSET16: case INST_VSET32: case INST_VSET64:
+        fprintf(output, "\t%s %s %s %s\n", name, get_vreg_str(op1, buff[0]), get_reg_str(op2, buff[1]), get_reg_str(op3, buff[2]));
+        return;
+    case INST_VSTORE:
+    case INST_VGET8: case INST_VGET16: case INST_VGET32: case INST_VGET64:
+        fprintf(output, "\t%s %s %s %s\n", name, get_reg_str(op1, buff[0]), get_vreg_str(op2, buff[1]), get_reg_str(op3, buff[2]));
+        return;
+    case INST_VSPLAT8: case INST_VSPLAT16: case INST_VSPLAT32: case INST_VSPLAT64:
+        fprintf(output, "\t%s %s %s\n", name, get_vreg_str(op1, buff[0]), get_reg_str(op2, buff[1]));
+        return;
+    default:
+        fprintf(output, "\t%s %s %s %s\n", name, get_vreg_str(op1, buff[0]), get_vreg_str(op2, buff[1]), get_vreg_str(op3, buff[2]));
+        return;
+    }
+}
+
 // \param buff should be an array of 3 buffers of size 8 bytes each
 // \returns 0 on success or 1 otherwise
 int print_inst(FILE* output, Inst inst, char** buff){
@@ -292,6 +316,23 @@ int print_inst(FILE* output, Inst inst, char** buff){
     case INST_CF6432:
         fprintf(output, "\tCF6432 %s %s\n", get_reg_str(R1, buff[0]), get_reg_str(R2, buff[1]));
         return 0;
+    case INST_SQRTF:
+    case INST_FLOORF:
+    case INST_CEILF:
+    case INST_ROUNDF:
+    case INST_SQRTF32:
+        fprintf(output, "\t%s %s %s\n", get_inst_name(inst & 0XFF), get_reg_str(R1, buff[0]), get_reg_str(R2, buff[1]));
+        return 0;
+    case INST_FMAF:
+    case INST_MINF:
+    case INST_MAXF:
+    case INST_ADDF32:
+    case INST_SUBF32:
+    case INST_MULF32:
+    case INST_DIVF32:
+    case INST_FMAF32:
+        fprintf(output, "\t%s %s %s %s\n", get_inst_name(inst & 0XFF), get_reg_str(R1, buff[0]), get_reg_str(R2, buff[1]), get_reg_str(R3, buff[2]));
+        return 0;
 
     case INST_FLOAT:
         fprintf(output, "\tFLOAT %s %s %s\n", get_reg_str(R1, buff[0]), get_reg_str(R2, buff[1]), get_reg_str(R3, buff[2]));
@@ -322,11 +363,66 @@ int print_inst(FILE* output, Inst inst, char** buff){
 	case INST_GIP:
 	    fprintf(output, "\tGIP %s %s %s\n", get_reg_str(R1, buff[0]), get_reg_str(R2, buff[1]), get_reg_str(R3, buff[2]));
         return 0;
+	case INST_MOVVW:
+	case INST_MOVVL:
+	    // the rest of the literal is in the containers that follow, see print_program_inst
+	    fprintf(output, "\t%s %s 0x%04"PRIx16"; (low 16 bits of a wide literal)\n", get_inst_name(inst & 0XFF), get_reg_str(R1, buff[0]), L2);
+        return 0;
+    case INST_MSTRLEN:
+        fprintf(output, "\tMSTRLEN %s %s\n", get_reg_str(R1, buff[0]), get_reg_str(R2, buff[1]));
+        return 0;
+    case INST_MCHR:
+    case INST_MFILL32:
+    case INST_MFILL64:
+    case INST_MCRC32:
+    case INST_MHASH:
+    case INST_MPOPCNT:
+    case INST_ALOAD8:
+    case INST_ALOAD16:
+    case INST_ALOAD32:
+    case INST_ALOAD:
+    case INST_ASTORE8:
+    case INST_ASTORE16:
+    case INST_ASTORE32:
+    case INST_ASTORE:
+    case INST_ACAS8:
+    case INST_ACAS16:
+    case INST_ACAS32:
+    case INST_ACAS:
+    case INST_AADD8:
+    case INST_AADD16:
+    case INST_AADD32:
+    case INST_AADD:
+    case INST_AOR8:
+    case INST_AOR16:
+    case INST_AOR32:
+    case INST_AOR:
+    case INST_AXCHG8:
+    case INST_AXCHG16:
+    case INST_AXCHG32:
+    case INST_AXCHG:
+        fprintf(output, "\t%s %s %s %s\n", get_inst_name(inst & 0XFF), get_reg_str(R1, buff[0]), get_reg_str(R2, buff[1]), get_reg_str(R3, buff[2]));
+        return 0;
+    case INST_FENCE:
+        fprintf(output, "\tFENCE\n");
+        return 0;
+	case INST_JMPW:
+	case INST_CALLW:
+	    fprintf(output, "\t%s 0x%04"PRIx16"; (low 16 bits of a wide literal)\n", get_inst_name(inst & 0XFF), L2);
+        return 0;
+	case INST_JMPFW:
+	case INST_JMPFNW:
+	    fprintf(output, "\t%s %s 0x%04"PRIx16"; (low 16 bits of a wide literal)\n", get_inst_name(inst & 0XFF), get_reg_str(R1, buff[0]), L2);
+        return 0;
 
     case INST_CONTAINER:
         fprintf(output, "\tCONTAINER 0x%"PRIx32"\n", (inst & 0xFFFFFF00) >> 8);
         return 0;
     default:
+        if(is_vector_inst(inst & 0XFF)){
+            print_vector_inst(output, inst, buff);
+            return 0;
+        }
         fprintf(stderr, "[ERROR] Unkonwn Instruction OpCode %u\n", inst & 0xFF);
         return 1;
     }
@@ -338,6 +434,39 @@ int print_inst(FILE* output, Inst inst, char** buff){
     #undef L2
 }
 
+// \returns how many containers follow the instruction at program[ip], 0 if they are not all in the program
+static inline uint64_t get_program_inst_payload(const Inst* program, uint64_t program_size, uint64_t ip){
+    const uint64_t payload = (uint64_t) get_inst_payload_size(program[ip] & 0XFF);
+    return (ip + payload < program_size)? payload : 0;
+}
+
+// prints the instruction at program[ip] like print_inst, wide instructions are printed with their whole literal
+// \param buff should be an array of 3 buffers of size 8 bytes each
+// \returns 0 on success or 1 otherwise
+int print_program_inst(FILE* output, const Inst* program, uint64_t program_size, uint64_t ip, char** buff){
+    const Inst inst = program[ip];
+    if(!get_program_inst_payload(program, program_size, ip)) return print_inst(output, inst, buff);
+    const Register op = {.as_uint64 = get_wide_literal(program + ip)};
+    switch (inst & 0XFF)
+    {
+    case INST_MOVVW:
+        fprintf(output, "\tMOVVW %s %"PRIi64"; (0x%"PRIx64")\n", get_reg_str((uint8_t) (inst >> 8), buff[0]), op.as_int64, op.as_uint64);
+        return 0;
+    case INST_JMPW:
+    case INST_CALLW:
+        fprintf(output, "\t%s %"PRIi64"\n", get_inst_name(inst & 0XFF), op.as_int64);
+        return 0;
+    case INST_JMPFW:
+    case INST_JMPFNW:
+        fprintf(output, "\t%s %s %"PRIi64"\n", get_inst_name(inst & 0XFF), get_reg_str((uint8_t) (inst >> 8), buff[0]), op.as_int64);
+        return 0;
+    default:
+        break;
+    }
+    fprintf(output, "\tMOVVL %s 0x%02"PRIx64"; (u: %"PRIu64"; i: %"PRIi64"; f: %f)\n", get_reg_str((uint8_t) (inst >> 8), buff[0]), op.as_uint64, op.as_uint64, op.as_int64, op.as_float64);
+    return 0;
+}
+
 int disassembler_invalid_label(const uint8_t* labels, uint64_t current_label){
     const Label label = get_label_from_raw_data(labels + current_label);
     fprintf(
@@ -461,7 +590,8 @@ int disassemble(
     while (queried_stop < entry_point && i < entry_point && last_label < labels_byte_size)
     {
         for(; i < queried_stop && i < inst_count && !status; i+=1){
-            status = print_inst(output, program[i], buff);
+            status = print_program_inst(output, program, inst_count, i, buff);
+            i += get_program_inst_payload(program, inst_count, i);
         }
         if(status || i == inst_count) break;
         const Label l = get_label_from_raw_data(((uint8_t*) labels) + last_label);
@@ -478,14 +608,17 @@ int disassemble(
         if(i == queried_stop) break;
     }
     
-    for( ; (i < entry_point) && !status; i += 1)
-        status = print_inst(output, program[i], buff);
+    for( ; (i < entry_point) && !status; i += 1){
+        status = print_program_inst(output, program, inst_count, i, buff);
+        i += get_program_inst_payload(program, inst_count, i);
+    }
     if(!status) fprintf(output, "%s\n", "%start");
 
     while (i < inst_count && last_label < labels_byte_size && i < queried_stop)
     {
         for(; i < queried_stop && i < inst_count && !status; i+=1){
-            status = print_inst(output, program[i], buff);
+            status = print_program_inst(output, program, inst_count, i, buff);
+            i += get_program_inst_payload(program, inst_count, i);
         }
         if(status || i == inst_count) break;
         const Label label = get_label_from_raw_data(((uint8_t*) labels) + last_label);
@@ -510,8 +643,10 @@ int disassemble(
         current_label += label.size;
     }
 
-    for( ; (i < inst_count) && !status; i += 1)
-        status = print_inst(output, program[i], buff);
+    for( ; (i < inst_count) && !status; i += 1){
+        status = print_program_inst(output, program, inst_count, i, buff);
+        i += get_program_inst_payload(program, inst_count, i);
+    }
     
 
     if(status) fprintf(stderr, "[ERROR] At Instruction Position %" PRIu64 " ^^^\n", i);
@@ -9,6 +9,10 @@
 // \returns 0 on success or 1 otherwise
 int print_inst(FILE* output, Inst inst, char** buff);
 
+// prints the instruction at program[ip] like print_inst, wide instructions are printed with their whole literal
+// \returns 0 on success or 1 otherwise
+int print_program_inst(FILE* output, const Inst* program, uint64_t program_size, uint64_t ip, char** buff);
+
 // disassembles program in input_path, writing the result to output_path
 // \returns 0 on success or error identifier on failure
 int disassemble(
@@ -0,0 +1,334 @@
+#ifndef VIRTUAL_INCLUDE_CACHE_H
+#define VIRTUAL_INCLUDE_CACHE_H
+
+/*
+ * per include object cache of the assembler
+ *
+ * an included file is parsed against what the includer left behind: the labels defined so far and where the
+ * program and the static memory end. when assembling with a cache directory every %include of the file being
+ * assembled is recorded while it is parsed:
+ *     - the labels from outside of it it looked at (used, checked with %iflabel/%ifnlabel, redefined or
+ *       unlabeled) and how they were defined at that moment, or that they were not
+ *     - the files it included in turn and hashes of their contents
+ *     - the instructions and static memory it appended, the labels it added and removed, in order, and %start
+ * the record is saved to the cache directory as a VIRTUAL_FILE_TYPE_INCLUDE virtual file named after a hash
+ * of the include's path, its contents and the program and static sizes it was included at. the next time the
+ * same file is included at the same place the record is replayed instead of parsing the file again, as long
+ * as the files it included still hash the same and every label it looked at is still defined exactly as it was
+ * (or still missing). the replay appends exactly what parsing the file would have, so the executable does not
+ * depend on the cache. a miss or a stale or unreadable record simply parses the file and records it again.
+ *
+ * includes are recorded as a whole, the ones they include are part of their record and not cached separately.
+ */
+
+#include "virtual.h"
+#include "virtual_files.h"
+#include "labels.h"
+#include <stdio.h>
+#include <inttypes.h>
+#include <time.h>
+
+#ifdef _WIN32
+    #include <direct.h>
+#else
+    #include <sys/stat.h>
+#endif
+
+// bump whenever what is recorded or how it is replayed changes, older records then simply miss
+#define INCLUDE_CACHE_VERSION 1
+
+#define INCLUDE_CACHE_FILE_EXTENSION ".vo"
+
+#define INCLUDE_CACHE_KEY_FIELD_NAME    "key"
+#define INCLUDE_CACHE_FILES_FIELD_NAME  "files"
+#define INCLUDE_CACHE_DEPS_FIELD_NAME   "deps"
+#define INCLUDE_CACHE_CODE_FIELD_NAME   "code"
+#define INCLUDE_CACHE_OPS_FIELD_NAME    "ops"
+#define INCLUDE_CACHE_START_FIELD_NAME  "start"
+
+enum IncludeRecordLabelOp{
+    INCLUDE_RECORD_ADD_LABEL = 1,
+    INCLUDE_RECORD_REMOVE_LABEL
+};
+
+// where an include was included and what it contained, records are only replayed for the same key
+typedef struct IncludeKey{
+    uint64_t program_base;
+    uint64_t static_base;
+    uint64_t content_hash;
+    // names the record in the cache directory, also covers the path
+    uint64_t hash;
+} IncludeKey;
+
+typedef struct IncludeRecord{
+    // the names of the labels already looked at or changed by the include (a label stream used as a set)
+    Mc_stream_t seen;
+    // [u8 defined][u32 size][the label as it is in the label stream if defined, else its name]...
+    Mc_stream_t deps;
+    // [u64 content hash][u32 path size][path]...
+    Mc_stream_t files;
+    // [u8 IncludeRecordLabelOp][u32 size][the added label as it is in the label stream or the removed name]...
+    Mc_stream_t label_ops;
+} IncludeRecord;
+
+static inline IncludeKey make_include_key(const char* path, uint32_t path_size, const char* content, uint64_t content_size,
+    uint64_t program_base, uint64_t static_base){
+
+    IncludeKey key = (IncludeKey){.program_base = program_base, .static_base = static_base};
+    key.content_hash = mc_fnv1a64(MC_FNV1A64_OFFSET_BASIS, content, (size_t) content_size);
+
+    const uint32_t versions[] = {INCLUDE_CACHE_VERSION, INST_TOTAL_COUNT, TKN_STATIC_SIZE};
+    key.hash = mc_fnv1a64(MC_FNV1A64_OFFSET_BASIS, versions, sizeof(versions));
+    key.hash = mc_fnv1a64(key.hash, VERSION, sizeof(VERSION));
+    key.hash = mc_fnv1a64(key.hash, &path_size, sizeof(path_size));
+    key.hash = mc_fnv1a64(key.hash, path, path_size);
+    key.hash = mc_fnv1a64(key.hash, &key.content_hash, sizeof(key.content_hash));
+    key.hash = mc_fnv1a64(key.hash, &key.program_base, sizeof(key.program_base));
+    key.hash = mc_fnv1a64(key.hash, &key.static_base, sizeof(key.static_base));
+    return key;
+}
+
+static inline IncludeRecord create_include_record(void){
+    return (IncludeRecord){
+        .seen       = mc_create_stream(0, 0),
+        .deps       = mc_create_stream(0, 0),
+        .files      = mc_create_stream(0, 0),
+        .label_ops  = mc_create_stream(0, 0)
+    };
+}
+
+static inline void destroy_include_record(IncludeRecord* record){
+    release_label_index(&record->seen);
+    mc_destroy_stream(record->seen);
+    mc_destroy_stream(record->deps);
+    mc_destroy_stream(record->files);
+    mc_destroy_stream(record->label_ops);
+    memset(record, 0, sizeof(*record));
+}
+
+static inline void _include_record_entry(Mc_stream_t* stream, uint8_t tag, const void* data, uint32_t size){
+    mc_stream(stream, &tag, sizeof(tag));
+    mc_stream(stream, &size, sizeof(size));
+    mc_stream(stream, data, size);
+}
+
+// records that the include looked name up in labels, only the first look at a label it did not change itself matters
+static inline void include_record_label_read(IncludeRecord* record, const Mc_stream_t* labels, const Token name){
+    if(get_label(&record->seen, name)) return;
+    add_label(&record->seen, name, (Token){.type = TKN_EMPTY});
+    const uint8_t* const label = (const uint8_t*) get_label(labels, name);
+    if(label) _include_record_entry(&record->deps, 1, label, get_label_from_raw_data(label).size);
+    else      _include_record_entry(&record->deps, 0, name.value.as_str, (uint32_t) name.size);
+}
+
+// records that the include just added name to labels, after it looked it up with include_record_label_read
+static inline void include_record_label_added(IncludeRecord* record, const Mc_stream_t* labels, const Token name){
+    const uint8_t* const label = (const uint8_t*) get_label(labels, name);
+    if(label) _include_record_entry(&record->label_ops, INCLUDE_RECORD_ADD_LABEL, label, get_label_from_raw_data(label).size);
+}
+
+// records that the include just removed name from labels, after it looked it up with include_record_label_read
+static inline void include_record_label_removed(IncludeRecord* record, const Token name){
+    _include_record_entry(&record->label_ops, INCLUDE_RECORD_REMOVE_LABEL, name.value.as_str, (uint32_t) name.size);
+}
+
+static inline void include_record_file(IncludeRecord* record, const char* path, uint32_t path_size, const char* content, uint64_t content_size){
+    const uint64_t hash = mc_fnv1a64(MC_FNV1A64_OFFSET_BASIS, content, (size_t) content_size);
+    mc_stream(&record->files, &hash, sizeof(hash));
+    mc_stream(&record->files, &path_size, sizeof(path_size));
+    mc_stream(&record->files, path, path_size);
+}
+
+// creates the cache directory if it does not exist yet
+static inline void create_include_cache(const char* directory){
+#ifdef _WIN32
+    _mkdir(directory);
+#else
+    mkdir(directory, 0777);
+#endif
+}
+
+static inline void _include_cache_file_path(char* buffer, size_t buffer_size, const char* directory, const IncludeKey key){
+    snprintf(buffer, buffer_size, "%s/%016" PRIx64 INCLUDE_CACHE_FILE_EXTENSION, directory, key.hash);
+}
+
+// walks the [tag][u32 size][data] entries of deps and label ops
+// \returns the position of the next entry or 0 if the entry at position is truncated
+static inline uint64_t _include_cache_entry(const uint8_t* data, uint64_t data_size, uint64_t position,
+    uint8_t* tag, const uint8_t** entry, uint32_t* entry_size){
+    if(data_size - position < sizeof(*tag) + sizeof(*entry_size)) return 0;
+    *tag = data[position];
+    memcpy(entry_size, data + position + sizeof(*tag), sizeof(*entry_size));
+    position += sizeof(*tag) + sizeof(*entry_size);
+    if(data_size - position < *entry_size) return 0;
+    *entry = data + position;
+    return position + *entry_size;
+}
+
+static inline int _include_cache_files_unchanged(const uint8_t* files, uint64_t size){
+    Mc_stream_t content = mc_create_stream(0, 0);
+    char path[4096];
+    int unchanged = 1;
+    for(uint64_t i = 0; unchanged && i < size; ){
+        uint64_t hash;
+        uint32_t path_size;
+        if(size - i < sizeof(hash) + sizeof(path_size)){
+            unchanged = 0;
+            break;
+        }
+        memcpy(&hash, files + i, sizeof(hash));
+        memcpy(&path_size, files + i + sizeof(hash), sizeof(path_size));
+        i += sizeof(hash) + sizeof(path_size);
+        if(size - i < path_size || path_size >= sizeof(path)){
+            unchanged = 0;
+            break;
+        }
+        memcpy(path, files + i, path_size);
+        path[path_size] = '\0';
+        i += path_size;
+        content.size = 0;
+        // read_file_txt null terminates what it reads
+        unchanged = read_file_txt(&content, path, 0) && mc_fnv1a64(MC_FNV1A64_OFFSET_BASIS, content.data, (size_t) content.size - 1) == hash;
+    }
+    mc_destroy_stream(content);
+    return unchanged;
+}
+
+static inline int _include_cache_labels_unchanged(const Mc_stream_t* labels, const uint8_t* deps, uint64_t size){
+    for(uint64_t i = 0; i < size; ){
+        uint8_t defined;
+        const uint8_t* dep;
+        uint32_t dep_size;
+        i = _include_cache_entry(deps, size, i, &defined, &dep, &dep_size);
+        if(i == 0) return 0;
+        if(defined && dep_size < SIZEOF_LABEL) return 0;
+        const Label recorded = defined? get_label_from_raw_data(dep) : (Label){0};
+        if(defined && (recorded.size != dep_size || recorded.str > dep_size || recorded.str_size > dep_size - recorded.str)) return 0;
+        const Token name = defined?
+            (Token){.value.as_str = (char*) (dep + recorded.str), .size = recorded.str_size}
+            : (Token){.value.as_str = (char*) dep, .size = dep_size};
+        const uint8_t* const label = (const uint8_t*) get_label(labels, name);
+        if(!defined != !label) return 0;
+        if(label && (get_label_from_raw_data(label).size != dep_size || memcmp(label, dep, dep_size))) return 0;
+    }
+    return 1;
+}
+
+// replays the record of the include with key from the cache directory, when it is still valid
+// \returns 0 if it was replayed, 1 if the include has to be parsed or -1 if the record could not be replayed after
+// it was found valid, the labels may then be left half way
+static inline int replay_cached_include(const char* directory, const IncludeKey key, Mc_stream_t* labels,
+    Mc_stream_t* program, Mc_stream_t* static_memory, uint64_t* entry_point){
+
+    char path[4096];
+    _include_cache_file_path(path, sizeof(path), directory, key);
+
+    // a miss is the usual case and not an error, vfmap would complain about it
+    FILE* const exists = fopen(path, "rb");
+    if(!exists) return 1;
+    fclose(exists);
+
+    const char* required_fields[] = {
+        INCLUDE_CACHE_KEY_FIELD_NAME, INCLUDE_CACHE_FILES_FIELD_NAME, INCLUDE_CACHE_DEPS_FIELD_NAME,
+        INCLUDE_CACHE_CODE_FIELD_NAME, VIRTUAL_FILE_STATIC_FIELD_NAME, INCLUDE_CACHE_OPS_FIELD_NAME,
+        INCLUDE_CACHE_START_FIELD_NAME, NULL
+    };
+    VirtualFile vfile;
+    if(vfmap(&vfile, path, required_fields, NULL)) return 1;
+
+    int status = 1;
+
+    uint64_t key_size = 0, files_size = 0, deps_size = 0, code_size = 0, static_size = 0, ops_size = 0, start_size = 0;
+    const uint8_t* const recorded_key = get_virtual_file_field_data(vfile, INCLUDE_CACHE_KEY_FIELD_NAME, &key_size);
+    const uint8_t* const files  = get_virtual_file_field_data(vfile, INCLUDE_CACHE_FILES_FIELD_NAME, &files_size);
+    const uint8_t* const deps   = get_virtual_file_field_data(vfile, INCLUDE_CACHE_DEPS_FIELD_NAME, &deps_size);
+    const uint8_t* const code   = get_virtual_file_field_data(vfile, INCLUDE_CACHE_CODE_FIELD_NAME, &code_size);
+    const uint8_t* const data   = get_virtual_file_field_data(vfile, VIRTUAL_FILE_STATIC_FIELD_NAME, &static_size);
+    const uint8_t* const ops    = get_virtual_file_field_data(vfile, INCLUDE_CACHE_OPS_FIELD_NAME, &ops_size);
+    const uint8_t* const start  = get_virtual_file_field_data(vfile, INCLUDE_CACHE_START_FIELD_NAME, &start_size);
+
+    if(vfile.vfile_type != VIRTUAL_FILE_TYPE_INCLUDE || !_vf_native_endianness(vfile.file_flags)) goto defer;
+    if(!recorded_key || !files || !deps || !code || !data || !ops || !start) goto defer;
+    if(key_size != sizeof(key) || memcmp(recorded_key, &key, sizeof(key))) goto defer;
+    if(code_size % sizeof(Inst) || start_size != 2 * sizeof(uint64_t)) goto defer;
+    if(static_size && !static_memory) goto defer;
+    if(!_include_cache_labels_unchanged(labels, deps, deps_size)) goto defer;
+    if(!_include_cache_files_unchanged(files, files_size)) goto defer;
+
+    status = -1;
+
+    for(uint64_t i = 0; i < ops_size; ){
+        uint8_t op;
+        const uint8_t* entry;
+        uint32_t entry_size;
+        i = _include_cache_entry(ops, ops_size, i, &op, &entry, &entry_size);
+        if(i == 0) goto defer;
+        if(op == INCLUDE_RECORD_ADD_LABEL){
+            if(entry_size < SIZEOF_LABEL) goto defer;
+            const Label label = get_label_from_raw_data(entry);
+            if(label.size != entry_size || label.str > entry_size || label.str_size > entry_size - label.str) goto defer;
+            if(get_label(labels, (Token){.value.as_str = (char*) (entry + label.str), .size = label.str_size})) goto defer;
+            mc_stream(labels, entry, entry_size);
+        }
+        else if(op == INCLUDE_RECORD_REMOVE_LABEL){
+            if(remove_label(labels, (Token){.value.as_str = (char*) entry, .size = entry_size})) goto defer;
+        }
+        else goto defer;
+    }
+
+    mc_stream(program, code, (size_t) code_size);
+    if(static_size) mc_stream(static_memory, data, (size_t) static_size);
+
+    uint64_t start_changed;
+    memcpy(&start_changed, start, sizeof(start_changed));
+    if(start_changed) memcpy(entry_point, start + sizeof(start_changed), sizeof(*entry_point));
+
+    VIRTUAL_DEBUG_LOG("replayed include record '%s'\n", path);
+    status = 0;
+
+    defer:
+    vfclose(vfile);
+    return status;
+}
+
+// saves the record of the include with key to the cache directory, it appended code_size bytes of code and
+// static_size bytes of static memory and, if start_changed, set the entry point to entry_point
+// \returns 0 on success or 1 otherwise
+static inline int save_cached_include(const char* directory, const IncludeKey key, const IncludeRecord* record,
+    const void* code, uint64_t code_size, const void* static_data, uint64_t static_size, int start_changed, uint64_t entry_point){
+
+    char path[4096];
+    _include_cache_file_path(path, sizeof(path), directory, key);
+
+    VirtualFile vfile = create_virtual_file(
+        NULL,
+        is_little_endian()? VIRTUAL_FILE_INTERNAL_FLAG_IS_LITTLE_ENDIAN : 0,
+        VIRTUAL_FILE_TYPE_INCLUDE, 0, 0, NULL, NULL
+    );
+
+    const uint64_t start[2] = {(uint64_t) (start_changed != 0), start_changed? entry_point : 0};
+
+    add_virtual_file_field(&vfile, INCLUDE_CACHE_KEY_FIELD_NAME, sizeof(key), (void*) &key);
+    add_virtual_file_field(&vfile, INCLUDE_CACHE_FILES_FIELD_NAME, record->files.size, record->files.data);
+    add_virtual_file_field(&vfile, INCLUDE_CACHE_DEPS_FIELD_NAME, record->deps.size, record->deps.data);
+    add_virtual_file_field(&vfile, INCLUDE_CACHE_CODE_FIELD_NAME, code_size, (void*) code);
+    add_virtual_file_field(&vfile, VIRTUAL_FILE_STATIC_FIELD_NAME, static_size, (void*) static_data);
+    add_virtual_file_field(&vfile, INCLUDE_CACHE_OPS_FIELD_NAME, record->label_ops.size, record->label_ops.data);
+    add_virtual_file_field(&vfile, INCLUDE_CACHE_START_FIELD_NAME, sizeof(start), (void*) start);
+
+    // written aside and renamed into place so whoever replays the record never sees it half written
+    char temporary_path[4096 + 32];
+    snprintf(temporary_path, sizeof(temporary_path), "%s.%" PRIxPTR "%lx", path, (uintptr_t) record, (unsigned long) time(NULL));
+
+    int status = vfsave(vfile, temporary_path, NULL);
+    if(!status){
+        remove(path);
+        status = rename(temporary_path, path) != 0;
+    }
+    if(status) remove(temporary_path);
+
+    vfclose(vfile);
+    return status;
+}
+
+#endif // =====================  END OF FILE VIRTUAL_INCLUDE_CACHE_H ===========================
@@ -0,0 +1,922 @@
+#ifndef VJIT_C
+#define VJIT_C
+
+/*
+ * baseline template jit:
+ * every instruction of the program is translated once, in order, into a fixed x86-64 template.
+ * the VPU registers stay in their register space (a pinned register file addressed through rbx),
+ * so sub registers and pointers to registers (GRP) keep working exactly like in the interpreter.
+ * host registers while running:
+ *      rbx: register space     r12: VPU*       r13: stack
+ *      r14: native address of every instruction (for jumps through registers and RET)
+ *      r15: program size
+ * jumps with literal offsets become direct native jumps, jumps through registers, RET and anything
+ * that may change RIP go back through the dispatch stub, which reads RIP and jumps through r14.
+ * RIP in the register space is only updated when it can be observed: before calling back into C,
+ * before going through the dispatch stub and when leaving. instructions naming RIP as an operand
+ * are therefore compiled as a call to perform_inst, just like EXEC, the memory block instructions,
+ * the I/O instructions and any opcode the templates don't cover.
+ * only available on x86-64 with the System V calling convention (linux, macos, bsd),
+ * jit_compile fails elsewhere and execute falls back to the threaded engine.
+ */
+
+#include "core.h"
+#include "system.h"
+#include "virtual.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#if defined(__x86_64__) && !defined(_WIN32) && !defined(VPU_NO_JIT)
+    #define VPU_JIT_SUPPORTED 1
+    #include <sys/mman.h>
+#else
+    #define VPU_JIT_SUPPORTED 0
+#endif
+
+typedef void (*JitEntry)(VPU* vpu, void** targets);
+
+typedef struct JitProgram{
+    // the executable buffer
+    void*       code;
+    size_t      code_size;
+    // the native address of each instruction
+    void**      targets;
+    uint64_t    size;
+    // how many instructions were left to perform_inst
+    uint64_t    fallbacks;
+    JitEntry    entry;
+} JitProgram;
+
+#if VPU_JIT_SUPPORTED
+
+enum JitHostRegister{
+    JIT_RAX = 0, JIT_RCX, JIT_RDX, JIT_RBX, JIT_RSP, JIT_RBP, JIT_RSI, JIT_RDI,
+    JIT_R8, JIT_R9, JIT_R10, JIT_R11, JIT_R12, JIT_R13, JIT_R14, JIT_R15
+};
+
+// condition codes, the low nibble of jcc and setcc
+enum JitCondition{
+    JIT_CC_B  = 0x2, JIT_CC_AE = 0x3, JIT_CC_E  = 0x4, JIT_CC_NE = 0x5,
+    JIT_CC_A  = 0x7, JIT_CC_S  = 0x8, JIT_CC_NP = 0xB, JIT_CC_L  = 0xC, JIT_CC_G  = 0xF
+};
+
+// a rel32 that has to point to the native code of the instruction target once everything is emitted
+typedef struct JitFixup{
+    uint64_t position;
+    uint64_t target;
+} JitFixup;
+
+typedef struct JitCompiler{
+    Mc_stream_t code;
+    Mc_stream_t fixups;
+    // native offset of every instruction, relative to the start of code
+    uint64_t*   offsets;
+    uint64_t    size;
+    uint64_t    dispatch;
+    uint64_t    exit;
+    uint64_t    fallbacks;
+} JitCompiler;
+
+static inline void jit_u8(JitCompiler* jit, uint8_t byte){ mc_stream(&jit->code, &byte, 1); }
+static inline void jit_u32(JitCompiler* jit, uint32_t value){ mc_stream(&jit->code, &value, sizeof(value)); }
+static inline void jit_u64(JitCompiler* jit, uint64_t value){ mc_stream(&jit->code, &value, sizeof(value)); }
+
+static inline void jit_patch32(JitCompiler* jit, uint64_t position, uint32_t value){
+    memcpy(mc_stream_on(&jit->code, position), &value, sizeof(value));
+}
+
+// [prefix] [rex] op0 [op1], prefix and op1 are omitted when 0 / negative
+static void jit_opcode(JitCompiler* jit, uint8_t prefix, int wide, int reg, int rm, uint8_t op0, int op1){
+    if(prefix) jit_u8(jit, prefix);
+    const uint8_t rex = 0x40 | (wide? 0x08 : 0) | ((reg & 8)? 0x04 : 0) | ((rm & 8)? 0x01 : 0);
+    if(rex != 0x40) jit_u8(jit, rex);
+    jit_u8(jit, op0);
+    if(op1 >= 0) jit_u8(jit, (uint8_t) op1);
+}
+
+// op reg, [base + disp32]
+static void jit_op_mem(JitCompiler* jit, uint8_t prefix, int wide, uint8_t op0, int op1, int reg, int base, int32_t disp){
+    jit_opcode(jit, prefix, wide, reg, base, op0, op1);
+    jit_u8(jit, 0x80 | ((reg & 7) << 3) | (base & 7));
+    // rsp and r12 as base need a SIB byte
+    if((base & 7) == JIT_RSP) jit_u8(jit, 0x24);
+    jit_u32(jit, (uint32_t) disp);
+}
+
+// op reg, rm (both registers)
+static void jit_op_reg(JitCompiler* jit, uint8_t prefix, int wide, uint8_t op0, int op1, int reg, int rm){
+    jit_opcode(jit, prefix, wide, reg, rm, op0, op1);
+    jit_u8(jit, 0xC0 | ((reg & 7) << 3) | (rm & 7));
+}
+
+// host = zero extended [base + disp] of bits size
+static void jit_load_mem(JitCompiler* jit, int host, int base, int32_t disp, int bits){
+    switch (bits)
+    {
+    case 8:  jit_op_mem(jit, 0, 0, 0x0F, 0xB6, host, base, disp); break;
+    case 16: jit_op_mem(jit, 0, 0, 0x0F, 0xB7, host, base, disp); break;
+    case 32: jit_op_mem(jit, 0, 0, 0x8B, -1,   host, base, disp); break;
+    default: jit_op_mem(jit, 0, 1, 0x8B, -1,   host, base, disp); break;
+    }
+}
+
+// [base + disp] = the lowest bits of host, host has to be rax, rcx or rdx for 8 bits
+static void jit_store_mem(JitCompiler* jit, int host, int base, int32_t disp, int bits){
+    switch (bits)
+    {
+    case 8:  jit_op_mem(jit, 0,    0, 0x88, -1, host, base, disp); break;
+    case 16: jit_op_mem(jit, 0x66, 0, 0x89, -1, host, base, disp); break;
+    case 32: jit_op_mem(jit, 0,    0, 0x89, -1, host, base, disp); break;
+    default: jit_op_mem(jit, 0,    1, 0x89, -1, host, base, disp); break;
+    }
+}
+
+// lock op [base], host of bits size, op0 op1 being the 16/32/64 bits form (xadd 0x0F 0xC1, cmpxchg 0x0F 0xB1),
+// the 8 bits form is the one before it, host has to be rax, rcx or rdx for 8 bits
+static void jit_locked_mem(JitCompiler* jit, uint8_t op0, int op1, int host, int base, int bits){
+    jit_u8(jit, 0xF0);
+    if(bits == 8) op1 -= 1;
+    jit_op_mem(jit, (bits == 16)? 0x66 : 0, bits == 64, op0, op1, host, base, 0);
+}
+
+#define jit_load(JIT, HOST, REG, BITS)  jit_load_mem(JIT, HOST, JIT_RBX, REG, BITS)
+#define jit_store(JIT, HOST, REG, BITS) jit_store_mem(JIT, HOST, JIT_RBX, REG, BITS)
+
+static void jit_mov_imm(JitCompiler* jit, int host, uint64_t value){
+    if(value <= 0xFFFFFFFF){
+        // mov r32, imm32 zero extends
+        if(host & 8) jit_u8(jit, 0x41);
+        jit_u8(jit, 0xB8 | (host & 7));
+        jit_u32(jit, (uint32_t) value);
+        return;
+    }
+    jit_u8(jit, 0x48 | ((host & 8)? 1 : 0));
+    jit_u8(jit, 0xB8 | (host & 7));
+    jit_u64(jit, value);
+}
+
+// dst = dst OP src, OP being one of the "op r/m64, r64" opcodes (add 0x01, or 0x09, and 0x21, sub 0x29, xor 0x31, cmp 0x39, test 0x85, mov 0x89)
+static inline void jit_alu(JitCompiler* jit, uint8_t op, int dst, int src){
+    jit_op_reg(jit, 0, 1, op, -1, src, dst);
+}
+
+// host <<= 3 (or any other shift amount), then host += base
+static void jit_index(JitCompiler* jit, int host, uint8_t shift, int base){
+    jit_op_reg(jit, 0, 1, 0xC1, -1, 4, host);
+    jit_u8(jit, shift);
+    jit_alu(jit, 0x01, host, base);
+}
+
+static void jit_movsd_load(JitCompiler* jit, int xmm, uint8_t reg){ jit_op_mem(jit, 0xF2, 0, 0x0F, 0x10, xmm, JIT_RBX, reg); }
+static void jit_movsd_store(JitCompiler* jit, int xmm, uint8_t reg){ jit_op_mem(jit, 0xF2, 0, 0x0F, 0x11, xmm, JIT_RBX, reg); }
+
+static void jit_set_rip(JitCompiler* jit, uint64_t ip){
+    jit_mov_imm(jit, JIT_RAX, ip);
+    jit_store(jit, JIT_RAX, RIP, 64);
+}
+
+static void jit_zero_r0(JitCompiler* jit){
+    // mov qword [rbx + R0], 0
+    jit_op_mem(jit, 0, 1, 0xC7, -1, 0, JIT_RBX, R0);
+    jit_u32(jit, 0);
+}
+
+// jmp to an already emitted native offset
+static void jit_jmp_back(JitCompiler* jit, uint64_t offset){
+    jit_u8(jit, 0xE9);
+    jit_u32(jit, (uint32_t) (int32_t) ((int64_t) offset - (int64_t) (jit->code.size + 4)));
+}
+
+// emits a jcc rel32 and returns the position of the rel32 to be patched with jit_land
+static uint64_t jit_jcc_forward(JitCompiler* jit, uint8_t condition){
+    jit_u8(jit, 0x0F);
+    jit_u8(jit, 0x80 | condition);
+    jit_u32(jit, 0);
+    return jit->code.size - 4;
+}
+
+// makes the rel32 at position point to the current position
+static void jit_land(JitCompiler* jit, uint64_t position){
+    jit_patch32(jit, position, (uint32_t) (jit->code.size - (position + 4)));
+}
+
+// jumps (or, with a condition, branches) to the native code of instruction target,
+// targets outside of the program leave the jitted code with RIP = target
+static void jit_goto(JitCompiler* jit, int condition, uint64_t target){
+    if(target < jit->size){
+        if(condition < 0) jit_u8(jit, 0xE9);
+        else{
+            jit_u8(jit, 0x0F);
+            jit_u8(jit, 0x80 | condition);
+        }
+        const JitFixup fixup = {.position = jit->code.size, .target = target};
+        mc_stream(&jit->fixups, &fixup, sizeof(fixup));
+        jit_u32(jit, 0);
+        return;
+    }
+    uint64_t skip = 0;
+    if(condition >= 0) skip = jit_jcc_forward(jit, condition ^ 1);
+    jit_set_rip(jit, target);
+    jit_jmp_back(jit, jit->exit);
+    if(condition >= 0) jit_land(jit, skip);
+}
+
+// STACK[RSP++] = host, host can't be rax
+static void jit_push(JitCompiler* jit, int host){
+    jit_load(jit, JIT_RAX, RSP, 64);
+    // inc qword [rbx + RSP]
+    jit_op_mem(jit, 0, 1, 0xFF, -1, 0, JIT_RBX, RSP);
+    jit_index(jit, JIT_RAX, 3, JIT_R13);
+    jit_store_mem(jit, host, JIT_RAX, 0, 64);
+}
+
+// rax = &STACK[--RSP]
+static void jit_pop_address(JitCompiler* jit){
+    jit_load(jit, JIT_RAX, RSP, 64);
+    // dec rax
+    jit_op_reg(jit, 0, 1, 0xFF, -1, 1, JIT_RAX);
+    jit_store(jit, JIT_RAX, RSP, 64);
+    jit_index(jit, JIT_RAX, 3, JIT_R13);
+}
+
+static void jit_call(JitCompiler* jit, const void* function){
+    jit_mov_imm(jit, JIT_RAX, (uint64_t)(uintptr_t) function);
+    // call rax
+    jit_u8(jit, 0xFF);
+    jit_u8(jit, 0xD0);
+}
+
+// leaves the instruction to perform_inst, if the instruction may change RIP its result is added
+// to RIP and execution continues through the dispatch stub
+static void jit_fallback(JitCompiler* jit, Inst inst, uint64_t ip, int changes_rip){
+    jit->fallbacks += 1;
+    jit_set_rip(jit, ip);
+    jit_alu(jit, 0x89, JIT_RDI, JIT_R12);
+    jit_mov_imm(jit, JIT_RSI, inst);
+    jit_call(jit, (const void*) perform_inst);
+    jit_zero_r0(jit);
+    if(changes_rip){
+        // add [rbx + RIP], rax
+        jit_op_mem(jit, 0, 1, 0x01, -1, JIT_RAX, JIT_RBX, RIP);
+        jit_jmp_back(jit, jit->dispatch);
+    }
+}
+
+// performs the syscall for the jitted code, same failure behaviour as perform_inst
+static int jit_syscall(VPU* vpu, uint64_t id){
+    if(virtual_syscall(vpu, id)){
+        fprintf(stderr, "Syscall Failed At IP %"PRIu64"\n", GET_REG(vpu->register_space, RIP)->as_uint64);
+        vpu->status = 1;
+        return 1;
+    }
+    return 0;
+}
+
+static inline int jit_touches_rip(uint8_t reg){
+    return reg > RIP - 8 && reg < RIP + 8;
+}
+
+// translates the instruction at program[ip]
+static void jit_compile_inst(JitCompiler* jit, const Inst* program, uint64_t ip){
+
+    const Inst     inst = program[ip];
+    const uint8_t  op   = inst & 0xFF;
+    const uint8_t  r1   = (uint8_t) (inst >> 8);
+    const uint8_t  r2   = (uint8_t) (inst >> 16);
+    const uint8_t  r3   = (uint8_t) (inst >> 24);
+    const uint16_t l1   = (uint16_t) (inst >> 8);
+    const uint16_t l2   = (uint16_t) (inst >> 16);
+    const int      lit  = GET_OP_HINT(inst) == HINT_LIT;
+
+    const int operands = get_inst_register_operands(inst);
+    if(
+        (operands > 0 && jit_touches_rip(r1)) ||
+        (operands > 1 && jit_touches_rip(r2)) ||
+        (operands > 2 && jit_touches_rip(r3))
+    ){
+        jit_fallback(jit, inst, ip, 1);
+        return;
+    }
+
+    #define LOAD2(BITS)     jit_load(jit, JIT_RAX, r2, BITS); jit_load(jit, JIT_RCX, r3, BITS)
+    #define BINARY(OPC, BITS) LOAD2(BITS); jit_alu(jit, OPC, JIT_RAX, JIT_RCX); jit_store(jit, JIT_RAX, r1, BITS)
+    #define MULTIPLY(BITS)  LOAD2(BITS); jit_op_reg(jit, 0, 1, 0x0F, 0xAF, JIT_RAX, JIT_RCX); jit_store(jit, JIT_RAX, r1, BITS)
+    #define COMPARE(CC)     LOAD2(64); jit_alu(jit, 0x39, JIT_RAX, JIT_RCX); jit_op_reg(jit, 0, 0, 0x0F, 0x90 | CC, 0, JIT_RAX); jit_store(jit, JIT_RAX, r1, 8)
+    #define FLOAT_BINARY(OPC) jit_movsd_load(jit, 0, r2); jit_movsd_load(jit, 1, r3); jit_op_reg(jit, 0xF2, 0, 0x0F, OPC, 0, 1); jit_movsd_store(jit, 0, r1)
+    // the same with movss and the float32 form (F3 instead of F2) of the instruction
+    #define FLOAT32_BINARY(OPC) jit_op_mem(jit, 0xF3, 0, 0x0F, 0x10, 0, JIT_RBX, r2); jit_op_mem(jit, 0xF3, 0, 0x0F, 0x10, 1, JIT_RBX, r3); \
+            jit_op_reg(jit, 0xF3, 0, 0x0F, OPC, 0, 1); jit_op_mem(jit, 0xF3, 0, 0x0F, 0x11, 0, JIT_RBX, r1)
+    #define READ(BITS)      jit_load(jit, JIT_RAX, r2, 64); jit_load(jit, JIT_RCX, r3, 64); jit_alu(jit, 0x01, JIT_RAX, JIT_RCX); \
+                            jit_load_mem(jit, JIT_RAX, JIT_RAX, 0, BITS); jit_store(jit, JIT_RAX, r1, BITS)
+    #define WRITE(BITS)     jit_load(jit, JIT_RAX, r1, 64); jit_load(jit, JIT_RCX, r3, 64); jit_alu(jit, 0x01, JIT_RAX, JIT_RCX); \
+                            jit_load(jit, JIT_RDX, r2, BITS); jit_store_mem(jit, JIT_RDX, JIT_RAX, 0, BITS)
+    // cmpxchg compares with and loads to rax, xchg with memory is always locked
+    #define CAS(BITS)       jit_load(jit, JIT_RCX, r2, 64); jit_load(jit, JIT_RAX, r1, BITS); jit_load(jit, JIT_RDX, r3, BITS); \
+                            jit_locked_mem(jit, 0x0F, 0xB1, JIT_RDX, JIT_RCX, BITS); jit_store(jit, JIT_RAX, r1, BITS)
+    #define XADD(BITS)      jit_load(jit, JIT_RAX, r2, 64); jit_load(jit, JIT_RDX, r3, BITS); \
+                            jit_locked_mem(jit, 0x0F, 0xC1, JIT_RDX, JIT_RAX, BITS); jit_store(jit, JIT_RDX, r1, BITS)
+    #define XCHG(BITS)      jit_load(jit, JIT_RAX, r2, 64); jit_load(jit, JIT_RDX, r3, BITS); \
+                            jit_op_mem(jit, (BITS == 16)? 0x66 : 0, BITS == 64, (BITS == 8)? 0x86 : 0x87, -1, JIT_RDX, JIT_RAX, 0); \
+                            jit_store(jit, JIT_RDX, r1, BITS)
+
+    int writes = 1;
+
+    switch (op)
+    {
+    case INST_NOP:
+        writes = 0;
+        break;
+    case INST_HALT:
+        if(lit) jit_mov_imm(jit, JIT_RAX, l1);
+        // movsx eax, byte [rbx + r1]
+        else jit_op_mem(jit, 0, 0, 0x0F, 0xBE, JIT_RAX, JIT_RBX, r1);
+        jit_op_mem(jit, 0, 0, 0x89, -1, JIT_RAX, JIT_R12, (int32_t) offsetof(VPU, status));
+        jit_set_rip(jit, 0XFFFFFFFFFFFFFFFF);
+        jit_jmp_back(jit, jit->exit);
+        return;
+    case INST_MOV8:   jit_load(jit, JIT_RAX, r2, 8);  jit_store(jit, JIT_RAX, r1, 8);  break;
+    case INST_MOV16:  jit_load(jit, JIT_RAX, r2, 16); jit_store(jit, JIT_RAX, r1, 16); break;
+    case INST_MOV32:  jit_load(jit, JIT_RAX, r2, 32); jit_store(jit, JIT_RAX, r1, 32); break;
+    case INST_CASTIU:
+    case INST_CASTUI:
+    case INST_MOV:    jit_load(jit, JIT_RAX, r2, 64); jit_store(jit, JIT_RAX, r1, 64); break;
+    case INST_MOVC:{
+        jit_load(jit, JIT_RCX, r1, 64);
+        jit_alu(jit, 0x85, JIT_RCX, JIT_RCX);
+        const uint64_t skip = jit_jcc_forward(jit, JIT_CC_E);
+        jit_load(jit, JIT_RAX, r3, 64);
+        jit_store(jit, JIT_RAX, r2, 64);
+        jit_land(jit, skip);
+        if(r2 < 8) jit_zero_r0(jit);
+        writes = 0;
+    }   break;
+    case INST_MOVV:   jit_mov_imm(jit, JIT_RAX, l2);              jit_store(jit, JIT_RAX, r1, 64); break;
+    case INST_MOVN:   jit_mov_imm(jit, JIT_RAX, ~(uint64_t) l2);  jit_store(jit, JIT_RAX, r1, 64); break;
+    case INST_MOVV16: jit_mov_imm(jit, JIT_RAX, l2);              jit_store(jit, JIT_RAX, r1, 16); break;
+    case INST_MOVVW:
+    case INST_MOVVL:{
+        const uint64_t next = ip + 1 + get_inst_payload_size(op);
+        if(next > jit->size){
+            jit_fallback(jit, inst, ip, 1);
+            return;
+        }
+        jit_mov_imm(jit, JIT_RAX, get_wide_literal(program + ip));
+        jit_store(jit, JIT_RAX, r1, 64);
+        if(r1 < 8) jit_zero_r0(jit);
+        // the containers are never run, they would fall back to perform_inst and fail
+        jit_goto(jit, -1, next);
+    }   return;
+    case INST_PUSH:
+        if(lit) jit_mov_imm(jit, JIT_RDX, l1);
+        else    jit_load(jit, JIT_RDX, r1, 64);
+        jit_push(jit, JIT_RDX);
+        writes = 0;
+        break;
+    case INST_POP:
+        jit_pop_address(jit);
+        jit_load_mem(jit, JIT_RAX, JIT_RAX, 0, 64);
+        jit_store(jit, JIT_RAX, r1, 64);
+        break;
+    case INST_STACK_GET:
+    case INST_STACK_PUT:
+        jit_load(jit, JIT_RAX, RSP, 64);
+        // sub rax, imm32
+        jit_op_reg(jit, 0, 1, 0x81, -1, 5, JIT_RAX);
+        jit_u32(jit, l2);
+        jit_index(jit, JIT_RAX, 3, JIT_R13);
+        if(op == INST_STACK_GET){
+            jit_load_mem(jit, JIT_RAX, JIT_RAX, 0, 64);
+            jit_store(jit, JIT_RAX, r1, 64);
+        }
+        else{
+            jit_load(jit, JIT_RDX, r1, 64);
+            jit_store_mem(jit, JIT_RDX, JIT_RAX, 0, 64);
+            writes = 0;
+        }
+        break;
+    case INST_GSP:
+        jit_load(jit, JIT_RAX, r2, 64);
+        jit_index(jit, JIT_RAX, 3, JIT_R13);
+        jit_load(jit, JIT_RCX, r3, 64);
+        jit_alu(jit, 0x01, JIT_RAX, JIT_RCX);
+        jit_store(jit, JIT_RAX, r1, 64);
+        break;
+    case INST_STATIC:
+        jit_load_mem(jit, JIT_RDX, JIT_R12, (int32_t) offsetof(VPU, static_memory), 64);
+        if(lit) jit_mov_imm(jit, JIT_RCX, l1);
+        else    jit_load(jit, JIT_RCX, r1, 64);
+        jit_alu(jit, 0x01, JIT_RDX, JIT_RCX);
+        jit_push(jit, JIT_RDX);
+        writes = 0;
+        break;
+    case INST_READ8:  READ(8);  break;
+    case INST_READ16: READ(16); break;
+    case INST_READ32: READ(32); break;
+    case INST_READ:   READ(64); break;
+    case INST_WRITE8:  WRITE(8);  writes = 0; break;
+    case INST_WRITE16: WRITE(16); writes = 0; break;
+    case INST_WRITE32: WRITE(32); writes = 0; break;
+    case INST_WRITE:   WRITE(64); writes = 0; break;
+    // x86 loads are acquire and its stores release already, only the read-modify-write ones need a lock
+    case INST_ALOAD8:  READ(8);  break;
+    case INST_ALOAD16: READ(16); break;
+    case INST_ALOAD32: READ(32); break;
+    case INST_ALOAD:   READ(64); break;
+    case INST_ASTORE8:  WRITE(8);  writes = 0; break;
+    case INST_ASTORE16: WRITE(16); writes = 0; break;
+    case INST_ASTORE32: WRITE(32); writes = 0; break;
+    case INST_ASTORE:   WRITE(64); writes = 0; break;
+    case INST_ACAS8:  CAS(8);  break;
+    case INST_ACAS16: CAS(16); break;
+    case INST_ACAS32: CAS(32); break;
+    case INST_ACAS:   CAS(64); break;
+    case INST_AADD8:  XADD(8);  break;
+    case INST_AADD16: XADD(16); break;
+    case INST_AADD32: XADD(32); break;
+    case INST_AADD:   XADD(64); break;
+    case INST_AXCHG8:  XCHG(8);  break;
+    case INST_AXCHG16: XCHG(16); break;
+    case INST_AXCHG32: XCHG(32); break;
+    case INST_AXCHG:   XCHG(64); break;
+    case INST_FENCE:
+        // mfence
+        jit_u8(jit, 0x0F); jit_u8(jit, 0xAE); jit_u8(jit, 0xF0);
+        writes = 0;
+        break;
+    case INST_NOT:
+        jit_load(jit, JIT_RAX, r2, 64);
+        jit_alu(jit, 0x85, JIT_RAX, JIT_RAX);
+        jit_op_reg(jit, 0, 0, 0x0F, 0x90 | JIT_CC_E, 0, JIT_RAX);
+        jit_op_reg(jit, 0, 0, 0x0F, 0xB6, JIT_RAX, JIT_RAX);
+        jit_store(jit, JIT_RAX, r1, 64);
+        break;
+    case INST_NEG:
+        jit_load(jit, JIT_RAX, r2, 64);
+        // not rax
+        jit_op_reg(jit, 0, 1, 0xF7, -1, 2, JIT_RAX);
+        jit_load(jit, JIT_RCX, r3, 64);
+        jit_alu(jit, 0x09, JIT_RAX, JIT_RCX);
+        jit_store(jit, JIT_RAX, r1, 64);
+        break;
+    case INST_AND: BINARY(0x21, 64); break;
+    case INST_OR:  BINARY(0x09, 64); break;
+    case INST_XOR: BINARY(0x31, 64); break;
+    case INST_NAND:
+        LOAD2(64);
+        jit_alu(jit, 0x21, JIT_RAX, JIT_RCX);
+        jit_op_reg(jit, 0, 1, 0xF7, -1, 2, JIT_RAX);
+        jit_store(jit, JIT_RAX, r1, 64);
+        break;
+    case INST_BSHIFT:{
+        jit_load(jit, JIT_RAX, r2, 64);
+        // movsx ecx, byte [rbx + r3]; test cl, cl
+        jit_op_mem(jit, 0, 0, 0x0F, 0xBE, JIT_RCX, JIT_RBX, r3);
+        jit_u8(jit, 0x84); jit_u8(jit, 0xC9);
+        const uint64_t right = jit_jcc_forward(jit, JIT_CC_S);
+        // shl rax, cl
+        jit_op_reg(jit, 0, 1, 0xD3, -1, 4, JIT_RAX);
+        jit_u8(jit, 0xE9);
+        jit_u32(jit, 0);
+        const uint64_t done = jit->code.size - 4;
+        jit_land(jit, right);
+        // neg ecx; shr rax, cl
+        jit_op_reg(jit, 0, 0, 0xF7, -1, 3, JIT_RCX);
+        jit_op_reg(jit, 0, 1, 0xD3, -1, 5, JIT_RAX);
+        jit_land(jit, done);
+        jit_store(jit, JIT_RAX, r1, 64);
+    }   break;
+    case INST_JMP:
+        if(lit){
+            jit_goto(jit, -1, ip + (int16_t) l1);
+            return;
+        }
+        jit_load(jit, JIT_RAX, r1, 64);
+        jit_mov_imm(jit, JIT_RCX, ip);
+        jit_alu(jit, 0x01, JIT_RAX, JIT_RCX);
+        jit_store(jit, JIT_RAX, RIP, 64);
+        jit_jmp_back(jit, jit->dispatch);
+        return;
+    case INST_JMPF:
+    case INST_JMPFN:
+        jit_load(jit, JIT_RAX, r1, 8);
+        jit_alu(jit, 0x85, JIT_RAX, JIT_RAX);
+        jit_goto(jit, (op == INST_JMPF)? JIT_CC_NE : JIT_CC_E, ip + (int16_t) l2);
+        writes = 0;
+        break;
+    case INST_CALL:
+        jit_mov_imm(jit, JIT_RDX, ip + 1);
+        jit_push(jit, JIT_RDX);
+        if(lit){
+            jit_goto(jit, -1, ip + (int16_t) l1);
+            return;
+        }
+        jit_load(jit, JIT_RAX, r1, 64);
+        jit_mov_imm(jit, JIT_RCX, ip);
+        jit_alu(jit, 0x01, JIT_RAX, JIT_RCX);
+        jit_store(jit, JIT_RAX, RIP, 64);
+        jit_jmp_back(jit, jit->dispatch);
+        return;
+    case INST_JMPW:
+    case INST_JMPFW:
+    case INST_JMPFNW:
+    case INST_CALLW:{
+        const uint64_t next = ip + 2;
+        if(next > jit->size){
+            jit_fallback(jit, inst, ip, 1);
+            return;
+        }
+        const uint64_t target = ip + get_wide_literal(program + ip);
+        if(op == INST_CALLW){
+            jit_mov_imm(jit, JIT_RDX, next);
+            jit_push(jit, JIT_RDX);
+        }
+        if(op == INST_JMPFW || op == INST_JMPFNW){
+            jit_load(jit, JIT_RAX, r1, 8);
+            jit_alu(jit, 0x85, JIT_RAX, JIT_RAX);
+            jit_goto(jit, (op == INST_JMPFW)? JIT_CC_NE : JIT_CC_E, target);
+            // the container is never run
+            jit_goto(jit, -1, next);
+            return;
+        }
+        jit_goto(jit, -1, target);
+    }   return;
+    case INST_RET:
+        jit_pop_address(jit);
+        jit_load_mem(jit, JIT_RAX, JIT_RAX, 0, 64);
+        jit_store(jit, JIT_RAX, RIP, 64);
+        jit_jmp_back(jit, jit->dispatch);
+        return;
+
+    case INST_ADD8:  BINARY(0x01, 8);  break;
+    case INST_SUB8:  BINARY(0x29, 8);  break;
+    case INST_MUL8:  MULTIPLY(8);      break;
+    case INST_ADD16: BINARY(0x01, 16); break;
+    case INST_SUB16: BINARY(0x29, 16); break;
+    case INST_MUL16: MULTIPLY(16);     break;
+    case INST_ADD32: BINARY(0x01, 32); break;
+    case INST_SUB32: BINARY(0x29, 32); break;
+    case INST_MUL32: MULTIPLY(32);     break;
+    case INST_ADD:   BINARY(0x01, 64); break;
+    case INST_SUB:   BINARY(0x29, 64); break;
+    case INST_MUL:   MULTIPLY(64);     break;
+    case INST_DIVI:
+    case INST_DIVU:
+        LOAD2(64);
+        if(op == INST_DIVI){
+            // cqo; idiv rcx
+            jit_u8(jit, 0x48); jit_u8(jit, 0x99);
+            jit_op_reg(jit, 0, 1, 0xF7, -1, 7, JIT_RCX);
+        }
+        else{
+            // xor edx, edx; div rcx
+            jit_op_reg(jit, 0, 0, 0x31, -1, JIT_RDX, JIT_RDX);
+            jit_op_reg(jit, 0, 1, 0xF7, -1, 6, JIT_RCX);
+        }
+        jit_store(jit, JIT_RAX, r1, 64);
+        break;
+    case INST_ADDF: FLOAT_BINARY(0x58); break;
+    case INST_SUBF: FLOAT_BINARY(0x5C); break;
+    case INST_MULF: FLOAT_BINARY(0x59); break;
+    case INST_DIVF: FLOAT_BINARY(0x5E); break;
+    // minsd and maxsd return their second operand unless the first is smaller (bigger), like MINF and MAXF
+    case INST_MINF: FLOAT_BINARY(0x5D); break;
+    case INST_MAXF: FLOAT_BINARY(0x5F); break;
+    case INST_SQRTF:
+        // sqrtsd xmm0, [rbx + r2]
+        jit_op_mem(jit, 0xF2, 0, 0x0F, 0x51, 0, JIT_RBX, r2);
+        jit_movsd_store(jit, 0, r1);
+        break;
+    case INST_ADDF32: FLOAT32_BINARY(0x58); break;
+    case INST_SUBF32: FLOAT32_BINARY(0x5C); break;
+    case INST_MULF32: FLOAT32_BINARY(0x59); break;
+    case INST_DIVF32: FLOAT32_BINARY(0x5E); break;
+    case INST_SQRTF32:
+        // sqrtss xmm0, [rbx + r2]; movss [rbx + r1], xmm0
+        jit_op_mem(jit, 0xF3, 0, 0x0F, 0x51, 0, JIT_RBX, r2);
+        jit_op_mem(jit, 0xF3, 0, 0x0F, 0x11, 0, JIT_RBX, r1);
+        break;
+    case INST_INC:
+    case INST_DEC:
+        // add/sub qword [rbx + r1], imm32
+        jit_op_mem(jit, 0, 1, 0x81, -1, (op == INST_INC)? 0 : 5, JIT_RBX, r1);
+        jit_u32(jit, l2);
+        break;
+    case INST_INCF:
+    case INST_DECF:{
+        const double value = (double) l2;
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        jit_movsd_load(jit, 0, r1);
+        jit_mov_imm(jit, JIT_RAX, bits);
+        // movq xmm1, rax
+        jit_op_reg(jit, 0x66, 1, 0x0F, 0x6E, 1, JIT_RAX);
+        jit_op_reg(jit, 0xF2, 0, 0x0F, (op == INST_INCF)? 0x58 : 0x5C, 0, 1);
+        jit_movsd_store(jit, 0, r1);
+    }   break;
+    case INST_ABS:
+        LOAD2(64);
+        jit_alu(jit, 0x29, JIT_RAX, JIT_RCX);
+        jit_alu(jit, 0x89, JIT_RCX, JIT_RAX);
+        // neg rcx; test rax, rax; cmovs rax, rcx
+        jit_op_reg(jit, 0, 1, 0xF7, -1, 3, JIT_RCX);
+        jit_alu(jit, 0x85, JIT_RAX, JIT_RAX);
+        jit_op_reg(jit, 0, 1, 0x0F, 0x48, JIT_RAX, JIT_RCX);
+        jit_store(jit, JIT_RAX, r1, 64);
+        break;
+
+    case INST_NEQ:  COMPARE(JIT_CC_NE); break;
+    case INST_EQ:   COMPARE(JIT_CC_E);  break;
+    case INST_BIGI: COMPARE(JIT_CC_G);  break;
+    case INST_BIGU: COMPARE(JIT_CC_A);  break;
+    case INST_SMLI: COMPARE(JIT_CC_L);  break;
+    case INST_SMLU: COMPARE(JIT_CC_B);  break;
+    case INST_EQF:
+        jit_movsd_load(jit, 0, r2);
+        jit_movsd_load(jit, 1, r3);
+        // ucomisd xmm0, xmm1; sete al; setnp cl; and al, cl
+        jit_op_reg(jit, 0x66, 0, 0x0F, 0x2E, 0, 1);
+        jit_op_reg(jit, 0, 0, 0x0F, 0x90 | JIT_CC_E, 0, JIT_RAX);
+        jit_op_reg(jit, 0, 0, 0x0F, 0x90 | JIT_CC_NP, 0, JIT_RCX);
+        jit_op_reg(jit, 0, 0, 0x20, -1, JIT_RCX, JIT_RAX);
+        jit_store(jit, JIT_RAX, r1, 8);
+        break;
+    case INST_BIGF:
+    case INST_SMLF:
+        jit_movsd_load(jit, 0, r2);
+        jit_movsd_load(jit, 1, r3);
+        // a > b is "above" after ucomisd a, b, a < b is b > a, both are false when unordered
+        if(op == INST_BIGF) jit_op_reg(jit, 0x66, 0, 0x0F, 0x2E, 0, 1);
+        else                jit_op_reg(jit, 0x66, 0, 0x0F, 0x2E, 1, 0);
+        jit_op_reg(jit, 0, 0, 0x0F, 0x90 | JIT_CC_A, 0, JIT_RAX);
+        jit_store(jit, JIT_RAX, r1, 8);
+        break;
+
+    case INST_CASTIF:
+        jit_movsd_load(jit, 0, r2);
+        // cvttsd2si rax, xmm0
+        jit_op_reg(jit, 0xF2, 1, 0x0F, 0x2C, JIT_RAX, 0);
+        jit_store(jit, JIT_RAX, r1, 64);
+        break;
+    case INST_CASTFI:
+        jit_load(jit, JIT_RAX, r2, 64);
+        // cvtsi2sd xmm0, rax
+        jit_op_reg(jit, 0xF2, 1, 0x0F, 0x2A, 0, JIT_RAX);
+        jit_movsd_store(jit, 0, r1);
+        break;
+    case INST_CF3264:
+        jit_movsd_load(jit, 0, r2);
+        // cvtsd2ss xmm0, xmm0; movss [rbx + r1], xmm0
+        jit_op_reg(jit, 0xF2, 0, 0x0F, 0x5A, 0, 0);
+        jit_op_mem(jit, 0xF3, 0, 0x0F, 0x11, 0, JIT_RBX, r1);
+        break;
+    case INST_CF6432:
+        // movss xmm0, [rbx + r2]; cvtss2sd xmm0, xmm0
+        jit_op_mem(jit, 0xF3, 0, 0x0F, 0x10, 0, JIT_RBX, r2);
+        jit_op_reg(jit, 0xF3, 0, 0x0F, 0x5A, 0, 0);
+        jit_movsd_store(jit, 0, r1);
+        break;
+
+    case INST_SYS:{
+        jit_set_rip(jit, ip);
+        jit_alu(jit, 0x89, JIT_RDI, JIT_R12);
+        if(lit) jit_mov_imm(jit, JIT_RSI, l1);
+        else    jit_load(jit, JIT_RSI, r1, 64);
+        jit_call(jit, (const void*) jit_syscall);
+        jit_zero_r0(jit);
+        // test eax, eax
+        jit_op_reg(jit, 0, 0, 0x85, -1, JIT_RAX, JIT_RAX);
+        const uint64_t ok = jit_jcc_forward(jit, JIT_CC_E);
+        jit_set_rip(jit, 0XFFFFFFFFFFFFFFFF);
+        jit_jmp_back(jit, jit->exit);
+        jit_land(jit, ok);
+        writes = 0;
+    }   break;
+    case INST_GRP:
+        // lea rax, [rbx + r2]
+        jit_op_mem(jit, 0, 1, 0x8D, -1, JIT_RAX, JIT_RBX, r2);
+        jit_load(jit, JIT_RCX, r3, 64);
+        jit_alu(jit, 0x01, JIT_RAX, JIT_RCX);
+        jit_store(jit, JIT_RAX, r1, 64);
+        break;
+    case INST_GIP:
+        jit_load_mem(jit, JIT_RAX, JIT_R12, (int32_t) offsetof(VPU, program), 64);
+        jit_load(jit, JIT_RCX, r2, 64);
+        jit_index(jit, JIT_RCX, 2, JIT_RAX);
+        jit_load(jit, JIT_RAX, r3, 64);
+        jit_alu(jit, 0x01, JIT_RAX, JIT_RCX);
+        jit_store(jit, JIT_RAX, r1, 64);
+        break;
+
+    // instructions that always continue to the next one
+    case INST_MREADS:
+    case INST_MWRITES:
+    case INST_MMOVS:
+    case INST_MEMCMP:
+    case INST_MSTRLEN:
+    case INST_MCHR:
+    case INST_MFILL32:
+    case INST_MFILL64:
+    case INST_MCRC32:
+    case INST_MHASH:
+    case INST_MPOPCNT:
+    case INST_FMAF:
+    case INST_FLOORF:
+    case INST_CEILF:
+    case INST_ROUNDF:
+    case INST_FMAF32:
+    case INST_AOR8:
+    case INST_AOR16:
+    case INST_AOR32:
+    case INST_AOR:
+    case INST_ABSF:
+    case INST_CASTUF:
+    case INST_CASTFU:
+    case INST_FLOAT:
+    case INST_DUMPCHAR:
+    case INST_GETCHAR:
+    case INST_DISREG:
+        jit_fallback(jit, inst, ip, 0);
+        return;
+
+    // EXEC and unknown instructions, the vector instructions always continue to the next one
+    default:
+        jit_fallback(jit, inst, ip, !is_vector_inst(op));
+        return;
+    }
+
+    // R0 always reads as 0
+    if(writes && r1 < 8) jit_zero_r0(jit);
+
+    #undef LOAD2
+    #undef BINARY
+    #undef MULTIPLY
+    #undef COMPARE
+    #undef FLOAT_BINARY
+    #undef FLOAT32_BINARY
+    #undef READ
+    #undef WRITE
+    #undef CAS
+    #undef XADD
+    #undef XCHG
+}
+
+// translates the program of vpu to native code
+// \returns 0 on success or non zero if the program could not be compiled
+int jit_compile(JitProgram* output, VPU* vpu, uint64_t program_size){
+
+    memset(output, 0, sizeof(*output));
+
+    int err = 0;
+
+    JitCompiler jit;
+    jit.code      = mc_create_stream(64 * (program_size + 16), 16);
+    jit.fixups    = mc_create_stream(sizeof(JitFixup) * 64, 8);
+    jit.offsets   = (uint64_t*) virtual_alloc(sizeof(uint64_t) * (program_size + 1));
+    jit.size      = program_size;
+    jit.fallbacks = 0;
+
+    uint8_t* executable = NULL;
+    void**   targets    = NULL;
+
+    if(!jit.code.data || !jit.fixups.data || !jit.offsets)
+        DEFER_ERROR("Could Not Allocate Memory To Compile %"PRIu64" Instructions\n", program_size);
+
+    // prologue: save the callee saved registers (5 pushes keep the stack 16 byte aligned for calls)
+    jit_u8(&jit, 0x53);
+    jit_u8(&jit, 0x41); jit_u8(&jit, 0x54);
+    jit_u8(&jit, 0x41); jit_u8(&jit, 0x55);
+    jit_u8(&jit, 0x41); jit_u8(&jit, 0x56);
+    jit_u8(&jit, 0x41); jit_u8(&jit, 0x57);
+    jit_alu(&jit, 0x89, JIT_R12, JIT_RDI);
+    jit_alu(&jit, 0x89, JIT_R14, JIT_RSI);
+    jit_load_mem(&jit, JIT_RBX, JIT_R12, (int32_t) offsetof(VPU, register_space), 64);
+    jit_load_mem(&jit, JIT_R13, JIT_R12, (int32_t) offsetof(VPU, stack), 64);
+    jit_mov_imm(&jit, JIT_R15, program_size);
+
+    // dispatch stub: continue at RIP or leave if it is outside of the program
+    jit.dispatch = jit.code.size;
+    jit_load(&jit, JIT_RAX, RIP, 64);
+    jit_alu(&jit, 0x39, JIT_RAX, JIT_R15);
+    const uint64_t leave = jit_jcc_forward(&jit, JIT_CC_AE);
+    jit_index(&jit, JIT_RAX, 3, JIT_R14);
+    // jmp [rax]
+    jit_op_mem(&jit, 0, 0, 0xFF, -1, 4, JIT_RAX, 0);
+
+    // exit stub
+    jit.exit = jit.code.size;
+    jit_land(&jit, leave);
+    jit_u8(&jit, 0x41); jit_u8(&jit, 0x5F);
+    jit_u8(&jit, 0x41); jit_u8(&jit, 0x5E);
+    jit_u8(&jit, 0x41); jit_u8(&jit, 0x5D);
+    jit_u8(&jit, 0x41); jit_u8(&jit, 0x5C);
+    jit_u8(&jit, 0x5B);
+    jit_u8(&jit, 0xC3);
+
+    for(uint64_t i = 0; i < program_size; i+=1){
+        jit.offsets[i] = jit.code.size;
+        jit_compile_inst(&jit, vpu->program, i);
+    }
+    // falling off the end of the program
+    jit.offsets[program_size] = jit.code.size;
+    jit_set_rip(&jit, program_size);
+    jit_jmp_back(&jit, jit.exit);
+
+    for(uint64_t i = 0; i < jit.fixups.size / sizeof(JitFixup); i+=1){
+        const JitFixup* const fixup = (const JitFixup*) mc_stream_on(&jit.fixups, i * sizeof(JitFixup));
+        jit_patch32(&jit, fixup->position, (uint32_t) (jit.offsets[fixup->target] - (fixup->position + 4)));
+    }
+
+    executable = (uint8_t*) mmap(NULL, jit.code.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(executable == MAP_FAILED){
+        executable = NULL;
+        DEFER_ERROR("Could Not Map %"PRIu64" Bytes For The Jit\n", jit.code.size);
+    }
+    memcpy(executable, jit.code.data, jit.code.size);
+    if(mprotect(executable, jit.code.size, PROT_READ | PROT_EXEC))
+        DEFER_ERROR("Could Not Make The Jitted Code Executable\n");
+
+    targets = (void**) virtual_alloc(sizeof(void*) * (program_size? program_size : 1));
+    if(!targets)
+        DEFER_ERROR("Could Not Allocate The Jit Jump Table\n");
+    for(uint64_t i = 0; i < program_size; i+=1){
+        targets[i] = executable + jit.offsets[i];
+    }
+
+    output->code      = executable;
+    output->code_size = jit.code.size;
+    output->targets   = targets;
+    output->size      = program_size;
+    output->fallbacks = jit.fallbacks;
+    output->entry     = (JitEntry)(uintptr_t) executable;
+
+defer:
+    if(err){
+        if(executable) munmap(executable, jit.code.size);
+        virtual_free(targets);
+    }
+    mc_destroy_stream(jit.code);
+    mc_destroy_stream(jit.fixups);
+    virtual_free(jit.offsets);
+    return err;
+}
+
+// the IP of the instruction whose native code contains pc, see watch_native_code
+// \returns 1 if pc is in the program's code or 0 otherwise
+static int jit_native_ip(const void* context, uintptr_t pc, uint64_t* ip){
+    const JitProgram* const program = (const JitProgram*) context;
+    const uintptr_t code = (uintptr_t) program->code;
+    if(pc < code || pc >= code + program->code_size || program->size == 0) return 0;
+    // the code of every instruction is emitted in order, so targets is sorted
+    uint64_t begin = 0;
+    uint64_t end = program->size;
+    while(begin < end){
+        const uint64_t middle = begin + (end - begin) / 2;
+        if((uintptr_t) program->targets[middle] <= pc) begin = middle + 1;
+        else end = middle;
+    }
+    if(begin == 0) return 0;
+    *ip = begin - 1;
+    return 1;
+}
+
+// runs the compiled program from the current RIP, just like run_threaded
+// \returns vpu->status
+int jit_run(VPU* vpu, JitProgram* program){
+    program->entry(vpu, program->targets);
+    return vpu->status;
+}
+
+void jit_free(JitProgram* program){
+    if(program->code) munmap(program->code, program->code_size);
+    virtual_free(program->targets);
+    memset(program, 0, sizeof(*program));
+}
+
+#else
+
+int jit_compile(JitProgram* output, VPU* vpu, uint64_t program_size){
+    (void) vpu; (void) program_size;
+    memset(output, 0, sizeof(*output));
+    fprintf(stderr, "[WARNING] The Jit Is Only Available On x86-64 With The System V Calling Convention\n");
+    return 1;
+}
+
+int jit_run(VPU* vpu, JitProgram* program){
+    (void) program;
+    return vpu->status;
+}
+
+static int jit_native_ip(const void* context, uintptr_t pc, uint64_t* ip){
+    (void) context; (void) pc; (void) ip;
+    return 0;
+}
+
+void jit_free(JitProgram* program){
+    memset(program, 0, sizeof(*program));
+}
+
+#endif // END OF #if VPU_JIT_SUPPORTED
+
+#endif // END OF FILE VJIT_C =================================================
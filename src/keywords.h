@@ -0,0 +1,138 @@
+#ifndef VIRTUAL_KEYWORDS_H
+#define VIRTUAL_KEYWORDS_H
+
+/*
+ * perfect hash tables for the fixed sets of names the parser looks up all the time (mnemonics, register names)
+ *
+ * hash and displace: the FNV-1a hash of a name picks its bucket and every bucket has a seed, chosen when the
+ * table is built so the names of the bucket land in slots no other name uses. a lookup is then one hash, one
+ * slot and one comparison against the only name that can be there, whatever the name and however many there are.
+ * tables are built the first time a thread looks something up in them, like the label indices (see labels.h),
+ * so no thread ever writes to a table another one reads.
+ */
+
+#include "virtual.h"
+#include <stdint.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+    #define KEYWORD_TABLE_THREAD_LOCAL __declspec(thread)
+#else
+    #define KEYWORD_TABLE_THREAD_LOCAL _Thread_local
+#endif
+
+// the most names a table can have, the buckets and slots are sized for it
+#define KEYWORD_TABLE_MAX_KEYS      512
+#define KEYWORD_TABLE_BUCKET_BITS   8
+#define KEYWORD_TABLE_SLOT_BITS     10
+
+typedef struct Keyword{
+    const char* name;
+    uint32_t    size;
+    int         value;
+} Keyword;
+
+typedef struct KeywordTable{
+    int         built;
+    // if set names are looked up regardless of the case of their letters, the names of the table must be upper case
+    int         fold_case;
+    uint32_t    count;
+    Keyword     keys[KEYWORD_TABLE_MAX_KEYS];
+    uint16_t    seeds[1 << KEYWORD_TABLE_BUCKET_BITS];
+    // index + 1 of the name in keys, 0 for none
+    uint16_t    slots[1 << KEYWORD_TABLE_SLOT_BITS];
+} KeywordTable;
+
+static inline uint64_t _keyword_hash(const char* name, uint32_t size, int fold_case){
+    uint64_t hash = MC_FNV1A64_OFFSET_BASIS;
+    for(uint32_t i = 0; i < size; i+=1){
+        const uint8_t c = (uint8_t) name[i];
+        hash = (hash ^ ((fold_case && c >= 'a' && c <= 'z')? c - ('a' - 'A') : c)) * MC_FNV1A64_PRIME;
+    }
+    // the high bits of FNV-1a barely change between short names, they pick the bucket so they get mixed in first
+    hash ^= hash >> 32;
+    hash *= 0xD6E8FEB86659FD93ULL;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+static inline uint32_t _keyword_slot(uint64_t hash, uint16_t seed){
+    hash ^= (uint64_t) seed * 0x9E3779B97F4A7C15ULL;
+    hash ^= hash >> 29;
+    hash *= 0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 32;
+    return (uint32_t) (hash & ((1 << KEYWORD_TABLE_SLOT_BITS) - 1));
+}
+
+static inline uint32_t _keyword_bucket(uint64_t hash){
+    return (uint32_t) (hash >> (64 - KEYWORD_TABLE_BUCKET_BITS));
+}
+
+// adds a name to a table that was not built yet
+// \returns 0 on success or 1 if the table is full
+static inline int add_keyword(KeywordTable* table, const char* name, uint32_t size, int value){
+    if(table->count >= KEYWORD_TABLE_MAX_KEYS) return 1;
+    table->keys[table->count++] = (Keyword){.name = name, .size = size, .value = value};
+    return 0;
+}
+
+// finds the seeds of every bucket, the fullest buckets first while there are still many free slots
+// \returns 0 on success or 1 if some bucket has no seed that works (a name added twice for example)
+static inline int build_keyword_table(KeywordTable* table){
+    uint16_t bucket_sizes[1 << KEYWORD_TABLE_BUCKET_BITS] = {0};
+    uint64_t hashes[KEYWORD_TABLE_MAX_KEYS];
+
+    memset(table->seeds, 0, sizeof(table->seeds));
+    memset(table->slots, 0, sizeof(table->slots));
+
+    for(uint32_t i = 0; i < table->count; i+=1){
+        hashes[i] = _keyword_hash(table->keys[i].name, table->keys[i].size, table->fold_case);
+        bucket_sizes[_keyword_bucket(hashes[i])] += 1;
+    }
+
+    for(uint32_t size = KEYWORD_TABLE_MAX_KEYS; size > 0; size-=1){
+        for(uint32_t bucket = 0; bucket < (1 << KEYWORD_TABLE_BUCKET_BITS); bucket+=1){
+            if(bucket_sizes[bucket] != size) continue;
+            uint32_t seed = 0;
+            for(; seed <= UINT16_MAX; seed+=1){
+                uint32_t placed = 0;
+                for(uint32_t i = 0; i < table->count; i+=1){
+                    if(_keyword_bucket(hashes[i]) != bucket) continue;
+                    const uint32_t slot = _keyword_slot(hashes[i], (uint16_t) seed);
+                    if(table->slots[slot]) break;
+                    table->slots[slot] = (uint16_t) (i + 1);
+                    placed += 1;
+                }
+                if(placed == size) break;
+                // undoes what this seed placed before trying the next one
+                for(uint32_t i = 0; i < table->count; i+=1){
+                    if(_keyword_bucket(hashes[i]) != bucket) continue;
+                    const uint32_t slot = _keyword_slot(hashes[i], (uint16_t) seed);
+                    if(table->slots[slot] == i + 1) table->slots[slot] = 0;
+                }
+            }
+            if(seed > UINT16_MAX) return 1;
+            table->seeds[bucket] = (uint16_t) seed;
+        }
+    }
+
+    table->built = 1;
+    return 0;
+}
+
+// \returns the value of name in table or -1 if it is not there
+static inline int find_keyword(const KeywordTable* table, const char* name, uint32_t size){
+    const uint64_t hash = _keyword_hash(name, size, table->fold_case);
+    const uint16_t index = table->slots[_keyword_slot(hash, table->seeds[_keyword_bucket(hash)])];
+    if(index == 0) return -1;
+    const Keyword* const key = &table->keys[index - 1];
+    if(key->size != size) return -1;
+    if(!table->fold_case) return memcmp(key->name, name, size)? -1 : key->value;
+    for(uint32_t i = 0; i < size; i+=1){
+        const char c = (name[i] >= 'a' && name[i] <= 'z')? name[i] - ('a' - 'A') : name[i];
+        if(c != key->name[i]) return -1;
+    }
+    return key->value;
+}
+
+#endif // =====================  END OF FILE VIRTUAL_KEYWORDS_H ===========================
@@ -7,6 +7,8 @@ enum LabelFlags{
     LABELFLAG_NONE = 0,
     LABELFLAG_EXPORT = 1 << 0,
     LABELFLAG_RESOLVED = 1 << 1,
+    // the label holds a static offset, only set when assembling objects (see object.h)
+    LABELFLAG_STATIC = 1 << 2,
 };
 
 typedef struct Label
@@ -59,7 +61,166 @@ static inline const char* get_label_def_as_str(const void* label){
     return (const char*)((uint8_t*)(label) + l.definition.as_uint + sizeof(uint32_t));  
 }
 
+/*
+ * hash index of label streams
+ *
+ * label streams stay what they always were (they are exported as is), every stream get_label is used on
+ * also gets an open addressing hash index (FNV-1a of the label's name) with the positions of its labels.
+ * the index follows the stream by its address: labels appended to the stream are indexed the next time it
+ * is looked up, a stream that shrank (reset by its owner) is indexed again from the start. whoever owns a
+ * stream must call release_label_index before destroying it so the index is not reused for another stream
+ * at the same address. indices are per thread, so streams can only be used from the thread that indexed them.
+ */
+
+#ifdef _MSC_VER
+    #define LABEL_INDEX_THREAD_LOCAL __declspec(thread)
+#else
+    #define LABEL_INDEX_THREAD_LOCAL _Thread_local
+#endif
+
+// how many streams can be indexed at the same time, lookups in any other stream scan it
+#define LABEL_INDEX_MAX_STREAMS 8
+
+typedef struct LabelIndex{
+    const Mc_stream_t*  labels;
+    // position + 1 of a label in the stream, 0 for empty slots
+    uint64_t*           slots;
+    // a power of two, kept at least twice the count
+    uint64_t            capacity;
+    uint64_t            count;
+    // the part of the stream already indexed
+    uint64_t            indexed_size;
+} LabelIndex;
+
+static LABEL_INDEX_THREAD_LOCAL LabelIndex label_indices[LABEL_INDEX_MAX_STREAMS];
+
+static inline uint32_t _hash_label_name(const char* name, uint32_t size){
+    return mc_fnv1a32(MC_FNV1A32_OFFSET_BASIS, name, size);
+}
+
+static inline uint64_t _label_index_slot(const LabelIndex* index, const uint8_t* label){
+    const Label l = get_label_from_raw_data(label);
+    return _hash_label_name((const char*) label + l.str, l.str_size) & (index->capacity - 1);
+}
+
+static inline void _label_index_insert(LabelIndex* index, const uint8_t* data, uint64_t position){
+    const Label label = get_label_from_raw_data(data + position);
+    for(uint64_t slot = _label_index_slot(index, data + position);; slot = (slot + 1) & (index->capacity - 1)){
+        if(index->slots[slot] == 0){
+            index->slots[slot] = position + 1;
+            index->count += 1;
+            return;
+        }
+        // the first of labels with the same name is the one found, as with a scan
+        const uint8_t* const other = data + index->slots[slot] - 1;
+        const Label other_label = get_label_from_raw_data(other);
+        if(other_label.str_size == label.str_size && memcmp(other + other_label.str, data + position + label.str, label.str_size) == 0) return;
+    }
+}
+
+// \returns 0 on success or 1 if it could not allocate the slots
+static inline int _label_index_grow(LabelIndex* index, const uint8_t* data){
+    uint64_t* const old_slots = index->slots;
+    const uint64_t old_capacity = index->capacity;
+    const uint64_t capacity = old_capacity? old_capacity * 2 : 64;
+    uint64_t* const slots = (uint64_t*) calloc((size_t) capacity, sizeof(uint64_t));
+    if(!slots) return 1;
+    index->slots = slots;
+    index->capacity = capacity;
+    index->count = 0;
+    for(uint64_t i = 0; i < old_capacity; i+=1){
+        if(old_slots[i]) _label_index_insert(index, data, old_slots[i] - 1);
+    }
+    free(old_slots);
+    return 0;
+}
+
+// \returns the up to date index of labels or NULL if it has none and can not get one
+static inline LabelIndex* _get_label_index(const Mc_stream_t* labels){
+    LabelIndex* index = NULL;
+    for(int i = 0; i < LABEL_INDEX_MAX_STREAMS && !index; i+=1){
+        if(label_indices[i].labels == labels) index = &label_indices[i];
+    }
+    for(int i = 0; i < LABEL_INDEX_MAX_STREAMS && !index; i+=1){
+        if(label_indices[i].labels == NULL){
+            index = &label_indices[i];
+            index->labels = labels;
+        }
+    }
+    if(!index) return NULL;
+
+    if(labels->size < index->indexed_size){
+        if(index->slots) memset(index->slots, 0, (size_t) index->capacity * sizeof(uint64_t));
+        index->count = 0;
+        index->indexed_size = 0;
+    }
+
+    const uint8_t* const data = (const uint8_t*) labels->data;
+    while(index->indexed_size < labels->size){
+        const Label label = get_label_from_raw_data(data + index->indexed_size);
+        // a corrupted stream, get_label reports it while scanning
+        if(label.size == 0 || index->indexed_size + label.size > labels->size) return NULL;
+        if((index->count + 1) * 2 > index->capacity && _label_index_grow(index, data)) return NULL;
+        _label_index_insert(index, data, index->indexed_size);
+        index->indexed_size += label.size;
+    }
+    return index;
+}
+
+// removes the label at position from the index and moves every label after it back by size, as remove_label does in the stream
+static inline void _label_index_remove(const Mc_stream_t* labels, uint64_t position, uint64_t size){
+    LabelIndex* index = NULL;
+    for(int i = 0; i < LABEL_INDEX_MAX_STREAMS && !index; i+=1){
+        if(label_indices[i].labels == labels) index = &label_indices[i];
+    }
+    if(!index || index->indexed_size < position + size) return;
+
+    const uint8_t* const data = (const uint8_t*) labels->data;
+    uint64_t removed_slot = index->capacity;
+    for(uint64_t slot = 0; slot < index->capacity; slot+=1){
+        if(index->slots[slot] == position + 1) removed_slot = slot;
+        else if(index->slots[slot] > position + 1) index->slots[slot] -= size;
+    }
+    index->indexed_size -= size;
+    if(removed_slot == index->capacity) return;
+
+    // the labels right after the removed one may only be where they are because its slot was taken
+    index->slots[removed_slot] = 0;
+    index->count -= 1;
+    for(uint64_t slot = (removed_slot + 1) & (index->capacity - 1); index->slots[slot]; slot = (slot + 1) & (index->capacity - 1)){
+        const uint64_t moved = index->slots[slot] - 1;
+        index->slots[slot] = 0;
+        index->count -= 1;
+        _label_index_insert(index, data, moved);
+    }
+}
+
+// frees the index of labels, if it has one, call it before destroying a stream that was used with get_label
+static inline void release_label_index(const Mc_stream_t* labels){
+    for(int i = 0; i < LABEL_INDEX_MAX_STREAMS; i+=1){
+        if(label_indices[i].labels == labels){
+            free(label_indices[i].slots);
+            memset(&label_indices[i], 0, sizeof(label_indices[i]));
+        }
+    }
+}
+
 Label* get_label(const Mc_stream_t* labels, const Token label_tkn){
+    const LabelIndex* const index = _get_label_index(labels);
+    if(index && index->capacity){
+        const uint8_t* const data = (const uint8_t*) labels->data;
+        for(uint64_t slot = _hash_label_name(label_tkn.value.as_str, label_tkn.size) & (index->capacity - 1);
+            index->slots[slot]; slot = (slot + 1) & (index->capacity - 1)){
+            const uint8_t* const label_data = data + index->slots[slot] - 1;
+            const Label label = get_label_from_raw_data(label_data);
+            if(mc_compare_token((Token){.value.as_str = (char*)(label_data + label.str), .size = label.str_size}, label_tkn, 0)){
+                return (Label*) label_data;
+            }
+        }
+        return NULL;
+    }
+    if(index) return NULL;
+
     for(size_t i = 0; i < labels->size; ){
         const uint8_t* data = (uint8_t*)(labels->data) + i;
         const Label label = get_label_from_raw_data(data);
@@ -89,9 +250,11 @@ int remove_label(Mc_stream_t* labels, const Token label_token){
     if(label_ptr == NULL) return 1;
     const Label label = get_label_from_raw_data(label_ptr);
     const uint32_t removed_label_size = label.size;
-    const size_t ssize = (size_t)(labels->size - label.size - (size_t)((uint8_t*)(label_ptr) - (uint8_t*)(labels->data)));
+    const size_t position = (size_t)((uint8_t*)(label_ptr) - (uint8_t*)(labels->data));
+    const size_t ssize = (size_t)(labels->size - label.size - position);
     memmove(label_ptr, ((uint8_t*)label_ptr) + label.size, ssize);
     labels->size -= removed_label_size;
+    _label_index_remove(labels, position, removed_label_size);
     return 0;
 }
 
@@ -156,7 +319,11 @@ Token resolve_token(const Mc_stream_t* labels, const Token token){
     };
 }
 
-int add_local_labelref(Mc_stream_t* local_labels, int16_t* stride, const Token name, uint64_t refposition){
+// finds the local label name (@.name) referenced, adding it unresolved if it was not defined yet,
+// the label is only defined later and its references are written when its scope closes (see relax.h)
+// \param label_position set to the position of the label in local_labels
+// \returns 0 on success or 1 if name is not a local label reference
+int add_local_labelref(Mc_stream_t* local_labels, const Token name, uint64_t* label_position){
     if(name.type != TKN_RAW){
         fprintf(stderr, "[ERROR] Invalid Local Label Reference\n");
         return 1;
@@ -177,34 +344,14 @@ int add_local_labelref(Mc_stream_t* local_labels, int16_t* stride, const Token n
         fprintf(stderr, "[ERROR] Invalid Local Label Reference, Missing '.' After '@' Preffix\n");
         return 1;
     }
-    Label* lp = get_label(local_labels, (Token){.value.as_str = name.value.as_str + 1, .type = TKN_RAW, .size = name.size - 1});
-    if(!lp){
-        if(stride) *stride = 0;
-        return add_label(
-            local_labels,
-            (Token){.value.as_str = name.value.as_str + 1, .type = TKN_RAW, .size = name.size - 1},
-            (Token){.value.as_uint = refposition, .type = TKN_ULIT}
-        );
-    }
-    Label label = get_label_from_raw_data(lp);
-
-    const uint64_t last_pos = label.definition.as_uint;
-
-    const int64_t o = (label.flags & LABELFLAG_RESOLVED)?
-        (int64_t) (last_pos) - (int64_t)(refposition / sizeof(Inst))
-                            :
-        (int64_t) (last_pos) - (int64_t)(refposition);
-    if(o > INT16_MAX || o < INT16_MIN){
-        fprintf(stderr, "[ERROR] local label is too far from reference\n");
-        return 1;
-    }
-    const int16_t output = (int16_t) o;
-    if(stride) *stride = output;
-    if(!(label.flags & LABELFLAG_RESOLVED)){
-        label.definition.as_uint = refposition;
-        put_label_in_raw_data(label, lp);
+    const Token label_name = (Token){.value.as_str = name.value.as_str + 1, .type = TKN_RAW, .size = name.size - 1};
+    const Label* const lp = get_label(local_labels, label_name);
+    if(lp){
+        *label_position = (uint64_t) ((const uint8_t*) lp - (const uint8_t*) local_labels->data);
+        return 0;
     }
-    return 0;
+    *label_position = local_labels->size;
+    return add_label(local_labels, label_name, (Token){.value.as_uint = 0, .type = TKN_INST_POSITION});
 }
 
 Label* get_missing_local_label(Mc_stream_t* local_labels){
@@ -228,7 +375,9 @@ Label* get_missing_local_label(Mc_stream_t* local_labels){
     return NULL;
 }
 
-int solve_local_label(Mc_stream_t* local_labels, void* program, const Token name, uint64_t label_pos){
+// defines the local label name at instruction label_pos
+// \returns 0 on success or 1 if it was already defined
+int solve_local_label(Mc_stream_t* local_labels, const Token name, uint64_t label_pos){
 
     Label* lp = get_label(local_labels, name);
     if(!lp){
@@ -242,29 +391,6 @@ int solve_local_label(Mc_stream_t* local_labels, void* program, const Token name
         return 1;
     }
 
-    uint64_t pos = label.definition.as_uint;
-
-    uint16_t stride = 0;
-
-    for(memcpy(&stride, ((uint8_t*) program) + pos, sizeof(stride)); stride; memcpy(&stride, ((uint8_t*) program) + pos, sizeof(stride))){
-        const int64_t o = (int64_t) (label_pos) - (int64_t)(pos / sizeof(Inst));
-        if(o > INT16_MAX || o < INT16_MIN){
-            fprintf(stderr, "[ERROR] local label is too far from reference\n");
-            return 1;
-        }
-        const int16_t output = (int16_t) o;
-        memcpy(((uint8_t*) program) + pos, &output, sizeof(output));
-        pos += stride;
-    }
-
-    const int64_t o = (int64_t) (label_pos) - (int64_t)(pos / sizeof(Inst));
-    if(o > INT16_MAX || o < INT16_MIN){
-        fprintf(stderr, "[ERROR] local label is too far from reference\n");
-        return 1;
-    }
-    const int16_t output = (int16_t) o;
-    memcpy(((uint8_t*) program) + pos, &output, sizeof(output));
-
     label.flags |= LABELFLAG_RESOLVED;
     label.definition.as_uint = label_pos;
     put_label_in_raw_data(label, lp);
@@ -73,6 +73,36 @@ typedef struct LexizedString{
 
 #define MKTKN(STR) ((Token){.value.as_str = STR, .size = sizeof(STR) - 1, .type = TKN_RAW})
 
+// what get_next_token needs to know about a character, see lexer_char_classes
+enum CharClasses{
+    // skipped between tokens
+    CHAR_CLASS_BLANK        = 1 << 0,
+    // ends a raw token
+    CHAR_CLASS_DELIMITER    = 1 << 1,
+    // a token of its own
+    CHAR_CLASS_SPECIAL      = 1 << 2,
+    // starts a string or character literal
+    CHAR_CLASS_QUOTE        = 1 << 3,
+};
+
+// the classes of every character, so the lexer needs one load and one test per character instead of
+// comparing it against every character of a set
+static const uint8_t lexer_char_classes[256] = {
+    ['\0'] = CHAR_CLASS_DELIMITER,
+    [' ']  = CHAR_CLASS_BLANK | CHAR_CLASS_DELIMITER,
+    ['\t'] = CHAR_CLASS_BLANK | CHAR_CLASS_DELIMITER,
+    ['\n'] = CHAR_CLASS_DELIMITER,
+    ['\r'] = CHAR_CLASS_DELIMITER,
+    [';']  = CHAR_CLASS_DELIMITER,
+    [':']  = CHAR_CLASS_DELIMITER | CHAR_CLASS_SPECIAL,
+    [',']  = CHAR_CLASS_DELIMITER | CHAR_CLASS_SPECIAL,
+    ['=']  = CHAR_CLASS_DELIMITER | CHAR_CLASS_SPECIAL,
+    ['\"'] = CHAR_CLASS_QUOTE,
+    ['\''] = CHAR_CLASS_QUOTE,
+};
+
+#define GET_CHAR_CLASS(C) (lexer_char_classes[(uint8_t)(C)])
+
 
 // returns the first found character position relative to the offset, or -1 if none are found
 static inline int mc_find_char(const char* str, char c, int offset){
@@ -184,116 +214,108 @@ LexizedString lexize_str(char* str, char delim){
 
 
 Token get_next_token(Tokenizer* tokenizer){
-    char* string = tokenizer->data;
-    const char* special_characters = ":,=";
-    const char line_comment = ';';
-    const char* delimiters = " \t\n\r;:,=";
+    char* const string = tokenizer->data;
+    // the position and column are kept in locals so the compiler does not have to assume every write
+    // to the source (strings are unescaped in place) changes them
+    uint64_t pos = tokenizer->pos;
+    int column = tokenizer->column;
 
     Token token = (Token){0};
     
-    for(; string[tokenizer->pos]; tokenizer->pos+=1){
-        while(string[tokenizer->pos] == ' ' || string[tokenizer->pos] == '\t'){
-            tokenizer->column += 1;
-            tokenizer->pos += 1;
-        }
-#ifdef _WIN32
-        if(string[tokenizer->pos] == '\r'){
-            if(string[tokenizer->pos + 1] == '\n'){
-                tokenizer->line += 1;
-                tokenizer->column = 0;
-                tokenizer->pos += 1;
-                continue;
-            }
-            tokenizer->column += 1;
-            continue;
-        }
-#endif // END OF #ifdef _WIN32
-        if(string[tokenizer->pos] == '\n'){
-            tokenizer->line += 1;
-            tokenizer->column = 0;
-            continue;;
+    for(; string[pos]; pos+=1){
+        while(GET_CHAR_CLASS(string[pos]) & CHAR_CLASS_BLANK){
+            column += 1;
+            pos += 1;
         }
 
-        const char c = string[tokenizer->pos];
-        if(c == '\"'){
-            token.value.as_str = string + tokenizer->pos;
-            const LexizedString ls = lexize_str(token.value.as_str + 1, '\"');
-            tokenizer->column += ls.read + 2;
-            tokenizer->pos += ls.read + 2;
-            if(ls.str == NULL){
+        const char c = string[pos];
+        const uint8_t char_class = GET_CHAR_CLASS(c);
+
+        if(char_class & CHAR_CLASS_QUOTE){
+            token.value.as_str = string + pos;
+            const LexizedString ls = lexize_str(token.value.as_str + 1, c);
+            column += ls.read + 2;
+            pos += ls.read + 2;
+            tokenizer->pos = pos;
+            tokenizer->column = column;
+            if((ls.str == NULL) || (c == '\'' && ls.written != 1)){
                 token.type = TKN_ERROR;
                 token.size = ls.written + 1;
                 return token;
-	        }
-            token.value.as_str = ls.str - 1;
-            token.size = ls.written + 2;
-            token.value.as_str[token.size - 1] = '\"';
-            token.type = TKN_STR;
-            return token;
-        }
-	if(c == '\''){
-	    token.value.as_str = string + tokenizer->pos;
-	    const LexizedString ls = lexize_str(token.value.as_str + 1, '\'');
-	    tokenizer->column += ls.read + 2;
-	    tokenizer->pos += ls.read + 2;
-	    if((ls.str == NULL) || (ls.written != 1)){
-            token.type = TKN_ERROR;
-            token.size = ls.written + 1;
-            return token;
-	    }
+            }
             token.value.as_str = ls.str - 1;
             token.size = ls.written + 2;
-            token.value.as_str[token.size - 1] = '\'';
-            token.type = TKN_CHAR;
+            token.value.as_str[token.size - 1] = c;
+            token.type = (c == '\"')? TKN_STR : TKN_CHAR;
             return token;
         }
-        if(c == line_comment){
-            int skip = mc_find_char(string + tokenizer->pos + 1, '\n', 0);
-            if(skip < 0){
-                return (Token){.value.as_str = NULL, .size = 0, .type = TKN_NONE};
+
+        if(char_class & CHAR_CLASS_DELIMITER){
+            if(c == '\0') break;
+#ifdef _WIN32
+            if(c == '\r'){
+                if(string[pos + 1] == '\n'){
+                    tokenizer->line += 1;
+                    column = 0;
+                    pos += 1;
+                    continue;
+                }
+                column += 1;
+                continue;
             }
-            tokenizer->pos += skip;
-            tokenizer->column += skip + 1;
-            continue;            
-        }
-        if(mc_find_char(special_characters, string[tokenizer->pos], 0) >= 0){
-            token.value.as_char = string[tokenizer->pos];
-            token.size = 1;
-            token.type = TKN_SPECIAL_SYM;
-            tokenizer->pos += 1;
-            tokenizer->column += 1;
-            return token;
-        }
-        token.size = mc_find_chars(string + tokenizer->pos, delimiters, 0);
-        if(token.size < 0 && string[tokenizer->pos]){
-            for(token.size = 0; string[token.size + tokenizer->pos]; token.size+=1);
-        } else if(token.size < 0){
-            break;
+#endif // END OF #ifdef _WIN32
+            if(c == '\n'){
+                tokenizer->line += 1;
+                column = 0;
+                continue;
+            }
+            if(c == ';'){
+                const char* const newline = strchr(string + pos + 1, '\n');
+                if(!newline){
+                    tokenizer->pos = pos;
+                    tokenizer->column = column;
+                    return (Token){.value.as_str = NULL, .size = 0, .type = TKN_NONE};
+                }
+                const int skip = (int) (newline - (string + pos + 1));
+                pos += skip;
+                column += skip + 1;
+                continue;
+            }
+            if(char_class & CHAR_CLASS_SPECIAL){
+                token.value.as_char = c;
+                token.size = 1;
+                token.type = TKN_SPECIAL_SYM;
+                tokenizer->pos = pos + 1;
+                tokenizer->column = column + 1;
+                return token;
+            }
+            // anything else ('\r' outside of windows) is an empty raw token
         }
-        token.value.as_str = string + tokenizer->pos;
-        switch (token.value.as_str[0])
+
+        token.value.as_str = string + pos;
+        for(token.size = 0; !(GET_CHAR_CLASS(token.value.as_str[token.size]) & CHAR_CLASS_DELIMITER); token.size+=1);
+        switch (c)
         {
-        case '\0':
-            token.type = TKN_NONE;
-            return token;
         case '%':
             token.type = TKN_MACRO_INST;
             break;
         case '$':
             token.type = TKN_LABEL_REF;
             break;
-	    case '@':
-	        token.type = TKN_ADDR_LABEL_REF;
-	        break;
+        case '@':
+            token.type = TKN_ADDR_LABEL_REF;
+            break;
         
         default:
             token.type = TKN_RAW;
             break;
         }
-        tokenizer->pos += token.size;
-        tokenizer->column += token.size;
+        tokenizer->pos = pos + token.size;
+        tokenizer->column = column + token.size;
         return token;
     }
+    tokenizer->pos = pos;
+    tokenizer->column = column;
     token.type = TKN_NONE;
     return token;
 }
@@ -0,0 +1,433 @@
+#ifndef VLINKER_C
+#define VLINKER_C
+
+/*
+ * the linker (-link), merges relocatable objects (see object.h) into one executable
+ *
+ * the code and static memory of the objects are laid out one after the other in the order they are passed, the
+ * static memory of every object starting 8 byte aligned. their symbols are merged into one label stream, looked
+ * up through its hash index (see labels.h), with their positions and static offsets moved to where their object
+ * ended up. a symbol can only be defined by more than one object when it is the very same constant (include
+ * guards, shared %label constants), positions and static offsets are unique. the relocations of all objects are
+ * then applied in one pass and the entry point is the one of the last object with %start, 0 if none has one.
+ */
+
+#include "assembler.c"
+#include "object.h"
+#include <stdio.h>
+#include <inttypes.h>
+
+typedef struct LinkerObject{
+    const char*     path;
+    VirtualFile     vfile;
+    const uint8_t*  code;
+    uint64_t        code_size;
+    const uint8_t*  static_memory;
+    uint64_t        static_size;
+    const uint8_t*  labels;
+    uint64_t        labels_size;
+    const uint8_t*  relocations;
+    uint64_t        relocations_size;
+    const uint8_t*  start;
+    // where its code (in instructions) and static memory start in the executable
+    uint64_t        program_base;
+    uint64_t        static_base;
+} LinkerObject;
+
+static inline int _link_open_object(LinkerObject* object, const char* path){
+    const char* required_fields[] = {
+        OBJECT_CODE_FIELD_NAME, VIRTUAL_FILE_STATIC_FIELD_NAME, VIRTUAL_FILE_LABELS_FIELD_NAME, OBJECT_RELOCATIONS_FIELD_NAME, NULL
+    };
+    const char* optional_fields[] = {OBJECT_START_FIELD_NAME, NULL};
+
+    memset(object, 0, sizeof(*object));
+    object->path = path;
+    if(vfmap(&object->vfile, path, required_fields, optional_fields)){
+        fprintf(stderr, "[ERROR] Could Not Open Object '%s'\n", path);
+        return 1;
+    }
+    if(object->vfile.vfile_type != VIRTUAL_FILE_TYPE_OBJECT){
+        fprintf(stderr, "[ERROR] '%s' Is Not An Object, Assemble It With -object\n", path);
+        vfclose(object->vfile);
+        return 1;
+    }
+    if(!_vf_native_endianness(object->vfile.file_flags)){
+        fprintf(stderr, "[ERROR] Object '%s' Was Assembled On A Machine With Different Endianness\n", path);
+        vfclose(object->vfile);
+        return 1;
+    }
+    uint64_t start_size = 0;
+    object->code            = get_virtual_file_field_data(object->vfile, OBJECT_CODE_FIELD_NAME, &object->code_size);
+    object->static_memory   = get_virtual_file_field_data(object->vfile, VIRTUAL_FILE_STATIC_FIELD_NAME, &object->static_size);
+    object->labels          = get_virtual_file_field_data(object->vfile, VIRTUAL_FILE_LABELS_FIELD_NAME, &object->labels_size);
+    object->relocations     = get_virtual_file_field_data(object->vfile, OBJECT_RELOCATIONS_FIELD_NAME, &object->relocations_size);
+    object->start           = get_virtual_file_field_data(object->vfile, OBJECT_START_FIELD_NAME, &start_size);
+    if(!object->code || !object->static_memory || !object->labels || !object->relocations
+        || object->code_size % sizeof(Inst) || (object->start && start_size != sizeof(uint64_t))){
+        fprintf(stderr, "[ERROR] Object '%s' Is Corrupted\n", path);
+        vfclose(object->vfile);
+        return 1;
+    }
+    object->code_size /= sizeof(Inst);
+    return 0;
+}
+
+// adds the symbols of object to symbols, moved to where the object is in the executable
+static inline int _link_add_symbols(Mc_stream_t* symbols, const LinkerObject* object){
+    for(uint64_t i = 0; i < object->labels_size; ){
+        const uint8_t* const data = object->labels + i;
+        if(object->labels_size - i < SIZEOF_LABEL){
+            fprintf(stderr, "[ERROR] Object '%s' Has Corrupted Labels\n", object->path);
+            return 1;
+        }
+        const Label label = get_label_from_raw_data(data);
+        if(label.size < SIZEOF_LABEL || label.size > object->labels_size - i || label.str > label.size || label.str_size > label.size - label.str){
+            fprintf(stderr, "[ERROR] Object '%s' Has Corrupted Labels\n", object->path);
+            return 1;
+        }
+        i += label.size;
+
+        const Token name = (Token){.value.as_str = (char*)(data + label.str), .size = label.str_size, .type = TKN_RAW};
+        const int moved = (label.type == TKN_INST_POSITION) || (label.flags & LABELFLAG_STATIC);
+        Token definition = (Token){.value = label.definition, .type = label.type, .size = 0};
+        if(label.type == TKN_STR || label.type == TKN_RAW){
+            definition.value.as_str = (char*) get_label_def_as_str(data);
+            definition.size = *(const uint32_t*)(data + label.definition.as_uint);
+        }
+        else if(label.type == TKN_INST_POSITION){
+            definition.value.as_uint += object->program_base;
+        }
+        else if(label.flags & LABELFLAG_STATIC){
+            definition.value.as_uint += object->static_base;
+        }
+
+        const uint8_t* const defined = (const uint8_t*) get_label(symbols, name);
+        if(defined){
+            const Label previous = get_label_from_raw_data(defined);
+            // the stream of a single object is copied as is, so equal constants have equal records
+            if(!moved && previous.type != TKN_INST_POSITION && previous.size == label.size
+                && !memcmp(defined + SIZEOF_LABEL, data + SIZEOF_LABEL, label.size - SIZEOF_LABEL)
+                && previous.type == label.type && previous.definition.as_uint == label.definition.as_uint){
+                continue;
+            }
+            fprintf(stderr, "[ERROR] Symbol '%.*s' Of '%s' Is Already Defined By Another Object\n", name.size, name.value.as_str, object->path);
+            return 1;
+        }
+        // only objects need to know which labels are static offsets, executables look the same as if assembled directly
+        if(add_label_with_flag(symbols, name, definition, label.flags & ~LABELFLAG_STATIC)){
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// applies the relocations of object to its code in program
+static inline int _link_relocate(Inst* program, const Mc_stream_t* symbols, const LinkerObject* object){
+    int err = 0;
+    for(uint64_t i = 0; i < object->relocations_size; ){
+        ObjectRelocation relocation;
+        i = get_object_relocation(object->relocations, object->relocations_size, i, &relocation);
+        if(i == 0 || relocation.inst >= object->code_size || relocation.byte + sizeof(uint16_t) > sizeof(Inst)){
+            fprintf(stderr, "[ERROR] Object '%s' Has Corrupted Relocations\n", object->path);
+            return 1;
+        }
+        const uint64_t position = object->program_base + relocation.inst;
+        const unsigned int shift = 8 * relocation.byte;
+        // the literal of a wide instruction goes on in its containers
+        const int opcode = program[position] & 0xFF;
+        const int wide = relocation.byte == 2 && get_inst_payload_size(opcode) &&
+            relocation.inst + get_inst_payload_size(opcode) < object->code_size;
+        const uint64_t literal = wide? get_wide_literal(program + position) : (program[position] >> shift) & 0xFFFF;
+        uint64_t value = 0;
+
+        switch (relocation.kind)
+        {
+        case OBJECT_RELOCATION_POSITION:
+            value = literal + object->program_base;
+            break;
+        case OBJECT_RELOCATION_STATIC:
+            value = literal + object->static_base;
+            break;
+        case OBJECT_RELOCATION_SYMBOL:
+        case OBJECT_RELOCATION_RELATIVE_SYMBOL:{
+            const Token name = (Token){.value.as_str = (char*) relocation.symbol, .size = relocation.symbol_size, .type = TKN_RAW};
+            const Label* const symbol = get_label(symbols, name);
+            if(!symbol){
+                fprintf(stderr, "[ERROR] Undefined Symbol '%.*s' Used By '%s'\n", name.size, name.value.as_str, object->path);
+                err = 1;
+                continue;
+            }
+            const Label label = get_label_from_raw_data(symbol);
+            if(relocation.kind == OBJECT_RELOCATION_RELATIVE_SYMBOL){
+                if(label.type != TKN_INST_POSITION){
+                    fprintf(stderr, "[ERROR] Symbol '%.*s' Used By '%s' For Relative Referencing Is Not An Instruction Position\n",
+                        name.size, name.value.as_str, object->path);
+                    err = 1;
+                    continue;
+                }
+                const int64_t distance = (int64_t) label.definition.as_uint - (int64_t) position;
+                if(wide){
+                    value = (uint64_t) distance;
+                    break;
+                }
+                if(distance != (int16_t) distance){
+                    fprintf(stderr, "[ERROR] Symbol '%.*s' Is Too Far From Its Reference In '%s', %"PRIi64" != %"PRIi16"\n",
+                        name.size, name.value.as_str, object->path, distance, (int16_t) distance);
+                    err = 1;
+                    continue;
+                }
+                value = (uint16_t)(int16_t) distance;
+                break;
+            }
+            if(label.type != TKN_INST_POSITION && label.type != TKN_ULIT && label.type != TKN_ILIT && label.type != TKN_FLIT){
+                fprintf(stderr, "[ERROR] Symbol '%.*s' Used By '%s' Is Not A Literal\n", name.size, name.value.as_str, object->path);
+                err = 1;
+                continue;
+            }
+            value = label.definition.as_uint;
+        }   break;
+        default:
+            fprintf(stderr, "[ERROR] Object '%s' Has Corrupted Relocations\n", object->path);
+            return 1;
+        }
+
+        if(wide){
+            if(!fits_wide_literal(opcode, value)){
+                fprintf(stderr, "[ERROR] Relocated Literal Of %s In '%s' Has To Be A 32 Bits Signed Integer, %"PRIi64" != %"PRIi32"\n",
+                    get_inst_name(opcode), object->path, (int64_t) value, (int32_t) value);
+                err = 1;
+                continue;
+            }
+            set_wide_literal(program + position, value);
+            continue;
+        }
+        if(value != (uint16_t) value){
+            fprintf(stderr, "[ERROR] Relocated Literal In '%s' Has To Be Up To 16 Bits Long, %"PRIu64" != %"PRIu16"\n",
+                object->path, value, (uint16_t) value);
+            err = 1;
+            continue;
+        }
+        program[position] = (program[position] & ~((Inst) 0xFFFF << shift)) | ((Inst) value << shift);
+    }
+    return err;
+}
+
+// lays out objects one after the other, resolves their symbols and relocations and saves the result to output_path
+// \returns 0 on success or 1 otherwise
+static int _link(LinkerObject* objects, int object_count, const char* output_path, const AssembleOptions* options){
+
+    Mc_stream_t program = mc_create_stream(1024 * sizeof(Inst), 8);
+    Mc_stream_t static_memory = mc_create_stream(0, 0);
+    Mc_stream_t symbols = mc_create_stream(0, 0);
+
+    int err = 0;
+    uint64_t entry_point = 0;
+
+    for(int i = 0; i < object_count; i+=1){
+        LinkerObject* const object = &objects[i];
+        object->program_base = program.size / sizeof(Inst);
+        mc_stream_aligned(&static_memory, NULL, 0, 8);
+        object->static_base = static_memory.size;
+        mc_stream(&program, object->code, (size_t) (object->code_size * sizeof(Inst)));
+        mc_stream(&static_memory, object->static_memory, (size_t) object->static_size);
+        if(object->start){
+            memcpy(&entry_point, object->start, sizeof(entry_point));
+            entry_point += object->program_base;
+        }
+        if(_link_add_symbols(&symbols, object)){
+            DEFER_ERROR("Could Not Link '%s'\n", output_path);
+        }
+    }
+
+    for(int i = 0; i < object_count; i+=1){
+        err |= _link_relocate((Inst*) program.data, &symbols, &objects[i]);
+    }
+    if(err){
+        DEFER_ERROR("Could Not Link '%s'\n", output_path);
+    }
+
+    mc_stream(&program, &entry_point, sizeof(entry_point));
+
+    err = save_executable(output_path, &program, &static_memory, &symbols, options->export_labels, options->compress);
+
+    defer:
+
+    release_label_index(&symbols);
+    mc_destroy_stream(program);
+    mc_destroy_stream(static_memory);
+    mc_destroy_stream(symbols);
+
+    return err;
+}
+
+// links the objects in input_paths into an executable in output_path (output.out if NULL)
+// \param options only export_labels and compress are used
+// \returns 0 on success or 1 otherwise
+int link_objects(const char* const* input_paths, int input_count, const char* output_path, const AssembleOptions* options){
+
+    LinkerObject* const objects = (LinkerObject*) calloc((size_t) input_count, sizeof(LinkerObject));
+    if(!objects){
+        fprintf(stderr, "[ERROR] Could Not Allocate The Objects To Link\n");
+        return 1;
+    }
+
+    int err = 0;
+    int opened = 0;
+
+    for(; opened < input_count; opened+=1){
+        if(_link_open_object(&objects[opened], input_paths[opened])){
+            DEFER_ERROR("Could Not Link '%s'\n", output_path? output_path : "output.out");
+        }
+    }
+
+    err = _link(objects, input_count, output_path? output_path : "output.out", options);
+
+    defer:
+
+    for(int i = 0; i < opened; i+=1){
+        vfclose(objects[i].vfile);
+    }
+    free(objects);
+
+    return err;
+}
+
+/*
+ * the front end of -assemble with several inputs
+ *
+ * every input is its own translation unit, it is assembled to an object in memory (see assemble_unit) by one of
+ * jobs threads, each with its own Parser, Tokenizer and streams, label indices are thread local (see labels.h).
+ * the objects are then linked in the order of the inputs just like -link would, so the executable is byte for byte
+ * the same no matter how many threads there are or which one finished first.
+ */
+
+#if !defined(_WIN32) && (defined(__unix__) || defined(__APPLE__)) && !defined(VPU_NO_ASSEMBLER_THREADS)
+    #define VPU_ASSEMBLER_THREADS 1
+    #include <pthread.h>
+#else
+    #define VPU_ASSEMBLER_THREADS 0
+#endif
+
+typedef struct _AssembleJobs{
+    const char* const*      input_paths;
+    AssembledUnit*          units;
+    int*                    status;
+    int                     input_count;
+    const AssembleOptions*  options;
+#if VPU_ASSEMBLER_THREADS
+    pthread_mutex_t         mutex;
+#endif
+    // the next input nobody took yet
+    int                     next;
+} _AssembleJobs;
+
+static void* _assemble_jobs(void* _jobs){
+    _AssembleJobs* const jobs = (_AssembleJobs*) _jobs;
+    for(;;){
+#if VPU_ASSEMBLER_THREADS
+        pthread_mutex_lock(&jobs->mutex);
+#endif
+        const int i = jobs->next;
+        jobs->next += (i < jobs->input_count);
+#if VPU_ASSEMBLER_THREADS
+        pthread_mutex_unlock(&jobs->mutex);
+#endif
+        if(i >= jobs->input_count) return NULL;
+        jobs->status[i] = assemble_unit(jobs->input_paths[i], jobs->options, &jobs->units[i]);
+    }
+}
+
+// assembles every input in input_paths as its own object and links them, in that order, into an executable in output_path
+// (output.out if NULL)
+// \param jobs how many inputs can be assembled at the same time
+// \param options object and include_cache are ignored, the inputs are always assembled as objects
+// \returns 0 on success or 1 otherwise
+int assemble_files(char* const* input_paths, int input_count, char* output_path, const AssembleOptions* options, int jobs){
+
+#ifdef _WIN32
+    // changing file separator to default '/'
+    for(int i = 0; i < input_count; i+=1){
+        for(size_t j = 0; input_paths[i][j]; j+=1){
+            if(input_paths[i][j] == '\\') input_paths[i][j] = '/';
+        }
+    }
+    for(size_t i = 0; output_path && output_path[i]; i+=1){
+        if(output_path[i] == '\\') output_path[i] = '/';
+    }
+#endif
+
+    const char* const output = output_path? output_path : "output.out";
+
+    AssembleOptions unit_options = *options;
+    unit_options.object = 1;
+    // the include cache can not replay the relocations of an object
+    unit_options.include_cache = NULL;
+
+    LinkerObject* const objects = (LinkerObject*) calloc((size_t) input_count, sizeof(LinkerObject));
+    AssembledUnit* const units = (AssembledUnit*) calloc((size_t) input_count, sizeof(AssembledUnit));
+    int* const status = (int*) calloc((size_t) input_count, sizeof(int));
+
+    int err = 0;
+
+    if(!objects || !units || !status){
+        DEFER_ERROR("Could Not Allocate The Inputs To Assemble\n");
+    }
+
+    _AssembleJobs work = (_AssembleJobs){
+        .input_paths = (const char* const*) input_paths, .units = units, .status = status, .input_count = input_count, .options = &unit_options, .next = 0
+    };
+
+    if(jobs > input_count) jobs = input_count;
+
+#if VPU_ASSEMBLER_THREADS
+    pthread_t* const threads = (jobs > 1)? (pthread_t*) calloc((size_t) jobs - 1, sizeof(pthread_t)) : NULL;
+    int started = 0;
+    pthread_mutex_init(&work.mutex, NULL);
+    for(; threads && started < jobs - 1; started+=1){
+        if(pthread_create(&threads[started], NULL, _assemble_jobs, &work)) break;
+    }
+    // this thread is a worker too, so it all still gets done if no thread could be started
+    _assemble_jobs(&work);
+    for(int i = 0; i < started; i+=1){
+        pthread_join(threads[i], NULL);
+    }
+    pthread_mutex_destroy(&work.mutex);
+    free(threads);
+#else
+    _assemble_jobs(&work);
+#endif
+
+    for(int i = 0; i < input_count; i+=1){
+        if(status[i]){
+            fprintf(stderr, "[ERROR] Could Not Assemble '%s'\n", input_paths[i]);
+            err = 1;
+            continue;
+        }
+        objects[i] = (LinkerObject){
+            .path = input_paths[i],
+            .code = (const uint8_t*) units[i].program.data, .code_size = units[i].program.size / sizeof(Inst),
+            .static_memory = (const uint8_t*) units[i].static_memory.data, .static_size = units[i].static_memory.size,
+            .labels = (const uint8_t*) units[i].labels.data, .labels_size = units[i].labels.size,
+            .relocations = (const uint8_t*) units[i].relocations.data, .relocations_size = units[i].relocations.size,
+            .start = (units[i].entry_point != UINT64_MAX)? (const uint8_t*) &units[i].entry_point : NULL
+        };
+    }
+    if(err){
+        DEFER_ERROR("Could Not Link '%s'\n", output);
+    }
+
+    err = _link(objects, input_count, output, options);
+
+    defer:
+
+    for(int i = 0; units && i < input_count; i+=1){
+        destroy_assembled_unit(&units[i]);
+    }
+    free(objects);
+    free(units);
+    free(status);
+
+    return err;
+}
+
+#endif // END OF FILE VLINKER_C =================================================
@@ -1,273 +1,466 @@
 #ifndef VLINUX_SYSTEM_C
 #define VLINUX_SYSTEM_C
 
-#include "system.h"
+/*
+ * the threads of the default system on linux (and the other POSIX systems), see system.c
+ *
+ * every VPU thread is a pthread running the program on the threaded engine (see threaded.c, the program is
+ * decoded against the registers of every thread) with its own VPU, registers and stack
+ * (a guarded one, see stack.c), the program, the static memory and the system are shared with the thread that
+ * created it. A thread starts at the instruction in RA of VSYS_NEW_THREAD with RB in its RA and ends when it
+ * returns from there, HALTs, a syscall fails or it is killed. Mutexes and condition variables are plain pthread
+ * ones handed to the program as pointers.
+ *
+ * the threads still running when the system closes are killed and waited for, killing is cooperative: a thread
+ * stops before its next backward jump, call or return (see poll_program). Threads blocked in VSYS_LOCK_MUTEX, VSYS_WAIT_COND or VSYS_SLEEP wake up
+ * every VTHREAD_POLL_MS to see if they were killed, so closing never waits on a mutex nobody will unlock.
+ */
+
 #include "core.h"
+#include "system.h"
+#include "stack.c"
+#include "threaded.c"
 #include <pthread.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <time.h>
+
+// the stack of a thread in bytes when VSYS_NEW_THREAD does not ask for one
+#ifndef VPU_THREAD_STACK_SIZE
+#define VPU_THREAD_STACK_SIZE (256 * 1024)
+#endif
 
 enum SystemThreadStates{
-    SYSTEM_THREAD_STATE_ACTIVE = 1 << 0,
+    SYSTEM_THREAD_STATE_ACTIVE   = 1 << 0,
+    SYSTEM_THREAD_STATE_JOINING  = 1 << 1,
     SYSTEM_THREAD_STATE_DETACHED = 1 << 2,
 };
 
+typedef struct VThreads VThreads;
+
 typedef struct _VThread
 {
+    // SystemThreadStates, changed with the mutex of the threads held
     int             state;
+    // cleared to make the thread stop before its next jump, see poll_program
+    atomic_int      running;
     pthread_t       handle;
-    pthread_mutex_t mutex;
-    void*           shared;
-    int             calldepth;
+    VThreads*       threads;
+    VpuStack        stack;
     VPU             vpu;
-    Register        registers[REGISTER_SPACE_SIZE / sizeof(Register)];
-    uint64_t        stack[1024];
+    Register        registers[VPU_REGISTER_SPACE_SIZE / sizeof(Register)];
+    // the program decoded against registers, threads run on the threaded engine
+    DecodedProgram  code;
 } _VThread;
 
-
-typedef struct VSystem
+struct VThreads
 {
+    _VThread**      threads;
+    int             thread_count;
+    int             thread_cap;
+    pthread_mutex_t mutex;
+    // signaled whenever a thread ends
+    pthread_cond_t  ended;
+};
 
-    _VThread**  threads;
-    int         thread_count;
-    int         thread_cap;
+// how often, in milliseconds, a thread blocked in a syscall checks whether it was killed
+#ifndef VTHREAD_POLL_MS
+#define VTHREAD_POLL_MS 20
+#endif
 
-    uint32_t* display;
-    uint32_t  display_width;
-    uint32_t  display_height;
+// the end of a thread, a thread returns to it from where it started and HALT jumps to it
+#define VTHREAD_END 0XFFFFFFFFFFFFFFFF
 
-} VSystem;
+// \returns 0 on success or non zero otherwise
+static int init_vthreads(VThreads* threads){
+    memset(threads, 0, sizeof(*threads));
+    if(pthread_mutex_init(&threads->mutex, NULL)) return 1;
+    if(pthread_cond_init(&threads->ended, NULL)){
+        pthread_mutex_destroy(&threads->mutex);
+        return 1;
+    }
+    return 0;
+}
 
-static void* _vthread(void* _data){
-    _VThread* const thread = (_VThread*) _data;
+static void _free_vthread(_VThread* thread){
+    free_decoded_program(&thread->code);
+    destroy_vpu_stack(&thread->stack);
+    virtual_free(thread);
+}
+
+// removes thread from threads, needs the mutex of threads
+static void _remove_vthread(VThreads* threads, const _VThread* thread){
+    for(int i = 0; i < threads->thread_count; i+=1){
+        if(threads->threads[i] == thread){
+            threads->threads[i] = threads->threads[--threads->thread_count];
+            return;
+        }
+    }
+}
+
+// \returns the index of thread in threads or -1 if it is not one of them, needs the mutex of threads
+static int _find_vthread(const VThreads* threads, const _VThread* thread){
+    for(int i = 0; i < threads->thread_count; i+=1){
+        if(threads->threads[i] == thread) return i;
+    }
+    return -1;
+}
+
+// the thread running on this pthread, NULL on the thread that runs the program
+static _Thread_local _VThread* _current_vthread = NULL;
 
-    pthread_mutex_lock(&thread->mutex);
+// \returns non zero if the calling thread was killed and should not keep blocking in a syscall
+static inline int _vthread_killed(void){
+    return _current_vthread && !atomic_load_explicit(&_current_vthread->running, memory_order_relaxed);
+}
 
+// performs the program on thread until it ends, is killed or leaves the program
+static void _run_vthread(_VThread* thread){
     VPU* const vpu = &thread->vpu;
+    Register* const rip = GET_REG(vpu->register_space, RIP);
+
+    run_threaded(vpu, &thread->code);
+    if(!atomic_load_explicit(&thread->running, memory_order_relaxed)) return;
+
+    // falling off the end ends it like it ends the program, jumping anywhere else past it is an error
+    if(rip->as_uint64 != VTHREAD_END && rip->as_uint64 != vpu->program_size){
+        fprintf(stderr, "[ERROR] Thread Jumped Out Of The Program To IP %"PRIu64" (Program Size Is %"PRIu64" Instructions)\n",
+            rip->as_uint64, vpu->program_size);
+        vpu->status = 1;
+    }
+}
 
-    while((thread->state & SYSTEM_THREAD_STATE_ACTIVE) && thread->calldepth > 0){
+static void* _vthread(void* _data){
+    _VThread* const thread = (_VThread*) _data;
+    VThreads* const threads = thread->threads;
 
-        thread->calldepth += (vpu->program[GET_REG(vpu->register_space, RIP)->as_uint64] & 0xFF) == INST_CALL;
-        thread->calldepth -= (vpu->program[GET_REG(vpu->register_space, RIP)->as_uint64] & 0xFF) == INST_RET;
+    _current_vthread = thread;
 
-        GET_REG(vpu->register_space, RIP)->as_int64 += perform_inst(
-            vpu,
-            vpu->program[GET_REG(vpu->register_space, RIP)->as_uint64]
-        );
+#if VPU_STACK_GUARD
+    // a stack fault ends the thread instead of the whole process, see stack.c
+    void* const signal_stack = push_vpu_signal_stack();
+    arm_vpu_stack_guard(&thread->vpu, &thread->stack);
+    if(sigsetjmp(vpu_stack_fault.jump, 1)){
+        fprintf(stderr, "[ERROR] Stack %s At IP %"PRIu64" In A Thread (Stack Size Is %"PRIu64" Bytes)\n",
+            (vpu_stack_fault.kind == VPU_STACK_UNDERFLOW)? "Underflow" : "Overflow", (uint64_t) vpu_stack_fault.ip, thread->stack.size);
+        thread->vpu.status = 1;
     }
+    else _run_vthread(thread);
+    disarm_vpu_stack_guard();
+    pop_vpu_signal_stack(signal_stack);
+#else
+    _run_vthread(thread);
+#endif
 
+    pthread_mutex_lock(&threads->mutex);
     thread->state &= ~SYSTEM_THREAD_STATE_ACTIVE;
+    if(thread->state & SYSTEM_THREAD_STATE_DETACHED){
+        _remove_vthread(threads, thread);
+        _free_vthread(thread);
+    }
+    pthread_cond_broadcast(&threads->ended);
+    pthread_mutex_unlock(&threads->mutex);
+
+    return NULL;
+}
+
+// kills every thread and waits for them, then frees threads
+static void close_vthreads(VThreads* threads){
+    pthread_mutex_lock(&threads->mutex);
+    for(int i = 0; i < threads->thread_count; i+=1){
+        atomic_store(&threads->threads[i]->running, 0);
+    }
+    for(int i = 0; i < threads->thread_count; ){
+        _VThread* const thread = threads->threads[i];
+        // detached threads remove themselves and the ones being joined are removed by their joiner
+        if(thread->state & (SYSTEM_THREAD_STATE_DETACHED | SYSTEM_THREAD_STATE_JOINING)){
+            pthread_cond_wait(&threads->ended, &threads->mutex);
+            i = 0;
+            continue;
+        }
+        thread->state |= SYSTEM_THREAD_STATE_JOINING;
+        pthread_mutex_unlock(&threads->mutex);
+        pthread_join(thread->handle, NULL);
+        pthread_mutex_lock(&threads->mutex);
+        _remove_vthread(threads, thread);
+        _free_vthread(thread);
+        i = 0;
+    }
+    pthread_mutex_unlock(&threads->mutex);
+    virtual_free(threads->threads);
+    pthread_cond_destroy(&threads->ended);
+    pthread_mutex_destroy(&threads->mutex);
+    memset(threads, 0, sizeof(*threads));
+}
+
+// \returns 0 on success or 1 on failure
+static int _new_vthread(VThreads* threads, VPU* vpu){
+    void* const registers = vpu->register_space;
+
+    _VThread* const thread = (_VThread*) virtual_alloc(sizeof(_VThread));
+    if(!thread) return 1;
+    memset(thread, 0, sizeof(*thread));
+    if(create_vpu_stack(&thread->stack, GET_REG(registers, RC)->as_uint64? GET_REG(registers, RC)->as_uint64 : VPU_THREAD_STACK_SIZE)){
+        virtual_free(thread);
+        return 1;
+    }
+    thread->state = SYSTEM_THREAD_STATE_ACTIVE;
+    atomic_init(&thread->running, 1);
+    thread->threads = threads;
+    thread->vpu = *vpu;
+    thread->vpu.status = 0;
+    thread->vpu.stack = thread->stack.base;
+    thread->vpu.register_space = (uint8_t*) &thread->registers[0];
+    *GET_REG(thread->vpu.register_space, RA) = *GET_REG(registers, RB);
+    GET_REG(thread->vpu.register_space, RIP)->as_uint64 = GET_REG(registers, RA)->as_uint64;
+    // returning from where it started ends the thread
+    thread->vpu.stack[GET_REG(thread->vpu.register_space, RSP)->as_uint64++] = VTHREAD_END;
+    if(decode_program(&thread->code, vpu->program, vpu->program_size, thread->vpu.register_space)){
+        _free_vthread(thread);
+        return 1;
+    }
+    poll_program(&thread->code, &thread->running);
+    fuse_program(&thread->code);
 
-    pthread_mutex_unlock(&thread->mutex);
+    pthread_mutex_lock(&threads->mutex);
+    if(threads->thread_count >= threads->thread_cap){
+        const int cap = threads->thread_cap? threads->thread_cap * 2 : 8;
+        _VThread** const grown = (_VThread**) realloc(threads->threads, (size_t) cap * sizeof(_VThread*));
+        if(!grown){
+            pthread_mutex_unlock(&threads->mutex);
+            _free_vthread(thread);
+            return 1;
+        }
+        threads->threads = grown;
+        threads->thread_cap = cap;
+    }
+    if(pthread_create(&thread->handle, NULL, _vthread, thread)){
+        pthread_mutex_unlock(&threads->mutex);
+        _free_vthread(thread);
+        return 1;
+    }
+    threads->threads[threads->thread_count++] = thread;
+    pthread_mutex_unlock(&threads->mutex);
 
-    return _data;
+    GET_REG(registers, RA)->as_ptr = (uint8_t*) thread;
+    return 0;
 }
 
-static char get_ascii_color(uint32_t color){
+// waits for the thread in RA, if kill is not 0 it is killed first
+// \returns 0 on success or 1 if RA is not a thread that can be waited for
+static int _wait_vthread(VThreads* threads, VPU* vpu, int kill){
+    void* const registers = vpu->register_space;
+    _VThread* const thread = (_VThread*) GET_REG(registers, RA)->as_ptr;
 
-    static const char ascii_map[] = "@#Xx%*+=~-:\"'. ";
-    const  int ascii_maplen = sizeof(ascii_map) / sizeof(ascii_map[0]) - 1;
+    pthread_mutex_lock(&threads->mutex);
+    if(_find_vthread(threads, thread) < 0 || (thread->state & (SYSTEM_THREAD_STATE_DETACHED | SYSTEM_THREAD_STATE_JOINING))){
+        pthread_mutex_unlock(&threads->mutex);
+        return 1;
+    }
+    thread->state |= SYSTEM_THREAD_STATE_JOINING;
+    if(kill) atomic_store(&thread->running, 0);
+    pthread_mutex_unlock(&threads->mutex);
 
-    const uint32_t rw = 2126;
-    const uint32_t gw = 7152;
-    const uint32_t bw =  722;
+    pthread_join(thread->handle, NULL);
 
-    const uint32_t r = ((color >>  0) & 0xFF);
-    const uint32_t g = ((color >>  8) & 0xFF);
-    const uint32_t b = ((color >> 16) & 0xFF);
-    const uint32_t a = ((color >> 24) & 0xFF);
+    // the RA and status the thread ended with
+    *GET_REG(registers, RA) = *GET_REG(thread->vpu.register_space, RA);
+    GET_REG(registers, RB)->as_int64 = thread->vpu.status;
 
-    const uint32_t brightness = a? (rw * r + gw * g + bw * b) / (rw + gw + bw) : 0;
-    const int ascii_index = (brightness < 255)? (brightness * ascii_maplen) / 255 : ascii_maplen - 1;
-    return ascii_map[ascii_maplen - 1 - ascii_index];
+    pthread_mutex_lock(&threads->mutex);
+    _remove_vthread(threads, thread);
+    _free_vthread(thread);
+    pthread_cond_broadcast(&threads->ended);
+    pthread_mutex_unlock(&threads->mutex);
+    return 0;
 }
 
-// if you provide your own sys_call method, you can to do whatever you want on a syscall with any id number
-// this is the default and a suggestion for what each call should try to do...
-// arguments are passed in order from registers ra to rz and returned in order throught the same registers
-// \returns 0 on success or non zero error code in failure
-int syscall(VPU* vpu, uint64_t call){
+// sets time to milliseconds after now on CLOCK_REALTIME, the clock of the timed pthread waits
+static void _vthread_deadline(struct timespec* time, int64_t milliseconds){
+    clock_gettime(CLOCK_REALTIME, time);
+    time->tv_sec  += (time_t) (milliseconds / 1000);
+    time->tv_nsec += (long) (milliseconds % 1000) * 1000000L;
+    if(time->tv_nsec >= 1000000000L){
+        time->tv_sec  += 1;
+        time->tv_nsec -= 1000000000L;
+    }
+}
+
+static inline int _vthread_before(const struct timespec* a, const struct timespec* b){
+    return a->tv_sec < b->tv_sec || (a->tv_sec == b->tv_sec && a->tv_nsec < b->tv_nsec);
+}
+
+// locks mutex, giving up if the calling thread is killed while waiting
+// \returns 0 if it was locked, ECANCELED if the thread was killed or an error code
+static int _lock_vmutex(pthread_mutex_t* mutex){
+    if(!_current_vthread) return pthread_mutex_lock(mutex);
+    for(;;){
+#ifdef __APPLE__
+        // no pthread_mutex_timedlock
+        const int r = pthread_mutex_trylock(mutex);
+        if(r != EBUSY) return r;
+        const struct timespec pause = {0, 1000000L};
+        nanosleep(&pause, NULL);
+#else
+        struct timespec until;
+        _vthread_deadline(&until, VTHREAD_POLL_MS);
+        const int r = pthread_mutex_timedlock(mutex, &until);
+        if(r != ETIMEDOUT) return r;
+#endif
+        if(_vthread_killed()) return ECANCELED;
+    }
+}
+
+// waits on cond for at most milliseconds (< 0 for no limit), waking up early if the calling thread is killed
+// \returns 0 if it was signaled (or woke up spuriously), ETIMEDOUT if it timed out or an error code
+static int _wait_vcond(pthread_cond_t* cond, pthread_mutex_t* mutex, int64_t milliseconds){
+    if(!_current_vthread && milliseconds < 0) return pthread_cond_wait(cond, mutex);
+    struct timespec end = {0, 0};
+    if(milliseconds >= 0) _vthread_deadline(&end, milliseconds);
+    for(;;){
+        struct timespec until;
+        if(_current_vthread) _vthread_deadline(&until, VTHREAD_POLL_MS);
+        if(!_current_vthread || (milliseconds >= 0 && _vthread_before(&end, &until))) until = end;
+        const int r = pthread_cond_timedwait(cond, mutex, &until);
+        if(r != ETIMEDOUT) return r;
+        if(milliseconds >= 0 && !_vthread_before(&until, &end)) return ETIMEDOUT;
+        if(_vthread_killed()) return ECANCELED;
+    }
+}
 
-    if(!vpu->system && !(call == SYS_GET_SYSTEM_SPECIFICATIONS || call == SYS_INITIALIZE))
+// sleeps for milliseconds, waking up early if the calling thread is killed
+static void _vthread_sleep(uint32_t milliseconds){
+    while(milliseconds && !_vthread_killed()){
+        const uint32_t step = (_current_vthread && milliseconds > VTHREAD_POLL_MS)? VTHREAD_POLL_MS : milliseconds;
+        struct timespec duration = {(time_t) (step / 1000), (long) (step % 1000) * 1000000L};
+        while(nanosleep(&duration, &duration) && errno == EINTR);
+        milliseconds -= step;
+    }
+}
+
+// \returns 0 on success or 1 if RA is not a thread that can be detached
+static int _detach_vthread(VThreads* threads, VPU* vpu){
+    _VThread* const thread = (_VThread*) GET_REG(vpu->register_space, RA)->as_ptr;
+
+    pthread_mutex_lock(&threads->mutex);
+    if(_find_vthread(threads, thread) < 0 || (thread->state & (SYSTEM_THREAD_STATE_DETACHED | SYSTEM_THREAD_STATE_JOINING))){
+        pthread_mutex_unlock(&threads->mutex);
         return 1;
+    }
+    pthread_detach(thread->handle);
+    if(thread->state & SYSTEM_THREAD_STATE_ACTIVE){
+        // it frees itself when it ends
+        thread->state |= SYSTEM_THREAD_STATE_DETACHED;
+    }
+    else{
+        _remove_vthread(threads, thread);
+        _free_vthread(thread);
+    }
+    pthread_mutex_unlock(&threads->mutex);
+    return 0;
+}
+
+// performs the thread, mutex, condition variable and time syscalls of the default system
+// arguments are passed in order from registers ra to rz and returned in order throught the same registers
+// \returns 0 on success or non zero error code in failure
+static int vthread_syscall(VThreads* threads, VPU* vpu, uint64_t call){
 
     void* const registers = vpu->register_space;
 
     switch (call)
     {
-    case SYS_GET_SYSTEM_SPECIFICATIONS:
-        // system name goes in RA
-        GET_REG(registers, RA)->as_uint64   = *(uint64_t*) "DEFAULT";
-        // system bitsize architecture goes in RB
-        GET_REG(registers, RB)->as_uint8    = sizeof(size_t);
-        // get system active state to RC
-        GET_REG(registers, RC)->as_uint64   = (vpu->system != NULL);
-        // system endianess goes in RD
-        GET_REG(registers, RD)->as_uint8    = is_little_endian()? 1 : 0;
-        return 0;
-    case SYS_INITIALIZE:{
-        VSystem* const system = virtual_alloc(sizeof(VSystem));
-        if(!system)
-            return 1;
-
-        memset(system, 0, sizeof(*system));
+    // RA: the instruction the thread starts at, RB: the RA of the thread, RC: its stack size in bytes or 0
+    // returns the thread in RA
+    case VSYS_NEW_THREAD:
+        return _new_vthread(threads, vpu);
+    // RA: the thread, returns the RA of the thread when it ended in RA and its status (see HALT) in RB
+    case VSYS_WAIT_THREAD:
+        return _wait_vthread(threads, vpu, 0);
+    case VSYS_DETACH_THREAD:
+        return _detach_vthread(threads, vpu);
+    // RA: the thread, it is stopped before its next backward jump and waited for like VSYS_WAIT_THREAD
+    case VSYS_KILL_THREAD:
+        return _wait_vthread(threads, vpu, 1);
 
-        system->display = virtual_alloc(GET_REG(registers, RA)->as_uint32 * GET_REG(registers, RA4)->as_uint32);
-        if(!system->display){
-            virtual_free(system);
-            return 1;
+    // returns the mutex in RA or 0 if it could not be created
+    case VSYS_CREATE_MUTEX:{
+        pthread_mutex_t* const mutex = (pthread_mutex_t*) virtual_alloc(sizeof(pthread_mutex_t));
+        if(mutex && pthread_mutex_init(mutex, NULL)){
+            virtual_free(mutex);
+            GET_REG(registers, RA)->as_ptr = NULL;
+            return 0;
         }
-        system->thread_cap = GET_REG(registers, RB)->as_uint32;
-        vpu->system = (void*) system;
+        GET_REG(registers, RA)->as_ptr = (uint8_t*) mutex;
     }
         return 0;
-    case SYS_CLOSE:
-        virtual_free(vpu->system);
-        vpu->system = NULL;
-        return 0;
-    
-    // heap
-    case SYS_MEMALLOC:
-        GET_REG(registers, RA)->as_ptr = virtual_alloc((size_t) GET_REG(registers, RA)->as_uint64);
-        return 0;
-    case SYS_MEMFREE:
-        virtual_free(GET_REG(registers, RA)->as_ptr);
-        return 0;
-    
-    // file operations
-    case SYS_FOPEN:
-        GET_REG(registers, RA)->as_ptr = (uint8_t*) fopen(
-            (const char*) GET_REG(registers, RA)->as_ptr,
-            (const char*) GET_REG(registers, RB)->as_ptr
-        );
-        return 0;
-    case SYS_FCLOSE:
-        GET_REG(registers, RA)->as_int32 = fclose((FILE*) GET_REG(registers, RA)->as_ptr);
-        return 0;
-    case SYS_FSEEK:
-        GET_REG(registers, RA)->as_int32 = fseek(
-            (FILE*) GET_REG(registers, RA)->as_ptr,
-            (long)  GET_REG(registers, RB)->as_int64,
-            (int)   GET_REG(registers, RC)->as_int32
-        );
-        return 0;
-    case SYS_FTELL:
-        GET_REG(registers, RA)->as_int64 = ftell((FILE*) GET_REG(registers, RA)->as_ptr);
-        return 0;
-    case SYS_FWRITE:
-        GET_REG(registers, RA)->as_uint64 = (uint64_t) fwrite(
-            (void*)  GET_REG(registers, RA)->as_ptr,
-            (size_t) GET_REG(registers, RB)->as_uint64,
-            (size_t) GET_REG(registers, RC)->as_uint64,
-            (FILE*)  GET_REG(registers, RD)->as_ptr
-        );
-        return 0;
-    case SYS_FREAD:
-        GET_REG(registers, RA)->as_uint64 = (uint64_t) fread(
-            (void*)  GET_REG(registers, RA)->as_ptr,
-            (size_t) GET_REG(registers, RB)->as_uint64,
-            (size_t) GET_REG(registers, RC)->as_uint64,
-            (FILE*)  GET_REG(registers, RD)->as_ptr
-        );
-        return 0;
-    case SYS_FPUTC:
-        GET_REG(registers, RA)->as_int64 = fputc(GET_REG(registers, RA)->as_int8, (FILE*) GET_REG(registers, RB)->as_ptr);
+    case VSYS_DESTROY_MUTEX:
+        if(GET_REG(registers, RA)->as_ptr){
+            pthread_mutex_destroy((pthread_mutex_t*) GET_REG(registers, RA)->as_ptr);
+            virtual_free(GET_REG(registers, RA)->as_ptr);
+        }
         return 0;
-    case SYS_FGETC:
-        GET_REG(registers, RA)->as_int64 = fgetc((FILE*) GET_REG(registers, RA)->as_ptr);
+    // RA: the mutex, RB.as_uint8: 0 waits for it and anything else only tries to lock it
+    // returns 0 in RA if it was locked, 1 if it was not because it is busy or an error code
+    case VSYS_LOCK_MUTEX:{
+        pthread_mutex_t* const mutex = (pthread_mutex_t*) GET_REG(registers, RA)->as_ptr;
+        const int r = GET_REG(registers, RB)->as_uint8? pthread_mutex_trylock(mutex) : _lock_vmutex(mutex);
+        GET_REG(registers, RA)->as_int64 = (r == EBUSY)? 1 : r;
+    }
         return 0;
-    case SYS_IOE:
-        GET_REG(registers, RA)->as_ptr = stdin;
-        GET_REG(registers, RB)->as_ptr = stdout;
-        GET_REG(registers, RC)->as_ptr = stderr;
+    case VSYS_UNLOCK_MUTEX:
+        GET_REG(registers, RA)->as_int64 = pthread_mutex_unlock((pthread_mutex_t*) GET_REG(registers, RA)->as_ptr);
         return 0;
-    
-    case SYS_NEW_THREAD:{
-        VSystem* const system = (VSystem*) vpu->system;
-        if(system->thread_count + 1 >= system->thread_cap){
-            GET_REG(registers, RA)->as_ptr = NULL;
-            return 0;
-        }
-        _VThread** const old = system->threads;
-        system->threads = (_VThread**) malloc((system->thread_count + 1) * sizeof(_VThread*));
-        memcpy(system->threads, old, system->thread_count * sizeof(_VThread*));
-        free(old);
-        _VThread* thread = system->threads[system->thread_count++];
-        memset(thread, 0, sizeof(*thread));
-        thread->vpu.system = vpu->system;
-        thread->vpu.stack = thread->stack;
-        thread->vpu.register_space = (uint8_t*) &thread->registers[0];
-        thread->registers[RIP >> 3].as_uint64 = GET_REG(registers, RA)->as_uint64;
-        thread->registers[RA  >> 3] = *GET_REG(registers, RB);
-        GET_REG(registers, RA)->as_ptr = thread;
-        if(pthread_mutex_init(&thread->mutex, NULL)){
-            GET_REG(registers, RA)->as_ptr = NULL;
-            system->thread_count -= 1;
-            return 0;
-        }
-        if(pthread_create(&thread->handle, NULL, _vthread, (void*) thread)){
-            pthread_mutex_destroy(&thread->mutex);
+
+    // returns the condition variable in RA or 0 if it could not be created
+    case VSYS_CREATE_COND:{
+        pthread_cond_t* const cond = (pthread_cond_t*) virtual_alloc(sizeof(pthread_cond_t));
+        if(cond && pthread_cond_init(cond, NULL)){
+            virtual_free(cond);
             GET_REG(registers, RA)->as_ptr = NULL;
-            system->thread_count -= 1;
             return 0;
         }
+        GET_REG(registers, RA)->as_ptr = (uint8_t*) cond;
     }
         return 0;
-    case SYS_WAIT_THREAD:{
-        VSystem* const system = (VSystem*) vpu->system;
-        _VThread* const thread = (_VThread*) GET_REG(vpu->register_space, RA)->as_ptr;
-        int r = 0;
-        int thread_found = 0;
-        for(int i = 0; i < system->thread_count; i+=1){
-            if(thread == system->threads[i]){
-                thread_found = 1;
-                r = pthread_join(thread->handle, &GET_REG(vpu->register_space, RA)->as_ptr);
-                virtual_free(thread);
-                system->threads[i] = system->threads[system->thread_count - 1];
-                system->thread_count -= 1;
-                break;
-            }
-        }
-        return thread_found? r : 1;
-    }
-    case SYS_DETACH_THREAD:{
-        VSystem* const system = (VSystem*) vpu->system;
-        _VThread* const thread = (_VThread*) GET_REG(vpu->register_space, RA)->as_ptr;
-        int thread_found = 0;
-        for(int i = 0; i < system->thread_count; i+=1){
-            if(thread == system->threads[i]){
-                thread_found = 1;
-                break;
-            }
+    case VSYS_DESTROY_COND:
+        if(GET_REG(registers, RA)->as_ptr){
+            pthread_cond_destroy((pthread_cond_t*) GET_REG(registers, RA)->as_ptr);
+            virtual_free(GET_REG(registers, RA)->as_ptr);
         }
-        if(!thread_found){
-            return 1;
-        }
-        return pthread_detach(thread->handle);
+        return 0;
+    case VSYS_SIGNAL_COND:
+        GET_REG(registers, RA)->as_int64 = pthread_cond_signal((pthread_cond_t*) GET_REG(registers, RA)->as_ptr);
+        return 0;
+    case VSYS_BROADCAST_COND:
+        GET_REG(registers, RA)->as_int64 = pthread_cond_broadcast((pthread_cond_t*) GET_REG(registers, RA)->as_ptr);
+        return 0;
+    // RA: the condition variable, RB: the mutex (locked), RC.as_int64: the most milliseconds to wait, < 0 for no limit
+    // returns 0 in RA if it was signaled, 1 if it timed out or an error code
+    case VSYS_WAIT_COND:{
+        pthread_cond_t*  const cond  = (pthread_cond_t* ) GET_REG(registers, RA)->as_ptr;
+        pthread_mutex_t* const mutex = (pthread_mutex_t*) GET_REG(registers, RB)->as_ptr;
+        const int r = _wait_vcond(cond, mutex, GET_REG(registers, RC)->as_int64);
+        GET_REG(registers, RA)->as_int64 = (r == ETIMEDOUT)? 1 : r;
     }
-    case SYS_SLEEP:
         return 0;
 
-    case SYS_GET_DISPLAY_FRAMEBUFFER:{
-        const VSystem* const system = (const VSystem*) vpu->system;
-        GET_REG(registers, RA)->as_ptr = (uint8_t*) system->display;
-        *(uint32_t*) (vpu->register_space + RB ) = system->display_width;
-        *(uint32_t*) (vpu->register_space + RB4) = system->display_height;
-    }
+    // RA.as_uint32: milliseconds
+    case VSYS_SLEEP:
+        _vthread_sleep(GET_REG(registers, RA)->as_uint32);
         return 0;
-    case SYS_DISPLAY_UPDATE:{
-        VSystem* const system = vpu->system;
-        printf("\x1B[2J\x1B[H\n");
-        for(uint32_t i = 0; i < system->display_height; i+=1){
-            for(uint32_t j = 0; j < system->display_width; j+=1){
-                putchar(get_ascii_color(system->display[i * system->display_width + j]));
-            }
-            putchar('\n');
-        }
+    // returns the milliseconds since some point in the past (that does not change while the program runs) in RA
+    case VSYS_GET_TIME:{
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        GET_REG(registers, RA)->as_uint64 = (uint64_t) now.tv_sec * 1000 + (uint64_t) now.tv_nsec / 1000000;
     }
         return 0;
-    
+
     default:
         return 1;
-    } 
+    }
 }
 
-#endif // =====================  END OF FILE VLINUX_SYSTEM_C ===========================
\ No newline at end of file
+#undef VTHREAD_END
+
+#endif // =====================  END OF FILE VLINUX_SYSTEM_C ===========================
@@ -0,0 +1,175 @@
+#ifndef VIRTUAL_LZ_H
+#define VIRTUAL_LZ_H
+
+/*
+ * a small LZ77 codec for virtual file fields
+ *
+ * the compressed data is a sequence of
+ *     [token][literal length extension][literals][offset (2 bytes, little endian)][match length extension]
+ * the high nibble of the token is the literal count and the low nibble the match length minus LZ_MIN_MATCH,
+ * a nibble of 15 is followed by extension bytes that are added to it until one is not 255.
+ * the last sequence has no match, the data simply ends after its literals.
+ *
+ * the decoder is streaming, it takes the compressed data in chunks of any size so fields can be
+ * decompressed while they are read, straight into their final place.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LZ_MIN_MATCH    4
+#define LZ_MAX_OFFSET   0xFFFF
+#define LZ_HASH_BITS    14
+
+// the most lz_compress can write for size bytes of input
+static inline uint64_t lz_compress_bound(uint64_t size){
+    return size + size / 255 + 16;
+}
+
+static inline uint64_t _lz_put_length(uint8_t* dst, uint64_t out, uint64_t length){
+    for(; length >= 255; length -= 255) dst[out++] = 255;
+    dst[out++] = (uint8_t) length;
+    return out;
+}
+
+static inline uint64_t _lz_put_sequence(uint8_t* dst, uint64_t out, const uint8_t* literals, uint64_t literal_count, uint64_t offset, uint64_t match){
+    const uint64_t match_nibble = match? match - LZ_MIN_MATCH : 0;
+    dst[out++] = (uint8_t) (((literal_count < 15)? literal_count : 15) << 4 | ((match_nibble < 15)? match_nibble : 15));
+    if(literal_count >= 15) out = _lz_put_length(dst, out, literal_count - 15);
+    memcpy(dst + out, literals, (size_t) literal_count);
+    out += literal_count;
+    if(match == 0) return out;
+    dst[out++] = (uint8_t) (offset & 0xFF);
+    dst[out++] = (uint8_t) (offset >> 8);
+    if(match_nibble >= 15) out = _lz_put_length(dst, out, match_nibble - 15);
+    return out;
+}
+
+// compresses size bytes from src to dst, which must have room for lz_compress_bound(size) bytes
+// \returns the compressed size or 0 if it could not allocate its match table
+static inline uint64_t lz_compress(const uint8_t* src, uint64_t size, uint8_t* dst){
+    // positions + 1 of the last occurrence of each hashed 4 bytes, 0 for none
+    uint64_t* const table = (uint64_t*) calloc((size_t) 1 << LZ_HASH_BITS, sizeof(uint64_t));
+    if(!table) return 0;
+
+    uint64_t out = 0;
+    uint64_t anchor = 0;
+    uint64_t i = 0;
+
+    while(i + LZ_MIN_MATCH <= size){
+        uint32_t word;
+        memcpy(&word, src + i, sizeof(word));
+        const uint32_t hash = (word * 2654435761u) >> (32 - LZ_HASH_BITS);
+        const uint64_t candidate = table[hash];
+        table[hash] = i + 1;
+        if(candidate == 0 || i - (candidate - 1) > LZ_MAX_OFFSET || memcmp(src + candidate - 1, src + i, LZ_MIN_MATCH)){
+            i += 1;
+            continue;
+        }
+        const uint64_t match_start = candidate - 1;
+        uint64_t match = LZ_MIN_MATCH;
+        while(i + match < size && src[match_start + match] == src[i + match]) match += 1;
+        out = _lz_put_sequence(dst, out, src + anchor, i - anchor, i - match_start, match);
+        i += match;
+        anchor = i;
+    }
+
+    out = _lz_put_sequence(dst, out, src + anchor, size - anchor, 0, 0);
+
+    free(table);
+    return out;
+}
+
+typedef enum LzDecoderState{
+    LZ_STATE_TOKEN = 0,
+    LZ_STATE_LITERAL_LENGTH,
+    LZ_STATE_LITERALS,
+    LZ_STATE_OFFSET_LOW,
+    LZ_STATE_OFFSET_HIGH,
+    LZ_STATE_MATCH_LENGTH
+} LzDecoderState;
+
+typedef struct LzDecoder{
+    uint8_t*        dst;
+    uint64_t        dst_size;
+    uint64_t        written;
+    LzDecoderState  state;
+    uint64_t        literals;
+    uint64_t        match;
+    uint64_t        offset;
+} LzDecoder;
+
+// dst must have room for the whole decompressed data, dst_size bytes
+static inline LzDecoder lz_create_decoder(void* dst, uint64_t dst_size){
+    return (LzDecoder){.dst = (uint8_t*) dst, .dst_size = dst_size, .state = LZ_STATE_TOKEN};
+}
+
+static inline int _lz_copy_match(LzDecoder* decoder){
+    if(decoder->offset == 0 || decoder->offset > decoder->written || decoder->match > decoder->dst_size - decoder->written) return 1;
+    uint8_t* const dst = decoder->dst + decoder->written;
+    const uint8_t* const from = dst - decoder->offset;
+    // matches may overlap the bytes they produce, so they are copied in chunks no longer than the offset
+    for(uint64_t i = 0; i < decoder->match;){
+        const uint64_t chunk = (decoder->offset < decoder->match - i)? decoder->offset : decoder->match - i;
+        memcpy(dst + i, from + i, (size_t) chunk);
+        i += chunk;
+    }
+    decoder->written += decoder->match;
+    decoder->state = LZ_STATE_TOKEN;
+    return 0;
+}
+
+// decompresses the next size bytes of compressed data
+// \returns 0 on success or 1 if the data is corrupted
+static inline int lz_decode(LzDecoder* decoder, const void* _src, size_t size){
+    const uint8_t* const src = (const uint8_t*) _src;
+    for(size_t i = 0; i < size;){
+        switch (decoder->state)
+        {
+        case LZ_STATE_TOKEN:
+            decoder->literals = src[i] >> 4;
+            decoder->match = (src[i] & 15) + LZ_MIN_MATCH;
+            i += 1;
+            decoder->state = (decoder->literals == 15)? LZ_STATE_LITERAL_LENGTH : (decoder->literals? LZ_STATE_LITERALS : LZ_STATE_OFFSET_LOW);
+            break;
+        case LZ_STATE_LITERAL_LENGTH:
+            decoder->literals += src[i];
+            if(src[i++] != 255) decoder->state = LZ_STATE_LITERALS;
+            break;
+        case LZ_STATE_LITERALS:{
+            const uint64_t count = (decoder->literals < size - i)? decoder->literals : size - i;
+            if(count > decoder->dst_size - decoder->written) return 1;
+            memcpy(decoder->dst + decoder->written, src + i, (size_t) count);
+            decoder->written += count;
+            decoder->literals -= count;
+            i += (size_t) count;
+            if(decoder->literals == 0) decoder->state = LZ_STATE_OFFSET_LOW;
+            break;
+        }
+        case LZ_STATE_OFFSET_LOW:
+            decoder->offset = src[i++];
+            decoder->state = LZ_STATE_OFFSET_HIGH;
+            break;
+        case LZ_STATE_OFFSET_HIGH:
+            decoder->offset |= (uint64_t) src[i++] << 8;
+            if(decoder->match == 15 + LZ_MIN_MATCH) decoder->state = LZ_STATE_MATCH_LENGTH;
+            else if(_lz_copy_match(decoder)) return 1;
+            break;
+        case LZ_STATE_MATCH_LENGTH:
+            decoder->match += src[i];
+            if(src[i++] != 255 && _lz_copy_match(decoder)) return 1;
+            break;
+        default:
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// \returns 1 if the decoder got all of its data and it ended where a sequence may end
+static inline int lz_decoder_done(const LzDecoder* decoder){
+    return decoder->written == decoder->dst_size && (decoder->state == LZ_STATE_TOKEN || decoder->state == LZ_STATE_OFFSET_LOW);
+}
+
+#endif // =====================  END OF FILE VIRTUAL_LZ_H ===========================
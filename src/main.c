@@ -3,6 +3,8 @@
 #include "core.c"
 #include "disassembler.c"
 #include "debugger.c"
+#include "aot.c"
+#include "linker.c"
 
 
 int is_file_executable(FILE* file){
@@ -23,7 +25,7 @@ int is_file_executable(FILE* file){
 
 static inline void help(const char* main_executable){
     printf(
-        "Usage: %s [options] <input>\n"
+        "Usage: %s [options] <input>...\n"
         "Functionality: either assembles assembly program in <input> to byte code, disassembles byte code in <input> or executes byte code in <input>.\n"
         "Options:\n"
         "   --help:         displays this help message\n"
@@ -33,11 +35,24 @@ static inline void help(const char* main_executable){
         "   -disassemble:   disassemble mode\n"
         "   -execute:       execute mode\n"
         "   -debug:         debug mode\n"
+        "   -compile-c:     translates the executable in <input> to a standalone C file (stdout by default)\n"
+        "   -cfg:           dumps the basic blocks of the executable in <input> and how long it took to find them\n"
+        "   -engine <name>: execute with engine <name>, 'switch' (the reference), 'threaded' or 'jit'\n"
+        "   -jit:           same as -engine jit\n"
+        "   -stats:         prints execution statistics (superinstructions, dispatches saved) to stderr after executing\n"
+        "   -profile:       executes on the profiler and prints the hottest labels, opcodes and instructions to stderr\n"
+        "   -profile-stacks <output>: same as -profile, also writes the call stacks to <output> for flamegraph tools\n"
+        "   -stack-size <size>: size of the VPU stack in bytes, K, M or G can follow the number (1M by default, 64G at most)\n"
         "   -o <output>:    choose <output> as output file\n"
         "   -i <input>:     choose <input> as input file\n"
         "   -args:          marks the beggining of the arguments to pass to the virtual machine executable\n"
         "   -0:             pass no argument to the virtual machine executable\n"
-        "   -no_export_labels: assembled executable/library will not include labels still defined by the end of the code\n",
+        "   -no_export_labels: assembled executable/library will not include labels still defined by the end of the code\n"
+        "   -compress:      compresses the static memory and program of the assembled executable, they are decompressed when loaded\n"
+        "   -include-cache <directory>: caches what every include assembles to in <directory> and reuses it while the include and the labels it uses do not change\n"
+        "   -object:        assembles <input> to a relocatable object, labels it does not define are left to the linker\n"
+        "   -link <objects>: links the objects (assembled with -object) into one executable\n"
+        "   -j <jobs>:      when assembling several inputs, assembles up to <jobs> of them at the same time (1 by default)\n",
         main_executable
     );
 }
@@ -55,13 +70,21 @@ int main(int argc, char** argv){
         MODE_ASSEMBLE    = 1 << 0,
         MODE_DISASSEMBLE = 1 << 1,
         MODE_EXECUTE     = 1 << 2,
-        MODE_DEBUG       = 1 << 3
+        MODE_DEBUG       = 1 << 3,
+        MODE_COMPILE_C   = 1 << 4,
+        MODE_CFG         = 1 << 5,
+        MODE_LINK        = 1 << 6
     } mode = MODE_NONE;
 
     int vpu_argv_begin  = argc - 1;
     int input_file_arg  = -1;
     int output_file_arg = -1;
-    int export_labels   = 1;
+    int link_inputs_arg = -1;
+    int link_input_count = 0;
+    int input_count     = 0;
+    int jobs            = 1;
+    AssembleOptions assemble_options = {.export_labels = 1, .compress = 0, .include_cache = NULL, .object = 0};
+    ExecuteOptions execute_options = {.engine = VPU_DEFAULT_ENGINE, .stats = 0, .profile = 0, .profile_stacks = NULL, .stack_size = 0};
 
     VIRTUAL_DEBUG_LOG("parsing cmd arguments\n");
     
@@ -107,10 +130,84 @@ int main(int argc, char** argv){
             mode |= MODE_EXECUTE;
             continue;
         }
+        if(mc_compare_str(argv[i], "-compile-c", 0)){
+            mode |= MODE_COMPILE_C;
+            continue;
+        }
+        if(mc_compare_str(argv[i], "-cfg", 0)){
+            mode |= MODE_CFG;
+            continue;
+        }
         if(mc_compare_str(argv[i], "-debug", 0)){
             mode |= MODE_DEBUG;
             continue;
         }
+        if(mc_compare_str(argv[i], "-engine", 0)){
+            if(i + 1 >= argc){
+                fprintf(stderr, "[ERROR] Missing Engine Name After '-engine'\n");
+                return 1;
+            }
+            i += 1;
+            if(mc_compare_str(argv[i], "switch", 0)){
+                execute_options.engine = VPU_ENGINE_SWITCH;
+            }
+            else if(mc_compare_str(argv[i], "threaded", 0)){
+                execute_options.engine = VPU_ENGINE_THREADED;
+            }
+            else if(mc_compare_str(argv[i], "jit", 0)){
+                execute_options.engine = VPU_ENGINE_JIT;
+            }
+            else{
+                fprintf(stderr, "[ERROR] Unknown Engine '%s', Expected 'switch', 'threaded' Or 'jit'\n", argv[i]);
+                return 1;
+            }
+            continue;
+        }
+        if(mc_compare_str(argv[i], "-jit", 0)){
+            execute_options.engine = VPU_ENGINE_JIT;
+            continue;
+        }
+        if(mc_compare_str(argv[i], "-stats", 0)){
+            execute_options.stats = 1;
+            continue;
+        }
+        if(mc_compare_str(argv[i], "-profile", 0)){
+            execute_options.profile = 1;
+            continue;
+        }
+        if(mc_compare_str(argv[i], "-profile-stacks", 0)){
+            if(i + 1 >= argc){
+                fprintf(stderr, "[ERROR] Missing Filename After '-profile-stacks'\n");
+                return 1;
+            }
+            execute_options.profile = 1;
+            execute_options.profile_stacks = argv[++i];
+            continue;
+        }
+        if(mc_compare_str(argv[i], "-stack-size", 0)){
+            if(i + 1 >= argc){
+                fprintf(stderr, "[ERROR] Missing Size After '-stack-size'\n");
+                return 1;
+            }
+            i += 1;
+            // strtoull takes a sign and wraps negative numbers around, so the size has to start with a digit
+            char* end = NULL;
+            uint64_t size = (argv[i][0] >= '0' && argv[i][0] <= '9')? (uint64_t) strtoull(argv[i], &end, 10) : 0;
+            uint64_t multiplier = 1;
+            if(end && (*end == 'k' || *end == 'K'))      { multiplier = 1024; end += 1; }
+            else if(end && (*end == 'm' || *end == 'M')) { multiplier = 1024 * 1024; end += 1; }
+            else if(end && (*end == 'g' || *end == 'G')) { multiplier = 1024 * 1024 * 1024; end += 1; }
+            if(!end || *end != '\0' || size == 0 || size > VPU_MAX_STACK_SIZE / multiplier){
+                fprintf(stderr,
+                    "[ERROR] Invalid Stack Size '%s', Expected A Number Of Bytes Optionally Followed By K, M Or G, Up To %"PRIu64" Bytes\n",
+                    argv[i], (uint64_t) VPU_MAX_STACK_SIZE
+                );
+                return 1;
+            }
+            size *= multiplier;
+            execute_options.stack_size = size;
+            continue;
+        }
         if(mc_compare_str(argv[i], "-o", 0)){
             if(i + 1 >= argc){
                 fprintf(stderr, "[ERROR] Missing Filename After '-o'\n");
@@ -123,6 +220,21 @@ int main(int argc, char** argv){
             output_file_arg = ++i;
             continue;
         }
+        if(mc_compare_str(argv[i], "-j", 0)){
+            if(i + 1 >= argc){
+                fprintf(stderr, "[ERROR] Missing Job Count After '-j'\n");
+                return 1;
+            }
+            i += 1;
+            char* end = NULL;
+            const long count = strtol(argv[i], &end, 10);
+            if(end == argv[i] || *end != '\0' || count < 1 || count > 1024){
+                fprintf(stderr, "[ERROR] Invalid Job Count '%s', Expected A Number From 1 To 1024\n", argv[i]);
+                return 1;
+            }
+            jobs = (int) count;
+            continue;
+        }
         if(mc_compare_str(argv[i], "-i", 0)){
             if(i + 1 >= argc){
                 fprintf(stderr, "[ERROR] Missing Filename After '-i'\n");
@@ -133,10 +245,42 @@ int main(int argc, char** argv){
                 return 1;
             }
             input_file_arg = ++i;
+            input_count = 1;
             continue;
         }
         if(mc_compare_str(argv[i], "-no_export_labels", 0)){
-            export_labels = 0;
+            assemble_options.export_labels = 0;
+            continue;
+        }
+        if(mc_compare_str(argv[i], "-compress", 0)){
+            assemble_options.compress = 1;
+            continue;
+        }
+        if(mc_compare_str(argv[i], "-include-cache", 0)){
+            if(i + 1 >= argc){
+                fprintf(stderr, "[ERROR] Missing Directory After '-include-cache'\n");
+                return 1;
+            }
+            assemble_options.include_cache = argv[++i];
+            continue;
+        }
+        if(mc_compare_str(argv[i], "-object", 0)){
+            assemble_options.object = 1;
+            continue;
+        }
+        if(mc_compare_str(argv[i], "-link", 0)){
+            if(link_inputs_arg > 0){
+                fprintf(stderr, "[ERROR] Multiple '-link' Flags\n");
+                return 1;
+            }
+            mode |= MODE_LINK;
+            link_inputs_arg = i + 1;
+            // the objects are every argument up to the next option
+            for( ; i + 1 < argc && argv[i + 1][0] != '-'; i+=1) link_input_count += 1;
+            if(link_input_count == 0){
+                fprintf(stderr, "[ERROR] Missing Objects After '-link'\n");
+                return 1;
+            }
             continue;
         }
         if(mc_compare_str(argv[i], "-args", 0)){
@@ -157,9 +301,28 @@ int main(int argc, char** argv){
         }
     
         input_file_arg = i;
+        input_count = 1;
+        // several inputs are assembled as one program each and linked together, see assemble_files
+        for( ; i + 1 < argc && argv[i + 1][0] != '-'; i+=1) input_count += 1;
     
     }
 
+    if((mode & MODE_LINK) && (mode != MODE_LINK || input_file_arg > 0)){
+        fprintf(stderr, "[ERROR] Can't Link Together With Any Other Mode Or Input\n");
+        return 1;
+    }
+
+    if(mode & MODE_LINK){
+        VIRTUAL_DEBUG_LOG("linking %i objects to %s\n", link_input_count, (output_file_arg > 0)? argv[output_file_arg] : "output.out");
+        const int status = link_objects(
+            (const char* const*) (argv + link_inputs_arg), link_input_count, (output_file_arg > 0)? argv[output_file_arg] : NULL, &assemble_options
+        );
+        if(status){
+            fprintf(stderr, "[ERROR] Linker Failed ^^^\n");
+        }
+        return status;
+    }
+
     if(input_file_arg < 0){
         fprintf(stderr, "[ERROR] Missing Input File\n");
         return 1;
@@ -176,6 +339,18 @@ int main(int argc, char** argv){
         fprintf(stderr, "[ERROR] Can't Both Assemble And Disassemble A File\n");
         return 1;
     }
+    if(input_count > 1 && (mode & ~MODE_ASSEMBLE)){
+        fprintf(stderr, "[ERROR] Only Assembling Takes More Than One Input\n");
+        return 1;
+    }
+    if(input_count > 1 && assemble_options.object){
+        fprintf(stderr, "[ERROR] Can't Assemble More Than One Input To An Object, Assemble Them One At A Time\n");
+        return 1;
+    }
+    if((mode & MODE_COMPILE_C) && (mode != MODE_COMPILE_C)){
+        fprintf(stderr, "[ERROR] Can't Compile To C Together With Any Other Mode\n");
+        return 1;
+    }
 
     if(mode == MODE_NONE){
         VIRTUAL_DEBUG_LOG("no mode provided, deducing best mode\n");
@@ -189,9 +364,47 @@ int main(int argc, char** argv){
         fclose(input);
     }
 
+    if(assemble_options.object && mode != MODE_ASSEMBLE){
+        fprintf(stderr, "[ERROR] '-object' Only Applies When Assembling\n");
+        return 1;
+    }
+
+    if((mode & MODE_CFG) && (mode != MODE_CFG)){
+        fprintf(stderr, "[ERROR] Can't Dump The Control Flow Graph Together With Any Other Mode\n");
+        return 1;
+    }
+
+    if(mode & MODE_CFG){
+        const int status = dump_cfg_file(argv[input_file_arg], (output_file_arg > 0)? argv[output_file_arg] : NULL);
+        if(status){
+            fprintf(stderr, "[ERROR] Could Not Build The Control Flow Graph ^^^\n");
+        }
+        return status;
+    }
+
+    if(mode & MODE_COMPILE_C){
+        VIRTUAL_DEBUG_LOG("compiling %s to C in %s\n", argv[input_file_arg], (output_file_arg > 0)? argv[output_file_arg] : "stdout");
+        const int status = compile_file_to_c(argv[input_file_arg], (output_file_arg > 0)? argv[output_file_arg] : NULL);
+        if(status){
+            fprintf(stderr, "[ERROR] Compilation To C Failed ^^^\n");
+        }
+        return status;
+    }
+
+    if((mode & MODE_ASSEMBLE) && input_count > 1){
+        VIRTUAL_DEBUG_LOG("assembling %i inputs with %i jobs to %s\n", input_count, jobs, (output_file_arg > 0)? argv[output_file_arg] : "output.out");
+        const int status = assemble_files(
+            argv + input_file_arg, input_count, (output_file_arg > 0)? argv[output_file_arg] : NULL, &assemble_options, jobs
+        );
+        if(status){
+            fprintf(stderr, "[ERROR] Assembler Failed ^^^\n");
+        }
+        return status;
+    }
+
     if(mode & MODE_ASSEMBLE){
         VIRTUAL_DEBUG_LOG("assembling %s to %s\n", argv[input_file_arg], (output_file_arg > 0)? argv[output_file_arg] : "output.out");
-        const int status = assemble(argv[input_file_arg], (output_file_arg > 0)? argv[output_file_arg] : NULL, export_labels);
+        const int status = assemble(argv[input_file_arg], (output_file_arg > 0)? argv[output_file_arg] : NULL, &assemble_options);
         if(status){
             fprintf(stderr, "[ERROR] Assembler Failed ^^^\n");
             return status;
@@ -221,7 +434,7 @@ int main(int argc, char** argv){
             argv[vpu_argv_begin] = argv[input_file_arg];
         }
         if(mode & MODE_EXECUTE){
-            const int status = execute(input_file_path, program_argc, program_argv);
+            const int status = execute(input_file_path, program_argc, program_argv, &execute_options);
             if(status){
                 fprintf(stderr, "[ERROR] Execution Failed ^^^\n");
                 return status;
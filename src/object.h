@@ -0,0 +1,74 @@
+#ifndef VIRTUAL_OBJECT_H
+#define VIRTUAL_OBJECT_H
+
+/*
+ * relocatable objects
+ *
+ * assembling with -object produces a VIRTUAL_FILE_TYPE_OBJECT virtual file instead of an executable, -link
+ * merges objects into one executable (see linker.c). an object has the fields:
+ *     code:   its instructions, instruction positions are relative to its first instruction
+ *     static: its static memory, static offsets are relative to its beginning
+ *     labels: the symbol table, the label stream at the end of the object as it would be exported by an
+ *             executable. labels defined with a string (static offsets) have LABELFLAG_STATIC set
+ *     relocs: the relocations, see ObjectRelocationKind, each is
+ *             [u64 instruction][u8 ObjectRelocationKind][u8 byte of the 16 bit literal in the instruction]
+ *             [u32 symbol size][symbol]
+ *     start:  the entry point (u64), only if the object has %start
+ * labels an object uses but does not define are only allowed as instruction literals ($name or @name), they are
+ * assembled as 0 with a relocation to the symbol and resolved by the linker.
+ */
+
+#include "virtual.h"
+#include "virtual_files.h"
+#include "labels.h"
+
+#define OBJECT_CODE_FIELD_NAME          "code"
+#define OBJECT_RELOCATIONS_FIELD_NAME   "relocs"
+#define OBJECT_START_FIELD_NAME         "start"
+
+typedef enum ObjectRelocationKind{
+    OBJECT_RELOCATION_NONE = 0,
+    // the value of a symbol defined by another object ($name)
+    OBJECT_RELOCATION_SYMBOL,
+    // the distance in instructions from the instruction to a symbol defined by another object (@name)
+    OBJECT_RELOCATION_RELATIVE_SYMBOL,
+    // an instruction position of the object ($name of one of its labels), moved with its code
+    OBJECT_RELOCATION_POSITION,
+    // a static offset of the object (a string literal or $name of a string label), moved with its static memory
+    OBJECT_RELOCATION_STATIC
+} ObjectRelocationKind;
+
+typedef struct ObjectRelocation{
+    uint64_t    inst;
+    uint8_t     kind;
+    uint8_t     byte;
+    uint32_t    symbol_size;
+    const char* symbol;
+} ObjectRelocation;
+
+#define SIZEOF_OBJECT_RELOCATION (sizeof(uint64_t) + 2 * sizeof(uint8_t) + sizeof(uint32_t))
+
+static inline void push_object_relocation(Mc_stream_t* relocations, const ObjectRelocation relocation){
+    mc_stream(relocations, &relocation.inst, sizeof(relocation.inst));
+    mc_stream(relocations, &relocation.kind, sizeof(relocation.kind));
+    mc_stream(relocations, &relocation.byte, sizeof(relocation.byte));
+    mc_stream(relocations, &relocation.symbol_size, sizeof(relocation.symbol_size));
+    mc_stream(relocations, relocation.symbol, relocation.symbol_size);
+}
+
+// reads the relocation at position of the relocs field data
+// \returns the position of the next relocation or 0 if the one at position is truncated
+static inline uint64_t get_object_relocation(const uint8_t* relocations, uint64_t size, uint64_t position, ObjectRelocation* relocation){
+    if(size - position < SIZEOF_OBJECT_RELOCATION) return 0;
+    const uint8_t* const data = relocations + position;
+    memcpy(&relocation->inst, data, sizeof(relocation->inst));
+    relocation->kind = data[sizeof(uint64_t)];
+    relocation->byte = data[sizeof(uint64_t) + 1];
+    memcpy(&relocation->symbol_size, data + sizeof(uint64_t) + 2, sizeof(relocation->symbol_size));
+    position += SIZEOF_OBJECT_RELOCATION;
+    if(size - position < relocation->symbol_size) return 0;
+    relocation->symbol = (const char*) (relocations + position);
+    return position + relocation->symbol_size;
+}
+
+#endif // =====================  END OF FILE VIRTUAL_OBJECT_H ===========================
@@ -5,6 +5,10 @@
 #include <stdio.h>
 #include "core.h"
 #include "labels.h"
+#include "include_cache.h"
+#include "object.h"
+#include "relax.h"
+#include "keywords.h"
 #include <inttypes.h>
 #include <stdarg.h>
 
@@ -39,14 +43,54 @@ typedef struct Parser
     int file_path_size;
     Mc_stream_t* labels;
     Mc_stream_t* local_labels;
+    // the relative references of the local scope being assembled (see relax.h), NULL to never relax branches
+    LocalScope* local_scope;
     Mc_stream_t* static_memory;
     Mc_stream_t* program;
     Tokenizer* tokenizer;
     uint32_t flags;
     int macro_if_depth;
     uint64_t entry_point;
+    // directory of the include cache (see include_cache.h), NULL to parse every include
+    const char* include_cache;
+    // the include being recorded for the cache, NULL when none is
+    IncludeRecord* include_record;
+    // the relocations of the object being assembled (see object.h), NULL when assembling an executable
+    Mc_stream_t* relocations;
 } Parser;
 
+// the label functions as the parser uses them on parser->labels, they also record what an include being
+// recorded for the include cache looks at and changes
+
+static inline Label* parser_get_label(const Parser* parser, const Token name){
+    if(parser->include_record) include_record_label_read(parser->include_record, parser->labels, name);
+    return get_label(parser->labels, name);
+}
+
+static inline Token parser_resolve_token(const Parser* parser, const Token token){
+    if(parser->include_record && token.type == TKN_LABEL_REF)
+        include_record_label_read(parser->include_record, parser->labels, (Token){.value.as_str = token.value.as_str + 1, .size = token.size - 1});
+    return resolve_token(parser->labels, token);
+}
+
+static inline int parser_add_label_with_flag(Parser* parser, const Token name, const Token definition, uint8_t flags){
+    if(parser->include_record) include_record_label_read(parser->include_record, parser->labels, name);
+    if(add_label_with_flag(parser->labels, name, definition, flags)) return 1;
+    if(parser->include_record) include_record_label_added(parser->include_record, parser->labels, name);
+    return 0;
+}
+
+static inline int parser_add_label(Parser* parser, const Token name, const Token definition){
+    return parser_add_label_with_flag(parser, name, definition, LABELFLAG_NONE);
+}
+
+static inline int parser_remove_label(Parser* parser, const Token name){
+    if(parser->include_record) include_record_label_read(parser->include_record, parser->labels, name);
+    if(remove_label(parser->labels, name)) return 1;
+    if(parser->include_record) include_record_label_removed(parser->include_record, name);
+    return 0;
+}
+
 
 void fprint_token(FILE* file, const Token token){
     switch(token.type){
@@ -114,127 +158,264 @@ const char* get_token_type_str(int type){
 
 }
 
-InstProfile get_inst_profile(const Token inst_token){
-    #define __VIRTUAL_RETURN_INST_PROFILE(INST_NAME, OP_PROFILE, ...)\
-        if(COMP_TKN(inst_token, MKTKN(#INST_NAME))) return (InstProfile){INST_ ## INST_NAME, OP_PROFILE}
-
-    if(inst_token.type != TKN_RAW)            return (InstProfile){INST_ERROR , 0};
-
-    __VIRTUAL_RETURN_INST_PROFILE(NOP,       OP_PROFILE_NONE, INST_NOP  );
-    __VIRTUAL_RETURN_INST_PROFILE(HALT,      OP_PROFILE_E  , INST_HALT  );
-    __VIRTUAL_RETURN_INST_PROFILE(MOV8,      OP_PROFILE_RR , INST_MOV8  );
-    __VIRTUAL_RETURN_INST_PROFILE(MOV16,     OP_PROFILE_RR , INST_MOV16 );
-    __VIRTUAL_RETURN_INST_PROFILE(MOV32,     OP_PROFILE_RR , INST_MOV32 );
-    __VIRTUAL_RETURN_INST_PROFILE(MOV,       OP_PROFILE_RR , INST_MOV   );
-    __VIRTUAL_RETURN_INST_PROFILE(MOVC,      OP_PROFILE_RRR, INST_MOVC  );
-    __VIRTUAL_RETURN_INST_PROFILE(MOVV,      OP_PROFILE_RL , INST_MOVV  );
-    __VIRTUAL_RETURN_INST_PROFILE(MOVN,      OP_PROFILE_RL , INST_MOVN  );
-    __VIRTUAL_RETURN_INST_PROFILE(MOVV16,    OP_PROFILE_RL , INST_MOVV16);
-    __VIRTUAL_RETURN_INST_PROFILE(PUSH,      OP_PROFILE_E  , INST_PUSH  );
-    __VIRTUAL_RETURN_INST_PROFILE(POP,       OP_PROFILE_R  , INST_POP   );
-    __VIRTUAL_RETURN_INST_PROFILE(STACK_GET, OP_PROFILE_RL , INST_STACK_GET);
-    __VIRTUAL_RETURN_INST_PROFILE(STACK_PUT, OP_PROFILE_RL , INST_STACK_PUT);
-    __VIRTUAL_RETURN_INST_PROFILE(GSP,       OP_PROFILE_RRR, INST_GSP   );
-    __VIRTUAL_RETURN_INST_PROFILE(STATIC,    OP_PROFILE_E  , INST_STATIC);
-    __VIRTUAL_RETURN_INST_PROFILE(READ8,     OP_PROFILE_RRR, INST_READ8 );
-    __VIRTUAL_RETURN_INST_PROFILE(READ16,    OP_PROFILE_RRR, INST_READ16);
-    __VIRTUAL_RETURN_INST_PROFILE(READ32,    OP_PROFILE_RRR, INST_READ32);
-    __VIRTUAL_RETURN_INST_PROFILE(READ,      OP_PROFILE_RRR, INST_READ  );
-    __VIRTUAL_RETURN_INST_PROFILE(MREADS,    OP_PROFILE_RRR, INST_MREADS);
-    __VIRTUAL_RETURN_INST_PROFILE(WRITE8,    OP_PROFILE_RRR, INST_WRITE8 );
-    __VIRTUAL_RETURN_INST_PROFILE(WRITE16,   OP_PROFILE_RRR, INST_WRITE16);
-    __VIRTUAL_RETURN_INST_PROFILE(WRITE32,   OP_PROFILE_RRR, INST_WRITE32);
-    __VIRTUAL_RETURN_INST_PROFILE(WRITE,     OP_PROFILE_RRR, INST_WRITE  );
-    __VIRTUAL_RETURN_INST_PROFILE(MWRITES,   OP_PROFILE_RRR, INST_MWRITES);
-    __VIRTUAL_RETURN_INST_PROFILE(MMOVS,     OP_PROFILE_RRR, INST_MMOVS );
-    __VIRTUAL_RETURN_INST_PROFILE(MEMCMP,    OP_PROFILE_RRR, INST_MEMCMP);
-    __VIRTUAL_RETURN_INST_PROFILE(NOT,       OP_PROFILE_RR , INST_NOT   );
-    __VIRTUAL_RETURN_INST_PROFILE(NEG,       OP_PROFILE_RRR, INST_NEG   );
-    __VIRTUAL_RETURN_INST_PROFILE(AND,       OP_PROFILE_RRR, INST_AND   );
-    __VIRTUAL_RETURN_INST_PROFILE(NAND,      OP_PROFILE_RRR, INST_NAND  );
-    __VIRTUAL_RETURN_INST_PROFILE(OR,        OP_PROFILE_RRR, INST_OR    );
-    __VIRTUAL_RETURN_INST_PROFILE(XOR,       OP_PROFILE_RRR, INST_XOR   );
-    __VIRTUAL_RETURN_INST_PROFILE(BSHIFT,    OP_PROFILE_RRR, INST_BSHIFT);
-    __VIRTUAL_RETURN_INST_PROFILE(JMP,       OP_PROFILE_E  , INST_JMP   );
-    __VIRTUAL_RETURN_INST_PROFILE(JMPF,      OP_PROFILE_RL , INST_JMPF  );
-    __VIRTUAL_RETURN_INST_PROFILE(JMPFN,     OP_PROFILE_RL , INST_JMPFN );
-    __VIRTUAL_RETURN_INST_PROFILE(CALL,      OP_PROFILE_E  , INST_CALL  );
-    __VIRTUAL_RETURN_INST_PROFILE(RET,       OP_PROFILE_NONE, INST_RET  );
-    __VIRTUAL_RETURN_INST_PROFILE(ADD8,      OP_PROFILE_RRR, INST_ADD8  );
-    __VIRTUAL_RETURN_INST_PROFILE(SUB8,      OP_PROFILE_RRR, INST_SUB8  );
-    __VIRTUAL_RETURN_INST_PROFILE(MUL8,      OP_PROFILE_RRR, INST_MUL8  );
-    __VIRTUAL_RETURN_INST_PROFILE(ADD16,     OP_PROFILE_RRR, INST_ADD16 );
-    __VIRTUAL_RETURN_INST_PROFILE(SUB16,     OP_PROFILE_RRR, INST_SUB16 );
-    __VIRTUAL_RETURN_INST_PROFILE(MUL16,     OP_PROFILE_RRR, INST_MUL16 );
-    __VIRTUAL_RETURN_INST_PROFILE(ADD32,     OP_PROFILE_RRR, INST_ADD32 );
-    __VIRTUAL_RETURN_INST_PROFILE(SUB32,     OP_PROFILE_RRR, INST_SUB32 );
-    __VIRTUAL_RETURN_INST_PROFILE(MUL32,     OP_PROFILE_RRR, INST_MUL32 );
-    __VIRTUAL_RETURN_INST_PROFILE(ADD,       OP_PROFILE_RRR, INST_ADD   );
-    __VIRTUAL_RETURN_INST_PROFILE(SUB,       OP_PROFILE_RRR, INST_SUB   );
-    __VIRTUAL_RETURN_INST_PROFILE(MUL,       OP_PROFILE_RRR, INST_MUL   );
-    __VIRTUAL_RETURN_INST_PROFILE(DIVI,      OP_PROFILE_RRR, INST_DIVI  );
-    __VIRTUAL_RETURN_INST_PROFILE(DIVU,      OP_PROFILE_RRR, INST_DIVU  );
-    __VIRTUAL_RETURN_INST_PROFILE(ADDF,      OP_PROFILE_RRR, INST_ADDF  );
-    __VIRTUAL_RETURN_INST_PROFILE(SUBF,      OP_PROFILE_RRR, INST_SUBF  );
-    __VIRTUAL_RETURN_INST_PROFILE(MULF,      OP_PROFILE_RRR, INST_MULF  );
-    __VIRTUAL_RETURN_INST_PROFILE(DIVF,      OP_PROFILE_RRR, INST_DIVF  );
-    __VIRTUAL_RETURN_INST_PROFILE(INC,       OP_PROFILE_RL , INST_INC   );
-    __VIRTUAL_RETURN_INST_PROFILE(DEC,       OP_PROFILE_RL , INST_DEC   );
-    __VIRTUAL_RETURN_INST_PROFILE(INCF,      OP_PROFILE_RL , INST_INCF  );
-    __VIRTUAL_RETURN_INST_PROFILE(DECF,      OP_PROFILE_RL , INST_DECF  );
-    __VIRTUAL_RETURN_INST_PROFILE(ABS,       OP_PROFILE_RRR, INST_ABS   );
-    __VIRTUAL_RETURN_INST_PROFILE(ABSF,      OP_PROFILE_RRR, INST_ABSF  );
-    __VIRTUAL_RETURN_INST_PROFILE(NEQ,       OP_PROFILE_RRR, INST_NEQ   );
-    __VIRTUAL_RETURN_INST_PROFILE(EQ,        OP_PROFILE_RRR, INST_EQ    );
-    __VIRTUAL_RETURN_INST_PROFILE(EQF,       OP_PROFILE_RRR, INST_EQF   );
-    __VIRTUAL_RETURN_INST_PROFILE(BIGI,      OP_PROFILE_RRR, INST_BIGI  );
-    __VIRTUAL_RETURN_INST_PROFILE(BIGU,      OP_PROFILE_RRR, INST_BIGU  );
-    __VIRTUAL_RETURN_INST_PROFILE(BIGF,      OP_PROFILE_RRR, INST_BIGF  );
-    __VIRTUAL_RETURN_INST_PROFILE(SMLI,      OP_PROFILE_RRR, INST_SMLI  );
-    __VIRTUAL_RETURN_INST_PROFILE(SMLU,      OP_PROFILE_RRR, INST_SMLU  );
-    __VIRTUAL_RETURN_INST_PROFILE(SMLF,      OP_PROFILE_RRR, INST_SMLF  );
-    __VIRTUAL_RETURN_INST_PROFILE(CASTIU,    OP_PROFILE_RR , INST_CASTIU);
-    __VIRTUAL_RETURN_INST_PROFILE(CASTIF,    OP_PROFILE_RR , INST_CASTIF);
-    __VIRTUAL_RETURN_INST_PROFILE(CASTUI,    OP_PROFILE_RR , INST_CASTUI);
-    __VIRTUAL_RETURN_INST_PROFILE(CASTUF,    OP_PROFILE_RR , INST_CASTUF);
-    __VIRTUAL_RETURN_INST_PROFILE(CASTFI,    OP_PROFILE_RR , INST_CASTFI);
-    __VIRTUAL_RETURN_INST_PROFILE(CASTFU,    OP_PROFILE_RR , INST_CASTFU);
-    __VIRTUAL_RETURN_INST_PROFILE(CF3264,    OP_PROFILE_RR , INST_CF3264);
-    __VIRTUAL_RETURN_INST_PROFILE(CF6432,    OP_PROFILE_RR , INST_CF6432);
-    __VIRTUAL_RETURN_INST_PROFILE(FLOAT,     OP_PROFILE_RRR, INST_FLOAT );
-    __VIRTUAL_RETURN_INST_PROFILE(DUMPCHAR,  OP_PROFILE_RRR, INST_DUMPCHAR);
-    __VIRTUAL_RETURN_INST_PROFILE(GETCHAR,   OP_PROFILE_RR , INST_GETCHAR);
-    __VIRTUAL_RETURN_INST_PROFILE(EXEC,      OP_PROFILE_R  , INST_EXEC  );
-    __VIRTUAL_RETURN_INST_PROFILE(SYS,       OP_PROFILE_E  , INST_SYS   );
-    __VIRTUAL_RETURN_INST_PROFILE(DISREG,    OP_PROFILE_RRR, INST_DISREG);
-    __VIRTUAL_RETURN_INST_PROFILE(GRP,       OP_PROFILE_RRR, INST_GRP);
-    __VIRTUAL_RETURN_INST_PROFILE(GIP,       OP_PROFILE_RRR, INST_GIP);
-
-    return (InstProfile){INST_ERROR, OP_PROFILE_NONE};
-    #undef __VIRTUAL_RETURN_INST_PROFILE
+// the operands every instruction takes, indexed by opcode
+static inline OpProfile get_inst_op_profile(int opcode){
+    static const OpProfile op_profiles[INST_TOTAL_COUNT] = {
+        [INST_NOP]       = OP_PROFILE_NONE,
+        [INST_HALT]      = OP_PROFILE_E,
+        [INST_MOV8]      = OP_PROFILE_RR,
+        [INST_MOV16]     = OP_PROFILE_RR,
+        [INST_MOV32]     = OP_PROFILE_RR,
+        [INST_MOV]       = OP_PROFILE_RR,
+        [INST_MOVC]      = OP_PROFILE_RRR,
+        [INST_MOVV]      = OP_PROFILE_RL,
+        [INST_MOVN]      = OP_PROFILE_RL,
+        [INST_MOVV16]    = OP_PROFILE_RL,
+        [INST_PUSH]      = OP_PROFILE_E,
+        [INST_POP]       = OP_PROFILE_R,
+        [INST_STACK_GET] = OP_PROFILE_RL,
+        [INST_STACK_PUT] = OP_PROFILE_RL,
+        [INST_GSP]       = OP_PROFILE_RRR,
+        [INST_STATIC]    = OP_PROFILE_E,
+        [INST_READ8]     = OP_PROFILE_RRR,
+        [INST_READ16]    = OP_PROFILE_RRR,
+        [INST_READ32]    = OP_PROFILE_RRR,
+        [INST_READ]      = OP_PROFILE_RRR,
+        [INST_MREADS]    = OP_PROFILE_RRR,
+        [INST_WRITE8]    = OP_PROFILE_RRR,
+        [INST_WRITE16]   = OP_PROFILE_RRR,
+        [INST_WRITE32]   = OP_PROFILE_RRR,
+        [INST_WRITE]     = OP_PROFILE_RRR,
+        [INST_MWRITES]   = OP_PROFILE_RRR,
+        [INST_MMOVS]     = OP_PROFILE_RRR,
+        [INST_MEMCMP]    = OP_PROFILE_RRR,
+        [INST_NOT]       = OP_PROFILE_RR,
+        [INST_NEG]       = OP_PROFILE_RRR,
+        [INST_AND]       = OP_PROFILE_RRR,
+        [INST_NAND]      = OP_PROFILE_RRR,
+        [INST_OR]        = OP_PROFILE_RRR,
+        [INST_XOR]       = OP_PROFILE_RRR,
+        [INST_BSHIFT]    = OP_PROFILE_RRR,
+        [INST_JMP]       = OP_PROFILE_E,
+        [INST_JMPF]      = OP_PROFILE_RL,
+        [INST_JMPFN]     = OP_PROFILE_RL,
+        [INST_CALL]      = OP_PROFILE_E,
+        [INST_RET]       = OP_PROFILE_NONE,
+        [INST_ADD8]      = OP_PROFILE_RRR,
+        [INST_SUB8]      = OP_PROFILE_RRR,
+        [INST_MUL8]      = OP_PROFILE_RRR,
+        [INST_ADD16]     = OP_PROFILE_RRR,
+        [INST_SUB16]     = OP_PROFILE_RRR,
+        [INST_MUL16]     = OP_PROFILE_RRR,
+        [INST_ADD32]     = OP_PROFILE_RRR,
+        [INST_SUB32]     = OP_PROFILE_RRR,
+        [INST_MUL32]     = OP_PROFILE_RRR,
+        [INST_ADD]       = OP_PROFILE_RRR,
+        [INST_SUB]       = OP_PROFILE_RRR,
+        [INST_MUL]       = OP_PROFILE_RRR,
+        [INST_DIVI]      = OP_PROFILE_RRR,
+        [INST_DIVU]      = OP_PROFILE_RRR,
+        [INST_ADDF]      = OP_PROFILE_RRR,
+        [INST_SUBF]      = OP_PROFILE_RRR,
+        [INST_MULF]      = OP_PROFILE_RRR,
+        [INST_DIVF]      = OP_PROFILE_RRR,
+        [INST_INC]       = OP_PROFILE_RL,
+        [INST_DEC]       = OP_PROFILE_RL,
+        [INST_INCF]      = OP_PROFILE_RL,
+        [INST_DECF]      = OP_PROFILE_RL,
+        [INST_ABS]       = OP_PROFILE_RRR,
+        [INST_ABSF]      = OP_PROFILE_RRR,
+        [INST_NEQ]       = OP_PROFILE_RRR,
+        [INST_EQ]        = OP_PROFILE_RRR,
+        [INST_EQF]       = OP_PROFILE_RRR,
+        [INST_BIGI]      = OP_PROFILE_RRR,
+        [INST_BIGU]      = OP_PROFILE_RRR,
+        [INST_BIGF]      = OP_PROFILE_RRR,
+        [INST_SMLI]      = OP_PROFILE_RRR,
+        [INST_SMLU]      = OP_PROFILE_RRR,
+        [INST_SMLF]      = OP_PROFILE_RRR,
+        [INST_CASTIU]    = OP_PROFILE_RR,
+        [INST_CASTIF]    = OP_PROFILE_RR,
+        [INST_CASTUI]    = OP_PROFILE_RR,
+        [INST_CASTUF]    = OP_PROFILE_RR,
+        [INST_CASTFI]    = OP_PROFILE_RR,
+        [INST_CASTFU]    = OP_PROFILE_RR,
+        [INST_CF3264]    = OP_PROFILE_RR,
+        [INST_CF6432]    = OP_PROFILE_RR,
+        [INST_FLOAT]     = OP_PROFILE_RRR,
+        [INST_DUMPCHAR]  = OP_PROFILE_RRR,
+        [INST_GETCHAR]   = OP_PROFILE_RR,
+        [INST_EXEC]      = OP_PROFILE_R,
+        [INST_SYS]       = OP_PROFILE_E,
+        [INST_DISREG]    = OP_PROFILE_RRR,
+        [INST_GRP]       = OP_PROFILE_RRR,
+        [INST_GIP]       = OP_PROFILE_RRR,
+        [INST_MOVVW]     = OP_PROFILE_RW,
+        [INST_MOVVL]     = OP_PROFILE_RW,
+        [INST_JMPW]      = OP_PROFILE_W,
+        [INST_JMPFW]     = OP_PROFILE_RW,
+        [INST_JMPFNW]    = OP_PROFILE_RW,
+        [INST_CALLW]     = OP_PROFILE_W,
+        [INST_VADD8]     = OP_PROFILE_VVV,
+        [INST_VSUB8]     = OP_PROFILE_VVV,
+        [INST_VMUL8]     = OP_PROFILE_VVV,
+        [INST_VMIN8]     = OP_PROFILE_VVV,
+        [INST_VMAX8]     = OP_PROFILE_VVV,
+        [INST_VEQ8]      = OP_PROFILE_VVV,
+        [INST_VBIG8]     = OP_PROFILE_VVV,
+        [INST_VADD16]    = OP_PROFILE_VVV,
+        [INST_VSUB16]    = OP_PROFILE_VVV,
+        [INST_VMUL16]    = OP_PROFILE_VVV,
+        [INST_VMIN16]    = OP_PROFILE_VVV,
+        [INST_VMAX16]    = OP_PROFILE_VVV,
+        [INST_VEQ16]     = OP_PROFILE_VVV,
+        [INST_VBIG16]    = OP_PROFILE_VVV,
+        [INST_VADD32]    = OP_PROFILE_VVV,
+        [INST_VSUB32]    = OP_PROFILE_VVV,
+        [INST_VMUL32]    = OP_PROFILE_VVV,
+        [INST_VMIN32]    = OP_PROFILE_VVV,
+        [INST_VMAX32]    = OP_PROFILE_VVV,
+        [INST_VEQ32]     = OP_PROFILE_VVV,
+        [INST_VBIG32]    = OP_PROFILE_VVV,
+        [INST_VADDF32]   = OP_PROFILE_VVV,
+        [INST_VSUBF32]   = OP_PROFILE_VVV,
+        [INST_VMULF32]   = OP_PROFILE_VVV,
+        [INST_VMINF32]   = OP_PROFILE_VVV,
+        [INST_VMAXF32]   = OP_PROFILE_VVV,
+        [INST_VEQF32]    = OP_PROFILE_VVV,
+        [INST_VBIGF32]   = OP_PROFILE_VVV,
+        [INST_VADDF64]   = OP_PROFILE_VVV,
+        [INST_VSUBF64]   = OP_PROFILE_VVV,
+        [INST_VMULF64]   = OP_PROFILE_VVV,
+        [INST_VMINF64]   = OP_PROFILE_VVV,
+        [INST_VMAXF64]   = OP_PROFILE_VVV,
+        [INST_VEQF64]    = OP_PROFILE_VVV,
+        [INST_VBIGF64]   = OP_PROFILE_VVV,
+        [INST_VAND]      = OP_PROFILE_VVV,
+        [INST_VOR]       = OP_PROFILE_VVV,
+        [INST_VXOR]      = OP_PROFILE_VVV,
+        [INST_VSHUF]     = OP_PROFILE_VVV,
+        [INST_VLOAD]     = OP_PROFILE_VRR,
+        [INST_VSTORE]    = OP_PROFILE_RVR,
+        [INST_VSPLAT8]   = OP_PROFILE_VR,
+        [INST_VSPLAT16]  = OP_PROFILE_VR,
+        [INST_VSPLAT32]  = OP_PROFILE_VR,
+        [INST_VSPLAT64]  = OP_PROFILE_VR,
+        [INST_VGET8]     = OP_PROFILE_RVR,
+        [INST_VGET16]    = OP_PROFILE_RVR,
+        [INST_VGET32]    = OP_PROFILE_RVR,
+        [INST_VGET64]    = OP_PROFILE_RVR,
+        [INST_VSET8]     = OP_PROFILE_VRR,
+        [INST_VSET16]    = OP_PROFILE_VRR,
+        [INST_VSET32]    = OP_PROFILE_VRR,
+        [INST_VSET64]    = OP_PROFILE_VRR,
+        [INST_MSTRLEN]   = OP_PROFILE_RR,
+        [INST_MCHR]      = OP_PROFILE_RRR,
+        [INST_MFILL32]   = OP_PROFILE_RRR,
+        [INST_MFILL64]   = OP_PROFILE_RRR,
+        [INST_MCRC32]    = OP_PROFILE_RRR,
+        [INST_MHASH]     = OP_PROFILE_RRR,
+        [INST_MPOPCNT]   = OP_PROFILE_RRR,
+        [INST_FMAF]      = OP_PROFILE_RRR,
+        [INST_SQRTF]     = OP_PROFILE_RR,
+        [INST_MINF]      = OP_PROFILE_RRR,
+        [INST_MAXF]      = OP_PROFILE_RRR,
+        [INST_FLOORF]    = OP_PROFILE_RR,
+        [INST_CEILF]     = OP_PROFILE_RR,
+        [INST_ROUNDF]    = OP_PROFILE_RR,
+        [INST_ADDF32]    = OP_PROFILE_RRR,
+        [INST_SUBF32]    = OP_PROFILE_RRR,
+        [INST_MULF32]    = OP_PROFILE_RRR,
+        [INST_DIVF32]    = OP_PROFILE_RRR,
+        [INST_FMAF32]    = OP_PROFILE_RRR,
+        [INST_SQRTF32]   = OP_PROFILE_RR,
+        [INST_ALOAD8]    = OP_PROFILE_RRR,
+        [INST_ALOAD16]   = OP_PROFILE_RRR,
+        [INST_ALOAD32]   = OP_PROFILE_RRR,
+        [INST_ALOAD]     = OP_PROFILE_RRR,
+        [INST_ASTORE8]   = OP_PROFILE_RRR,
+        [INST_ASTORE16]  = OP_PROFILE_RRR,
+        [INST_ASTORE32]  = OP_PROFILE_RRR,
+        [INST_ASTORE]    = OP_PROFILE_RRR,
+        [INST_ACAS8]     = OP_PROFILE_RRR,
+        [INST_ACAS16]    = OP_PROFILE_RRR,
+        [INST_ACAS32]    = OP_PROFILE_RRR,
+        [INST_ACAS]      = OP_PROFILE_RRR,
+        [INST_AADD8]     = OP_PROFILE_RRR,
+        [INST_AADD16]    = OP_PROFILE_RRR,
+        [INST_AADD32]    = OP_PROFILE_RRR,
+        [INST_AADD]      = OP_PROFILE_RRR,
+        [INST_AOR8]      = OP_PROFILE_RRR,
+        [INST_AOR16]     = OP_PROFILE_RRR,
+        [INST_AOR32]     = OP_PROFILE_RRR,
+        [INST_AOR]       = OP_PROFILE_RRR,
+        [INST_AXCHG8]    = OP_PROFILE_RRR,
+        [INST_AXCHG16]   = OP_PROFILE_RRR,
+        [INST_AXCHG32]   = OP_PROFILE_RRR,
+        [INST_AXCHG]     = OP_PROFILE_RRR,
+        [INST_FENCE]     = OP_PROFILE_NONE,
+    };
+    return op_profiles[opcode];
 }
 
-static inline int get_major_reg_identifier(const Token token){
-    if(token.size < 2) return -1;
-    if(token.value.as_str[0] != 'r' && token.value.as_str[0] != 'R')
-        return -1;
-    
-    if(mc_compare_token(token, MKTKN("r0"), 1))  return MR0;
-    if(mc_compare_token(token, MKTKN("R0"), 1))  return MR0;
-    if(mc_compare_token(token, MKTKN("rsp"), 1) && token.size > 2) return MRSP;
-    if(mc_compare_token(token, MKTKN("RSP"), 1) && token.size > 2) return MRSP;
-    if(mc_compare_token(token, MKTKN("rip"), 1) && token.size > 2) return MRIP;
-    if(mc_compare_token(token, MKTKN("RIP"), 1) && token.size > 2) return MRIP;
+// mnemonics and register names are found through perfect hash tables (see keywords.h) instead of comparing
+// them against every name there is
+static KEYWORD_TABLE_THREAD_LOCAL KeywordTable mnemonic_table;
+static KEYWORD_TABLE_THREAD_LOCAL KeywordTable register_table;
+// RX and RX0 to RX7 for X in 0, A to Z, SP and IP, at most 4 characters and a null terminator each
+static KEYWORD_TABLE_THREAD_LOCAL char register_names[(MRIP + 1) * 9][5];
+
+static inline const KeywordTable* get_mnemonic_table(void){
+    if(mnemonic_table.built) return &mnemonic_table;
+    mnemonic_table.count = 0;
+    mnemonic_table.fold_case = 0;
+    for(int opcode = 0; opcode < INST_TOTAL_COUNT; opcode+=1){
+        const char* const name = get_inst_name(opcode);
+        add_keyword(&mnemonic_table, name, (uint32_t) strlen(name), opcode);
+    }
+    if(build_keyword_table(&mnemonic_table)){
+        fprintf(stderr, "[INTERNAL ERROR] " __FILE__ ":%i:9 : Could Not Build The Mnemonic Table\n", (int) __LINE__);
+        mnemonic_table.built = 1;
+    }
+    return &mnemonic_table;
+}
 
-    if(token.size > 3) return -1;
+static inline const KeywordTable* get_register_table(void){
+    if(register_table.built) return &register_table;
+    register_table.count = 0;
+    // registers can be written in any case, rsp, RSP, ra1 or rA1
+    register_table.fold_case = 1;
+    uint32_t name_count = 0;
+    for(int major = MR0; major <= MRIP; major+=1){
+        char base[4] = {'R', 0, 0, 0};
+        if(major == MR0)        base[1] = '0';
+        else if(major == MRSP)  memcpy(base + 1, "SP", 2);
+        else if(major == MRIP)  memcpy(base + 1, "IP", 2);
+        else                    base[1] = (char) ('A' + (major - MRA));
+        const uint32_t base_size = (uint32_t) strlen(base);
+        // the plain name is the same register as its 0th sub-register
+        for(int sub = -1; sub < 8; sub+=1){
+            char* const name = register_names[name_count++];
+            memcpy(name, base, base_size);
+            name[base_size] = (sub < 0)? '\0' : (char) ('0' + sub);
+            name[base_size + 1] = '\0';
+            add_keyword(&register_table, name, base_size + (sub >= 0), major * 8 + ((sub < 0)? 0 : sub));
+        }
+    }
+    if(build_keyword_table(&register_table)){
+        fprintf(stderr, "[INTERNAL ERROR] " __FILE__ ":%i:9 : Could Not Build The Register Table\n", (int) __LINE__);
+        register_table.built = 1;
+    }
+    return &register_table;
+}
 
-    if(token.value.as_str[1] >= 'a' && token.value.as_str[1] <= 'z')
-        return MRA + (token.value.as_str[1] - 'a');
+InstProfile get_inst_profile(const Token inst_token){
+    if(inst_token.type != TKN_RAW || inst_token.size <= 0) return (InstProfile){INST_ERROR , 0};
 
-    if(token.value.as_str[1] >= 'A' && token.value.as_str[1] <= 'Z')
-        return MRA + (token.value.as_str[1] - 'A');
+    const int opcode = find_keyword(get_mnemonic_table(), inst_token.value.as_str, (uint32_t) inst_token.size);
+    if(opcode < 0) return (InstProfile){INST_ERROR, OP_PROFILE_NONE};
 
-    return -1;
+    return (InstProfile){(uint8_t) opcode, get_inst_op_profile(opcode)};
 }
 
 int get_reg(const Token token){
@@ -242,29 +423,21 @@ int get_reg(const Token token){
     if(token.type != TKN_RAW) return -1;
 	if(token.size > 4 || token.size < 2) return -1;
 
-    const int reg = get_major_reg_identifier(token);
-    if(reg < 0) return -1;
-    if(token.size == 2){
-        return reg * 8;
-    }
-	if(token.size == 4){
-        const int i = get_digit(token.value.as_str[3]);
-        if((i < 0) || (i > 7)){
-            return -1;
-        }
-        return reg * 8 + i;
-	}
-    if(reg == MRSP || reg == MRIP || reg == MRST)
-        return reg * 8;
-	if(token.size == 3){
-        const int i = get_digit(token.value.as_str[2]);
-        if((i < 0) || (i > 7)){
-            return -1;
-        }
-        return reg * 8 + i;
-    }
+    return find_keyword(get_register_table(), token.value.as_str, (uint32_t) token.size);
+}
 
-    return -1;
+// \returns the vector register named by token (V0 to V15, in any case) or -1 if it names none
+int get_vreg(const Token token){
+    if(token.type != TKN_RAW || token.size < 2 || token.size > 3) return -1;
+    if(token.value.as_str[0] != 'V' && token.value.as_str[0] != 'v') return -1;
+    // V01 is not a name
+    if(token.size == 3 && token.value.as_str[1] == '0') return -1;
+    int vreg = 0;
+    for(int i = 1; i < token.size; i+=1){
+        if(token.value.as_str[i] < '0' || token.value.as_str[i] > '9') return -1;
+        vreg = vreg * 10 + (token.value.as_str[i] - '0');
+    }
+    return (vreg < VECTOR_REGISTER_COUNT)? vreg : -1;
 }
 
 Operand parse_op_literal(Token token){
@@ -425,12 +598,14 @@ int parse_macro(Parser* parser, const Token macro, StringView* include_path){
         const Token arg1 = get_next_token(parser->tokenizer);
         Token arg2 = get_next_token(parser->tokenizer);
         const Token original_arg2 = arg2;
+        uint8_t flags = LABELFLAG_NONE;
 
         if(arg1.type != TKN_RAW){
             REPORT_ERROR(parser, "\n\tLabel Identifier Is Either Missing Or Invalid%c\n\n", ' ');
             return 1;
         }
-        if(arg2.type == TKN_RAW){
+        // a character is stored as its value, the token points to the source, which is gone once the labels are exported
+        if(arg2.type == TKN_RAW || arg2.type == TKN_CHAR){
             const Operand op = parse_op_literal(arg2);
             if(op.type != TKN_ERROR){
                 arg2.type = op.type;
@@ -438,15 +613,20 @@ int parse_macro(Parser* parser, const Token macro, StringView* include_path){
             }
         }
         else if(arg2.type == TKN_LABEL_REF){
-            arg2 = resolve_token(parser->labels, arg2);
+            arg2 = parser_resolve_token(parser, arg2);
             if(arg2.type == TKN_ERROR){
                 REPORT_ERROR(parser, "\n\tCould Not Resolve Label '%.*s'\n\n", arg2.size, arg2.value.as_str);
                 return 1;
             }
+            // a copy of a static offset still has to move with the static memory
+            if(parser->relocations){
+                const Label* const source = get_label(parser->labels, (Token){.value.as_str = original_arg2.value.as_str + 1, .size = original_arg2.size - 1});
+                if(source) flags = get_label_from_raw_data(source).flags & LABELFLAG_STATIC;
+            }
         }
         else if(arg2.type == TKN_ADDR_LABEL_REF){
             arg2.type = TKN_LABEL_REF;
-            arg2 = resolve_token(parser->labels, arg2);
+            arg2 = parser_resolve_token(parser, arg2);
             if(arg2.type == TKN_ERROR){
                 REPORT_ERROR(parser, "\n\tCould Not Resolve Label '%.*s'\n\n", arg2.size, arg2.value.as_str);
                 return 1;
@@ -472,12 +652,13 @@ int parse_macro(Parser* parser, const Token macro, StringView* include_path){
             push_to_static(parser->static_memory, arg2);
             arg2.value.as_uint = spos;
             arg2.type = TKN_ULIT;
+            if(parser->relocations) flags = LABELFLAG_STATIC;
         }
         else if(arg2.type == TKN_NONE){
             REPORT_ERROR(parser, "\n\tMissing Definition For '%.*s' Label\n\n", arg1.size, arg1.value.as_str);
             return 1;
         }
-        if(add_label(parser->labels, arg1, arg2)){
+        if(parser_add_label_with_flag(parser, arg1, arg2, flags)){
             REPORT_ERROR(
                 parser, "\n\tInvalid Label Or Definition '%s %.*s %.*s'\n\tNOT: You Can Not Redifine Already Labeled Labels\n\n",
                 "%label",
@@ -493,7 +674,7 @@ int parse_macro(Parser* parser, const Token macro, StringView* include_path){
             REPORT_ERROR(parser, "\n\tLabel Identifier Is Either Missing Or Invalid%c\n\n", ' ');
             return 1;
         }
-        if(add_label(parser->labels, arg1, (Token){.type = TKN_EMPTY})){
+        if(parser_add_label(parser, arg1, (Token){.type = TKN_EMPTY})){
             REPORT_ERROR(
                 parser, "\n\tInvalid Label Or Definition '%s %.*s'\n\tNOTE: You Can Not Relabel\n\n",
                 "%label", arg1.size, arg1.value.as_str
@@ -508,7 +689,7 @@ int parse_macro(Parser* parser, const Token macro, StringView* include_path){
             REPORT_ERROR(parser, "\n\tLabel Identifier Is Either Missing Or Invalid%c\n\n", ' ');
             return 1;
         }
-        if(remove_label(parser->labels, arg)){
+        if(parser_remove_label(parser, arg)){
             REPORT_ERROR(parser, "\n\tAttempting To Unlabel '%.*s' While Label Does Not Exist\n\n", arg.size, arg.value.as_str);
             return 1;
         }
@@ -520,7 +701,7 @@ int parse_macro(Parser* parser, const Token macro, StringView* include_path){
             REPORT_ERROR(parser, "\n\tLabel Identifier Is Either Missing Or Invalid%c\n\n", ' ');
             return 1;
         }
-        if(!get_label(parser->labels, arg)){
+        if(!parser_get_label(parser, arg)){
             tokenizer_goto(parser->tokenizer, "%endif");
             get_next_token(parser->tokenizer);
         }
@@ -533,7 +714,7 @@ int parse_macro(Parser* parser, const Token macro, StringView* include_path){
             REPORT_ERROR(parser, "\n\tLabel Identifier Is Either Missing Or Invalid%c\n\n", ' ');
             return 1;
         }
-        if(get_label(parser->labels, arg)){
+        if(parser_get_label(parser, arg)){
             tokenizer_goto(parser->tokenizer, "%endif");
             get_next_token(parser->tokenizer);
         }
@@ -579,7 +760,7 @@ int parse_macro(Parser* parser, const Token macro, StringView* include_path){
                 if(definition.type == TKN_LABEL_REF || definition.type == TKN_ADDR_LABEL_REF){
                     const Token label = definition;
                     if(label.type == TKN_ADDR_LABEL_REF) definition.type = TKN_LABEL_REF;
-                    definition = resolve_token(parser->labels, definition);
+                    definition = parser_resolve_token(parser, definition);
                     if(definition.type == TKN_ERROR){
                         REPORT_ERROR(parser, "\n\tCould Not Resolve Label '%.*s'\n", label.size, label.value.as_str);
                         return 1;
@@ -606,7 +787,7 @@ int parse_macro(Parser* parser, const Token macro, StringView* include_path){
                 next = get_next_token(parser->tokenizer);
             }
 
-            if(add_label(parser->labels, token, definition)){
+            if(parser_add_label(parser, token, definition)){
                 REPORT_ERROR(
                     parser, "\n\t%.*s Could Not Add Label '%.*s', It's Invalid Or It Already Exists\n",
                     macro.size, macro.value.as_str,
@@ -636,8 +817,15 @@ int parse_macro(Parser* parser, const Token macro, StringView* include_path){
     return 1;
 }
 
-int pre_parse_inst_operand(const Parser* parser, Token* _token, uint64_t absolute_program_position){
+// \param relocation set to the relocation the operand needs when assembling an object (OBJECT_RELOCATION_NONE if none),
+// labels the object does not define are resolved to 0 and left to the linker
+// \param ref set to the relative reference the operand is (see relax.h), its byte is 0 if the operand is not one
+// \param wide if the operand is the literal of a wide instruction or of a branch that can become wide, relative
+// references are then not limited to 16 bits
+int pre_parse_inst_operand(const Parser* parser, Token* _token, uint64_t absolute_program_position, ObjectRelocation* relocation, RelativeRef* ref, int wide){
     Token token = *_token;
+    *relocation = (ObjectRelocation){.kind = OBJECT_RELOCATION_NONE};
+    *ref = (RelativeRef){.inst = parser->program->size / sizeof(Inst), .byte = 0};
     if(token.type == TKN_LABEL_REF){
         if(token.size > 2){
             if(token.value.as_str[2] == '.'){
@@ -645,32 +833,57 @@ int pre_parse_inst_operand(const Parser* parser, Token* _token, uint64_t absolut
                 return 1;
             }
         }
-        token = resolve_token(parser->labels, token);
+        token = parser_resolve_token(parser, token);
         if(token.type == TKN_ERROR){
+            if(parser->relocations){
+                *relocation = (ObjectRelocation){
+                    .kind = OBJECT_RELOCATION_SYMBOL, .symbol = _token->value.as_str + 1, .symbol_size = _token->size - 1
+                };
+                *_token = (Token){.value.as_uint = 0, .type = TKN_ULIT, .size = 0};
+                return 0;
+            }
             REPORT_ERROR(parser, "\n\tCould Not Resolve Label '%.*s'\n\n", _token->size, _token->value.as_str);
             return 1;
         }
         if(token.type == TKN_STATIC_SIZE){
             token.value.as_uint = parser->static_memory->size;
             token.type = TKN_ULIT;
+            if(parser->relocations) relocation->kind = OBJECT_RELOCATION_STATIC;
+        }
+        else if(parser->relocations && token.type == TKN_INST_POSITION){
+            relocation->kind = OBJECT_RELOCATION_POSITION;
+        }
+        else if(parser->relocations){
+            const Label* const label = get_label(parser->labels, (Token){.value.as_str = _token->value.as_str + 1, .size = _token->size - 1});
+            if(label && (get_label_from_raw_data(label).flags & LABELFLAG_STATIC)) relocation->kind = OBJECT_RELOCATION_STATIC;
         }
     }
     else if(token.type == TKN_ADDR_LABEL_REF){
         token.type = TKN_LABEL_REF;
-        token = resolve_token(parser->labels, token);
+        token = parser_resolve_token(parser, token);
         if(token.type == TKN_ERROR){
             if(token.size > 1 && parser->local_labels){
                 if(token.value.as_str[1] == '.'){
-                    union {int16_t as_int16; uint16_t as_uint16; } stride;
+                    uint64_t label_position;
                     token.type = TKN_RAW;
-                    if(add_local_labelref(parser->local_labels, &stride.as_int16, token, absolute_program_position)){
+                    if(!parser->local_scope || add_local_labelref(parser->local_labels, token, &label_position)){
                         REPORT_ERROR(parser, "\n\tCould Not Add Local Label Reference '%.*s'\n", token.size, token.value.as_str);
                         return 1;
                     }
-                    *_token = (Token){.value.as_uint = stride.as_uint16, .type = TKN_ILIT, .size = 0};
+                    // written when the scope closes
+                    ref->local_label = label_position + 1;
+                    ref->byte = (uint8_t) (absolute_program_position - parser->program->size);
+                    *_token = (Token){.value.as_uint = 0, .type = TKN_ILIT, .size = 0};
                     return 0;
                 }
             }
+            if(parser->relocations){
+                *relocation = (ObjectRelocation){
+                    .kind = OBJECT_RELOCATION_RELATIVE_SYMBOL, .symbol = _token->value.as_str + 1, .symbol_size = _token->size - 1
+                };
+                *_token = (Token){.value.as_uint = 0, .type = TKN_ULIT, .size = 0};
+                return 0;
+            }
             REPORT_ERROR(parser, "\n\tCould Not Resolve Label '%.*s'\n\n", _token->size, _token->value.as_str);
             return 1;
         }
@@ -681,6 +894,12 @@ int pre_parse_inst_operand(const Parser* parser, Token* _token, uint64_t absolut
             return 1;
         }
         const int64_t v = token.value.as_uint - (parser->program->size / 4);
+        ref->target = token.value.as_uint;
+        ref->byte = (uint8_t) (absolute_program_position - parser->program->size);
+        if(wide){
+            *_token = (Token){.value.as_int = v, .type = TKN_ILIT, .size = 0};
+            return 0;
+        }
         if(v != (int16_t) v){
             REPORT_ERROR(parser, "\n\tLiteral Has To Be Up To 16 Bits Long, %"PRIi64" != %"PRIi16"\n\n", v, (int16_t) v);
             return 1;
@@ -693,8 +912,33 @@ int pre_parse_inst_operand(const Parser* parser, Token* _token, uint64_t absolut
     return 0;
 }
 
+// records the relocation of the literal at byte of the instruction being parsed, when assembling an object
+// \returns 0 on success or 1 if the literal can not be relocated
+static inline int push_operand_relocation(const Parser* parser, ObjectRelocation relocation, int byte){
+    if(!parser->relocations || relocation.kind == OBJECT_RELOCATION_NONE) return 0;
+    if(byte + sizeof(uint16_t) > sizeof(Inst)){
+        REPORT_ERROR(parser, "\n\tCan Not Relocate A Literal At Byte %i Of An Instruction\n", byte);
+        return 1;
+    }
+    relocation.inst = parser->program->size / sizeof(Inst);
+    relocation.byte = (uint8_t) byte;
+    push_object_relocation(parser->relocations, relocation);
+    return 0;
+}
+
+// records ref, if the operand is a relative reference, as the literal at byte of the instruction being parsed,
+// to be written when the local scope closes (see relax.h)
+static inline void push_parser_relative_ref(const Parser* parser, RelativeRef ref, int byte, RelativeRefFlags flags){
+    if(!parser->local_scope || !ref.byte) return;
+    ref.byte = (uint8_t) byte;
+    ref.flags = (uint8_t) flags;
+    push_relative_ref(parser->local_scope, ref);
+}
+
+// \param payload receives the containers that follow the instruction if it is wide (see get_inst_payload_size),
+// it has room for 2
 // \returns the parsed instruction on success or INST_ERROR on failure
-Inst parse_inst(Parser* parser, InstProfile inst_profile, const StringView inst_sv){
+Inst parse_inst(Parser* parser, InstProfile inst_profile, const StringView inst_sv, Inst* payload){
 
     Inst inst = inst_profile.opcode;
     int op_pos_in_inst = 1;
@@ -705,8 +949,13 @@ Inst parse_inst(Parser* parser, InstProfile inst_profile, const StringView inst_
     {
         const Token tokenRW = get_next_token(parser->tokenizer);
         Token token = tokenRW;
+        ObjectRelocation relocation;
+        RelativeRef ref;
 
-        if(pre_parse_inst_operand(parser, &token, parser->program->size + op_pos_in_inst))
+        int wide = (inst_profile.op_profile & 0XFF) == EXPECT_OP_WIDE_LIT;
+        // JMP, JMPF, JMPFN and CALL take their wide form when their offset does not fit in 16 bits (see relax.h)
+        const int relaxable = !wide && parser->local_scope && get_far_branch(inst_profile.opcode) != INST_ERROR;
+        if(pre_parse_inst_operand(parser, &token, parser->program->size + op_pos_in_inst, &relocation, &ref, wide || relaxable))
             return INST_ERROR;
 
         switch (inst_profile.op_profile & 0XFF)
@@ -725,7 +974,22 @@ Inst parse_inst(Parser* parser, InstProfile inst_profile, const StringView inst_
             op_pos_in_inst += 1;
             op_token_pos += 1;
         }   break;
-        case EXPECT_OP_LIT:{
+        case EXPECT_OP_VREG:{
+            const int vreg = get_vreg(token);
+            if(vreg < 0){
+                REPORT_ERROR(
+                    parser,
+                    "\n\tArgument %i Of Instruction %.*s Should Be Vector Register (V0 To V15), Got '%.*s' Of Type %s Instead\n\n",
+                    op_token_pos, inst_sv.size, inst_sv.str, tokenRW.size, tokenRW.value.as_str, get_token_type_str(token.type)
+                );
+                return INST_ERROR;
+            }
+            inst |= ((Inst) vreg << (op_pos_in_inst * 8));
+            op_pos_in_inst += 1;
+            op_token_pos += 1;
+        }   break;
+        case EXPECT_OP_LIT:
+        case EXPECT_OP_WIDE_LIT:{
             if(token.type == TKN_STR){
                 if(!parser->static_memory){
                     REPORT_ERROR(parser, "\n\tNo Static Memory Available%c\n", '\n');
@@ -739,8 +1003,9 @@ Inst parse_inst(Parser* parser, InstProfile inst_profile, const StringView inst_
                 push_to_static(parser->static_memory, token);
                 token.value.as_uint = spos;
                 token.type = TKN_ULIT;
+                relocation.kind = OBJECT_RELOCATION_STATIC;
             }
-            const Operand operand = parse_op_literal(token);
+            Operand operand = parse_op_literal(token);
             if(operand.type == TKN_ERROR){
                 REPORT_ERROR(
                     parser,
@@ -749,7 +1014,32 @@ Inst parse_inst(Parser* parser, InstProfile inst_profile, const StringView inst_
                 );
                 return INST_ERROR;
             }
-            if(operand.value.as_uint64 != operand.value.as_uint16){
+            if(relaxable && ref.byte){
+                if(operand.value.as_int64 == (int16_t) operand.value.as_int64) operand.value.as_uint64 &= 0xFFFF;
+                else{
+                    inst_profile.opcode = (uint8_t) get_far_branch(inst_profile.opcode);
+                    inst = (inst & ~(Inst) 0xFF) | inst_profile.opcode;
+                    wide = 1;
+                }
+            }
+            if(wide){
+                if(!fits_wide_literal(inst_profile.opcode, operand.value.as_uint64)){
+                    REPORT_ERROR(
+                        parser,
+                        "\n\tLiteral Of %.*s Has To Be A 32 Bits Signed Integer %"PRIi64" != %"PRIi32"\n\n",
+                        inst_sv.size, inst_sv.str, operand.value.as_int64, operand.value.as_int32
+                    );
+                    return INST_ERROR;
+                }
+                Inst wide_inst[3] = {inst, INST_CONTAINER, INST_CONTAINER};
+                set_wide_literal(wide_inst, operand.value.as_uint64);
+                inst = wide_inst[0];
+                payload[0] = wide_inst[1];
+                payload[1] = wide_inst[2];
+                // the wide literal always starts at L2, even without a register before it
+                if(op_pos_in_inst < 2) op_pos_in_inst = 2;
+            }
+            else if(operand.value.as_uint64 != operand.value.as_uint16){
                 REPORT_ERROR(
                     parser,
                     "\n\tLiteral Has To Be Up To 16 Bits Long %"PRIu64" != %"PRIu16"\n\n",
@@ -757,7 +1047,10 @@ Inst parse_inst(Parser* parser, InstProfile inst_profile, const StringView inst_
                 );
                 return INST_ERROR;
             }
-            inst |= operand.value.as_uint16 << (8 * op_pos_in_inst);
+            else inst |= operand.value.as_uint16 << (8 * op_pos_in_inst);
+            if(push_operand_relocation(parser, relocation, op_pos_in_inst))
+                return INST_ERROR;
+            push_parser_relative_ref(parser, ref, op_pos_in_inst, wide? RELATIVE_REF_WIDE : relaxable? RELATIVE_REF_RELAXABLE : RELATIVE_REF_SHORT);
             op_pos_in_inst += 2;
             op_token_pos += 1;
         }   break;
@@ -776,13 +1069,16 @@ Inst parse_inst(Parser* parser, InstProfile inst_profile, const StringView inst_
                 push_to_static(parser->static_memory, token);
                 inst |= (op_value & 0XFFFF) << 8;
                 inst |= HINT_LIT << 31;
+                relocation.kind = OBJECT_RELOCATION_STATIC;
+                if(push_operand_relocation(parser, relocation, 1))
+                    return INST_ERROR;
                 op_token_pos += 1;
                 op_pos_in_inst += 3;
                 break;
             }
             const int reg = get_reg(token);
             if(reg < 0){
-                const Operand operand = parse_op_literal(token);
+                Operand operand = parse_op_literal(token);
                 if(operand.type == TKN_ERROR){
                     REPORT_ERROR(
                         parser,
@@ -791,6 +1087,28 @@ Inst parse_inst(Parser* parser, InstProfile inst_profile, const StringView inst_
                     );
                     return INST_ERROR;
                 }
+                if(relaxable && ref.byte && operand.value.as_int64 != (int16_t) operand.value.as_int64){
+                    // the wide JMP and CALL only take a literal, so they have no hint
+                    inst_profile.opcode = (uint8_t) get_far_branch(inst_profile.opcode);
+                    if(!fits_wide_literal(inst_profile.opcode, operand.value.as_uint64)){
+                        REPORT_ERROR(
+                            parser,
+                            "\n\tOffset Of %.*s Has To Be A 32 Bits Signed Integer %"PRIi64" != %"PRIi32"\n\n",
+                            inst_sv.size, inst_sv.str, operand.value.as_int64, operand.value.as_int32
+                        );
+                        return INST_ERROR;
+                    }
+                    // sized for the widest payload, set_wide_literal only fills the one container of a wide branch
+                    Inst wide_inst[3] = {inst_profile.opcode, INST_CONTAINER, INST_CONTAINER};
+                    set_wide_literal(wide_inst, operand.value.as_uint64);
+                    inst = wide_inst[0];
+                    payload[0] = wide_inst[1];
+                    push_parser_relative_ref(parser, ref, 2, RELATIVE_REF_WIDE);
+                    op_pos_in_inst += 3;
+                    op_token_pos += 1;
+                    break;
+                }
+                if(relaxable && ref.byte) operand.value.as_uint64 &= 0xFFFF;
                 if(operand.value.as_uint16 != operand.value.as_uint64){
                     REPORT_ERROR(
                         parser,
@@ -801,6 +1119,9 @@ Inst parse_inst(Parser* parser, InstProfile inst_profile, const StringView inst_
                 }
                 inst |= operand.value.as_uint16 << (8 * op_pos_in_inst);
                 inst |= HINT_LIT << 31;
+                if(push_operand_relocation(parser, relocation, op_pos_in_inst))
+                    return INST_ERROR;
+                push_parser_relative_ref(parser, ref, op_pos_in_inst, relaxable? RELATIVE_REF_RELAXABLE : RELATIVE_REF_SHORT);
                 op_pos_in_inst += 3;
                 op_token_pos += 1;
                 break;
@@ -826,6 +1147,29 @@ Inst parse_inst(Parser* parser, InstProfile inst_profile, const StringView inst_
     return inst;
 }
 
+// closes the local scope at the end of the program, its local labels have to be defined by then
+// and its branches are relaxed (see relax.h)
+// \returns 0 on success or 1 otherwise
+static inline int parser_close_local_scope(Parser* parser){
+    if(!parser->local_labels) return 0;
+    const Label* unsolved_local_label = get_missing_local_label(parser->local_labels);
+    if(unsolved_local_label){
+        const Label l = get_label_from_raw_data(unsolved_local_label);
+        const char* const unsolved_local_label_name = (char*) (((uintptr_t) unsolved_local_label) + l.str);
+        REPORT_ERROR(parser, "\n\tUnsolved Local Label '%.*s'\n", l.str_size, unsolved_local_label_name);
+        return 1;
+    }
+    if(!parser->local_scope){
+        parser->local_labels->size = 0;
+        return 0;
+    }
+    if(close_local_scope(parser->local_scope, parser->local_labels, parser->program, parser->relocations, &parser->entry_point)){
+        REPORT_ERROR(parser, "\n\tCould Not Lay Out The Local Scope That Ends Here%c\n", ' ');
+        return 1;
+    }
+    return 0;
+}
+
 // \return 1 on error or 0 otherwise
 int parse_file(Parser* parser, Mc_stream_t* files_stream){
 
@@ -842,7 +1186,7 @@ int parse_file(Parser* parser, Mc_stream_t* files_stream){
             continue;
         }
         if(token.type == TKN_LABEL_REF){
-            const Token tmp = resolve_token(parser->labels, token);
+            const Token tmp = parser_resolve_token(parser, token);
             if(tmp.type == TKN_ERROR){
                 REPORT_ERROR(parser, "\n\tCould Not Resolve Label '%.*s'\n\n", token.size, token.value.as_str);
                 return 1;
@@ -874,23 +1218,82 @@ int parse_file(Parser* parser, Mc_stream_t* files_stream){
                     );
                     return 1;
                 }
-                const Tokenizer previous_tokenizer_state = *(parser->tokenizer);
-                const int macro_if_depth = parser->macro_if_depth;
-                const int previous_file_path_size = parser->file_path_size;
-		        parser->file_path_size = mother_directory.size + next_path_sv.size;
-                parser->macro_if_depth = 0;
-                *(parser->tokenizer) = (Tokenizer){
-                    .data = (char*)((uint8_t*)(new_file) + mother_directory.size + next_path_sv.size + 1 + sizeof(uint32_t)),
-                    .pos = 0, .line = 0, .column = 0
-                };
-                parser->file_path = (char*)((uint8_t*)(new_file) + sizeof(uint32_t));
-                if(parse_file(parser, files_stream))
-                    return 1;
+                const uint32_t new_file_path_size = mother_directory.size + next_path_sv.size;
+                const char* const new_file_path = new_file + sizeof(uint32_t);
+                const char* const new_file_content = new_file_path + new_file_path_size + 1;
+                // read_file_relative null terminates the content
+                const uint64_t new_file_content_size = files_stream->size - (uint64_t)(new_file_content - (char*) files_stream->data) - 1;
+                if(parser->include_record){
+                    include_record_file(parser->include_record, new_file_path, new_file_path_size, new_file_content, new_file_content_size);
+                }
+                // only the includes of the file being assembled are cached (the ones they include are part of them),
+                // only when no local label is pending, as the include could solve it, and not in objects (records have
+                // no relocations)
+                const int cache_include = parser->include_cache && !parser->include_record && !parser->relocations
+                    && parser->local_labels && parser->local_labels->size == 0;
+                IncludeKey include_key;
+                int parse_include = 1;
+                if(cache_include){
+                    include_key = make_include_key(
+                        new_file_path, new_file_path_size, new_file_content, new_file_content_size,
+                        parser->program->size, parser->static_memory? parser->static_memory->size : 0
+                    );
+                    parse_include = replay_cached_include(
+                        parser->include_cache, include_key, parser->labels, parser->program, parser->static_memory, &parser->entry_point
+                    );
+                    if(parse_include < 0){
+                        parser->file_path = (char*) mc_stream_on(files_stream, file_pos);
+                        REPORT_ERROR(parser, "\n\tCould Not Replay The Cached '%s' Include, Remove The Include Cache And Try Again\n", new_file_path);
+                        return 1;
+                    }
+                    // the include closed the local scope when it was assembled
+                    if(!parse_include){
+                        parser->file_path = (char*) mc_stream_on(files_stream, file_pos);
+                        if(parser_close_local_scope(parser))
+                            return 1;
+                    }
+                }
+                if(parse_include){
+                    const Tokenizer previous_tokenizer_state = *(parser->tokenizer);
+                    const int macro_if_depth = parser->macro_if_depth;
+                    const int previous_file_path_size = parser->file_path_size;
+                    const uint64_t program_base = parser->program->size;
+                    const uint64_t static_base = parser->static_memory? parser->static_memory->size : 0;
+                    const uint64_t previous_entry_point = parser->entry_point;
+                    IncludeRecord record;
+                    if(cache_include){
+                        record = create_include_record();
+                        parser->include_record = &record;
+                    }
+                    parser->file_path_size = new_file_path_size;
+                    parser->macro_if_depth = 0;
+                    *(parser->tokenizer) = (Tokenizer){.data = (char*) new_file_content, .pos = 0, .line = 0, .column = 0};
+                    parser->file_path = (char*) new_file_path;
+                    const int status = parse_file(parser, files_stream);
+                    if(cache_include){
+                        parser->include_record = NULL;
+                        if(!status && save_cached_include(
+                                parser->include_cache, include_key, &record,
+                                mc_stream_on(parser->program, program_base), parser->program->size - program_base,
+                                parser->static_memory? mc_stream_on(parser->static_memory, static_base) : NULL,
+                                parser->static_memory? parser->static_memory->size - static_base : 0,
+                                parser->entry_point != previous_entry_point, parser->entry_point
+                            )){
+                            fprintf(
+                                stderr, "[WARNING] Could Not Cache '%s' In '%s'\n",
+                                (char*) mc_stream_on(files_stream, previous_file_stream_size + sizeof(uint32_t)), parser->include_cache
+                            );
+                        }
+                        destroy_include_record(&record);
+                    }
+                    if(status)
+                        return 1;
+                    parser->file_path_size = previous_file_path_size;
+                    parser->macro_if_depth = macro_if_depth;
+                    *(parser->tokenizer) = previous_tokenizer_state;
+                }
                 files_stream->size = previous_file_stream_size;
                 parser->file_path = (char*)((uint8_t*)(files_stream->data) + file_pos);
-                parser->file_path_size = previous_file_path_size;
-                parser->macro_if_depth = macro_if_depth;
-                *(parser->tokenizer) = previous_tokenizer_state;
                 parser->tokenizer->data = (char*) mc_stream_on(files_stream, file_pos + parser->file_path_size + 1);
             }
             continue;
@@ -906,7 +1309,7 @@ int parse_file(Parser* parser, Mc_stream_t* files_stream){
                     REPORT_ERROR(parser, "\n\tExpected '%c' After Label Identifier\n", ':');
                     return 1;
                 }
-                if(solve_local_label(parser->local_labels, parser->program->data, token, parser->program->size / 4)){
+                if(solve_local_label(parser->local_labels, token, parser->program->size / 4)){
                     REPORT_ERROR(parser, "\n\tCould Not Add Local Label '%.*s'\n", token.size, token.value.as_str);
                     return 1;
                 }
@@ -919,7 +1322,10 @@ int parse_file(Parser* parser, Mc_stream_t* files_stream){
             const Token next_token = get_next_token(parser->tokenizer);
             if((next_token.type == TKN_SPECIAL_SYM) && (token.type == TKN_RAW)){
                 if(next_token.value.as_char == ':'){
-                    if(add_label(parser->labels, token, (Token){.value.as_uint = parser->program->size / 4, .type = TKN_INST_POSITION}))
+                    // a global label ends the local scope, which may grow before the label is placed
+                    if(parser_close_local_scope(parser))
+                        return 1;
+                    if(parser_add_label(parser, token, (Token){.value.as_uint = parser->program->size / 4, .type = TKN_INST_POSITION}))
                     {
                         REPORT_ERROR(
                             parser,
@@ -928,16 +1334,6 @@ int parse_file(Parser* parser, Mc_stream_t* files_stream){
                         );
                         return 1;
                     }
-                    if(parser->local_labels){
-                        const Label* unsolved_local_label = get_missing_local_label(parser->local_labels);
-                        if(unsolved_local_label){
-                            const Label l = get_label_from_raw_data(parser->local_labels->data);
-                            const char* const unsolved_local_label_name = (char*) (((uintptr_t) unsolved_local_label) + l.str);
-                            REPORT_ERROR(parser, "\n\tUnsolved Local Label '%.*s'\n", l.size, unsolved_local_label_name);
-                            return 1;
-                        }
-                        parser->local_labels->size = 0;
-                    }
                     continue;
                 }
             }
@@ -945,12 +1341,14 @@ int parse_file(Parser* parser, Mc_stream_t* files_stream){
             return 1;
         }
         
-        const Inst inst = parse_inst(parser, inst_profile, (StringView){.str = token.value.as_str, .size = token.size});
+        Inst payload[2];
+        const Inst inst = parse_inst(parser, inst_profile, (StringView){.str = token.value.as_str, .size = token.size}, payload);
 
         if(inst == INST_ERROR){
             return 1;
         }
         mc_stream(parser->program, &inst, sizeof(inst));
+        mc_stream(parser->program, payload, sizeof(Inst) * get_inst_payload_size(inst & 0xFF));
     }
 
     if(token.type == TKN_ERROR){
@@ -958,18 +1356,7 @@ int parse_file(Parser* parser, Mc_stream_t* files_stream){
         return 1;
     }
 
-    if(parser->local_labels){
-        const Label* unsolved_local_label = get_missing_local_label(parser->local_labels);
-        if(unsolved_local_label){
-            const Label l = get_label_from_raw_data(parser->local_labels->data);
-            const char* const unsolved_local_label_name = (char*) (((uintptr_t) unsolved_local_label) + l.str);
-            REPORT_ERROR(parser, "\n\tUnsolved Local Label '%.*s'\n", l.size, unsolved_local_label_name);
-            return 1;
-        }
-        parser->local_labels->size = 0;
-    }
-
-    return 0;
+    return parser_close_local_scope(parser);
 }
 
 
@@ -0,0 +1,307 @@
+#ifndef VPROFILER_C
+#define VPROFILER_C
+
+// execution profiler used by execute when -profile is passed
+//
+// the profiled program runs on its own loop around perform_inst, so none of the engines pay anything for it
+// when profiling is off. It counts how many times every instruction and every opcode executed and how many
+// instructions executed inside every label range (from a label's position up to the next label's), the
+// ranges come from the labels field exported by the assembler. Calls are followed through a tree of
+// frames (one per call path, named after the label range of the callee) that is written as collapsed
+// stacks ("frame;frame;frame count" lines) for flamegraph tools.
+
+#include "core.h"
+#include "labels.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <inttypes.h>
+
+// deeper call paths are folded into their parent frame
+#define PROFILE_MAX_DEPTH 512
+
+typedef struct ProfileLabel{
+    uint64_t    position;
+    const char* name;
+    uint32_t    name_size;
+} ProfileLabel;
+
+typedef struct ProfileFrame{
+    // index in Profile.labels (Profile.label_count for instructions before the first label)
+    uint64_t label;
+    uint64_t parent;
+    uint64_t first_child;
+    uint64_t next_sibling;
+    // instructions executed in this frame (not counting its callees)
+    uint64_t self;
+    uint32_t depth;
+} ProfileFrame;
+
+#define PROFILE_NO_FRAME 0xFFFFFFFFFFFFFFFF
+
+typedef struct Profile{
+    uint64_t        program_size;
+    uint64_t        total;
+    // executions per instruction index
+    uint64_t*       inst_counts;
+    // executions per opcode, invalid opcodes are counted in the last slot
+    uint64_t        op_counts[INST_TOTAL_COUNT + 1];
+    // sorted by position
+    ProfileLabel*   labels;
+    uint64_t        label_count;
+    // executions per label range, the last slot is for instructions before the first label
+    uint64_t*       label_counts;
+    ProfileFrame*   frames;
+    uint64_t        frame_count;
+    uint64_t        frame_capacity;
+} Profile;
+
+static int _compare_profile_labels(const void* a, const void* b){
+    const uint64_t pa = ((const ProfileLabel*) a)->position;
+    const uint64_t pb = ((const ProfileLabel*) b)->position;
+    return (pa > pb) - (pa < pb);
+}
+
+// index of the label range ip is in, or profile->label_count if ip is before every label
+static inline uint64_t get_profile_label(const Profile* profile, uint64_t ip){
+    uint64_t begin = 0;
+    uint64_t end = profile->label_count;
+    while(begin < end){
+        const uint64_t middle = begin + (end - begin) / 2;
+        if(profile->labels[middle].position <= ip) begin = middle + 1;
+        else end = middle;
+    }
+    return begin? begin - 1 : profile->label_count;
+}
+
+static inline void print_profile_label(FILE* output, const Profile* profile, uint64_t label){
+    if(label < profile->label_count)
+        fprintf(output, "%.*s", (int) profile->labels[label].name_size, profile->labels[label].name);
+    else
+        fprintf(output, "[no label]");
+}
+
+static uint64_t add_profile_frame(Profile* profile, uint64_t parent, uint64_t label){
+    if(profile->frame_count == profile->frame_capacity){
+        profile->frame_capacity = profile->frame_capacity? profile->frame_capacity * 2 : 64;
+        ProfileFrame* const frames = (ProfileFrame*) realloc(profile->frames, profile->frame_capacity * sizeof(ProfileFrame));
+        if(!frames) return PROFILE_NO_FRAME;
+        profile->frames = frames;
+    }
+    const uint64_t frame = profile->frame_count++;
+    profile->frames[frame] = (ProfileFrame){
+        .label = label,
+        .parent = parent,
+        .first_child = PROFILE_NO_FRAME,
+        .next_sibling = PROFILE_NO_FRAME,
+        .self = 0,
+        .depth = (parent == PROFILE_NO_FRAME)? 0 : profile->frames[parent].depth + 1
+    };
+    if(parent != PROFILE_NO_FRAME){
+        profile->frames[frame].next_sibling = profile->frames[parent].first_child;
+        profile->frames[parent].first_child = frame;
+    }
+    return frame;
+}
+
+// the child of frame for label, created if needed
+static uint64_t enter_profile_frame(Profile* profile, uint64_t frame, uint64_t label){
+    if(profile->frames[frame].depth + 1 >= PROFILE_MAX_DEPTH) return frame;
+    for(uint64_t child = profile->frames[frame].first_child; child != PROFILE_NO_FRAME; child = profile->frames[child].next_sibling){
+        if(profile->frames[child].label == label) return child;
+    }
+    const uint64_t child = add_profile_frame(profile, frame, label);
+    return (child == PROFILE_NO_FRAME)? frame : child;
+}
+
+void free_profile(Profile* profile){
+    free(profile->inst_counts);
+    free(profile->labels);
+    free(profile->label_counts);
+    free(profile->frames);
+    *profile = (Profile){0};
+}
+
+// \param labels the raw labels stream (the labels field without its header), may be NULL
+// \returns 0 on success or 1 otherwise
+int init_profile(Profile* profile, uint64_t program_size, uint64_t entry_point, const void* labels, uint64_t labels_size){
+    *profile = (Profile){0};
+    profile->program_size = program_size;
+
+    // the code after %start usually has no label of its own and would be counted as part of the label before it
+    int entry_has_label = 0;
+    for(uint64_t i = 0; labels && i < labels_size; ){
+        const Label label = get_label_from_raw_data((const uint8_t*) labels + i);
+        if(label.size == 0) break;
+        if(label.type == TKN_INST_POSITION && label.definition.as_uint < program_size){
+            profile->label_count += 1;
+            entry_has_label |= label.definition.as_uint == entry_point;
+        }
+        i += label.size;
+    }
+    if(!entry_has_label && entry_point < program_size) profile->label_count += 1;
+
+    profile->inst_counts  = (uint64_t*) calloc(program_size? program_size : 1, sizeof(uint64_t));
+    profile->labels       = (ProfileLabel*) calloc(profile->label_count? profile->label_count : 1, sizeof(ProfileLabel));
+    profile->label_counts = (uint64_t*) calloc(profile->label_count + 1, sizeof(uint64_t));
+    if(!profile->inst_counts || !profile->labels || !profile->label_counts){
+        fprintf(stderr, "[ERROR] Could Not Allocate Memory For The Profiler\n");
+        free_profile(profile);
+        return 1;
+    }
+
+    uint64_t l = 0;
+    for(uint64_t i = 0; labels && i < labels_size; ){
+        const uint8_t* const label_ptr = (const uint8_t*) labels + i;
+        const Label label = get_label_from_raw_data(label_ptr);
+        if(label.size == 0) break;
+        if(label.type == TKN_INST_POSITION && label.definition.as_uint < program_size){
+            profile->labels[l++] = (ProfileLabel){
+                .position = label.definition.as_uint,
+                .name = (const char*) (label_ptr + label.str),
+                .name_size = label.str_size
+            };
+        }
+        i += label.size;
+    }
+    if(!entry_has_label && entry_point < program_size){
+        profile->labels[l++] = (ProfileLabel){.position = entry_point, .name = "[entry]", .name_size = sizeof("[entry]") - 1};
+    }
+    qsort(profile->labels, profile->label_count, sizeof(ProfileLabel), _compare_profile_labels);
+
+    return 0;
+}
+
+// runs the program loaded in vpu from entry_point with perform_inst, counting everything it executes in profile
+void run_profiled(VPU* vpu, Profile* profile, uint64_t entry_point){
+
+    Register* const registers = (Register*) vpu->register_space;
+    const uint64_t program_size = profile->program_size;
+
+    uint64_t frame = add_profile_frame(profile, PROFILE_NO_FRAME, get_profile_label(profile, entry_point));
+    if(frame == PROFILE_NO_FRAME){
+        fprintf(stderr, "[ERROR] Could Not Allocate Memory For The Profiler\n");
+        vpu->status = 1;
+        return;
+    }
+
+    for(registers[RIP >> 3].as_uint64 = entry_point; registers[RIP >> 3].as_uint64 < program_size; ){
+        const uint64_t ip = registers[RIP >> 3].as_uint64;
+        const Inst inst = vpu->program[ip];
+        const uint8_t opcode = (uint8_t) inst;
+
+        profile->total += 1;
+        profile->inst_counts[ip] += 1;
+        profile->op_counts[(opcode < INST_TOTAL_COUNT)? opcode : INST_TOTAL_COUNT] += 1;
+        profile->label_counts[get_profile_label(profile, ip)] += 1;
+        profile->frames[frame].self += 1;
+
+        registers[RIP >> 3].as_int64 += perform_inst(vpu, inst);
+
+        if(opcode == INST_CALL && registers[RIP >> 3].as_uint64 < program_size){
+            frame = enter_profile_frame(profile, frame, get_profile_label(profile, registers[RIP >> 3].as_uint64));
+        }
+        else if(opcode == INST_RET && profile->frames[frame].parent != PROFILE_NO_FRAME){
+            frame = profile->frames[frame].parent;
+        }
+    }
+}
+
+// sorts the indices in [0, count) by counts (descending) and returns how many of them are not 0
+static uint64_t _sort_profile_counts(uint64_t* indices, const uint64_t* counts, uint64_t count){
+    uint64_t non_zero = 0;
+    for(uint64_t i = 0; i < count; i+=1){
+        if(counts[i]) indices[non_zero++] = i;
+    }
+    // insertion sort over the executed entries only, the reports are short and run once
+    for(uint64_t i = 1; i < non_zero; i+=1){
+        const uint64_t index = indices[i];
+        uint64_t j = i;
+        for(; j > 0 && counts[indices[j - 1]] < counts[index]; j-=1) indices[j] = indices[j - 1];
+        indices[j] = index;
+    }
+    return non_zero;
+}
+
+// prints the hot spots of profile (hottest label ranges, opcodes and instructions of program), at most top lines each
+void report_profile(FILE* output, const Profile* profile, const Inst* program, uint64_t top){
+
+    const double total = profile->total? (double) profile->total : 1.0;
+
+    uint64_t max_entries = profile->program_size;
+    if(max_entries < INST_TOTAL_COUNT + 1) max_entries = INST_TOTAL_COUNT + 1;
+    if(max_entries < profile->label_count + 1) max_entries = profile->label_count + 1;
+    uint64_t* const indices = (uint64_t*) malloc(max_entries * sizeof(uint64_t));
+    if(!indices){
+        fprintf(stderr, "[ERROR] Could Not Allocate Memory For The Profile Report\n");
+        return;
+    }
+
+    fprintf(output, "[PROFILE] %"PRIu64" instructions executed\n", profile->total);
+
+    uint64_t count = _sort_profile_counts(indices, profile->label_counts, profile->label_count + 1);
+    fprintf(output, "[PROFILE] label ranges:\n");
+    for(uint64_t i = 0; i < count && i < top; i+=1){
+        const uint64_t label = indices[i];
+        fprintf(output, "    %14"PRIu64" %6.2f%%  ", profile->label_counts[label], 100.0 * (double) profile->label_counts[label] / total);
+        print_profile_label(output, profile, label);
+        fprintf(output, "\n");
+    }
+
+    count = _sort_profile_counts(indices, profile->op_counts, INST_TOTAL_COUNT + 1);
+    fprintf(output, "[PROFILE] opcodes:\n");
+    for(uint64_t i = 0; i < count && i < top; i+=1){
+        const uint64_t opcode = indices[i];
+        fprintf(output, "    %14"PRIu64" %6.2f%%  %s\n",
+            profile->op_counts[opcode], 100.0 * (double) profile->op_counts[opcode] / total,
+            (opcode < INST_TOTAL_COUNT)? get_inst_name((int) opcode) : "(invalid)"
+        );
+    }
+
+    count = _sort_profile_counts(indices, profile->inst_counts, profile->program_size);
+    fprintf(output, "[PROFILE] instructions:\n");
+    for(uint64_t i = 0; i < count && i < top; i+=1){
+        const uint64_t ip = indices[i];
+        const uint64_t label = get_profile_label(profile, ip);
+        fprintf(output, "    %14"PRIu64" %6.2f%%  %8"PRIu64"  %-8s ",
+            profile->inst_counts[ip], 100.0 * (double) profile->inst_counts[ip] / total, ip, get_inst_name((int)(uint8_t) program[ip])
+        );
+        print_profile_label(output, profile, label);
+        if(label < profile->label_count) fprintf(output, "+%"PRIu64, ip - profile->labels[label].position);
+        fprintf(output, "\n");
+    }
+
+    free(indices);
+}
+
+// writes the call tree of profile as collapsed stacks, one "frame;frame;frame count" line per call path
+// \returns 0 on success or 1 otherwise
+int write_profile_stacks(const char* path, const Profile* profile){
+
+    FILE* const output = fopen(path, "w");
+    if(!output){
+        fprintf(stderr, "[ERROR] Could Not Open '%s'\n", path);
+        return 1;
+    }
+
+    uint64_t path_frames[PROFILE_MAX_DEPTH];
+
+    for(uint64_t f = 0; f < profile->frame_count; f+=1){
+        if(!profile->frames[f].self) continue;
+        uint64_t depth = 0;
+        for(uint64_t p = f; p != PROFILE_NO_FRAME && depth < PROFILE_MAX_DEPTH; p = profile->frames[p].parent){
+            path_frames[depth++] = p;
+        }
+        while(depth--){
+            print_profile_label(output, profile, profile->frames[path_frames[depth]].label);
+            fputc(depth? ';' : ' ', output);
+        }
+        fprintf(output, "%"PRIu64"\n", profile->frames[f].self);
+    }
+
+    const int err = ferror(output);
+    fclose(output);
+    if(err) fprintf(stderr, "[ERROR] Could Not Write Profile Stacks To '%s'\n", path);
+    return err? 1 : 0;
+}
+
+#endif // END OF FILE VPROFILER_C =================================================
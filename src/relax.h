@@ -0,0 +1,198 @@
+#ifndef VIRTUAL_RELAX_H
+#define VIRTUAL_RELAX_H
+
+/*
+ * branch relaxation
+ *
+ * JMP, JMPF, JMPFN and CALL with a literal offset reach 32K instructions in either direction, their wide forms
+ * (JMPW, JMPFW, JMPFNW and CALLW, see get_far_branch) reach any instruction for one more word, the container with
+ * the high bits of their offset. the assembler picks the short form whenever it reaches and the wide one otherwise.
+ *
+ * the distance to a local label is only known once the label is defined, so the relative references made inside
+ * a local scope (the instructions between two global labels of a file) are recorded and the scope is laid out when
+ * it closes: every branch starts short, the ones that don't reach their target grow and, as growing moves what
+ * comes after them, that is repeated until no branch has to grow anymore (branches never shrink back, so it ends).
+ * the scope is then rewritten once with the grown branches and every recorded offset is written.
+ * a scope has no global label in it, so only the positions inside it move, the relocations and the entry point that
+ * fall in it move with them. programs that never needed a wide branch are assembled exactly as they were.
+ */
+
+#include "core.h"
+#include "labels.h"
+#include "object.h"
+#include <stdlib.h>
+#include <inttypes.h>
+
+typedef enum RelativeRefFlags{
+    // a 16 bit literal at byte of the instruction
+    RELATIVE_REF_SHORT      = 0,
+    // a short JMP, JMPF, JMPFN or CALL that becomes its wide form if it doesn't reach
+    RELATIVE_REF_RELAXABLE  = 1 << 0,
+    // the wide literal of the instruction (see set_wide_literal)
+    RELATIVE_REF_WIDE       = 1 << 1,
+    // a relaxable branch that had to grow
+    RELATIVE_REF_GROWN      = 1 << 2,
+} RelativeRefFlags;
+
+typedef struct RelativeRef{
+    // the instruction with the reference, where it was assembled
+    uint64_t inst;
+    // the instruction referenced, where it was assembled
+    uint64_t target;
+    // position + 1 of the referenced label in the local label stream, 0 if target is already known
+    uint64_t local_label;
+    // how many of the branches before this one grew, only meaningful while relaxing
+    uint64_t shift;
+    // the byte of the literal in the instruction
+    uint8_t  byte;
+    uint8_t  flags;
+} RelativeRef;
+
+typedef struct LocalScope{
+    // the RelativeRefs of the scope, in the order of their instructions
+    Mc_stream_t refs;
+    // the first instruction of the scope
+    uint64_t    begin;
+    // the size of the relocation stream when the scope opened
+    uint64_t    relocations;
+} LocalScope;
+
+static inline void push_relative_ref(LocalScope* scope, const RelativeRef ref){
+    mc_stream(&scope->refs, &ref, sizeof(ref));
+}
+
+// \returns where position is once the branches that grew (counted in the shifts of refs) are wide
+static inline uint64_t _relaxed_position(const RelativeRef* refs, uint64_t count, uint64_t grown, uint64_t position){
+    uint64_t low = 0, high = count;
+    while(low < high){
+        const uint64_t middle = low + (high - low) / 2;
+        if(refs[middle].inst < position) low = middle + 1;
+        else high = middle;
+    }
+    return position + ((low < count)? refs[low].shift : grown);
+}
+
+// \returns how many branches grew, counting them in the shift of every ref
+static inline uint64_t _count_grown_branches(RelativeRef* refs, uint64_t count){
+    uint64_t grown = 0;
+    for(uint64_t i = 0; i < count; i+=1){
+        refs[i].shift = grown;
+        grown += (refs[i].flags & RELATIVE_REF_GROWN)? 1 : 0;
+    }
+    return grown;
+}
+
+// lays out the scope that ends at the end of program (see the top of the file), resolving its local references
+// with local_labels, moving the relocations of the scope and the entry point if it is in the scope,
+// then opens a new scope at the end of program
+// every label the scope references has to be resolved already (see get_missing_local_label)
+// \returns 0 on success or 1 if a reference that can't grow does not reach its target
+int close_local_scope(LocalScope* scope, Mc_stream_t* local_labels, Mc_stream_t* program, Mc_stream_t* relocations, uint64_t* entry_point){
+
+    RelativeRef* const refs = (RelativeRef*) scope->refs.data;
+    const uint64_t count = scope->refs.size / sizeof(RelativeRef);
+    const uint64_t end = program->size / sizeof(Inst);
+    int status = 0;
+
+    for(uint64_t i = 0; i < count; i+=1){
+        if(!refs[i].local_label) continue;
+        const Label label = get_label_from_raw_data((uint8_t*) local_labels->data + refs[i].local_label - 1);
+        refs[i].target = label.definition.as_uint;
+    }
+
+    uint64_t grown = 0;
+    for(int changed = 1; changed; ){
+        changed = 0;
+        grown = _count_grown_branches(refs, count);
+        for(uint64_t i = 0; i < count; i+=1){
+            if((refs[i].flags & (RELATIVE_REF_RELAXABLE | RELATIVE_REF_GROWN)) != RELATIVE_REF_RELAXABLE) continue;
+            const int64_t distance = (int64_t) (_relaxed_position(refs, count, grown, refs[i].target)
+                - _relaxed_position(refs, count, grown, refs[i].inst));
+            if(distance == (int16_t) distance) continue;
+            refs[i].flags |= RELATIVE_REF_GROWN;
+            changed = 1;
+        }
+    }
+
+    if(grown){
+        const uint64_t size = (end - scope->begin) * sizeof(Inst);
+        Inst* const old = (Inst*) malloc((size_t) size);
+        if(!old){
+            fprintf(stderr, "[ERROR] Could Not Allocate Memory To Relax The Branches Of %"PRIu64" Instructions\n", end - scope->begin);
+            return 1;
+        }
+        memcpy(old, mc_stream_on(program, scope->begin * sizeof(Inst)), (size_t) size);
+        // reserves the containers of the grown branches
+        program->size += grown * sizeof(Inst);
+        mc_stream(program, &program, 0);
+        Inst* const code = (Inst*) program->data;
+
+        uint64_t from = scope->begin;
+        Inst* to = code + scope->begin;
+        for(uint64_t i = 0; i < count; i+=1){
+            if(!(refs[i].flags & RELATIVE_REF_GROWN)) continue;
+            const uint64_t inst = refs[i].inst;
+            memcpy(to, old + (from - scope->begin), (size_t) (inst - from) * sizeof(Inst));
+            to += inst - from;
+            const Inst branch = old[inst - scope->begin];
+            // JMPF and JMPFN keep their register, the short offset is replaced by the wide one
+            to[0] = get_far_branch(branch & 0XFF) | (branch & ((Inst) 0XFFFFFFFF >> (32 - 8 * refs[i].byte)) & ~(Inst) 0XFF);
+            to[1] = INST_CONTAINER;
+            to += 2;
+            from = inst + 1;
+            refs[i].byte = 2;
+            refs[i].flags |= RELATIVE_REF_WIDE;
+        }
+        memcpy(to, old + (from - scope->begin), (size_t) (end - from) * sizeof(Inst));
+        free(old);
+    }
+
+    Inst* const code = (Inst*) program->data;
+    for(uint64_t i = 0; i < count; i+=1){
+        const uint64_t inst = _relaxed_position(refs, count, grown, refs[i].inst);
+        const int64_t distance = (int64_t) (_relaxed_position(refs, count, grown, refs[i].target) - inst);
+        if(refs[i].flags & RELATIVE_REF_WIDE){
+            if(!fits_wide_literal(code[inst] & 0XFF, (uint64_t) distance)){
+                fprintf(
+                    stderr, "[ERROR] The Target Of The %s At Instruction %"PRIu64" Is Too Far, %"PRIi64" Does Not Fit In 32 Bits\n",
+                    get_inst_name(code[inst] & 0XFF), inst, distance
+                );
+                status = 1;
+                continue;
+            }
+            set_wide_literal(code + inst, (uint64_t) distance);
+            continue;
+        }
+        if(distance != (int16_t) distance){
+            fprintf(
+                stderr, "[ERROR] The Target Of The %s At Instruction %"PRIu64" Is Too Far, %"PRIi64" Does Not Fit In 16 Bits\n",
+                get_inst_name(code[inst] & 0XFF), inst, distance
+            );
+            status = 1;
+            continue;
+        }
+        const int16_t literal = (int16_t) distance;
+        memcpy((uint8_t*) (code + inst) + refs[i].byte, &literal, sizeof(literal));
+    }
+
+    if(grown){
+        if(*entry_point >= scope->begin && *entry_point <= end)
+            *entry_point = _relaxed_position(refs, count, grown, *entry_point);
+        for(uint64_t position = scope->relocations; relocations && position < relocations->size; ){
+            ObjectRelocation relocation;
+            const uint64_t next = get_object_relocation((const uint8_t*) relocations->data, relocations->size, position, &relocation);
+            if(!next) break;
+            relocation.inst = _relaxed_position(refs, count, grown, relocation.inst);
+            memcpy((uint8_t*) relocations->data + position, &relocation.inst, sizeof(relocation.inst));
+            position = next;
+        }
+    }
+
+    local_labels->size = 0;
+    scope->refs.size = 0;
+    scope->begin = program->size / sizeof(Inst);
+    scope->relocations = relocations? relocations->size : 0;
+    return status;
+}
+
+#endif // =====================  END OF FILE VIRTUAL_RELAX_H ===========================
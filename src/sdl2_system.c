@@ -19,7 +19,7 @@ typedef struct _VThread
     void*           shared;
     int             calldepth;
     VPU             vpu;
-    Register        registers[REGISTER_SPACE_SIZE / sizeof(Register)];
+    Register        registers[VPU_REGISTER_SPACE_SIZE / sizeof(Register)];
     uint64_t        stack[1024];
 } _VThread;
 
@@ -280,6 +280,7 @@ int virtual_syscall(VPU* vpu, uint64_t call){
         _VThread* thread = virtual_alloc(sizeof(*thread));
         memset(thread, 0, sizeof(*thread));
         thread->vpu.program = vpu->program;
+        thread->vpu.program_size = vpu->program_size;
         thread->calldepth = 1;
         thread->state = SYSTEM_THREAD_STATE_ACTIVE;
         thread->vpu.static_memory = vpu->static_memory;
@@ -0,0 +1,236 @@
+#ifndef VSTACK_C
+#define VSTACK_C
+
+/*
+ * the VPU stack used by execute
+ *
+ * PUSH/POP/CALL/RET and friends index vpu->stack without any bounds check, so instead of checking every
+ * access the stack is mapped between two inaccessible guard regions: running past its end (overflow) or
+ * popping more than was pushed (underflow) touches a guard region and faults. While a program runs on a
+ * guarded stack a SIGSEGV/SIGBUS handler catches faults inside the guard regions and jumps back to
+ * execute, which reports them as a VPU error with the IP of the instruction instead of crashing.
+ * the lower guard region is big enough to catch STACK_GET/STACK_PUT reaching below the stack by their
+ * largest (16 bit) offset.
+ *
+ * the fault state is per thread, so every thread running a program on its own guarded stack (see
+ * linux_system.c) arms its own guard and a fault is reported by the thread that caused it.
+ *
+ * guards need mmap and sigaction, elsewhere the stack is a plain allocation as before.
+ */
+
+#include "core.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#if !defined(_WIN32) && (defined(__unix__) || defined(__APPLE__)) && !defined(VPU_NO_STACK_GUARD)
+    #define VPU_STACK_GUARD 1
+    #include <sys/mman.h>
+    #include <signal.h>
+    #include <setjmp.h>
+    #include <unistd.h>
+    #include <stdatomic.h>
+#else
+    #define VPU_STACK_GUARD 0
+#endif
+
+// the stack size in bytes when none is requested
+#ifndef VPU_DEFAULT_STACK_SIZE
+#define VPU_DEFAULT_STACK_SIZE (1024 * 1024)
+#endif
+
+// the largest stack size in bytes, small enough for the round-ups of create_vpu_stack not to wrap around
+#ifndef VPU_MAX_STACK_SIZE
+#define VPU_MAX_STACK_SIZE ((uint64_t) 64 * 1024 * 1024 * 1024)
+#endif
+
+// STACK_GET/STACK_PUT can reach up to this many bytes below RSP
+#define VPU_STACK_MAX_REACH (0x10000 * sizeof(uint64_t))
+
+typedef struct VpuStack{
+    uint64_t*   base;
+    // in bytes
+    uint64_t    size;
+    // the whole mapping, guard regions included (NULL when the stack is not guarded)
+    uint8_t*    mapping;
+    size_t      mapping_size;
+    size_t      lower_guard;
+    size_t      upper_guard;
+} VpuStack;
+
+// \param size in bytes, 0 for VPU_DEFAULT_STACK_SIZE, up to VPU_MAX_STACK_SIZE, rounded up to whole pages when guarded
+// \returns 0 on success or 1 otherwise
+int create_vpu_stack(VpuStack* stack, uint64_t size){
+    memset(stack, 0, sizeof(*stack));
+    if(size == 0) size = VPU_DEFAULT_STACK_SIZE;
+    if(size > VPU_MAX_STACK_SIZE){
+        fprintf(stderr, "[ERROR] Invalid Stack Size %"PRIu64" Bytes, The Largest Is %"PRIu64" Bytes\n", size, (uint64_t) VPU_MAX_STACK_SIZE);
+        return 1;
+    }
+    size = (size + sizeof(uint64_t) - 1) & ~(uint64_t)(sizeof(uint64_t) - 1);
+
+#if VPU_STACK_GUARD
+    const size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    size = (size + page - 1) & ~(uint64_t)(page - 1);
+    stack->lower_guard  = (VPU_STACK_MAX_REACH + page - 1) & ~(page - 1);
+    stack->upper_guard  = page;
+    stack->mapping_size = stack->lower_guard + (size_t) size + stack->upper_guard;
+    // the guards are only reserved, the stack itself is committed as it is touched
+    void* const mapping = mmap(NULL, stack->mapping_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(mapping == MAP_FAILED){
+        fprintf(stderr, "[ERROR] Could Not Map A %"PRIu64" Bytes Stack\n", size);
+        memset(stack, 0, sizeof(*stack));
+        return 1;
+    }
+    stack->mapping = (uint8_t*) mapping;
+    if(mprotect(stack->mapping + stack->lower_guard, (size_t) size, PROT_READ | PROT_WRITE)){
+        fprintf(stderr, "[ERROR] Could Not Make The Stack Writable\n");
+        munmap(mapping, stack->mapping_size);
+        memset(stack, 0, sizeof(*stack));
+        return 1;
+    }
+    stack->base = (uint64_t*) (stack->mapping + stack->lower_guard);
+#else
+    stack->base = (uint64_t*) calloc((size_t) size, 1);
+    if(!stack->base){
+        fprintf(stderr, "[ERROR] Could Not Allocate A %"PRIu64" Bytes Stack\n", size);
+        return 1;
+    }
+#endif
+    stack->size = size;
+    return 0;
+}
+
+void destroy_vpu_stack(VpuStack* stack){
+#if VPU_STACK_GUARD
+    if(stack->mapping) munmap(stack->mapping, stack->mapping_size);
+#else
+    free(stack->base);
+#endif
+    memset(stack, 0, sizeof(*stack));
+}
+
+typedef enum VpuStackFaultKind{
+    VPU_STACK_NO_FAULT = 0,
+    VPU_STACK_OVERFLOW,
+    VPU_STACK_UNDERFLOW
+} VpuStackFaultKind;
+
+// maps the native pc of a fault inside generated code (the jit) to the IP of its instruction,
+// \returns 0 if pc is not in the generated code
+typedef int (*VpuNativeIp)(const void* context, uintptr_t pc, uint64_t* ip);
+
+#if VPU_STACK_GUARD
+
+// the stack the fault handler runs on in threads that set one, see push_vpu_signal_stack
+#ifndef VPU_SIGNAL_STACK_SIZE
+#define VPU_SIGNAL_STACK_SIZE (64 * 1024)
+#endif
+
+// everything the fault handler needs about the program being run on this thread, set by execute and run_program
+static _Thread_local struct{
+    const VpuStack*         stack;
+    const VPU*              vpu;
+    VpuNativeIp             native_ip;
+    const void*             native_context;
+    sigjmp_buf              jump;
+    volatile sig_atomic_t   armed;
+    volatile sig_atomic_t   kind;
+    volatile uint64_t       ip;
+} vpu_stack_fault;
+
+static inline uintptr_t _get_fault_pc(void* context){
+    const ucontext_t* const uc = (const ucontext_t*) context;
+#if defined(__linux__) && defined(__x86_64__)
+    // REG_RIP needs _GNU_SOURCE, its value is fixed by the x86-64 linux ABI
+    return (uintptr_t) uc->uc_mcontext.gregs[16];
+#elif defined(__APPLE__) && defined(__x86_64__)
+    return (uintptr_t) uc->uc_mcontext->__ss.__rip;
+#else
+    (void) uc;
+    return 0;
+#endif
+}
+
+static void _vpu_stack_fault_handler(int signal_number, siginfo_t* info, void* context){
+    const uint8_t* const address = (const uint8_t*) info->si_addr;
+    const VpuStack* const stack = vpu_stack_fault.stack;
+    if(vpu_stack_fault.armed && stack && address >= stack->mapping && address < stack->mapping + stack->mapping_size){
+        uint64_t ip = ((const Register*) vpu_stack_fault.vpu->register_space)[RIP >> 3].as_uint64;
+        if(vpu_stack_fault.native_ip) vpu_stack_fault.native_ip(vpu_stack_fault.native_context, _get_fault_pc(context), &ip);
+        vpu_stack_fault.ip = ip;
+        vpu_stack_fault.kind = (address < (const uint8_t*) stack->base)? VPU_STACK_UNDERFLOW : VPU_STACK_OVERFLOW;
+        vpu_stack_fault.armed = 0;
+        siglongjmp(vpu_stack_fault.jump, 1);
+    }
+    // not ours, let it crash as it would have without the handler
+    signal(signal_number, SIG_DFL);
+}
+
+// installs the fault handler (once) and starts watching stack for vpu,
+// must be followed by sigsetjmp(vpu_stack_fault.jump, 1) in the function running the program
+static inline void arm_vpu_stack_guard(const VPU* vpu, const VpuStack* stack){
+    static atomic_flag installed = ATOMIC_FLAG_INIT;
+    if(!atomic_flag_test_and_set(&installed)){
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_sigaction = _vpu_stack_fault_handler;
+        // threads without a signal stack of their own stay on their native stack
+        action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGSEGV, &action, NULL);
+        sigaction(SIGBUS, &action, NULL);
+    }
+    vpu_stack_fault.vpu = vpu;
+    vpu_stack_fault.stack = stack;
+    vpu_stack_fault.native_ip = NULL;
+    vpu_stack_fault.native_context = NULL;
+    vpu_stack_fault.kind = VPU_STACK_NO_FAULT;
+    vpu_stack_fault.armed = 1;
+}
+
+static inline void disarm_vpu_stack_guard(void){
+    vpu_stack_fault.armed = 0;
+    vpu_stack_fault.stack = NULL;
+    vpu_stack_fault.native_ip = NULL;
+}
+
+// gives the calling thread a stack of its own for the fault handler
+// \returns it for pop_vpu_signal_stack or NULL if it could not be set (the handler then runs on the thread's stack)
+static inline void* push_vpu_signal_stack(void){
+    stack_t signal_stack;
+    memset(&signal_stack, 0, sizeof(signal_stack));
+    signal_stack.ss_sp = malloc(VPU_SIGNAL_STACK_SIZE);
+    signal_stack.ss_size = VPU_SIGNAL_STACK_SIZE;
+    if(signal_stack.ss_sp && sigaltstack(&signal_stack, NULL)){
+        free(signal_stack.ss_sp);
+        return NULL;
+    }
+    return signal_stack.ss_sp;
+}
+
+static inline void pop_vpu_signal_stack(void* stack){
+    if(!stack) return;
+    stack_t signal_stack;
+    memset(&signal_stack, 0, sizeof(signal_stack));
+    signal_stack.ss_flags = SS_DISABLE;
+    sigaltstack(&signal_stack, NULL);
+    free(stack);
+}
+
+// while set, faults inside generated code are attributed to the instruction native_ip maps them to
+static inline void watch_native_code(VpuNativeIp native_ip, const void* context){
+    vpu_stack_fault.native_context = context;
+    vpu_stack_fault.native_ip = native_ip;
+}
+
+#else
+
+static inline void watch_native_code(VpuNativeIp native_ip, const void* context){
+    (void) native_ip; (void) context;
+}
+
+#endif // END OF #if VPU_STACK_GUARD
+
+#endif // END OF FILE VSTACK_C =================================================
@@ -12,12 +12,25 @@
 #include "core.h"
 #include "system.h"
 
+// threads, mutexes, condition variables and sleep are pthread based where there are pthreads (see linux_system.c)
+// and no-ops elsewhere, VPU_NO_SYSTEM_THREADS leaves them as no-ops everywhere
+#if !defined(_WIN32) && (defined(__unix__) || defined(__APPLE__)) && !defined(VPU_NO_SYSTEM_THREADS)
+    #define VPU_SYSTEM_THREADS 1
+    #include "linux_system.c"
+#else
+    #define VPU_SYSTEM_THREADS 0
+#endif
+
 typedef struct VSystem
 {
     uint32_t* display;
     uint32_t  display_width;
     uint32_t  display_height;
 
+#if VPU_SYSTEM_THREADS
+    VThreads  threads;
+#endif
+
 } VSystem;
 
 
@@ -73,10 +86,21 @@ int virtual_syscall(VPU* vpu, uint64_t call){
         }
         system->display_width  = GET_REG(registers, RA)->as_uint32;
         system->display_height = GET_REG(registers, RA4)->as_uint32;
+#if VPU_SYSTEM_THREADS
+        if(init_vthreads(&system->threads)){
+            virtual_free(system->display);
+            virtual_free(system);
+            return 1;
+        }
+#endif
         vpu->system = system;
     }
         return 0;
     case VSYS_CLOSE:
+#if VPU_SYSTEM_THREADS
+        close_vthreads(&((VSystem*) vpu->system)->threads);
+#endif
+        virtual_free(((VSystem*) vpu->system)->display);
         virtual_free(vpu->system);
         vpu->system = NULL;
         return 0;
@@ -137,13 +161,33 @@ int virtual_syscall(VPU* vpu, uint64_t call){
         GET_REG(registers, RC)->as_ptr = stderr;
         return 0;
     
-    // no threads...
+    // threads
 
+#if VPU_SYSTEM_THREADS
+    case VSYS_NEW_THREAD:
+    case VSYS_WAIT_THREAD:
+    case VSYS_DETACH_THREAD:
+    case VSYS_KILL_THREAD:
+    case VSYS_CREATE_MUTEX:
+    case VSYS_DESTROY_MUTEX:
+    case VSYS_LOCK_MUTEX:
+    case VSYS_UNLOCK_MUTEX:
+    case VSYS_CREATE_COND:
+    case VSYS_DESTROY_COND:
+    case VSYS_SIGNAL_COND:
+    case VSYS_BROADCAST_COND:
+    case VSYS_WAIT_COND:
+    case VSYS_SLEEP:
+    case VSYS_GET_TIME:
+        return vthread_syscall(&((VSystem*) vpu->system)->threads, vpu, call);
+#else
+    // no threads...
     case VSYS_NEW_THREAD:
     case VSYS_WAIT_THREAD:
     case VSYS_DETACH_THREAD:
     case VSYS_SLEEP:
         return 0;
+#endif
 
     case VSYS_GET_DISPLAY_FRAMEBUFFER:{
         const VSystem* const system = (const VSystem*) vpu->system;
@@ -0,0 +1,1121 @@
+#ifndef VTHREADED_C
+#define VTHREADED_C
+
+/*
+ * threaded engine:
+ * an alternative to the perform_inst loop in execute. the program is decoded once at load time (decode_program)
+ * into an array of DecodedInst holding the handler, direct register pointers and extended literals,
+ * each handler then jumps straight to the handler of the next instruction instead of returning to the loop.
+ * with gcc and clang the jump is a computed goto (labels as values), other compilers fall back to a switch
+ * over the same handlers, define VPU_NO_COMPUTED_GOTO to force the fallback.
+ * perform_inst is still the semantic reference, rare instructions (EXEC, SYS, DISREG) are delegated to it.
+ * execution contract of the decoded program, which keeps the per instruction work of the handlers to the instruction itself:
+ *      R0 is never cleared while running, decode_program points every operand that R0 would be written through
+ *      to a sink instead, so R0 stays 0 (writing to R0 through a pointer, e.g. one made with GRP, is not undone)
+ *      a TRAP record is placed right after the program, so falling through the last instruction needs no bounds check
+ *      jumps and branches with literal offsets go straight to the record decoded for their target (the TRAP if
+ *      the target is outside of the program), only jumps through registers, RET and instructions that may write
+ *      to RIP go through a checked dispatch from RIP
+ *      instructions naming RIP as an operand are delegated to perform_inst, so every other handler can assume
+ *      RIP is only changed by control flow
+ *      HALT, the TRAP and failures leave run_threaded directly
+ *      a program that can be stopped from another thread (poll_program) checks for it only in the checked dispatch,
+ *      every jump and call with a literal target at or before itself goes through it, so loops are still stopped
+ */
+
+#include "core.h"
+#include "system.h"
+#include "vector.c"
+#include "bulk.c"
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdatomic.h>
+
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(VPU_NO_COMPUTED_GOTO)
+    #define VPU_COMPUTED_GOTO 1
+#else
+    #define VPU_COMPUTED_GOTO 0
+#endif
+
+// opcodes whose handler has the same name as the instruction
+#define VPU_THREADED_OPS(X)                                                                     \
+    X(NOP) X(MOV8) X(MOV16) X(MOV32) X(MOV) X(MOVC) X(MOVV) X(MOVV16)                           \
+    X(POP) X(STACK_GET) X(STACK_PUT) X(GSP)                                                     \
+    X(READ8) X(READ16) X(READ32) X(READ) X(MREADS)                                              \
+    X(WRITE8) X(WRITE16) X(WRITE32) X(WRITE) X(MWRITES) X(MMOVS) X(MEMCMP)                      \
+    X(MSTRLEN) X(MCHR) X(MFILL32) X(MFILL64) X(MCRC32) X(MHASH) X(MPOPCNT)                      \
+    X(NOT) X(NEG) X(AND) X(NAND) X(OR) X(XOR) X(BSHIFT)                                         \
+    X(JMPF) X(JMPFN) X(RET)                                                                     \
+    X(ADD8) X(SUB8) X(MUL8) X(ADD16) X(SUB16) X(MUL16) X(ADD32) X(SUB32) X(MUL32)               \
+    X(ADD) X(SUB) X(MUL) X(DIVI) X(DIVU) X(ADDF) X(SUBF) X(MULF) X(DIVF)                        \
+    X(INC) X(DEC) X(INCF) X(DECF) X(ABS) X(ABSF)                                                \
+    X(NEQ) X(EQ) X(EQF) X(BIGI) X(BIGU) X(BIGF) X(SMLI) X(SMLU) X(SMLF)                         \
+    X(CASTIU) X(CASTIF) X(CASTUI) X(CASTUF) X(CASTFI) X(CASTFU) X(CF3264) X(CF6432) X(FLOAT)    \
+    X(FMAF) X(SQRTF) X(MINF) X(MAXF) X(FLOORF) X(CEILF) X(ROUNDF)                              \
+    X(ADDF32) X(SUBF32) X(MULF32) X(DIVF32) X(FMAF32) X(SQRTF32)                                \
+    X(ALOAD8) X(ALOAD16) X(ALOAD32) X(ALOAD) X(ASTORE8) X(ASTORE16) X(ASTORE32) X(ASTORE)       \
+    X(ACAS8) X(ACAS16) X(ACAS32) X(ACAS) X(AADD8) X(AADD16) X(AADD32) X(AADD)                   \
+    X(AOR8) X(AOR16) X(AOR32) X(AOR) X(AXCHG8) X(AXCHG16) X(AXCHG32) X(AXCHG) X(FENCE)          \
+    X(DUMPCHAR) X(GETCHAR) X(EXEC) X(SYS) X(DISREG) X(GRP) X(GIP)
+
+// handlers specialized by the decoder, instructions that take either a register or a literal (E)
+// get one handler per hint so the hint is never checked at run time
+// MULTI_PUSH and MULTI_POP are superinstructions made by fuse_program out of runs of PUSH or POP,
+// MOVV_WIDE is MOVVW and MOVVL with their whole literal, spanning their containers, JMPW runs as JMP_LIT and
+// the other wide branches (JMPF_WIDE, JMPFN_WIDE, CALL_WIDE) skip their container when they fall through or return,
+// VECTOR runs every vector instruction through perform_vector_inst (see vector.c), REFERENCE runs any instruction naming RIP through perform_inst and TRAP is the record after the last instruction
+#define VPU_THREADED_VARIANTS(X)                                                                \
+    X(HALT_REG) X(HALT_LIT) X(PUSH_REG) X(PUSH_LIT) X(STATIC_REG) X(STATIC_LIT)                 \
+    X(JMP_REG) X(JMP_LIT) X(CALL_REG) X(CALL_LIT) X(MULTI_PUSH) X(MULTI_POP) X(MOVV_WIDE)       \
+    X(JMPF_WIDE) X(JMPFN_WIDE) X(CALL_WIDE) X(VECTOR) X(REFERENCE) X(TRAP) X(UNKNOWN)
+
+// comparisons fused by fuse_program with the JMPF or JMPFN that follows them (compare-and-branch),
+// optionally preceded by an INC or DEC (step-and-branch), X(NAME, OPERATOR, TYPE)
+#define VPU_FUSABLE_COMPARES(X)                                                                 \
+    X(NEQ, !=, uint64) X(EQ, ==, uint64) X(EQF, ==, float64)                                    \
+    X(BIGI, >, int64) X(BIGU, >, uint64) X(BIGF, >, float64)                                    \
+    X(SMLI, <, int64) X(SMLU, <, uint64) X(SMLF, <, float64)
+
+// the longest run of PUSH or POP fused into a single superinstruction
+#define VPU_MAX_FUSED_SPAN 16
+
+typedef enum VpuHandler{
+    #define X(NAME) VPU_HANDLER_##NAME,
+    VPU_THREADED_OPS(X)
+    VPU_THREADED_VARIANTS(X)
+    #undef X
+    #define X(NAME, OP, TYPE)                                                                   \
+        VPU_HANDLER_FUSED_##NAME##_JMPF,     VPU_HANDLER_FUSED_##NAME##_JMPFN,                  \
+        VPU_HANDLER_FUSED_INC_##NAME##_JMPF, VPU_HANDLER_FUSED_INC_##NAME##_JMPFN,              \
+        VPU_HANDLER_FUSED_DEC_##NAME##_JMPF, VPU_HANDLER_FUSED_DEC_##NAME##_JMPFN,
+    VPU_FUSABLE_COMPARES(X)
+    #undef X
+
+    // for counting purposes
+    VPU_HANDLER_COUNT
+} VpuHandler;
+
+// an instruction expanded once at load time so the engine never has to decode it again
+typedef struct DecodedInst{
+    // the VpuHandler id, replaced by the handler address the first time the program runs with computed goto
+    union{
+        uint64_t    id;
+        const void* address;
+    } handler;
+    Register*   r1;
+    Register*   r2;
+    Register*   r3;
+    // the literal operand already extended the way its instruction reads it
+    Register    lit;
+    // the record of the target of jumps, branches and calls with literal offsets
+    const struct DecodedInst* target;
+    // the original instruction, for the instructions delegated to perform_inst
+    Inst        inst;
+    // how many instructions, starting from this one, the handler executes (more than 1 for superinstructions)
+    uint32_t    span;
+} DecodedInst;
+
+typedef struct DecodedProgram{
+    // size instructions followed by the TRAP
+    DecodedInst*    code;
+    uint64_t        size;
+    // where writes to R0 go, two registers wide so writes to the sub registers of R0 fit
+    Register*       sink;
+    // whether the handler ids were already replaced by handler addresses
+    int             linked;
+    // how many instructions were turned into superinstructions by fuse_program
+    uint64_t        fused_sites;
+    // how many dispatches the superinstructions spared during run_threaded
+    uint64_t        dispatches_saved;
+    // if not NULL run_threaded stops at its next checked dispatch once this is 0, see poll_program
+    const atomic_int* running;
+} DecodedProgram;
+
+static VpuHandler get_plain_handler(uint8_t opcode){
+    switch (opcode)
+    {
+    #define X(NAME) case INST_##NAME: return VPU_HANDLER_##NAME;
+    VPU_THREADED_OPS(X)
+    #undef X
+    default: return VPU_HANDLER_UNKNOWN;
+    }
+}
+
+// the operand an instruction only writes to (1 for R1, 2 for R2) or 0 if it has none,
+// the memory block instructions also read their destination, so they are left out and clear R0 themselves
+static int get_destination_operand(uint8_t opcode){
+    switch (opcode)
+    {
+    case INST_MOVC:
+        return 2;
+    case INST_MOV8: case INST_MOV16: case INST_MOV32: case INST_MOV:
+    case INST_MOVV: case INST_MOVN: case INST_MOVV16: case INST_MOVVW: case INST_MOVVL:
+    case INST_POP: case INST_STACK_GET: case INST_GSP:
+    case INST_READ8: case INST_READ16: case INST_READ32: case INST_READ:
+    case INST_NOT: case INST_NEG: case INST_AND: case INST_NAND: case INST_OR: case INST_XOR: case INST_BSHIFT:
+    case INST_ADD8: case INST_SUB8: case INST_MUL8: case INST_ADD16: case INST_SUB16: case INST_MUL16:
+    case INST_ADD32: case INST_SUB32: case INST_MUL32: case INST_ADD: case INST_SUB: case INST_MUL:
+    case INST_DIVI: case INST_DIVU: case INST_ADDF: case INST_SUBF: case INST_MULF: case INST_DIVF:
+    case INST_INC: case INST_DEC: case INST_INCF: case INST_DECF: case INST_ABS: case INST_ABSF:
+    case INST_NEQ: case INST_EQ: case INST_EQF: case INST_BIGI: case INST_BIGU: case INST_BIGF:
+    case INST_SMLI: case INST_SMLU: case INST_SMLF:
+    case INST_CASTIU: case INST_CASTIF: case INST_CASTUI: case INST_CASTUF: case INST_CASTFI: case INST_CASTFU:
+    case INST_CF3264: case INST_CF6432: case INST_FLOAT:
+    case INST_FMAF: case INST_SQRTF: case INST_MINF: case INST_MAXF: case INST_FLOORF: case INST_CEILF: case INST_ROUNDF:
+    case INST_ADDF32: case INST_SUBF32: case INST_MULF32: case INST_DIVF32: case INST_FMAF32: case INST_SQRTF32:
+    case INST_ALOAD8: case INST_ALOAD16: case INST_ALOAD32: case INST_ALOAD:
+    case INST_AADD8: case INST_AADD16: case INST_AADD32: case INST_AADD: case INST_AOR8: case INST_AOR16: case INST_AOR32: case INST_AOR:
+    case INST_AXCHG8: case INST_AXCHG16: case INST_AXCHG32: case INST_AXCHG:
+    case INST_GETCHAR: case INST_GRP: case INST_GIP:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+// expands every instruction of program into output->code, register operands are resolved against register_space,
+// so the decoded program can only run on a VPU using that same register space.
+// the program is assumed not to change while it runs, instructions built at run time should go through EXEC
+// \returns 0 on success or non zero on failure
+int decode_program(DecodedProgram* output, const Inst* program, uint64_t program_size, uint8_t* register_space){
+
+    output->size   = program_size;
+    output->linked = 0;
+    output->fused_sites      = 0;
+    output->dispatches_saved = 0;
+    output->running          = NULL;
+    output->code   = (DecodedInst*) virtual_alloc(sizeof(DecodedInst) * (program_size + 1));
+    output->sink   = (Register*) virtual_alloc(sizeof(Register) * 2);
+    if(!output->code || !output->sink){
+        fprintf(stderr, "[ERROR] Could Not Allocate %"PRIu64" Decoded Instructions\n", program_size);
+        virtual_free(output->code);
+        virtual_free(output->sink);
+        output->code = NULL;
+        output->sink = NULL;
+        return 1;
+    }
+
+    DecodedInst* const trap = output->code + program_size;
+    memset(trap, 0, sizeof(*trap));
+    trap->handler.id = VPU_HANDLER_TRAP;
+    trap->span = 1;
+
+    for(uint64_t i = 0; i < program_size; i+=1){
+
+        const Inst inst = program[i];
+        DecodedInst* const d = output->code + i;
+        const int lit_hint = GET_OP_HINT(inst) == HINT_LIT;
+
+        d->inst = inst;
+        d->span = 1;
+        d->r1 = GET_REG(register_space, (uint8_t) (inst >> 8));
+        d->r2 = GET_REG(register_space, (uint8_t) (inst >> 16));
+        d->r3 = GET_REG(register_space, (uint8_t) (inst >> 24));
+        d->lit.as_uint64 = 0;
+        d->target = trap;
+
+        const int operands = get_inst_register_operands(inst);
+        int names_rip = 0;
+        for(int operand = 0; operand < operands; operand+=1){
+            const uint8_t reg = (uint8_t) (inst >> (8 * (operand + 1)));
+            names_rip |= reg > RIP - 8 && reg < RIP + 8;
+        }
+        if(names_rip){
+            d->handler.id = VPU_HANDLER_REFERENCE;
+            continue;
+        }
+
+        switch (get_destination_operand(inst & 0xFF))
+        {
+        case 1:
+            if((uint8_t) (inst >> 8) < R0 + 8) d->r1 = (Register*) ((uint8_t*) output->sink + (uint8_t) (inst >> 8));
+            break;
+        case 2:
+            if((uint8_t) (inst >> 16) < R0 + 8) d->r2 = (Register*) ((uint8_t*) output->sink + (uint8_t) (inst >> 16));
+            break;
+        default:
+            break;
+        }
+
+        switch (inst & 0xFF)
+        {
+        case INST_HALT:
+            d->handler.id = lit_hint? VPU_HANDLER_HALT_LIT : VPU_HANDLER_HALT_REG;
+            d->lit.as_uint64 = (uint16_t) (inst >> 8);
+            break;
+        case INST_PUSH:
+            d->handler.id = lit_hint? VPU_HANDLER_PUSH_LIT : VPU_HANDLER_PUSH_REG;
+            d->lit.as_uint64 = (uint16_t) (inst >> 8);
+            // so MULTI_PUSH can read every pushed value through r1
+            if(lit_hint) d->r1 = &d->lit;
+            break;
+        case INST_STATIC:
+            d->handler.id = lit_hint? VPU_HANDLER_STATIC_LIT : VPU_HANDLER_STATIC_REG;
+            d->lit.as_uint64 = (uint16_t) (inst >> 8);
+            break;
+        case INST_JMP:
+            d->handler.id = lit_hint? VPU_HANDLER_JMP_LIT : VPU_HANDLER_JMP_REG;
+            d->lit.as_int64 = (int16_t) (inst >> 8);
+            break;
+        case INST_CALL:
+            d->handler.id = lit_hint? VPU_HANDLER_CALL_LIT : VPU_HANDLER_CALL_REG;
+            d->lit.as_int64 = (int16_t) (inst >> 8);
+            break;
+        case INST_JMPF:
+        case INST_JMPFN:
+            d->handler.id = get_plain_handler(inst & 0xFF);
+            d->lit.as_int64 = (int16_t) (inst >> 16);
+            break;
+        case INST_MOVN:
+            // MOVN is just a MOVV with the literal already negated
+            d->handler.id = VPU_HANDLER_MOVV;
+            d->lit.as_uint64 = ~(uint64_t)(uint16_t) (inst >> 16);
+            break;
+        case INST_INCF:
+        case INST_DECF:
+            d->handler.id = get_plain_handler(inst & 0xFF);
+            d->lit.as_float64 = (double)(uint16_t) (inst >> 16);
+            break;
+        case INST_MOVVW:
+        case INST_MOVVL:
+            // the containers keep the UNKNOWN handler, running into them is an error like in perform_inst
+            if(i + get_inst_payload_size(inst & 0xFF) >= program_size){
+                d->handler.id = VPU_HANDLER_UNKNOWN;
+                break;
+            }
+            d->handler.id = VPU_HANDLER_MOVV_WIDE;
+            d->lit.as_uint64 = get_wide_literal(program + i);
+            d->span = 1 + get_inst_payload_size(inst & 0xFF);
+            break;
+        case INST_JMPW:
+        case INST_JMPFW:
+        case INST_JMPFNW:
+        case INST_CALLW:
+            if(i + 1 >= program_size){
+                d->handler.id = VPU_HANDLER_UNKNOWN;
+                break;
+            }
+            d->handler.id =
+                ((inst & 0xFF) == INST_JMPW)?   VPU_HANDLER_JMP_LIT    :
+                ((inst & 0xFF) == INST_JMPFW)?  VPU_HANDLER_JMPF_WIDE  :
+                ((inst & 0xFF) == INST_JMPFNW)? VPU_HANDLER_JMPFN_WIDE : VPU_HANDLER_CALL_WIDE;
+            d->lit.as_uint64 = get_wide_literal(program + i);
+            d->span = 2;
+            break;
+        default:
+            d->handler.id = is_vector_inst(inst & 0xFF)? VPU_HANDLER_VECTOR : get_plain_handler(inst & 0xFF);
+            d->lit.as_uint64 = (uint16_t) (inst >> 16);
+            break;
+        }
+
+        switch (d->handler.id)
+        {
+        case VPU_HANDLER_JMP_LIT:
+        case VPU_HANDLER_CALL_LIT:
+        case VPU_HANDLER_JMPF:
+        case VPU_HANDLER_JMPFN:
+        case VPU_HANDLER_JMPF_WIDE:
+        case VPU_HANDLER_JMPFN_WIDE:
+        case VPU_HANDLER_CALL_WIDE:{
+            const uint64_t target = i + d->lit.as_uint64;
+            d->target = output->code + ((target < program_size)? target : program_size);
+        }   break;
+        default:
+            break;
+        }
+    }
+
+    return 0;
+}
+
+// makes run_threaded stop program once running is cleared, for programs run by threads that can be killed.
+// every jump, branch and call with a literal target at or before itself is left to perform_inst, so every loop
+// goes through the checked dispatch, a program that never does only runs forward and ends by itself.
+// has to be called before fuse_program and before the program first runs
+void poll_program(DecodedProgram* program, const atomic_int* running){
+
+    program->running = running;
+
+    for(uint64_t i = 0; i < program->size; i+=1){
+        DecodedInst* const d = program->code + i;
+        switch (d->handler.id)
+        {
+        case VPU_HANDLER_JMP_LIT:
+        case VPU_HANDLER_CALL_LIT:
+        case VPU_HANDLER_JMPF:
+        case VPU_HANDLER_JMPFN:
+        case VPU_HANDLER_JMPF_WIDE:
+        case VPU_HANDLER_JMPFN_WIDE:
+        case VPU_HANDLER_CALL_WIDE:
+            if(d->target <= d) d->handler.id = VPU_HANDLER_REFERENCE;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+static VpuHandler get_fused_handler(uint64_t step, uint64_t compare, uint64_t branch){
+    const int jmpfn = branch == VPU_HANDLER_JMPFN;
+    switch (compare)
+    {
+    #define X(NAME, OP, TYPE) case VPU_HANDLER_##NAME:                                                          \
+        if(step == VPU_HANDLER_INC) return jmpfn? VPU_HANDLER_FUSED_INC_##NAME##_JMPFN : VPU_HANDLER_FUSED_INC_##NAME##_JMPF; \
+        if(step == VPU_HANDLER_DEC) return jmpfn? VPU_HANDLER_FUSED_DEC_##NAME##_JMPFN : VPU_HANDLER_FUSED_DEC_##NAME##_JMPF; \
+        return jmpfn? VPU_HANDLER_FUSED_##NAME##_JMPFN : VPU_HANDLER_FUSED_##NAME##_JMPF;
+    VPU_FUSABLE_COMPARES(X)
+    #undef X
+    default: return VPU_HANDLER_UNKNOWN;
+    }
+}
+
+static inline int is_fusable_compare(uint64_t handler){
+    switch (handler)
+    {
+    #define X(NAME, OP, TYPE) case VPU_HANDLER_##NAME:
+    VPU_FUSABLE_COMPARES(X)
+    #undef X
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+// replaces the handler of every instruction that starts a fusable sequence with a superinstruction:
+//      CMP R1 R2 R3; JMPF|JMPFN R1 L2           -> compare-and-branch (any comparison in VPU_FUSABLE_COMPARES)
+//      INC|DEC R L2; CMP R1 R2 R3; JMPF|JMPFN   -> step-and-branch
+//      PUSH E; PUSH E; ...                      -> MULTI_PUSH
+//      POP R; POP R; ...                        -> MULTI_POP
+// only the handler and span of the first instruction change, the instructions after it stay as they were,
+// so jumping into the middle of a sequence and every IP seen by the program (CALL, GIP, RIP) are preserved.
+// instructions naming RIP were already decoded to REFERENCE, so they are never part of a sequence.
+// has to be called before the program first runs
+// \returns the number of superinstructions made
+uint64_t fuse_program(DecodedProgram* program){
+
+    if(program->linked) return 0;
+
+    DecodedInst* const code = program->code;
+    const uint64_t size = program->size;
+
+    #define HANDLER(I)  code[I].handler.id
+
+    uint64_t fused = 0;
+    for(uint64_t i = 0; i < size; i+=1){
+
+        const uint64_t h = HANDLER(i);
+
+        if(
+            (h == VPU_HANDLER_INC || h == VPU_HANDLER_DEC) && i + 2 < size &&
+            is_fusable_compare(HANDLER(i + 1)) &&
+            (HANDLER(i + 2) == VPU_HANDLER_JMPF || HANDLER(i + 2) == VPU_HANDLER_JMPFN)
+        ){
+            code[i].handler.id = get_fused_handler(h, HANDLER(i + 1), HANDLER(i + 2));
+            code[i].span = 3;
+            fused += 1;
+        }
+        else if(
+            is_fusable_compare(h) && i + 1 < size &&
+            (HANDLER(i + 1) == VPU_HANDLER_JMPF || HANDLER(i + 1) == VPU_HANDLER_JMPFN)
+        ){
+            code[i].handler.id = get_fused_handler(VPU_HANDLER_NOP, h, HANDLER(i + 1));
+            code[i].span = 2;
+            fused += 1;
+        }
+        else if(h == VPU_HANDLER_PUSH_REG || h == VPU_HANDLER_PUSH_LIT){
+            uint32_t span = 1;
+            while(
+                i + span < size && span < VPU_MAX_FUSED_SPAN &&
+                (HANDLER(i + span) == VPU_HANDLER_PUSH_REG || HANDLER(i + span) == VPU_HANDLER_PUSH_LIT)
+            ) span += 1;
+            if(span > 1){
+                code[i].handler.id = VPU_HANDLER_MULTI_PUSH;
+                code[i].span = span;
+                fused += 1;
+            }
+        }
+        else if(h == VPU_HANDLER_POP){
+            uint32_t span = 0;
+            while(
+                i + span < size && span < VPU_MAX_FUSED_SPAN &&
+                HANDLER(i + span) == VPU_HANDLER_POP
+            ) span += 1;
+            if(span > 1){
+                code[i].handler.id = VPU_HANDLER_MULTI_POP;
+                code[i].span = span;
+                fused += 1;
+            }
+        }
+    }
+
+    #undef HANDLER
+
+    program->fused_sites = fused;
+    return fused;
+}
+
+void free_decoded_program(DecodedProgram* program){
+    virtual_free(program->code);
+    virtual_free(program->sink);
+    program->code = NULL;
+    program->sink = NULL;
+    program->size = 0;
+}
+
+// runs the decoded program in vpu starting from the current RIP until RIP leaves [0, program->size)
+// or program->running is cleared, the observable behaviour is the same as the perform_inst loop in execute
+// \returns vpu->status
+int run_threaded(VPU* vpu, DecodedProgram* program){
+
+    uint8_t*     const register_space = vpu->register_space;
+    DecodedInst* const code           = program->code;
+    const uint64_t     program_size   = program->size;
+    Register*    const r0             = GET_REG(register_space, R0);
+    Register*    const rip            = GET_REG(register_space, RIP);
+    Register*    const rsp            = GET_REG(register_space, RSP);
+    const atomic_int* const running   = program->running;
+
+    const DecodedInst* d;
+    uint64_t dispatches_saved = 0;
+
+    #define R1 (*d->r1)
+    #define R2 (*d->r2)
+    #define R3 (*d->r3)
+    #define LIT d->lit
+    #define SP rsp->as_uint64
+    #define IP rip->as_uint64
+
+    #define OPERATION(OP, TYPE) R1.as_##TYPE = R2.as_##TYPE OP R3.as_##TYPE
+    #define COMPARE(OP, TYPE)   R1.as_uint8 = R2.as_##TYPE OP R3.as_##TYPE
+
+#if VPU_COMPUTED_GOTO
+    if(!program->linked){
+        const void* handlers[VPU_HANDLER_COUNT];
+        #define X(NAME) handlers[VPU_HANDLER_##NAME] = &&do_##NAME;
+        VPU_THREADED_OPS(X)
+        VPU_THREADED_VARIANTS(X)
+        #undef X
+        #define X(NAME, OP, TYPE)                                                                                           \
+            handlers[VPU_HANDLER_FUSED_##NAME##_JMPF]      = &&do_FUSED_##NAME##_JMPF;                                      \
+            handlers[VPU_HANDLER_FUSED_##NAME##_JMPFN]     = &&do_FUSED_##NAME##_JMPFN;                                     \
+            handlers[VPU_HANDLER_FUSED_INC_##NAME##_JMPF]  = &&do_FUSED_INC_##NAME##_JMPF;                                  \
+            handlers[VPU_HANDLER_FUSED_INC_##NAME##_JMPFN] = &&do_FUSED_INC_##NAME##_JMPFN;                                 \
+            handlers[VPU_HANDLER_FUSED_DEC_##NAME##_JMPF]  = &&do_FUSED_DEC_##NAME##_JMPF;                                  \
+            handlers[VPU_HANDLER_FUSED_DEC_##NAME##_JMPFN] = &&do_FUSED_DEC_##NAME##_JMPFN;
+        VPU_FUSABLE_COMPARES(X)
+        #undef X
+        for(uint64_t i = 0; i <= program_size; i+=1){
+            code[i].handler.address = handlers[code[i].handler.id];
+        }
+        program->linked = 1;
+    }
+    #define DISPATCH() goto *d->handler.address
+#else
+    #define DISPATCH() goto dispatch
+#endif
+
+    // fetches the instruction at RIP and jumps to its handler, for control flow that is only known at run time
+    #define NEXT() do{                                                                          \
+        if(IP >= program_size) goto done;                                                       \
+        if(running && !atomic_load_explicit(running, memory_order_relaxed)) goto done;          \
+        d = code + IP;                                                                          \
+        DISPATCH();                                                                             \
+    } while(0)
+
+    // the common ending of every handler that does not touch RIP, the TRAP catches the end of the program
+    #define STEP() do{ IP += 1; d += 1; DISPATCH(); } while(0)
+
+    // jumps to the target decoded for a jump with a literal offset, IP has to be updated already
+    #define TAKE(RECORD) do{ d = (RECORD)->target; DISPATCH(); } while(0)
+
+    r0->as_uint64 = 0;
+    NEXT();
+
+#if !VPU_COMPUTED_GOTO
+dispatch:
+    switch (d->handler.id)
+    {
+    #define X(NAME) case VPU_HANDLER_##NAME: goto do_##NAME;
+    VPU_THREADED_OPS(X)
+    VPU_THREADED_VARIANTS(X)
+    #undef X
+    #define X(NAME, OP, TYPE)                                                                   \
+    case VPU_HANDLER_FUSED_##NAME##_JMPF:      goto do_FUSED_##NAME##_JMPF;                     \
+    case VPU_HANDLER_FUSED_##NAME##_JMPFN:     goto do_FUSED_##NAME##_JMPFN;                    \
+    case VPU_HANDLER_FUSED_INC_##NAME##_JMPF:  goto do_FUSED_INC_##NAME##_JMPF;                 \
+    case VPU_HANDLER_FUSED_INC_##NAME##_JMPFN: goto do_FUSED_INC_##NAME##_JMPFN;                \
+    case VPU_HANDLER_FUSED_DEC_##NAME##_JMPF:  goto do_FUSED_DEC_##NAME##_JMPF;                 \
+    case VPU_HANDLER_FUSED_DEC_##NAME##_JMPFN: goto do_FUSED_DEC_##NAME##_JMPFN;
+    VPU_FUSABLE_COMPARES(X)
+    #undef X
+    default: goto do_UNKNOWN;
+    }
+#endif
+
+do_NOP:
+    STEP();
+do_HALT_REG:
+    vpu->status = (int) R1.as_int8;
+    IP = 0XFFFFFFFFFFFFFFFF;
+    goto done;
+do_HALT_LIT:
+    vpu->status = (int) LIT.as_uint64;
+    IP = 0XFFFFFFFFFFFFFFFF;
+    goto done;
+do_MOV8:
+    R1.as_uint8 = R2.as_uint8;
+    STEP();
+do_MOV16:
+    R1.as_uint16 = R2.as_uint16;
+    STEP();
+do_MOV32:
+    R1.as_uint32 = R2.as_uint32;
+    STEP();
+do_MOV:
+    R1 = R2;
+    STEP();
+do_MOVC:
+    if(R1.as_uint64) R2 = R3;
+    STEP();
+do_MOVV:
+    R1.as_uint64 = LIT.as_uint64;
+    STEP();
+do_MOVV16:
+    R1.as_uint16 = (uint16_t) LIT.as_uint64;
+    STEP();
+do_MOVV_WIDE:
+    R1.as_uint64 = LIT.as_uint64;
+    IP += d->span;
+    d  += d->span;
+    DISPATCH();
+do_PUSH_REG:
+    vpu->stack[SP++] = R1.as_uint64;
+    STEP();
+do_PUSH_LIT:
+    vpu->stack[SP++] = LIT.as_uint64;
+    STEP();
+do_POP:
+    R1.as_uint64 = vpu->stack[--SP];
+    STEP();
+do_STACK_GET:
+    R1.as_uint64 = vpu->stack[SP - LIT.as_uint64];
+    STEP();
+do_STACK_PUT:
+    vpu->stack[SP - LIT.as_uint64] = R1.as_uint64;
+    STEP();
+do_GSP:
+    R1.as_ptr = (uint8_t*)((uint64_t*) vpu->stack + R2.as_uint64) + R3.as_uint64;
+    STEP();
+do_STATIC_REG:
+    vpu->stack[SP++] = (uint64_t)(uintptr_t)(vpu->static_memory + R1.as_uint64);
+    STEP();
+do_STATIC_LIT:
+    vpu->stack[SP++] = (uint64_t)(uintptr_t)(vpu->static_memory + LIT.as_uint64);
+    STEP();
+do_READ8:
+    R1.as_uint8 = *(uint8_t*)((uintptr_t)(R2.as_ptr) + R3.as_int64);
+    STEP();
+do_READ16:
+    R1.as_uint16 = *(uint16_t*)((uintptr_t)(R2.as_ptr) + R3.as_int64);
+    STEP();
+do_READ32:
+    R1.as_uint32 = *(uint32_t*)((uintptr_t)(R2.as_ptr) + R3.as_int64);
+    STEP();
+do_READ:
+    R1.as_uint64 = *(uint64_t*)((uintptr_t)(R2.as_ptr) + R3.as_int64);
+    STEP();
+do_MREADS:
+    R1.as_ptr = memcpy(R1.as_ptr, R2.as_ptr, (size_t) R3.as_uint64);
+    r0->as_uint64 = 0;
+    STEP();
+do_WRITE8:
+    *(uint8_t*)((uintptr_t)(R1.as_ptr) + R3.as_int64) = R2.as_uint8;
+    STEP();
+do_WRITE16:
+    *(uint16_t*)((uintptr_t)(R1.as_ptr) + R3.as_int64) = R2.as_uint16;
+    STEP();
+do_WRITE32:
+    *(uint32_t*)((uintptr_t)(R1.as_ptr) + R3.as_int64) = R2.as_uint32;
+    STEP();
+do_WRITE:
+    *(uint64_t*)((uintptr_t)(R1.as_ptr) + R3.as_int64) = R2.as_uint64;
+    STEP();
+do_MWRITES:
+    R1.as_ptr = memset(R1.as_ptr, (int) R2.as_int8, (size_t) R3.as_uint64);
+    r0->as_uint64 = 0;
+    STEP();
+do_MMOVS:
+    R1.as_ptr = memmove(R1.as_ptr,  R2.as_ptr, (size_t) R3.as_uint64);
+    r0->as_uint64 = 0;
+    STEP();
+do_MEMCMP:
+    R1.as_uint8 = (uint8_t) memcmp(R1.as_ptr, R2.as_ptr, (size_t) R3.as_uint64);
+    r0->as_uint64 = 0;
+    STEP();
+do_MSTRLEN:
+    R1.as_uint64 = (uint64_t) strlen((const char*) R2.as_ptr);
+    r0->as_uint64 = 0;
+    STEP();
+do_MCHR:
+    R1.as_ptr = memchr(R1.as_ptr, (int) R2.as_uint8, (size_t) R3.as_uint64);
+    r0->as_uint64 = 0;
+    STEP();
+do_MFILL32:
+    bulk_fill32(R1.as_ptr, R2.as_uint32, R3.as_uint64);
+    STEP();
+do_MFILL64:
+    bulk_fill64(R1.as_ptr, R2.as_uint64, R3.as_uint64);
+    STEP();
+do_MCRC32:
+    R1.as_uint64 = bulk_crc32c(R1.as_uint32, R2.as_ptr, R3.as_uint64);
+    r0->as_uint64 = 0;
+    STEP();
+do_MHASH:
+    R1.as_uint64 = bulk_hash(R1.as_uint64, R2.as_ptr, R3.as_uint64);
+    r0->as_uint64 = 0;
+    STEP();
+do_MPOPCNT:
+    R1.as_uint64 = bulk_popcount(R2.as_ptr, R3.as_uint64);
+    r0->as_uint64 = 0;
+    STEP();
+do_ALOAD8:
+    R1.as_uint8 = atomic_load_explicit(VPU_ATOMIC(8, (uintptr_t)(R2.as_ptr) + R3.as_int64), memory_order_acquire);
+    STEP();
+do_ALOAD16:
+    R1.as_uint16 = atomic_load_explicit(VPU_ATOMIC(16, (uintptr_t)(R2.as_ptr) + R3.as_int64), memory_order_acquire);
+    STEP();
+do_ALOAD32:
+    R1.as_uint32 = atomic_load_explicit(VPU_ATOMIC(32, (uintptr_t)(R2.as_ptr) + R3.as_int64), memory_order_acquire);
+    STEP();
+do_ALOAD:
+    R1.as_uint64 = atomic_load_explicit(VPU_ATOMIC(64, (uintptr_t)(R2.as_ptr) + R3.as_int64), memory_order_acquire);
+    STEP();
+do_ASTORE8:
+    atomic_store_explicit(VPU_ATOMIC(8, (uintptr_t)(R1.as_ptr) + R3.as_int64), R2.as_uint8, memory_order_release);
+    STEP();
+do_ASTORE16:
+    atomic_store_explicit(VPU_ATOMIC(16, (uintptr_t)(R1.as_ptr) + R3.as_int64), R2.as_uint16, memory_order_release);
+    STEP();
+do_ASTORE32:
+    atomic_store_explicit(VPU_ATOMIC(32, (uintptr_t)(R1.as_ptr) + R3.as_int64), R2.as_uint32, memory_order_release);
+    STEP();
+do_ASTORE:
+    atomic_store_explicit(VPU_ATOMIC(64, (uintptr_t)(R1.as_ptr) + R3.as_int64), R2.as_uint64, memory_order_release);
+    STEP();
+do_ACAS8:
+    atomic_compare_exchange_strong(VPU_ATOMIC(8, R2.as_ptr), &R1.as_uint8, R3.as_uint8);
+    r0->as_uint64 = 0;
+    STEP();
+do_ACAS16:
+    atomic_compare_exchange_strong(VPU_ATOMIC(16, R2.as_ptr), &R1.as_uint16, R3.as_uint16);
+    r0->as_uint64 = 0;
+    STEP();
+do_ACAS32:
+    atomic_compare_exchange_strong(VPU_ATOMIC(32, R2.as_ptr), &R1.as_uint32, R3.as_uint32);
+    r0->as_uint64 = 0;
+    STEP();
+do_ACAS:
+    atomic_compare_exchange_strong(VPU_ATOMIC(64, R2.as_ptr), &R1.as_uint64, R3.as_uint64);
+    r0->as_uint64 = 0;
+    STEP();
+do_AADD8:
+    R1.as_uint8 = atomic_fetch_add(VPU_ATOMIC(8, R2.as_ptr), R3.as_uint8);
+    STEP();
+do_AADD16:
+    R1.as_uint16 = atomic_fetch_add(VPU_ATOMIC(16, R2.as_ptr), R3.as_uint16);
+    STEP();
+do_AADD32:
+    R1.as_uint32 = atomic_fetch_add(VPU_ATOMIC(32, R2.as_ptr), R3.as_uint32);
+    STEP();
+do_AADD:
+    R1.as_uint64 = atomic_fetch_add(VPU_ATOMIC(64, R2.as_ptr), R3.as_uint64);
+    STEP();
+do_AOR8:
+    R1.as_uint8 = atomic_fetch_or(VPU_ATOMIC(8, R2.as_ptr), R3.as_uint8);
+    STEP();
+do_AOR16:
+    R1.as_uint16 = atomic_fetch_or(VPU_ATOMIC(16, R2.as_ptr), R3.as_uint16);
+    STEP();
+do_AOR32:
+    R1.as_uint32 = atomic_fetch_or(VPU_ATOMIC(32, R2.as_ptr), R3.as_uint32);
+    STEP();
+do_AOR:
+    R1.as_uint64 = atomic_fetch_or(VPU_ATOMIC(64, R2.as_ptr), R3.as_uint64);
+    STEP();
+do_AXCHG8:
+    R1.as_uint8 = atomic_exchange(VPU_ATOMIC(8, R2.as_ptr), R3.as_uint8);
+    STEP();
+do_AXCHG16:
+    R1.as_uint16 = atomic_exchange(VPU_ATOMIC(16, R2.as_ptr), R3.as_uint16);
+    STEP();
+do_AXCHG32:
+    R1.as_uint32 = atomic_exchange(VPU_ATOMIC(32, R2.as_ptr), R3.as_uint32);
+    STEP();
+do_AXCHG:
+    R1.as_uint64 = atomic_exchange(VPU_ATOMIC(64, R2.as_ptr), R3.as_uint64);
+    STEP();
+do_FENCE:
+    atomic_thread_fence(memory_order_seq_cst);
+    STEP();
+do_NOT:
+    R1.as_uint64 = !R2.as_uint64;
+    STEP();
+do_NEG:
+    R1.as_uint64 = ~R2.as_uint64 | R3.as_uint64;
+    STEP();
+do_AND:
+    R1.as_uint64 = R2.as_uint64 & R3.as_uint64;
+    STEP();
+do_NAND:
+    R1.as_uint64 = ~(R2.as_uint64 & R3.as_uint64);
+    STEP();
+do_OR:
+    R1.as_uint64 = R2.as_uint64 | R3.as_uint64;
+    STEP();
+do_XOR:
+    R1.as_uint64 = R2.as_uint64 ^ R3.as_uint64;
+    STEP();
+do_BSHIFT:
+    R1.as_uint64 = R3.as_int8 < 0? R2.as_uint64 >> -(R3.as_int8) : R2.as_uint64 << R3.as_uint8;
+    STEP();
+do_JMP_REG:
+    IP += R1.as_int64;
+    NEXT();
+do_JMP_LIT:
+    IP += LIT.as_int64;
+    TAKE(d);
+do_JMPF:
+    if(R1.as_uint8){
+        IP += LIT.as_int64;
+        TAKE(d);
+    }
+    STEP();
+do_JMPFN:
+    if(!(R1.as_uint8)){
+        IP += LIT.as_int64;
+        TAKE(d);
+    }
+    STEP();
+do_CALL_REG:
+    vpu->stack[SP++] = IP + 1;
+    IP += R1.as_int64;
+    NEXT();
+do_CALL_LIT:
+    vpu->stack[SP++] = IP + 1;
+    IP += LIT.as_int64;
+    TAKE(d);
+do_JMPF_WIDE:
+    if(R1.as_uint8){
+        IP += LIT.as_int64;
+        TAKE(d);
+    }
+    IP += 2;
+    d  += 2;
+    DISPATCH();
+do_JMPFN_WIDE:
+    if(!(R1.as_uint8)){
+        IP += LIT.as_int64;
+        TAKE(d);
+    }
+    IP += 2;
+    d  += 2;
+    DISPATCH();
+do_CALL_WIDE:
+    vpu->stack[SP++] = IP + 2;
+    IP += LIT.as_int64;
+    TAKE(d);
+do_RET:
+    IP = vpu->stack[--SP];
+    NEXT();
+
+do_ADD8:
+    OPERATION(+, uint8);
+    STEP();
+do_SUB8:
+    OPERATION(-, uint8);
+    STEP();
+do_MUL8:
+    OPERATION(*, uint8);
+    STEP();
+do_ADD16:
+    OPERATION(+, uint16);
+    STEP();
+do_SUB16:
+    OPERATION(-, uint16);
+    STEP();
+do_MUL16:
+    OPERATION(*, uint16);
+    STEP();
+do_ADD32:
+    OPERATION(+, uint32);
+    STEP();
+do_SUB32:
+    OPERATION(-, uint32);
+    STEP();
+do_MUL32:
+    OPERATION(*, uint32);
+    STEP();
+do_ADD:
+    OPERATION(+, uint64);
+    STEP();
+do_SUB:
+    OPERATION(-, uint64);
+    STEP();
+do_MUL:
+    OPERATION(*, uint64);
+    STEP();
+do_DIVI:
+    OPERATION(/, int64);
+    STEP();
+do_DIVU:
+    OPERATION(/, uint64);
+    STEP();
+do_ADDF:
+    OPERATION(+, float64);
+    STEP();
+do_SUBF:
+    OPERATION(-, float64);
+    STEP();
+do_MULF:
+    OPERATION(*, float64);
+    STEP();
+do_DIVF:
+    OPERATION(/, float64);
+    STEP();
+do_INC:
+    R1.as_uint64 += LIT.as_uint64;
+    STEP();
+do_DEC:
+    R1.as_int64 -= LIT.as_int64;
+    STEP();
+do_INCF:
+    R1.as_float64 += LIT.as_float64;
+    STEP();
+do_DECF:
+    R1.as_float64 -= LIT.as_float64;
+    STEP();
+do_ABS:{
+    const int64_t v = R2.as_int64 - R3.as_int64;
+    R1.as_uint64 = (v < 0)? -v : v;
+}   STEP();
+do_ABSF:{
+    const double v = R2.as_float64 - R3.as_float64;
+    R1.as_float64 = (v < 0)? -v : v;
+}   STEP();
+
+do_NEQ:
+    COMPARE(!=, uint64);
+    STEP();
+do_EQ:
+    COMPARE(==, uint64);
+    STEP();
+do_EQF:
+    COMPARE(==, float64);
+    STEP();
+do_BIGI:
+    COMPARE(>, int64);
+    STEP();
+do_BIGU:
+    COMPARE(>, uint64);
+    STEP();
+do_BIGF:
+    COMPARE(>, float64);
+    STEP();
+do_SMLI:
+    COMPARE(<, int64);
+    STEP();
+do_SMLU:
+    COMPARE(<, uint64);
+    STEP();
+do_SMLF:
+    COMPARE(<, float64);
+    STEP();
+
+do_CASTIU:
+    R1.as_int64 = (int64_t)R2.as_uint64;
+    STEP();
+do_CASTIF:
+    R1.as_int64 = (int64_t)R2.as_float64;
+    STEP();
+do_CASTUI:
+    R1.as_uint64 = (uint64_t)R2.as_int64;
+    STEP();
+do_CASTUF:
+    R1.as_uint64 = (uint64_t)R2.as_float64;
+    STEP();
+do_CASTFI:
+    R1.as_float64 = (double)R2.as_int64;
+    STEP();
+do_CASTFU:
+    R1.as_float64 = (double)R2.as_uint64;
+    STEP();
+do_CF3264:
+    R1.as_float32 = (float)R2.as_float64;
+    STEP();
+do_CF6432:
+    R1.as_float64 = (double)R2.as_float32;
+    STEP();
+do_FMAF:
+    R1.as_float64 = fma(R2.as_float64, R3.as_float64, R1.as_float64);
+    STEP();
+do_SQRTF:
+    R1.as_float64 = sqrt(R2.as_float64);
+    STEP();
+do_MINF:
+    R1.as_float64 = (R2.as_float64 < R3.as_float64)? R2.as_float64 : R3.as_float64;
+    STEP();
+do_MAXF:
+    R1.as_float64 = (R2.as_float64 > R3.as_float64)? R2.as_float64 : R3.as_float64;
+    STEP();
+do_FLOORF:
+    R1.as_float64 = floor(R2.as_float64);
+    STEP();
+do_CEILF:
+    R1.as_float64 = ceil(R2.as_float64);
+    STEP();
+do_ROUNDF:
+    R1.as_float64 = nearbyint(R2.as_float64);
+    STEP();
+do_ADDF32:
+    R1.as_float32 = R2.as_float32 + R3.as_float32;
+    STEP();
+do_SUBF32:
+    R1.as_float32 = R2.as_float32 - R3.as_float32;
+    STEP();
+do_MULF32:
+    R1.as_float32 = R2.as_float32 * R3.as_float32;
+    STEP();
+do_DIVF32:
+    R1.as_float32 = R2.as_float32 / R3.as_float32;
+    STEP();
+do_FMAF32:
+    R1.as_float32 = fmaf(R2.as_float32, R3.as_float32, R1.as_float32);
+    STEP();
+do_SQRTF32:
+    R1.as_float32 = sqrtf(R2.as_float32);
+    STEP();
+do_FLOAT:
+    R1.as_float64 = (double) R2.as_int64 / (double) R3.as_uint64;
+    STEP();
+
+do_DUMPCHAR:
+    if(R2.as_int8 == 0){
+        putchar((int) R1.as_int32);
+        if(R3.as_uint8) fflush(stdout);
+    }
+    else{
+        fputc((int) R1.as_int32, stderr);
+        if(R3.as_uint8) fflush(stdout);
+    }
+    STEP();
+do_GETCHAR:
+    R1.as_int32 = fgetc(stdin);
+    if(R2.as_uint8) fclose(stdin);
+    STEP();
+do_GRP:
+    R1.as_ptr = ((uint8_t*) &R2) + R3.as_int64;
+    STEP();
+do_GIP:
+    R1.as_ptr = ((uint8_t*) (vpu->program + R2.as_uint64)) + R3.as_uint64;
+    STEP();
+
+// superinstructions, writes to R0 already go to the sink so nothing has to be cleared between the fused instructions
+
+do_MULTI_PUSH:{
+    const uint32_t span = d->span;
+    for(uint32_t i = 0; i < span; i+=1){
+        vpu->stack[SP++] = d[i].r1->as_uint64;
+    }
+    IP += span;
+    dispatches_saved += span - 1;
+    d += span;
+    DISPATCH();
+}
+do_MULTI_POP:{
+    const uint32_t span = d->span;
+    for(uint32_t i = 0; i < span; i+=1){
+        d[i].r1->as_uint64 = vpu->stack[--SP];
+    }
+    IP += span;
+    dispatches_saved += span - 1;
+    d += span;
+    DISPATCH();
+}
+
+    // the compare at d[FIRST], then the conditional jump at d[FIRST + 1]
+    #define COMPARE_AND_BRANCH(FIRST, OP, TYPE, TAKEN)                                                  \
+        d[FIRST].r1->as_uint8 = d[FIRST].r2->as_##TYPE OP d[FIRST].r3->as_##TYPE;                       \
+        dispatches_saved += (FIRST) + 1;                                                                \
+        if(TAKEN d[(FIRST) + 1].r1->as_uint8){                                                          \
+            IP += (FIRST) + 1 + d[(FIRST) + 1].lit.as_int64;                                            \
+            TAKE(d + (FIRST) + 1);                                                                      \
+        }                                                                                               \
+        IP += (FIRST) + 2;                                                                              \
+        d += (FIRST) + 2;                                                                               \
+        DISPATCH()
+
+    #define X(NAME, OP, TYPE)                                                                           \
+    do_FUSED_##NAME##_JMPF:                                                                             \
+        COMPARE_AND_BRANCH(0, OP, TYPE, );                                                              \
+    do_FUSED_##NAME##_JMPFN:                                                                            \
+        COMPARE_AND_BRANCH(0, OP, TYPE, !);                                                             \
+    do_FUSED_INC_##NAME##_JMPF:                                                                         \
+        R1.as_uint64 += LIT.as_uint64;                                                                  \
+        COMPARE_AND_BRANCH(1, OP, TYPE, );                                                              \
+    do_FUSED_INC_##NAME##_JMPFN:                                                                        \
+        R1.as_uint64 += LIT.as_uint64;                                                                  \
+        COMPARE_AND_BRANCH(1, OP, TYPE, !);                                                             \
+    do_FUSED_DEC_##NAME##_JMPF:                                                                         \
+        R1.as_int64 -= LIT.as_int64;                                                                    \
+        COMPARE_AND_BRANCH(1, OP, TYPE, );                                                              \
+    do_FUSED_DEC_##NAME##_JMPFN:                                                                        \
+        R1.as_int64 -= LIT.as_int64;                                                                    \
+        COMPARE_AND_BRANCH(1, OP, TYPE, !);
+    VPU_FUSABLE_COMPARES(X)
+    #undef X
+    #undef COMPARE_AND_BRANCH
+
+// VGET can write to R0 like the instructions left to perform_inst
+do_VECTOR:
+    perform_vector_inst(vpu->register_space, d->inst);
+    r0->as_uint64 = 0;
+    STEP();
+
+// rarely executed instructions are left to the reference implementation, which may write to R0 or RIP
+do_EXEC:
+do_SYS:
+do_DISREG:
+do_REFERENCE:
+    IP += perform_inst(vpu, d->inst);
+    r0->as_uint64 = 0;
+    NEXT();
+
+do_TRAP:
+    goto done;
+
+do_UNKNOWN:
+    fprintf(stderr, "[ERROR] Unknwon Instruction '%u' At Instuction Position %"PRIu64"\n", (unsigned int)d->inst, IP);
+    vpu->status = 1;
+    IP = 0XFFFFFFFFFFFFFFFF;
+
+done:
+    program->dispatches_saved += dispatches_saved;
+    return vpu->status;
+
+    #undef R1
+    #undef R2
+    #undef R3
+    #undef LIT
+    #undef SP
+    #undef IP
+    #undef OPERATION
+    #undef COMPARE
+    #undef DISPATCH
+    #undef NEXT
+    #undef STEP
+    #undef TAKE
+}
+
+#endif // END OF FILE VTHREADED_C =================================================
@@ -0,0 +1,289 @@
+#ifndef VVECTOR_C
+#define VVECTOR_C
+
+/*
+ * vector instructions:
+ * 16 vector registers of 128 bits (V0 to V15, see VRegister) live after the registers in the register space,
+ * the instructions work on their 16 lanes of 8 bits, 8 of 16 bits, 4 of 32 bits (integers or float32) or 2 float64.
+ * on x86-64 (and x86 with SSE2) every instruction is a few SSE2 instructions, the instructions SSE2 lacks
+ * (VSHUF, VMUL32, VMIN/VMAX of 16 and 32 bits) use SSSE3 and SSE4.1 when the compiler targets them (-march=native)
+ * and are emulated with SSE2 otherwise. elsewhere, or with VPU_NO_SIMD defined, every lane is done on its own.
+ * both ways give the same results, bit for bit, including for NaNs and signed zeros:
+ *      VADD, VSUB and VMUL of floats give the canonical quiet NaN (VPU_NAN32/VPU_NAN64) for any NaN lane, which
+ *      NaN payload survives an operation differs between SSE (the first operand's) and compilers (often the second)
+ *      VMIN and VMAX of floats are (a < b)? a : b and (a > b)? a : b, like minps and maxps
+ *      VEQ and VBIG of floats are false if either lane is NaN
+ * the three engines run them through perform_vector_inst, only the decoding around it differs.
+ */
+
+#include "core.h"
+#include <string.h>
+
+#if !defined(VPU_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #define VPU_SSE2 1
+    #include <emmintrin.h>
+    #ifdef __SSSE3__
+        #include <tmmintrin.h>
+    #endif
+    #ifdef __SSE4_1__
+        #include <smmintrin.h>
+    #endif
+#else
+    #define VPU_SSE2 0
+#endif
+
+// the bits of the NaN every NaN result of VADD, VSUB and VMUL of floats is turned into
+#define VPU_NAN32 0x7FC00000u
+#define VPU_NAN64 0x7FF8000000000000u
+
+static inline float vcanonical32(float x){
+    if(x != x){
+        const uint32_t nan = VPU_NAN32;
+        memcpy(&x, &nan, sizeof(x));
+    }
+    return x;
+}
+
+static inline double vcanonical64(double x){
+    if(x != x){
+        const uint64_t nan = VPU_NAN64;
+        memcpy(&x, &nan, sizeof(x));
+    }
+    return x;
+}
+
+// the results the lane by lane instructions go through, only the float ones change anything
+#define VCANONICAL_uint8(X)     (X)
+#define VCANONICAL_uint16(X)    (X)
+#define VCANONICAL_uint32(X)    (X)
+#define VCANONICAL_float32(X)   vcanonical32(X)
+#define VCANONICAL_float64(X)   vcanonical64(X)
+
+#if VPU_SSE2
+
+#define VLOADI(V)       _mm_loadu_si128((const __m128i*) (V))
+#define VSTOREI(V, X)   _mm_storeu_si128((__m128i*) (V), X)
+
+// a > b for unsigned lanes, SSE2 only compares signed lanes so the sign bit of both sides is flipped first
+#define VGREATER_UNSIGNED(BITS, A, B)                                                   \
+    _mm_cmpgt_epi##BITS(                                                               \
+        _mm_xor_si128(A, _mm_set1_epi##BITS((int##BITS##_t) ((uint##BITS##_t) 1 << (BITS - 1)))), \
+        _mm_xor_si128(B, _mm_set1_epi##BITS((int##BITS##_t) ((uint##BITS##_t) 1 << (BITS - 1))))  \
+    )
+
+// mask? a : b
+static inline __m128i vselect(__m128i mask, __m128i a, __m128i b){
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// replaces the NaN lanes of x by VPU_NAN32/VPU_NAN64
+static inline __m128 vcanonical_ps(__m128 x){
+    const __m128 nan = _mm_cmpunord_ps(x, x);
+    return _mm_or_ps(_mm_andnot_ps(nan, x), _mm_and_ps(nan, _mm_castsi128_ps(_mm_set1_epi32((int) VPU_NAN32))));
+}
+
+static inline __m128d vcanonical_pd(__m128d x){
+    const __m128d nan = _mm_cmpunord_pd(x, x);
+    return _mm_or_pd(_mm_andnot_pd(nan, x), _mm_and_pd(nan, _mm_castsi128_pd(_mm_set1_epi64x((long long) VPU_NAN64))));
+}
+
+static inline __m128i vmul8(__m128i a, __m128i b){
+    // the even bytes are the low bytes of the 16 bits products, the odd bytes are multiplied shifted down
+    const __m128i even = _mm_mullo_epi16(a, b);
+    const __m128i odd  = _mm_mullo_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8));
+    return _mm_or_si128(_mm_and_si128(even, _mm_set1_epi16(0xFF)), _mm_slli_epi16(odd, 8));
+}
+
+static inline __m128i vmul32(__m128i a, __m128i b){
+#ifdef __SSE4_1__
+    return _mm_mullo_epi32(a, b);
+#else
+    // _mm_mul_epu32 multiplies lanes 0 and 2 into 64 bits, the low halves of both products are interleaved back
+    const __m128i even = _mm_mul_epu32(a, b);
+    const __m128i odd  = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+#endif
+}
+
+static inline __m128i vmin16(__m128i a, __m128i b){
+#ifdef __SSE4_1__
+    return _mm_min_epu16(a, b);
+#else
+    return _mm_sub_epi16(a, _mm_subs_epu16(a, b));
+#endif
+}
+
+static inline __m128i vmax16(__m128i a, __m128i b){
+#ifdef __SSE4_1__
+    return _mm_max_epu16(a, b);
+#else
+    return _mm_add_epi16(b, _mm_subs_epu16(a, b));
+#endif
+}
+
+static inline __m128i vmin32(__m128i a, __m128i b){
+#ifdef __SSE4_1__
+    return _mm_min_epu32(a, b);
+#else
+    return vselect(VGREATER_UNSIGNED(32, a, b), b, a);
+#endif
+}
+
+static inline __m128i vmax32(__m128i a, __m128i b){
+#ifdef __SSE4_1__
+    return _mm_max_epu32(a, b);
+#else
+    return vselect(VGREATER_UNSIGNED(32, a, b), a, b);
+#endif
+}
+
+#endif // VPU_SSE2
+
+static inline void vshuf(VRegister* v1, const VRegister* v2, const VRegister* v3){
+#if VPU_SSE2 && defined(__SSSE3__)
+    VSTOREI(v1, _mm_shuffle_epi8(VLOADI(v2), VLOADI(v3)));
+#else
+    VRegister result;
+    for(int i = 0; i < 16; i+=1)
+        result.as_uint8[i] = (v3->as_uint8[i] & 0x80)? 0 : v2->as_uint8[v3->as_uint8[i] & 0x0F];
+    *v1 = result;
+#endif
+}
+
+// performs the vector instruction inst on the registers in register_space, see is_vector_inst
+void perform_vector_inst(uint8_t* register_space, Inst inst){
+
+    // the operands, vector registers or registers depending on the instruction
+    #define V1 GET_VREG(register_space, (uint8_t) (inst >> 8))
+    #define V2 GET_VREG(register_space, (uint8_t) (inst >> 16))
+    #define V3 GET_VREG(register_space, (uint8_t) (inst >> 24))
+    #define R1 (*GET_REG(register_space, (uint8_t) (inst >> 8)))
+    #define R2 (*GET_REG(register_space, (uint8_t) (inst >> 16)))
+    #define R3 (*GET_REG(register_space, (uint8_t) (inst >> 24)))
+
+    // a lane by lane operation, through a copy so the destination can also be a source
+    // (1u * keeps the products of 16 bits lanes from overflowing int)
+    #define LANES(TYPE, COUNT, EXPRESSION) {                                            \
+        const VRegister a = *V2, b = *V3;                                               \
+        VRegister result;                                                               \
+        for(int i = 0; i < COUNT; i+=1) result.as_##TYPE[i] = EXPRESSION;               \
+        memcpy(V1, &result, sizeof(result));                                            \
+    }
+    #define PORTABLE_OPS(TYPE, COUNT, MASK)                                                                 \
+        case LANE_ADD: LANES(TYPE, COUNT, VCANONICAL_##TYPE(a.as_##TYPE[i] + b.as_##TYPE[i])) return;    \
+        case LANE_SUB: LANES(TYPE, COUNT, VCANONICAL_##TYPE(a.as_##TYPE[i] - b.as_##TYPE[i])) return;    \
+        case LANE_MUL: LANES(TYPE, COUNT, VCANONICAL_##TYPE(1u * a.as_##TYPE[i] * b.as_##TYPE[i])) return; \
+        case LANE_MIN: LANES(TYPE, COUNT, (a.as_##TYPE[i] < b.as_##TYPE[i])? a.as_##TYPE[i] : b.as_##TYPE[i]) return; \
+        case LANE_MAX: LANES(TYPE, COUNT, (a.as_##TYPE[i] > b.as_##TYPE[i])? a.as_##TYPE[i] : b.as_##TYPE[i]) return; \
+        case LANE_EQ:  LANES(MASK, COUNT, (a.as_##TYPE[i] == b.as_##TYPE[i])? ~(MASK##_t) 0 : 0) return; \
+        case LANE_BIG: LANES(MASK, COUNT, (a.as_##TYPE[i] > b.as_##TYPE[i])? ~(MASK##_t) 0 : 0) return;
+
+    // the instructions of one lane type, in the order of their opcodes
+    enum { LANE_ADD, LANE_SUB, LANE_MUL, LANE_MIN, LANE_MAX, LANE_EQ, LANE_BIG, LANE_OPS };
+
+    const int opcode = inst & 0xFF;
+
+#if VPU_SSE2
+    #define SSE_INT(EXPRESSION) { const __m128i a = VLOADI(V2), b = VLOADI(V3); VSTOREI(V1, EXPRESSION); return; }
+    #define SSE_PS(EXPRESSION)  { const __m128  a = _mm_loadu_ps(V2->as_float32), b = _mm_loadu_ps(V3->as_float32); _mm_storeu_ps(V1->as_float32, EXPRESSION); return; }
+    #define SSE_PD(EXPRESSION)  { const __m128d a = _mm_loadu_pd(V2->as_float64), b = _mm_loadu_pd(V3->as_float64); _mm_storeu_pd(V1->as_float64, EXPRESSION); return; }
+    switch (opcode)
+    {
+    case INST_VADD8:    SSE_INT(_mm_add_epi8(a, b))
+    case INST_VSUB8:    SSE_INT(_mm_sub_epi8(a, b))
+    case INST_VMUL8:    SSE_INT(vmul8(a, b))
+    case INST_VMIN8:    SSE_INT(_mm_min_epu8(a, b))
+    case INST_VMAX8:    SSE_INT(_mm_max_epu8(a, b))
+    case INST_VEQ8:     SSE_INT(_mm_cmpeq_epi8(a, b))
+    case INST_VBIG8:    SSE_INT(VGREATER_UNSIGNED(8, a, b))
+    case INST_VADD16:   SSE_INT(_mm_add_epi16(a, b))
+    case INST_VSUB16:   SSE_INT(_mm_sub_epi16(a, b))
+    case INST_VMUL16:   SSE_INT(_mm_mullo_epi16(a, b))
+    case INST_VMIN16:   SSE_INT(vmin16(a, b))
+    case INST_VMAX16:   SSE_INT(vmax16(a, b))
+    case INST_VEQ16:    SSE_INT(_mm_cmpeq_epi16(a, b))
+    case INST_VBIG16:   SSE_INT(VGREATER_UNSIGNED(16, a, b))
+    case INST_VADD32:   SSE_INT(_mm_add_epi32(a, b))
+    case INST_VSUB32:   SSE_INT(_mm_sub_epi32(a, b))
+    case INST_VMUL32:   SSE_INT(vmul32(a, b))
+    case INST_VMIN32:   SSE_INT(vmin32(a, b))
+    case INST_VMAX32:   SSE_INT(vmax32(a, b))
+    case INST_VEQ32:    SSE_INT(_mm_cmpeq_epi32(a, b))
+    case INST_VBIG32:   SSE_INT(VGREATER_UNSIGNED(32, a, b))
+    case INST_VADDF32:  SSE_PS(vcanonical_ps(_mm_add_ps(a, b)))
+    case INST_VSUBF32:  SSE_PS(vcanonical_ps(_mm_sub_ps(a, b)))
+    case INST_VMULF32:  SSE_PS(vcanonical_ps(_mm_mul_ps(a, b)))
+    case INST_VMINF32:  SSE_PS(_mm_min_ps(a, b))
+    case INST_VMAXF32:  SSE_PS(_mm_max_ps(a, b))
+    case INST_VEQF32:   SSE_PS(_mm_cmpeq_ps(a, b))
+    case INST_VBIGF32:  SSE_PS(_mm_cmpgt_ps(a, b))
+    case INST_VADDF64:  SSE_PD(vcanonical_pd(_mm_add_pd(a, b)))
+    case INST_VSUBF64:  SSE_PD(vcanonical_pd(_mm_sub_pd(a, b)))
+    case INST_VMULF64:  SSE_PD(vcanonical_pd(_mm_mul_pd(a, b)))
+    case INST_VMINF64:  SSE_PD(_mm_min_pd(a, b))
+    case INST_VMAXF64:  SSE_PD(_mm_max_pd(a, b))
+    case INST_VEQF64:   SSE_PD(_mm_cmpeq_pd(a, b))
+    case INST_VBIGF64:  SSE_PD(_mm_cmpgt_pd(a, b))
+    case INST_VAND:     SSE_INT(_mm_and_si128(a, b))
+    case INST_VOR:      SSE_INT(_mm_or_si128(a, b))
+    case INST_VXOR:     SSE_INT(_mm_xor_si128(a, b))
+    case INST_VSPLAT8:  VSTOREI(V1, _mm_set1_epi8((char) R2.as_uint8));        return;
+    case INST_VSPLAT16: VSTOREI(V1, _mm_set1_epi16((short) R2.as_uint16));     return;
+    case INST_VSPLAT32: VSTOREI(V1, _mm_set1_epi32((int) R2.as_uint32));       return;
+    default:
+        break;
+    }
+    #undef SSE_INT
+    #undef SSE_PS
+    #undef SSE_PD
+#endif
+
+    // the arithmetic instructions come in groups of LANE_OPS, one group per lane type
+    if(opcode >= INST_VADD8 && opcode <= INST_VBIGF64){
+        switch ((opcode - INST_VADD8) / LANE_OPS)
+        {
+        case 0: switch ((opcode - INST_VADD8) % LANE_OPS){ PORTABLE_OPS(uint8,   16, uint8)  } break;
+        case 1: switch ((opcode - INST_VADD8) % LANE_OPS){ PORTABLE_OPS(uint16,  8,  uint16) } break;
+        case 2: switch ((opcode - INST_VADD8) % LANE_OPS){ PORTABLE_OPS(uint32,  4,  uint32) } break;
+        case 3: switch ((opcode - INST_VADD8) % LANE_OPS){ PORTABLE_OPS(float32, 4,  uint32) } break;
+        case 4: switch ((opcode - INST_VADD8) % LANE_OPS){ PORTABLE_OPS(float64, 2,  uint64) } break;
+        default: break;
+        }
+        return;
+    }
+
+    switch (opcode)
+    {
+    case INST_VAND:     LANES(uint64, 2, a.as_uint64[i] & b.as_uint64[i]) return;
+    case INST_VOR:      LANES(uint64, 2, a.as_uint64[i] | b.as_uint64[i]) return;
+    case INST_VXOR:     LANES(uint64, 2, a.as_uint64[i] ^ b.as_uint64[i]) return;
+    case INST_VSHUF:    vshuf(V1, V2, V3); return;
+    case INST_VLOAD:    memcpy(V1, (uint8_t*) R2.as_ptr + R3.as_int64, sizeof(VRegister)); return;
+    case INST_VSTORE:   memcpy((uint8_t*) R1.as_ptr + R3.as_int64, V2, sizeof(VRegister)); return;
+    case INST_VSPLAT8:  { const uint8_t  x = R2.as_uint8;  for(int i = 0; i < 16; i+=1) V1->as_uint8[i]  = x; } return;
+    case INST_VSPLAT16: { const uint16_t x = R2.as_uint16; for(int i = 0; i < 8;  i+=1) V1->as_uint16[i] = x; } return;
+    case INST_VSPLAT32: { const uint32_t x = R2.as_uint32; for(int i = 0; i < 4;  i+=1) V1->as_uint32[i] = x; } return;
+    case INST_VSPLAT64: { const uint64_t x = R2.as_uint64; for(int i = 0; i < 2;  i+=1) V1->as_uint64[i] = x; } return;
+    case INST_VGET8:    R1.as_uint8  = V2->as_uint8 [R3.as_uint64 % 16]; return;
+    case INST_VGET16:   R1.as_uint16 = V2->as_uint16[R3.as_uint64 % 8];  return;
+    case INST_VGET32:   R1.as_uint32 = V2->as_uint32[R3.as_uint64 % 4];  return;
+    case INST_VGET64:   R1.as_uint64 = V2->as_uint64[R3.as_uint64 % 2];  return;
+    case INST_VSET8:    V1->as_uint8 [R3.as_uint64 % 16] = R2.as_uint8;  return;
+    case INST_VSET16:   V1->as_uint16[R3.as_uint64 % 8]  = R2.as_uint16; return;
+    case INST_VSET32:   V1->as_uint32[R3.as_uint64 % 4]  = R2.as_uint32; return;
+    case INST_VSET64:   V1->as_uint64[R3.as_uint64 % 2]  = R2.as_uint64; return;
+    default:
+        return;
+    }
+
+    #undef V1
+    #undef V2
+    #undef V3
+    #undef R1
+    #undef R2
+    #undef R3
+    #undef LANES
+    #undef PORTABLE_OPS
+}
+
+#endif // =====================  END OF FILE VVECTOR_C ===========================
@@ -46,21 +46,7 @@ typedef struct Mc_stream_t{
 static inline int is_little_endian(){ return (*(unsigned short *)"\x01\x00" == 0x01); }
 
 int get_digit(char c){
-    switch (c)
-    {
-    case '0': return 0;
-    case '1': return 1;
-    case '2': return 2;
-    case '3': return 3;
-    case '4': return 4;
-    case '5': return 5;
-    case '6': return 6;
-    case '7': return 7;
-    case '8': return 8;
-    case '9': return 9;
-
-    default: return -1;
-    }
+    return (c >= '0' && c <= '9')? c - '0' : -1;
 }
 
 #define is_char_numeric(CHARACTER) (get_digit(CHARACTER) >= 0)
@@ -84,33 +70,11 @@ char get_char_digit(int d){
 }
 
 uint8_t get_hex_digit(char c){
-    switch (c)
-    {
-    case '0': return 0;
-    case '1': return 1;
-    case '2': return 2;
-    case '3': return 3;
-    case '4': return 4;
-    case '5': return 5;
-    case '6': return 6;
-    case '7': return 7;
-    case '8': return 8;
-    case '9': return 9;
-    case 'a':
-    case 'A': return 10;
-    case 'b':
-    case 'B': return 11;
-    case 'c':
-    case 'C': return 12;
-    case 'd':
-    case 'D': return 13;
-    case 'e':
-    case 'E': return 14;
-    case 'f':
-    case 'F': return 15;
-
-    default: return 255;
-    }
+    if(c >= '0' && c <= '9') return (uint8_t) (c - '0');
+    // setting bit 5 turns upper case letters into lower case ones
+    c |= 0x20;
+    if(c >= 'a' && c <= 'f') return (uint8_t) (c - 'a' + 10);
+    return 255;
 }
 
 // if you only wish to compare the strings up to where the first one terminates, pass _only_compare_till_first_null=1
@@ -121,6 +85,32 @@ int mc_compare_str(const char* str1, const char* str2, int _only_compare_till_fi
     return (str1[i] == str2[i]) || (_only_compare_till_first_null && (!str1[i] || !str2[i]));
 }
 
+#define MC_FNV1A32_OFFSET_BASIS 0x811C9DC5u
+#define MC_FNV1A32_PRIME        0x01000193u
+
+// 32 bit FNV-1a of size bytes at data, pass MC_FNV1A32_OFFSET_BASIS as hash or the result of a previous call to continue it
+static inline uint32_t mc_fnv1a32(uint32_t hash, const void* data, size_t size){
+    const uint8_t* const bytes = (const uint8_t*) data;
+    for(size_t i = 0; i < size; i+=1){
+        hash ^= bytes[i];
+        hash *= MC_FNV1A32_PRIME;
+    }
+    return hash;
+}
+
+#define MC_FNV1A64_OFFSET_BASIS 0xCBF29CE484222325ULL
+#define MC_FNV1A64_PRIME        0x00000100000001B3ULL
+
+// 64 bit FNV-1a, same as mc_fnv1a32 for when collisions have to be rare (hashes used as keys of files)
+static inline uint64_t mc_fnv1a64(uint64_t hash, const void* data, size_t size){
+    const uint8_t* const bytes = (const uint8_t*) data;
+    for(size_t i = 0; i < size; i+=1){
+        hash ^= bytes[i];
+        hash *= MC_FNV1A64_PRIME;
+    }
+    return hash;
+}
+
 static inline uint16_t mc_swap16(uint16_t x){
     return (
         ((x & 0X00FF) >> 8)  |
@@ -193,11 +183,15 @@ int virtual_free_aligned(void* ptr){
 // \returns pointer to beggining of streamed data in stream
 void* mc_stream(Mc_stream_t* stream, const void* data, size_t size){
     if(size + stream->size > stream->capacity){
+        // stream->size may already be past the old capacity when callers reserve memory by growing it first
+        const size_t old_size = (stream->size < stream->capacity)? stream->size : stream->capacity;
         if(stream->capacity == 0) stream->capacity = size + stream->size;
         else stream->capacity *= 1 + (size_t)((size + stream->size) / stream->capacity);
         void* old_data = stream->data;
         stream->data = virtual_alloc_aligned(stream->capacity, stream->alignment);
-        memcpy(stream->data, old_data, stream->size);
+        if(old_size) memcpy(stream->data, old_data, old_size);
+        // so reserved but unwritten bytes (padding) are deterministic
+        memset((uint8_t*) stream->data + old_size, 0, stream->capacity - old_size);
         virtual_free_aligned(old_data);
     }
     void* const dest = (void*) (((uintptr_t) stream->data) + stream->size);
@@ -236,7 +230,9 @@ static inline void* mc_stream_on(const Mc_stream_t* stream, uint64_t index){ ret
 
 
 Mc_stream_t mc_create_stream(uint64_t capacity, uint8_t alignment){
-    return (Mc_stream_t){.data = virtual_alloc_aligned(capacity, alignment), .size = 0, .capacity = capacity, .alignment = alignment};
+    Mc_stream_t stream = (Mc_stream_t){.data = virtual_alloc_aligned(capacity, alignment), .size = 0, .capacity = capacity, .alignment = alignment};
+    if(stream.data) memset(stream.data, 0, capacity);
+    return stream;
 }
 
 void mc_destroy_stream(Mc_stream_t stream){
@@ -3,18 +3,67 @@
 
 #include "core.h"
 #include "virtual.h"
+#include "lz.h"
+
+#if !defined(_WIN32) && (defined(__unix__) || defined(__APPLE__)) && !defined(VIRTUAL_FILE_NO_MMAP)
+    #define VIRTUAL_FILE_MMAP 1
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#else
+    #define VIRTUAL_FILE_MMAP 0
+#endif
 
 #define VIRTUAL_FILE_MAGIC_NUMBER "VF:"
 
+// magic number, file flags, xflag, file type, field count and data size
+#define VIRTUAL_FILE_HEADER_SIZE (sizeof(VIRTUAL_FILE_MAGIC_NUMBER) + 1 + 1 + 2 + 8 + 8)
+
 #define VIRTUAL_FILE_INTERNAL_FLAG_IS_LITTLE_ENDIAN 1
 
 #define VIRTUAL_FILE_PROGRAM_FIELD_NAME "program"
 #define VIRTUAL_FILE_LABELS_FIELD_NAME "labels"
 #define VIRTUAL_FILE_STATIC_FIELD_NAME "static"
+// the first field of files from VIRTUAL_FILE_DIRECTORY_VERSION on, lists every other field
+#define VIRTUAL_FILE_DIRECTORY_FIELD_NAME "dir"
+// filler vfsave puts between fields so every field starts 8 byte aligned in the file, readers skip it as any unknown field
+#define VIRTUAL_FILE_PADDING_FIELD_NAME "pad"
+
+// the format revision vfsave writes, stored in xflag
+#define VIRTUAL_FILE_VERSION 2
+// files from this revision on start with a directory field, older ones (xflag 0) are only read sequentially
+#define VIRTUAL_FILE_DIRECTORY_VERSION 1
+// files from this revision on have flags in their directory entries
+#define VIRTUAL_FILE_COMPRESSION_VERSION 2
+
+// the field is stored as [size]["id\0"][uint64_t decompressed data size][lz compressed data], see lz.h
+#define VIRTUAL_FILE_FIELD_FLAG_LZ 1
+
+// an entry of the directory field, which is laid out as
+// [uint64_t size]["dir\0"][uint32_t entry count][entry count * VirtualFileDirEntry]
+typedef struct VirtualFileDirEntry{
+    char        name[8];
+    // of the field's size, relative to the beginning of the file's data
+    uint64_t    offset;
+    // of the whole field, as stored in its first 8 bytes
+    uint64_t    size;
+    uint16_t    alignment;
+    // VIRTUAL_FILE_FIELD_FLAG_*, from VIRTUAL_FILE_COMPRESSION_VERSION on
+    uint16_t    flags;
+    // FNV-1a of the whole field as stored in the file
+    uint32_t    checksum;
+} VirtualFileDirEntry;
+
+#define VIRTUAL_FILE_DIRECTORY_HEADER_SIZE (sizeof(uint64_t) + sizeof(VIRTUAL_FILE_DIRECTORY_FIELD_NAME) + sizeof(uint32_t))
 
 enum VirtualFileTypes{
     VIRTUAL_FILE_TYPE_UNKNOWN = 0,
     VIRTUAL_FILE_TYPE_EXE,
+    // an include recorded by the assembler's include cache, see include_cache.h
+    VIRTUAL_FILE_TYPE_INCLUDE,
+    // a relocatable object, see object.h
+    VIRTUAL_FILE_TYPE_OBJECT,
 
     // for counting purposes
     VIRTUAL_FILE_TYPE_COUNT
@@ -25,14 +74,17 @@ typedef struct VirtualFile
     int         validated;
     const char* name;
     uint8_t     file_flags;
-    // for now this is just padding to garantee that if the file is read into an 8 byte aligned buffer
-    // the beginning of the file's data will also be aligned to 8 bytes
+    // the format revision (VIRTUAL_FILE_VERSION), a single byte so the header stays 24 bytes long
+    // and the beginning of the file's data is 8 byte aligned whenever the file is
     uint8_t     xflag;
     uint16_t    vfile_type;
     uint64_t    field_count;
     uint64_t    file_data_size;
     uint64_t*   fields;
     void*       data;
+    // set by vfmap, the whole file as mapped in memory (data points inside it), NULL when the file was read with vfopen
+    void*       mapping;
+    uint64_t    mapping_size;
 } VirtualFile;
 
 
@@ -76,6 +128,66 @@ static inline VirtualFile create_virtual_file(
     };
 }
 
+// whether the file was written on a machine with the same endianness, the directory is only used then
+static inline int _vf_native_endianness(uint8_t file_flags){
+    return ((file_flags & VIRTUAL_FILE_INTERNAL_FLAG_IS_LITTLE_ENDIAN) != 0) == (is_little_endian() != 0);
+}
+
+static inline uint16_t _vf_entry_flags(uint8_t version, const VirtualFileDirEntry* entry){
+    return (version >= VIRTUAL_FILE_COMPRESSION_VERSION)? entry->flags : 0;
+}
+
+// like query_field but leaves the field arrays as they are
+static inline int _vf_field_wanted(const char* field, const char** required_fields, const char** optional_fields){
+    for(int i = 0; required_fields && required_fields[i]; i+=1) if(mc_compare_str(field, required_fields[i], 0)) return 1;
+    for(int i = 0; optional_fields && optional_fields[i]; i+=1) if(mc_compare_str(field, optional_fields[i], 0)) return 1;
+    return 0;
+}
+
+// validates the directory field at field, data_size being the size of the file's data
+// \returns the directory's entries or NULL if it is not a valid directory
+static inline const VirtualFileDirEntry* _vf_directory_entries(const uint8_t* field, uint64_t data_size, uint32_t* entry_count){
+    uint64_t size;
+    uint32_t count;
+    memcpy(&size, field, sizeof(size));
+    memcpy(&count, field + sizeof(size) + sizeof(VIRTUAL_FILE_DIRECTORY_FIELD_NAME), sizeof(count));
+    if(memcmp(field + sizeof(size), VIRTUAL_FILE_DIRECTORY_FIELD_NAME, sizeof(VIRTUAL_FILE_DIRECTORY_FIELD_NAME))) return NULL;
+    if(size > data_size || size != VIRTUAL_FILE_DIRECTORY_HEADER_SIZE + (uint64_t) count * sizeof(VirtualFileDirEntry)) return NULL;
+    const VirtualFileDirEntry* const entries = (const VirtualFileDirEntry*) (field + VIRTUAL_FILE_DIRECTORY_HEADER_SIZE);
+    for(uint32_t i = 0; i < count; i+=1){
+        const VirtualFileDirEntry* const entry = &entries[i];
+        if(memchr(entry->name, '\0', sizeof(entry->name)) == NULL || entry->name[0] == '\0') return NULL;
+        if(entry->offset < size || entry->size > data_size || entry->offset > data_size - entry->size) return NULL;
+        if(entry->size < sizeof(uint64_t) + strlen(entry->name) + 1) return NULL;
+    }
+    *entry_count = count;
+    return entries;
+}
+
+// reads the directory field at the current position of f into a new allocation, the entries are at
+// VIRTUAL_FILE_DIRECTORY_HEADER_SIZE in it
+// \returns NULL if f has no valid directory there
+static inline uint8_t* _vfread_directory(FILE* f, uint64_t data_size, uint32_t* entry_count, const VirtualFileDirEntry** entries){
+    uint8_t header[VIRTUAL_FILE_DIRECTORY_HEADER_SIZE];
+    if(fread(header, 1, sizeof(header), f) != sizeof(header)) return NULL;
+    uint64_t size;
+    memcpy(&size, header, sizeof(size));
+    if(size < sizeof(header) || size > data_size) return NULL;
+    uint8_t* const directory = (uint8_t*) malloc((size_t) size);
+    if(!directory) return NULL;
+    memcpy(directory, header, sizeof(header));
+    if(fread(directory + sizeof(header), 1, (size_t) (size - sizeof(header)), f) != size - sizeof(header)){
+        free(directory);
+        return NULL;
+    }
+    *entries = _vf_directory_entries(directory, data_size, entry_count);
+    if(*entries == NULL){
+        free(directory);
+        return NULL;
+    }
+    return directory;
+}
+
 static inline int _vfopen_all_fields_found(const char** required_fields, const char** optional_fields){
     if(required_fields || optional_fields)     return 0;
     if(required_fields) if(required_fields[0]) return 0;
@@ -96,6 +208,9 @@ int vfopen(VirtualFile* vfile, const char* path, const char** required_fields, c
 
     vfile->name = NULL;
 
+    vfile->mapping = NULL;
+    vfile->mapping_size = 0;
+
     int err = 0;
 
     char magic_number[5];
@@ -105,6 +220,11 @@ int vfopen(VirtualFile* vfile, const char* path, const char** required_fields, c
 
     size_t meta_data_block = 0;
 
+    uint8_t* directory = NULL;
+    const VirtualFileDirEntry* entries = NULL;
+    uint32_t entry_count = 0;
+    uint32_t next_entry = 0;
+
     FILE* f = fopen(path, "rb");
 
     if(!f){
@@ -161,11 +281,31 @@ int vfopen(VirtualFile* vfile, const char* path, const char** required_fields, c
 
     vfile->field_count = 0;
 
+    if(vfile->xflag >= VIRTUAL_FILE_DIRECTORY_VERSION && _vf_native_endianness(vfile->file_flags)){
+        VIRTUAL_DEBUG_LOG("reading field directory\n");
+        directory = _vfread_directory(f, vfile->file_data_size, &entry_count, &entries);
+        if(!directory){
+            DEFER_ERROR("invalid field directory\n");
+        }
+    }
+
     for(size_t i = 0; i < vfile->file_data_size && !_vfopen_all_fields_found(required_fields, optional_fields); meta_data_block += 1){
         uint64_t size;
         uint64_t buff = 0;
         char*    id = (char*) &buff;
 
+        // with a directory only the wanted fields are visited
+        const VirtualFileDirEntry* entry = NULL;
+        if(directory){
+            for(; next_entry < entry_count && !_vf_field_wanted(entries[next_entry].name, required_fields, optional_fields); next_entry+=1);
+            if(next_entry >= entry_count) break;
+            entry = &entries[next_entry++];
+            i = (size_t) entry->offset;
+            if(fseek(f, (long) (VIRTUAL_FILE_HEADER_SIZE + entry->offset), SEEK_SET)){
+                DEFER_ERROR("failed to seek field '%s' at %"PRIu64"\n", entry->name, entry->offset);
+            }
+        }
+
         VIRTUAL_DEBUG_LOG("reading field %zu at position %zu relative to data, and %li relative to file's start\n", meta_data_block, i, ftell(f));
 
         if(fread(&size, 1, sizeof(size), f) != sizeof(size))
@@ -203,7 +343,45 @@ int vfopen(VirtualFile* vfile, const char* path, const char** required_fields, c
             VIRTUAL_DEBUG_LOG("field is not required\n");
             field = query_field(id, optional_fields);
         }
-        if(field >= 0){
+        if(field >= 0 && entry && (_vf_entry_flags(vfile->xflag, entry) & VIRTUAL_FILE_FIELD_FLAG_LZ)){
+            // decompressed straight into the stream while it is read, the field ends up as if it was never compressed
+            uint64_t raw_size;
+            if(size < sizeof(size) + id_len + 1 + sizeof(raw_size) || fread(&raw_size, 1, sizeof(raw_size), f) != sizeof(raw_size)){
+                DEFER_ERROR("compressed field '%s' is too small\n", id);
+            }
+            uint64_t compressed_size = size - sizeof(size) - id_len - 1 - sizeof(raw_size);
+            // a compressed byte can not stand for more than 255 decompressed ones
+            if(raw_size / 256 > compressed_size){
+                DEFER_ERROR("compressed field '%s' is corrupted\n", id);
+            }
+            const uint64_t raw_field_size = sizeof(size) + id_len + 1 + raw_size;
+            const uintptr_t data = (uintptr_t) mc_stream_aligned(&stream, NULL, raw_field_size, 8);
+            *((uint64_t*) data) = raw_field_size;
+            memcpy((void*) (data + sizeof(size)), id, id_len + 1);
+
+            uint32_t checksum = mc_fnv1a32(MC_FNV1A32_OFFSET_BASIS, &size, sizeof(size));
+            checksum = mc_fnv1a32(checksum, id, id_len + 1);
+            checksum = mc_fnv1a32(checksum, &raw_size, sizeof(raw_size));
+
+            LzDecoder decoder = lz_create_decoder((void*) (data + sizeof(size) + id_len + 1), raw_size);
+            uint8_t chunk[16 * 1024];
+            while(compressed_size){
+                const size_t chunk_size = (compressed_size < sizeof(chunk))? (size_t) compressed_size : sizeof(chunk);
+                if(fread(chunk, 1, chunk_size, f) != chunk_size){
+                    DEFER_ERROR("file ended abrubtly in compressed field '%s'\n", id);
+                }
+                checksum = mc_fnv1a32(checksum, chunk, chunk_size);
+                if(lz_decode(&decoder, chunk, chunk_size)){
+                    DEFER_ERROR("compressed field '%s' is corrupted\n", id);
+                }
+                compressed_size -= chunk_size;
+            }
+            if(!lz_decoder_done(&decoder) || size != entry->size || checksum != entry->checksum){
+                DEFER_ERROR("field '%s' is corrupted, it does not match its directory entry\n", entry->name);
+            }
+            vfile->field_count += 1;
+        }
+        else if(field >= 0){
             const uintptr_t data = (uintptr_t) mc_stream_aligned(&stream, NULL, size, 8);
             VIRTUAL_DEBUG_LOG("streaming field data to %p at %"PRIu64" stream position\n", (void*) data, data - (uintptr_t) stream.data);
             *((uint64_t*) data) = size;
@@ -213,6 +391,11 @@ int vfopen(VirtualFile* vfile, const char* path, const char** required_fields, c
                 DEFER_ERROR("field %zu 0x%.*"PRIx64" was not read properly, expected to read %zu bytes, read %zu instead\n",
                     meta_data_block, id_len, buff, (size_t) (size - sizeof(size) - id_len - 1), read);
             }
+            if(entry){
+                if(size != entry->size || mc_fnv1a32(MC_FNV1A32_OFFSET_BASIS, (const void*) data, size) != entry->checksum){
+                    DEFER_ERROR("field '%s' is corrupted, it does not match its directory entry\n", entry->name);
+                }
+            }
             vfile->field_count += 1;
         }
         if(field < 0){
@@ -263,6 +446,7 @@ int vfopen(VirtualFile* vfile, const char* path, const char** required_fields, c
 
     defer:
     VIRTUAL_DEBUG_LOG("cleaning up\n");
+    free(directory);
     if(f) fclose(f);
     if(err){
         mc_destroy_stream(stream);
@@ -274,6 +458,176 @@ int vfopen(VirtualFile* vfile, const char* path, const char** required_fields, c
     return err;
 }
 
+// maps the file at path instead of reading it, the fields returned by get_virtual_file_field point straight into
+// the mapping so nothing is copied. The mapping is private, so writes to it (to static memory for example) stay
+// in this process and never reach the file.
+// files whose fields are not all 8 byte aligned (written before vfsave padded them), files with compressed
+// fields and files of the other endianness, as well as systems without mmap, go through vfopen instead.
+// directory checksums are only verified by vfopen, checking them here would read the whole file in
+// \returns 0 on success or 1 otherwise
+int vfmap(VirtualFile* vfile, const char* path, const char** required_fields, const char** optional_fields){
+
+#if VIRTUAL_FILE_MMAP
+
+    VIRTUAL_DEBUG_LOG("mapping vfile '%s' to %p\n", path, vfile);
+
+    if(!vfile){
+        fprintf(stderr, "[INTERNAL ERROR] " __FILE__ "%i:0: missing output vfile\n", __LINE__);
+        return 1;
+    }
+
+    vfile->validated = 0;
+    vfile->name = NULL;
+    vfile->fields = NULL;
+    vfile->data = NULL;
+    vfile->mapping = NULL;
+    vfile->mapping_size = 0;
+
+    int err = 0;
+
+    uint8_t* mapping = NULL;
+    size_t   mapping_size = 0;
+    uint64_t field_count = 0;
+
+    const int fd = open(path, O_RDONLY);
+    if(fd < 0){
+        DEFER_ERROR("could not open file\n");
+    }
+
+    struct stat file_stat;
+    if(fstat(fd, &file_stat) || file_stat.st_size < (off_t) VIRTUAL_FILE_HEADER_SIZE){
+        DEFER_ERROR("file is too small to be a virtual file\n");
+    }
+    mapping_size = (size_t) file_stat.st_size;
+
+    mapping = (uint8_t*) mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if((void*) mapping == MAP_FAILED){
+        mapping = NULL;
+        DEFER_ERROR("could not map file\n");
+    }
+
+    if(memcmp(mapping, VIRTUAL_FILE_MAGIC_NUMBER, sizeof(VIRTUAL_FILE_MAGIC_NUMBER))){
+        DEFER_ERROR("magic number '%.*s' does not match expected '%s'\n",
+            (int) sizeof(VIRTUAL_FILE_MAGIC_NUMBER), (char*) mapping, VIRTUAL_FILE_MAGIC_NUMBER);
+    }
+
+    uint8_t* const header = mapping + sizeof(VIRTUAL_FILE_MAGIC_NUMBER);
+    vfile->file_flags = header[0];
+    vfile->xflag      = header[1];
+    memcpy(&vfile->vfile_type, header + 2, sizeof(vfile->vfile_type));
+    memcpy(&vfile->field_count, header + 4, sizeof(vfile->field_count));
+    memcpy(&vfile->file_data_size, header + 12, sizeof(vfile->file_data_size));
+
+    uint8_t* const data = mapping + VIRTUAL_FILE_HEADER_SIZE;
+
+    int aligned = _vf_native_endianness(vfile->file_flags);
+
+    if(aligned && vfile->file_data_size > mapping_size - VIRTUAL_FILE_HEADER_SIZE){
+        DEFER_ERROR("file's data size %"PRIu64" overflows the file\n", vfile->file_data_size);
+    }
+
+    // validates the fields and makes sure they can be used in place before touching the field lists,
+    // since query_field removes what it finds from them
+    const VirtualFileDirEntry* entries = NULL;
+    uint32_t entry_count = 0;
+    if(aligned && vfile->xflag >= VIRTUAL_FILE_DIRECTORY_VERSION){
+        if(vfile->file_data_size < VIRTUAL_FILE_DIRECTORY_HEADER_SIZE ||
+           (entries = _vf_directory_entries(data, vfile->file_data_size, &entry_count)) == NULL){
+            DEFER_ERROR("invalid field directory\n");
+        }
+        // only the listed fields are looked at, the rest of the file is never touched
+        for(uint32_t e = 0; e < entry_count; e+=1){
+            const VirtualFileDirEntry* const entry = &entries[e];
+            // compressed fields have to be decompressed somewhere, vfopen does that while reading them
+            if(entry->offset % 8 || ((_vf_entry_flags(vfile->xflag, entry) & VIRTUAL_FILE_FIELD_FLAG_LZ) &&
+               _vf_field_wanted(entry->name, required_fields, optional_fields))){
+                aligned = 0;
+                break;
+            }
+            if(*(uint64_t*) (data + entry->offset) != entry->size || !mc_compare_str((const char*) (data + entry->offset + sizeof(uint64_t)), entry->name, 0)){
+                DEFER_ERROR("field '%s' does not match its directory entry\n", entry->name);
+            }
+        }
+        field_count = entry_count;
+    }
+
+    for(uint64_t i = 0; aligned && !entries && i < vfile->file_data_size; field_count += 1){
+        uint64_t size;
+        if(i + sizeof(size) > vfile->file_data_size){
+            DEFER_ERROR("meta data block %"PRIu64" at position %"PRIu64" is cut short\n", field_count, i);
+        }
+        memcpy(&size, data + i, sizeof(size));
+        if(size < sizeof(size) + 2 || size > vfile->file_data_size - i){
+            DEFER_ERROR("meta data block %"PRIu64" at position %"PRIu64" has invalid size %"PRIu64"\n", field_count, i, size);
+        }
+        const char* const id = (const char*) (data + i + sizeof(size));
+        int id_len = 0;
+        for(; id_len < 8 && id_len + sizeof(size) < size && id[id_len]; id_len+=1);
+        if(id_len >= 8 || id_len == 0 || id_len + sizeof(size) >= size){
+            DEFER_ERROR("field %"PRIu64" has an invalid id\n", field_count);
+        }
+        // only the padding itself may be misaligned
+        if(i % 8 && !mc_compare_str(id, VIRTUAL_FILE_PADDING_FIELD_NAME, 0)) aligned = 0;
+        i += size;
+    }
+
+    if(!aligned){
+        VIRTUAL_DEBUG_LOG("'%s' can not be used in place, reading it instead\n", path);
+        munmap(mapping, mapping_size);
+        close(fd);
+        return vfopen(vfile, path, required_fields, optional_fields);
+    }
+
+    vfile->fields = (uint64_t*) malloc((field_count + 1) * sizeof(vfile->fields[0]));
+    if(!vfile->fields){
+        DEFER_ERROR("could not allocate fields\n");
+    }
+
+    vfile->field_count = 0;
+
+    for(uint32_t e = 0; entries && e < entry_count; e+=1){
+        int field = query_field(entries[e].name, required_fields);
+        if(field < 0) field = query_field(entries[e].name, optional_fields);
+        if(field >= 0) vfile->fields[vfile->field_count++] = entries[e].offset;
+    }
+
+    for(uint64_t i = 0; !entries && i < vfile->file_data_size;){
+        uint64_t size;
+        memcpy(&size, data + i, sizeof(size));
+        const char* const id = (const char*) (data + i + sizeof(size));
+        int field = query_field(id, required_fields);
+        if(field < 0) field = query_field(id, optional_fields);
+        if(field >= 0) vfile->fields[vfile->field_count++] = i;
+        i += size;
+    }
+
+    if(required_fields){
+        if(required_fields[0])
+            DEFER_ERROR("missing required field '%s'\n", required_fields[0]);
+    }
+
+    vfile->data = data;
+    vfile->mapping = mapping;
+    vfile->mapping_size = mapping_size;
+    vfile->validated = 1;
+
+    defer:
+    if(fd >= 0) close(fd);
+    if(err){
+        if(mapping) munmap(mapping, mapping_size);
+        free(vfile->fields);
+        vfile->fields = NULL;
+        vfile->data = NULL;
+        VIRTUAL_DEBUG_ERR("could not map virtual file '%s'\n", path);
+    }
+    else VIRTUAL_DEBUG_LOG("mapped virtual file '%s' to %p\n", path, vfile);
+    return err;
+
+#else
+    return vfopen(vfile, path, required_fields, optional_fields);
+#endif
+}
+
 // \param name the fields name (up to 8 characters including null termination), if the name is already in data pass NULL
 // \param data_size the data size in bytes
 int add_virtual_file_field(VirtualFile* vfile, const char* name, uint64_t data_size, void* data){
@@ -293,10 +647,18 @@ int add_virtual_file_field(VirtualFile* vfile, const char* name, uint64_t data_s
         }
     }
 
+    // fields are 8 byte aligned in memory but packed in the file, so file_data_size can fall short of where the
+    // last field actually ends in vfile->data, appending there would overwrite that field's tail
+    uint64_t data_end = vfile->file_data_size;
+    for(uint64_t i = 0; vfile->data && i < vfile->field_count; i+=1){
+        const uint64_t field_end = vfile->fields[i] + *(uint64_t*)((uint8_t*)(vfile->data) + vfile->fields[i]);
+        if(field_end > data_end) data_end = field_end;
+    }
+
     Mc_stream_t stream = (Mc_stream_t){
         .data = vfile->data,
-        .size = vfile->file_data_size,
-        .capacity = vfile->file_data_size,
+        .size = data_end,
+        .capacity = data_end,
         .alignment = 8
     };
 
@@ -359,7 +721,25 @@ void* get_virtual_file_field(const VirtualFile vfile, const char* field){
     return NULL;
 }
 
+// the contents of field in vfile (what follows its size and id) and their size in bytes, NULL if vfile has no such field
+static inline const uint8_t* get_virtual_file_field_data(const VirtualFile vfile, const char* field, uint64_t* size){
+    const uint8_t* const data = (const uint8_t*) get_virtual_file_field(vfile, field);
+    if(!data) return NULL;
+    const uint64_t header_size = sizeof(uint64_t) + strlen(field) + 1;
+    const uint64_t field_size = *(const uint64_t*) data;
+    if(field_size < header_size) return NULL;
+    *size = field_size - header_size;
+    return data + header_size;
+}
+
 static inline void vfclose(VirtualFile vfile){
+#if VIRTUAL_FILE_MMAP
+    if(vfile.mapping){
+        munmap(vfile.mapping, (size_t) vfile.mapping_size);
+        free(vfile.fields);
+        return;
+    }
+#endif
     if(vfile.data) virtual_free_aligned(vfile.data);
 }
 
@@ -392,7 +772,39 @@ Inst* get_program_from_vfield(const void* _field, uint64_t* _program_size, uint6
     return (Inst*) (field + sizeof(field_size) + sizeof(VIRTUAL_FILE_PROGRAM_FIELD_NAME));
 }
 
-int vfsave(const VirtualFile vfile, const char* path){
+// the size of the padding field that takes a field at position up to the next 8 byte boundary, 0 if it is already there
+static inline uint64_t _vfsave_padding_size(uint64_t position){
+    const uint64_t min_size = sizeof(uint64_t) + sizeof(VIRTUAL_FILE_PADDING_FIELD_NAME);
+    uint64_t padding = (8 - position % 8) % 8;
+    if(padding == 0) return 0;
+    while(padding < min_size) padding += 8;
+    return padding;
+}
+
+// stores the fields [size]["id\0"][uint64_t data size][lz compressed data] (see VIRTUAL_FILE_FIELD_FLAG_LZ),
+// \returns the stored field or NULL if compressing it does not make it smaller
+static inline uint8_t* _vfsave_compress_field(const uint8_t* field){
+    uint64_t size;
+    memcpy(&size, field, sizeof(size));
+    const uint64_t id_size = strlen((const char*) field + sizeof(size)) + 1;
+    const uint64_t header_size = sizeof(size) + id_size + sizeof(uint64_t);
+    const uint64_t raw_size = size - sizeof(size) - id_size;
+    uint8_t* const stored = (uint8_t*) malloc((size_t) (header_size + lz_compress_bound(raw_size)));
+    if(!stored) return NULL;
+    const uint64_t compressed_size = lz_compress(field + sizeof(size) + id_size, raw_size, stored + header_size);
+    const uint64_t stored_size = header_size + compressed_size;
+    if(compressed_size == 0 || stored_size >= size){
+        free(stored);
+        return NULL;
+    }
+    memcpy(stored, &stored_size, sizeof(stored_size));
+    memcpy(stored + sizeof(size), field + sizeof(size), (size_t) id_size);
+    memcpy(stored + sizeof(size) + id_size, &raw_size, sizeof(raw_size));
+    return stored;
+}
+
+// \param compressed_fields NULL terminated list of the fields to compress (when that makes them smaller), can be NULL
+int vfsave(const VirtualFile vfile, const char* path, const char** compressed_fields){
 
     if(!vfile.validated){
         fprintf(
@@ -408,11 +820,52 @@ int vfsave(const VirtualFile vfile, const char* path){
 
     VIRTUAL_DEBUG_LOG("saving vfile '%s' to '%s'\n", vfile.name, path);
 
+    // the directory goes first and lists every field, every field is written 8 byte aligned so vfmap can
+    // use the file in place (the header and the directory already are multiples of 8 bytes long)
+    const uint64_t directory_size = VIRTUAL_FILE_DIRECTORY_HEADER_SIZE + vfile.field_count * sizeof(VirtualFileDirEntry);
+    uint8_t* const directory = (uint8_t*) calloc((size_t) directory_size, 1);
+    // the compressed version of each field, NULL for the ones stored as they are
+    uint8_t** const compressed = (uint8_t**) calloc((size_t) vfile.field_count + 1, sizeof(uint8_t*));
+    if(!directory || !compressed){
+        fprintf(stderr, "[ERROR] could not allocate field directory for '%s'\n", path);
+        free(directory);
+        free(compressed);
+        return 1;
+    }
+    VirtualFileDirEntry* const entries = (VirtualFileDirEntry*) (directory + VIRTUAL_FILE_DIRECTORY_HEADER_SIZE);
+    const uint32_t entry_count = (uint32_t) vfile.field_count;
+    memcpy(directory, &directory_size, sizeof(directory_size));
+    memcpy(directory + sizeof(directory_size), VIRTUAL_FILE_DIRECTORY_FIELD_NAME, sizeof(VIRTUAL_FILE_DIRECTORY_FIELD_NAME));
+    memcpy(directory + sizeof(directory_size) + sizeof(VIRTUAL_FILE_DIRECTORY_FIELD_NAME), &entry_count, sizeof(entry_count));
+
+    uint64_t field_count = vfile.field_count + 1;
+    uint64_t file_data_size = directory_size;
+    for(uint64_t i = 0; i < vfile.field_count; i+=1){
+        const uint8_t* field = ((const uint8_t*) vfile.data) + vfile.fields[i];
+        const uint64_t padding = _vfsave_padding_size(file_data_size);
+        if(padding) field_count += 1;
+        file_data_size += padding;
+        VirtualFileDirEntry* const entry = &entries[i];
+        strncpy(entry->name, (const char*) field + sizeof(uint64_t), sizeof(entry->name) - 1);
+        if(_vf_field_wanted(entry->name, compressed_fields, NULL) && (compressed[i] = _vfsave_compress_field(field))){
+            field = compressed[i];
+            entry->flags |= VIRTUAL_FILE_FIELD_FLAG_LZ;
+        }
+        memcpy(&entry->size, field, sizeof(entry->size));
+        entry->offset    = file_data_size;
+        entry->alignment = 8;
+        entry->checksum  = mc_fnv1a32(MC_FNV1A32_OFFSET_BASIS, field, (size_t) entry->size);
+        file_data_size += entry->size;
+    }
+
+    const uint8_t version = VIRTUAL_FILE_VERSION;
+
     FILE* f = fopen(path, "wb");
 
     if(!f){
         fprintf(stderr, "[ERROR] could not open '%s'\n", path);
-        return 1;
+        err = 1;
+        goto defer;
     }
 
     if(fwrite(VIRTUAL_FILE_MAGIC_NUMBER, 1, sizeof(VIRTUAL_FILE_MAGIC_NUMBER), f) != sizeof(VIRTUAL_FILE_MAGIC_NUMBER))
@@ -420,27 +873,45 @@ int vfsave(const VirtualFile vfile, const char* path){
 
     if(fwrite(&vfile.file_flags , 1, sizeof(vfile.file_flags), f) != sizeof(vfile.file_flags))
         DEFER_ERROR("failed to write internal_flags\n");
-    if(fwrite(&vfile.xflag          , 1, sizeof(vfile.xflag)         , f) != sizeof(vfile.xflag))
+    if(fwrite(&version              , 1, sizeof(version)             , f) != sizeof(version))
         DEFER_ERROR("failed to write xflag\n");
     if(fwrite(&vfile.vfile_type     , 1, sizeof(vfile.vfile_type)    , f) != sizeof(vfile.vfile_type))
         DEFER_ERROR("failed to write virtual_file_type\n");
-    if(fwrite(&vfile.field_count, 1 ,    sizeof(vfile.field_count)   , f) != sizeof(vfile.field_count))
+    if(fwrite(&field_count, 1 ,    sizeof(field_count)   , f) != sizeof(field_count))
         DEFER_ERROR("failed to write field_count\n");
-    if(fwrite(&vfile.file_data_size , 1, sizeof(vfile.file_data_size), f) != sizeof(vfile.file_data_size))
+    if(fwrite(&file_data_size , 1, sizeof(file_data_size), f) != sizeof(file_data_size))
         DEFER_ERROR("failed to write file_data_size\n");
 
+    if(fwrite(directory, 1, (size_t) directory_size, f) != directory_size)
+        DEFER_ERROR("failed to write field directory\n");
+
+    uint64_t written = directory_size;
+
     for(uint64_t i = 0; i < vfile.field_count; i+=1){
-        const void* field = (void*) (((uintptr_t) vfile.data) + vfile.fields[i]);
-        uint64_t field_size = *(uint64_t*) field;
-        const char* const id = ((uint8_t*) field) + sizeof(field_size);
-        VIRTUAL_DEBUG_LOG("writing field '%s' of size %"PRIu64"\n", id, field_size);
+        const uint64_t padding = _vfsave_padding_size(written);
+        if(padding){
+            uint8_t padding_field[24] = {0};
+            memcpy(padding_field, &padding, sizeof(padding));
+            memcpy(padding_field + sizeof(padding), VIRTUAL_FILE_PADDING_FIELD_NAME, sizeof(VIRTUAL_FILE_PADDING_FIELD_NAME));
+            if(fwrite(padding_field, 1, padding, f) != padding)
+                DEFER_ERROR("failed to write padding before field %"PRIu64 "\n", i);
+            written += padding;
+        }
+        const void* field = compressed[i]? (void*) compressed[i] : (void*) (((uintptr_t) vfile.data) + vfile.fields[i]);
+        uint64_t field_size;
+        memcpy(&field_size, field, sizeof(field_size));
+        VIRTUAL_DEBUG_LOG("writing field '%s' of size %"PRIu64"\n", (const char*) field + sizeof(field_size), field_size);
         if(fwrite(field, 1, field_size, f) != field_size)
             DEFER_ERROR("failed to write field %"PRIu64 "\n", i);
+        written += field_size;
     }
 
     defer:
     VIRTUAL_DEBUG_LOG("cleaning up\n");
     if(f) fclose(f);
+    for(uint64_t i = 0; i < vfile.field_count; i+=1) free(compressed[i]);
+    free(compressed);
+    free(directory);
     return err;
 }
 
@@ -3,6 +3,7 @@ import platform
 import sys
 import subprocess
 import locale
+import shutil
 
 ENCODING = locale.getpreferredencoding()
 print(f"Default encoding: {ENCODING}")
@@ -13,12 +14,28 @@ PRECOMP_DIR = sys.argv[3]
 
 PRECOMPUTE: bool = len(sys.argv) > 4
 
+# 'returncode' is the exit code the example has to end with (0 if missing), 'stdout' what it has to print and 'stderr'
+# something its stderr has to have, on every engine
 special_cases = [
     {
         'example_name': "input",
         'text': True,
         'shell': True,
         'input': "test message!"
+    },
+    {
+        'example_name': "stack_overflow",
+        'returncode': 1,
+        'stdout': "recursing until the stack overflows\n",
+        'stderr': "[ERROR] Stack Overflow"
+    },
+    {
+        'example_name': "bulk_memory",
+        'stdout': "3808858755\n3808858755\n4014398263\n1373170073\n18\n5\n0\n" + "*" * 32 + "\n128\n"
+    },
+    {
+        'example_name': "atomics",
+        'stdout': "40\n42\n1\n100\n0\n100\n111\n7\n0\n0\n40000\n"
     }
 ]
 
@@ -38,6 +55,19 @@ DISASSEMBLE = VPU + " -disassemble"
 RUN         = VPU + " -execute"
 DEBUG       = VPU + " -debug -0"
 
+COMPILE_C   = VPU + " -compile-c"
+CFG         = VPU + " -cfg"
+# the C compiler used to build the output of -compile-c, the check is skipped if there is none
+CC          = shutil.which("cc") or shutil.which("gcc") or shutil.which("clang")
+SRC_DIR     = os.path.join(os.path.dirname(os.path.abspath(sys.argv[0])), "..", "src")
+
+# every alternative way of running a program, their output has to match the one from RUN
+ALTERNATIVE_RUNS = [
+    VPU + " -engine switch -execute",
+    VPU + " -jit -execute",
+    VPU + " -profile -execute",
+]
+
 def run_process(*command, text=True, shell=False, _input=None):
     cmd = ""
     for c in command:
@@ -126,6 +156,12 @@ def test_example(example_path: str) -> int:
         print("Compiled " + EXAMPLE_NAME + " Does Not Match Expected")
         err_status = 1
  
+    process = run_process(CFG, COMPILED)
+    if process.returncode != 0:
+        print("Could Not Build The Control Flow Graph Of " + EXAMPLE_NAME)
+        print("stderr: " + process.stderr.decode(ENCODING))
+        err_status = 1
+
     process = run_process(DISASSEMBLE, COMPILED, "-o", DECOMPILED)
     if process.returncode != 0:
         print("Decompilation Failed For " + EXAMPLE_NAME)
@@ -147,14 +183,59 @@ def test_example(example_path: str) -> int:
             special_case = i
             break
     
+    expected_returncode = special_case.get('returncode', 0) if special_case is not None else 0
+    expected_stderr = special_case.get('stderr') if special_case is not None else None
+
     if special_case is not None and 'input' in special_case:
         process = run_process(f"echo \"{special_case['input']}\" |", RUN, COMPILED)
     else:
         process = run_process(RUN, COMPILED)
-    if process.returncode != 0:
-        print("Run Failed For " + EXAMPLE_NAME)
+    if process.returncode != expected_returncode:
+        print("Run Failed For " + EXAMPLE_NAME + ", Exit Code " + str(process.returncode) + " Instead Of " + str(expected_returncode))
         print("stderr: " + process.stderr.decode(ENCODING))
         err_status = 1
+    if special_case is not None and 'stdout' in special_case and process.stdout != special_case['stdout'].encode(ENCODING):
+        print("Output Of " + EXAMPLE_NAME + " Does Not Match Expected")
+        print("stdout: " + process.stdout.decode(ENCODING))
+        err_status = 1
+    if expected_stderr is not None and expected_stderr.encode(ENCODING) not in process.stderr:
+        print("Errors Of " + EXAMPLE_NAME + " Do Not Have '" + expected_stderr + "'")
+        print("stderr: " + process.stderr.decode(ENCODING))
+        err_status = 1
+
+    for alternative_run in ALTERNATIVE_RUNS:
+        if special_case is not None and 'input' in special_case:
+            alternative = run_process(f"echo \"{special_case['input']}\" |", alternative_run, COMPILED)
+        else:
+            alternative = run_process(alternative_run, COMPILED)
+        if alternative.returncode != process.returncode or alternative.stdout != process.stdout or \
+           (expected_stderr is not None and expected_stderr.encode(ENCODING) not in alternative.stderr):
+            print("'" + alternative_run + "' Does Not Match The Reference Run For " + EXAMPLE_NAME)
+            print("stderr: " + alternative.stderr.decode(ENCODING))
+            err_status = 1
+
+    if CC is not None:
+        TRANSLATED = BUILD_DIR + PATH_SEP + "assembled" + PATH_SEP + EXAMPLE_NAME + ".c"
+        NATIVE     = BUILD_DIR + PATH_SEP + "assembled" + PATH_SEP + EXAMPLE_NAME + ".bin"
+        translation = run_process(COMPILE_C, COMPILED, "-o", TRANSLATED)
+        if translation.returncode == 0:
+            translation = run_process(CC, "-O1", "-I", SRC_DIR, TRANSLATED, "-o", NATIVE, "-lm", "-pthread")
+        if translation.returncode != 0:
+            print("Could Not Compile " + EXAMPLE_NAME + " To Native Code Through C")
+            print("stderr: " + translation.stderr.decode(ENCODING))
+            err_status = 1
+        else:
+            if special_case is not None and 'input' in special_case:
+                native = run_process(f"echo \"{special_case['input']}\" |", NATIVE)
+            else:
+                native = run_process(NATIVE)
+            # the program path is in argv[0]
+            expected = process.stdout.replace(COMPILED.encode(ENCODING), NATIVE.encode(ENCODING))
+            if native.returncode != process.returncode or native.stdout != expected or \
+               (expected_stderr is not None and expected_stderr.encode(ENCODING) not in native.stderr):
+                print("Program Compiled Through C Does Not Match The Reference Run For " + EXAMPLE_NAME)
+                print("stderr: " + native.stderr.decode(ENCODING))
+                err_status = 1
 
     if err_status == 0:
         print("Test " + EXAMPLE_NAME + " was successfull")
@@ -164,6 +245,371 @@ def test_example(example_path: str) -> int:
     return err_status
     
 
+# tests of the assembler and the tools around it that need generated sources or more than one file,
+# they work in FEATURES_DIR and each returns 0 on success
+FEATURES_DIR = BUILD_DIR + PATH_SEP + "features"
+
+def feature_path(name: str) -> str:
+    return FEATURES_DIR + PATH_SEP + name
+
+def write_feature_file(name: str, contents: str) -> str:
+    path = feature_path(name)
+    with open(path, "w") as f:
+        f.write(contents)
+    return path
+
+# runs the executable in program with RUN and every alternative run
+# \returns 0 if they all exit with 0 and print expected
+def run_everywhere(test_name: str, program: str, expected: bytes) -> int:
+    for run in [RUN] + ALTERNATIVE_RUNS:
+        process = run_process(run, program)
+        if process.returncode != 0 or process.stdout != expected:
+            print(f"'{run}' Does Not Give The Expected Output For {test_name}")
+            print("stdout: " + process.stdout.decode(ENCODING))
+            print("stderr: " + process.stderr.decode(ENCODING))
+            return 1
+    return 0
+
+# branches further than 32K instructions away become JMPW/JMPFW/CALLW, both the ones resolved while parsing
+# (backwards to a global label) and the ones relaxed when their local scope closes (forwards to a local label)
+def test_far_branches() -> int:
+    distance = 40000
+    source = "far:\n    MOVV RB 'F'\n    DUMPCHAR RB R0 R0\n    RET\n"
+    source += "back:\n    MOVV RB 'B'\n    DUMPCHAR RB R0 R0\n    MOVV RB '\\n'\n    DUMPCHAR RB R0 R0\n    HALT 0\n"
+    source += "    NOP\n" * distance
+    source += "%start\n    CALL @far\n    MOVV RA 1\n    JMPF RA @.over\n"
+    source += "    NOP\n" * distance
+    source += "    .over:\n    MOVV RB 'L'\n    DUMPCHAR RB R0 R0\n    JMP @back\n"
+    source_path = write_feature_file("far_branches.txt", source)
+    program = feature_path("far_branches.out")
+
+    process = run_process(ASSEMBLE, source_path, "-o", program)
+    if process.returncode != 0:
+        print("Could Not Assemble The Far Branches")
+        print("stderr: " + process.stderr.decode(ENCODING))
+        return 1
+    if run_everywhere("far_branches", program, b"FLB\n"):
+        return 1
+
+    disassembled = feature_path("far_branches_disassembled.txt")
+    process = run_process(DISASSEMBLE, program, "-o", disassembled)
+    if process.returncode != 0:
+        print("Could Not Disassemble The Far Branches")
+        return 1
+    with open(disassembled, "r") as f:
+        text = f.read()
+    for wide in ["CALLW", "JMPFW", "JMPW"]:
+        if wide + " " not in text:
+            print(f"The Far Branches Were Not Relaxed To {wide}")
+            return 1
+    process = run_process(ASSEMBLE, disassembled, "-o", feature_path("far_branches_again.out"))
+    if process.returncode != 0 or not cmpf(feature_path("far_branches_again.out"), program, "rb"):
+        print("The Disassembled Far Branches Do Not Assemble Back To The Same Executable")
+        return 1
+    return 0
+
+# assembling with -include-cache gives the same bytes as without it, when the cache is filled, when it is replayed
+# and after a label the include depends on changes (the stale record must not be replayed)
+def test_include_cache() -> int:
+    cache = feature_path("include_cache")
+    shutil.rmtree(cache, ignore_errors=True)
+    write_feature_file("include_cache_lib.txt",
+        "print_value:\n"
+        "    MOVV RB $VALUE\n    MOVV RC '0'\n    ADD RB RB RC\n    DUMPCHAR RB R0 R0\n"
+        "    MOVV RB '\\n'\n    DUMPCHAR RB R0 R0\n"
+        "    RET\n"
+    )
+    for value in ["5", "7"]:
+        source = write_feature_file("include_cache.txt",
+            f"%label VALUE {value}\n%include \"include_cache_lib.txt\"\n%start\nCALL @print_value\n"
+        )
+        reference = feature_path("include_cache_reference.out")
+        process = run_process(ASSEMBLE, source, "-o", reference)
+        if process.returncode != 0:
+            print("Could Not Assemble The Include Cache Test")
+            print("stderr: " + process.stderr.decode(ENCODING))
+            return 1
+        for attempt in range(2):
+            cached = feature_path(f"include_cache_{attempt}.out")
+            process = run_process(ASSEMBLE, source, "-include-cache", cache, "-o", cached)
+            if process.returncode != 0:
+                print("Could Not Assemble The Include Cache Test With The Cache")
+                print("stderr: " + process.stderr.decode(ENCODING))
+                return 1
+            if not cmpf(cached, reference, "rb"):
+                print(f"Assembling With The Include Cache (Run {attempt + 1}, VALUE {value}) Does Not Match Assembling Without It")
+                return 1
+        if run_everywhere("include_cache", reference, (value + "\n").encode(ENCODING)):
+            return 1
+    if not [f for f in os.listdir(cache) if f.endswith(".vo")]:
+        print("The Include Cache Recorded Nothing")
+        return 1
+    return 0
+
+# executables assembled with -compress run and disassemble exactly like the uncompressed ones
+def test_compress() -> int:
+    for example in ["hello_world", "primes", "string"]:
+        source = EXAMPLES_DIR + PATH_SEP + example + ".txt"
+        plain = feature_path(example + ".out")
+        compressed = feature_path(example + "_compressed.out")
+        for program, flags in [(plain, ""), (compressed, "-compress")]:
+            process = run_process(ASSEMBLE, source, flags, "-o", program)
+            if process.returncode != 0:
+                print(f"Could Not Assemble {example} {flags}")
+                print("stderr: " + process.stderr.decode(ENCODING))
+                return 1
+        reference = run_process(RUN, plain)
+        if reference.returncode != 0:
+            print(f"Could Not Run {example}")
+            return 1
+        # the program path is in argv[0]
+        expected = reference.stdout.replace(plain.encode(ENCODING), compressed.encode(ENCODING))
+        if run_everywhere(example + " compressed", compressed, expected):
+            return 1
+        for program in [plain, compressed]:
+            process = run_process(DISASSEMBLE, program, "-o", program + ".txt")
+            if process.returncode != 0:
+                print(f"Could Not Disassemble {program}")
+                print("stderr: " + process.stderr.decode(ENCODING))
+                return 1
+        if not cmpf(plain + ".txt", compressed + ".txt", "r"):
+            print(f"Compressed {example} Does Not Disassemble Like The Uncompressed One")
+            return 1
+    return 0
+
+# a damaged executable is refused with an error instead of being run: a flipped byte in the field directory, in the
+# program (caught by its directory checksum, which vfopen checks and decompression always does) or a truncated file
+def test_corrupted_files() -> int:
+    source = EXAMPLES_DIR + PATH_SEP + "primes.txt"
+    for flags in ["", "-compress"]:
+        program = feature_path("corrupted.out")
+        process = run_process(ASSEMBLE, source, flags, "-o", program)
+        if process.returncode != 0:
+            print("Could Not Assemble The Corruption Test")
+            return 1
+        with open(program, "rb") as f:
+            data = f.read()
+        # the 24 bytes header is followed by the directory, its size, id and entry count take 16 bytes
+        program_field = data.index(b"program\0")
+        damages = [
+            ("directory", 24 + 16 + 4, RUN),
+            ("program", program_field + 16, RUN if flags else DISASSEMBLE),
+            ("truncated", len(data) - 16, RUN),
+        ]
+        for damage, position, tool in damages:
+            damaged = bytearray(data)
+            if damage == "truncated":
+                damaged = damaged[:position]
+            else:
+                damaged[position] ^= 0x5A
+            corrupted = feature_path("corrupted_" + damage + ".out")
+            with open(corrupted, "wb") as f:
+                f.write(damaged)
+            process = run_process(tool, corrupted, "-o", feature_path("corrupted.txt")) if tool == DISASSEMBLE else run_process(tool, corrupted)
+            if process.returncode != 1 or b"[ERROR]" not in process.stderr:
+                print(f"'{tool}' Did Not Refuse An Executable With A Damaged {damage} ({flags or 'uncompressed'}), Exit Code {process.returncode}")
+                print("stderr: " + process.stderr.decode(ENCODING))
+                return 1
+    return 0
+
+LINK_LIBRARY = (
+    "%label NEWLINE '\\n'\n%label DIGIT '7'\n"
+    "greet:\n"
+    "    STATIC \"Linked\"\n    POP RS\n    MOVV RI 0\n"
+    "    .loop:\n        READ8 RB RS RI\n        JMPFN RB @.done\n        DUMPCHAR RB R0 R0\n        INC RI 1\n    JMP @.loop\n"
+    "    .done:\n    MOVV RB $NEWLINE\n    DUMPCHAR RB R0 R0\n    RET\n"
+)
+LINK_MAIN = (
+    "%label NEWLINE '\\n'\n"
+    "%start\n"
+    "    STATIC \"!\"\n    POP RT\n    CALL @greet\n"
+    "    MOVV RB $DIGIT\n    DUMPCHAR RB R0 R0\n    READ8 RB RT R0\n    DUMPCHAR RB R0 R0\n"
+    "    MOVV RB $NEWLINE\n    DUMPCHAR RB R0 R0\n    HALT 0\n"
+)
+
+# objects assembled with -object link in any order: the symbols one object leaves to the linker ($DIGIT, @greet) are
+# resolved, the static memory of each object moves with it and equal constants (NEWLINE) can be defined by both,
+# linking a single object gives the same executable as assembling its source, missing and duplicate symbols are refused
+def test_link() -> int:
+    objects = {}
+    for name, source in [("link_library", LINK_LIBRARY), ("link_main", LINK_MAIN)]:
+        objects[name] = feature_path(name + ".o")
+        process = run_process(ASSEMBLE, write_feature_file(name + ".txt", source), "-object", "-o", objects[name])
+        if process.returncode != 0:
+            print(f"Could Not Assemble {name} As An Object")
+            print("stderr: " + process.stderr.decode(ENCODING))
+            return 1
+    for order in [["link_library", "link_main"], ["link_main", "link_library"]]:
+        program = feature_path("linked.out")
+        process = run_process(VPU, "-link", *[objects[name] for name in order], "-o", program)
+        if process.returncode != 0:
+            print(f"Could Not Link {' '.join(order)}")
+            print("stderr: " + process.stderr.decode(ENCODING))
+            return 1
+        if run_everywhere("link " + " ".join(order), program, b"Linked\n7!\n"):
+            return 1
+
+    source = write_feature_file("link_single.txt", LINK_LIBRARY + LINK_MAIN.replace("%label NEWLINE '\\n'\n", ""))
+    direct = feature_path("link_single.out")
+    linked = feature_path("link_single_linked.out")
+    process = run_process(ASSEMBLE, source, "-o", direct)
+    if process.returncode != 0:
+        print("Could Not Assemble The Single Object Source")
+        print("stderr: " + process.stderr.decode(ENCODING))
+        return 1
+    process = run_process(ASSEMBLE, source, "-object", "-o", feature_path("link_single.o"))
+    if process.returncode != 0:
+        print("Could Not Assemble The Single Object")
+        print("stderr: " + process.stderr.decode(ENCODING))
+        return 1
+    process = run_process(VPU, "-link", feature_path("link_single.o"), "-o", linked)
+    if process.returncode != 0 or not cmpf(direct, linked, "rb"):
+        print("Linking A Single Object Does Not Give The Same Executable As Assembling Its Source")
+        return 1
+
+    for failure, linked_objects in [("Undefined", [objects["link_main"]]), ("Already Defined", [objects["link_library"]] * 2)]:
+        process = run_process(VPU, "-link", *linked_objects, "-o", feature_path("link_failure.out"))
+        if process.returncode != 1 or failure.encode(ENCODING) not in process.stderr:
+            print(f"Linking {' '.join(linked_objects)} Was Not Refused With An '{failure}' Error, Exit Code {process.returncode}")
+            print("stderr: " + process.stderr.decode(ENCODING))
+            return 1
+    return 0
+
+# several inputs assembled at once give the same executable whatever the number of jobs, run after run, and the
+# same one -link gives for their objects
+def test_parallel_assembler() -> int:
+    parts = 8
+    sources = []
+    for i in range(parts):
+        sources.append(write_feature_file(f"parallel_{i}.txt",
+            f"%label LETTER_{i} '{chr(ord('A') + i)}'\n"
+            f"part_{i}:\n    STATIC \"{chr(ord('a') + i) * (i + 1)}\"\n    POP RS\n    READ8 RB RS R0\n    DUMPCHAR RB R0 R0\n"
+            f"    MOVV RB $LETTER_{i}\n    DUMPCHAR RB R0 R0\n    RET\n"
+        ))
+    sources.append(write_feature_file("parallel_main.txt",
+        "%start\n" + "".join(f"    CALL @part_{i}\n" for i in range(parts)) + "    MOVV RB '\\n'\n    DUMPCHAR RB R0 R0\n    HALT 0\n"
+    ))
+    expected = "".join(chr(ord('a') + i) + chr(ord('A') + i) for i in range(parts)) + "\n"
+
+    reference = feature_path("parallel_1.out")
+    process = run_process(ASSEMBLE, *sources, "-j", "1", "-o", reference)
+    if process.returncode != 0:
+        print("Could Not Assemble The Parallel Inputs With -j 1")
+        print("stderr: " + process.stderr.decode(ENCODING))
+        return 1
+    if run_everywhere("parallel assembler", reference, expected.encode(ENCODING)):
+        return 1
+    for attempt in range(3):
+        program = feature_path("parallel_8.out")
+        process = run_process(ASSEMBLE, *sources, "-j", "8", "-o", program)
+        if process.returncode != 0:
+            print("Could Not Assemble The Parallel Inputs With -j 8")
+            print("stderr: " + process.stderr.decode(ENCODING))
+            return 1
+        if not cmpf(program, reference, "rb"):
+            print(f"Assembling With -j 8 (Run {attempt + 1}) Does Not Give The Same Executable As With -j 1")
+            return 1
+
+    objects = []
+    for source in sources:
+        objects.append(source[:-len(".txt")] + ".o")
+        process = run_process(ASSEMBLE, source, "-object", "-o", objects[-1])
+        if process.returncode != 0:
+            print(f"Could Not Assemble {source} As An Object")
+            print("stderr: " + process.stderr.decode(ENCODING))
+            return 1
+    linked = feature_path("parallel_linked.out")
+    process = run_process(VPU, "-link", *objects, "-o", linked)
+    if process.returncode != 0 or not cmpf(linked, reference, "rb"):
+        print("Linking The Objects Does Not Give The Same Executable As Assembling The Inputs Together")
+        print("stderr: " + process.stderr.decode(ENCODING))
+        return 1
+    return 0
+
+SPELLING_UPPER_CASE = (
+    "MOVV RA 'x'\nMOVV RB 1\nADD RA RA RB\nMOV8 RC0 RA0\nDUMPCHAR RC R0 R0\n"
+    "VSPLAT32 V1 RA\nVGET32 RD V1 R0\nDUMPCHAR RD R0 R0\n"
+    "MOVVW RE 0x10000\nMOVVL RF 0x100000000\nOR RE RE RF\nGSP RG RSP R0\n"
+    "MOVV RB '\\n'\nDUMPCHAR RB R0 R0\nHALT 0\n"
+)
+SPELLING_MIXED_CASE = (
+    "MOVV ra 'x'\nMOVV Rb 1\nADD rA ra RB\nMOV8 rc0 Ra0\nDUMPCHAR rC r0 R0\n"
+    "VSPLAT32 v1 rA\nVGET32 rd V1 r0\nDUMPCHAR Rd r0 r0\n"
+    "MOVVW re 0x10000\nMOVVL Rf 0x100000000\nOR rE Re rf\nGSP rg Rsp r0\n"
+    "MOVV rb '\\n'\nDUMPCHAR rB r0 R0\nHALT 0\n"
+)
+
+# registers can be spelled in any case (the lookup folds it), mnemonics only in upper case, and a name that is one
+# character away from a mnemonic or a register is not taken for it
+def test_spelling() -> int:
+    programs = []
+    for name, source in [("spelling_upper", SPELLING_UPPER_CASE), ("spelling_mixed", SPELLING_MIXED_CASE)]:
+        programs.append(feature_path(name + ".out"))
+        process = run_process(ASSEMBLE, write_feature_file(name + ".txt", source), "-o", programs[-1])
+        if process.returncode != 0:
+            print(f"Could Not Assemble {name}")
+            print("stderr: " + process.stderr.decode(ENCODING))
+            return 1
+    if not cmpf(programs[0], programs[1], "rb"):
+        print("Registers Spelled In Lower Or Mixed Case Do Not Assemble Like The Upper Case Ones")
+        return 1
+    if run_everywhere("spelling", programs[1], b"yy\n"):
+        return 1
+
+    for line in ["movv RA 1", "Movv RA 1", "movvl RA 1", "MOVVX RA 1", "HAL 0", "HALTT 0", "MOV RA8 RB", "MOV RSPX RB", "MOVVL rAA 1"]:
+        source = write_feature_file("spelling_wrong.txt", line + "\nHALT 0\n")
+        process = run_process(ASSEMBLE, source, "-o", feature_path("spelling_wrong.out"))
+        if process.returncode != 1 or b"[ERROR]" not in process.stderr:
+            print(f"'{line}' Was Not Refused, Exit Code {process.returncode}")
+            return 1
+    return 0
+
+# -stack-size takes a number of bytes followed by K, M or G, signed, wrapping and too large sizes are refused instead
+# of giving the program a stack of the wrapped around size
+def test_stack_size() -> int:
+    program = feature_path("stack_size.out")
+    process = run_process(ASSEMBLE, EXAMPLES_DIR + PATH_SEP + "hello_world.txt", "-o", program)
+    if process.returncode != 0:
+        print("Could Not Assemble The Stack Size Test")
+        return 1
+    for size in ["4096", "64K", "2M"]:
+        process = run_process(VPU, "-stack-size", size, "-execute", program)
+        if process.returncode != 0:
+            print(f"Could Not Run With -stack-size {size}")
+            print("stderr: " + process.stderr.decode(ENCODING))
+            return 1
+    for size in ["-5", "+5", "0", "18446744073709551615", "17179869183G", "65G", "99999999999999999999999", "5X"]:
+        process = run_process(VPU, "-stack-size", f"'{size}'", "-execute", program)
+        if process.returncode != 1 or b"Invalid Stack Size" not in process.stderr:
+            print(f"-stack-size {size} Was Not Refused, Exit Code {process.returncode}")
+            print("stderr: " + process.stderr.decode(ENCODING))
+            return 1
+    return 0
+
+FEATURE_TESTS = [
+    ("far_branches", test_far_branches),
+    ("include_cache", test_include_cache),
+    ("compress", test_compress),
+    ("corrupted_files", test_corrupted_files),
+    ("link", test_link),
+    ("parallel_assembler", test_parallel_assembler),
+    ("spelling", test_spelling),
+    ("stack_size", test_stack_size),
+]
+
+def test_features() -> int:
+    os.makedirs(FEATURES_DIR, exist_ok=True)
+    failed = 0
+    for name, test in FEATURE_TESTS:
+        print("Beggining Test " + name)
+        if test() == 0:
+            print("Test " + name + " was successfull")
+        else:
+            print("*Test " + name + " failed ***")
+            failed += 1
+    return failed
+
+
 examples = [f for f in os.listdir(EXAMPLES_DIR) if os.path.isfile(os.path.join(EXAMPLES_DIR, f))]
 test_count = len(examples)
 failed_tests = 0
@@ -172,6 +618,8 @@ if not PRECOMPUTE:
     os.makedirs(BUILD_DIR + PATH_SEP + "assembled", exist_ok=True)
     for example in examples:
         failed_tests += test_example(EXAMPLES_DIR + PATH_SEP + example)
+    test_count += len(FEATURE_TESTS)
+    failed_tests += test_features()
     
     print(str(failed_tests) + " tests failed out of " + str(test_count) + " (" + str(100 * (float(failed_tests) / float(test_count))) + "%)" if failed_tests > 0 else "all tests were successfull")
 else: